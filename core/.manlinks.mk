@@ -110,6 +110,7 @@ MANLINKS+=AG_Db.3:AG_DbDel.3
 MANLINKS+=AG_Db.3:AG_DbGet.3
 MANLINKS+=AG_Db.3:AG_DbPut.3
 MANLINKS+=AG_Db.3:AG_DbSync.3
+MANLINKS+=AG_Db.3:AG_DbIterate.3
 MANLINKS+=AG_Error.3:AG_SetError.3
 MANLINKS+=AG_Error.3:AG_SetErrorS.3
 MANLINKS+=AG_Error.3:AG_SetErrorV.3
@@ -356,8 +357,13 @@ MANLINKS+=AG_String.3:AG_ProcessFmtString.3
 MANLINKS+=AG_String.3:AG_RegisterFmtStringExt.3
 MANLINKS+=AG_String.3:AG_FMTSTRING_ARG.3
 MANLINKS+=AG_String.3:AG_UnregisterFmtStringExt.3
+MANLINKS+=AG_String.3:AG_FmtCompile.3
+MANLINKS+=AG_String.3:AG_FmtFree.3
+MANLINKS+=AG_String.3:AG_FmtPrint.3
+MANLINKS+=AG_String.3:AG_FmtPrintV.3
 MANLINKS+=AG_String.3:AG_FmtString.3
 MANLINKS+=AG_String.3:AG_FmtStringExtFn.3
+MANLINKS+=AG_String.3:AG_FmtProgram.3
 MANLINKS+=AG_String.3:AG_Strsep.3
 MANLINKS+=AG_String.3:AG_Strdup.3
 MANLINKS+=AG_String.3:AG_TryStrdup.3
@@ -446,6 +452,16 @@ MANLINKS+=AG_Threads.3:AG_ThreadKeyTryDelete.3
 MANLINKS+=AG_Threads.3:AG_ThreadKeyGet.3
 MANLINKS+=AG_Threads.3:AG_ThreadKeySet.3
 MANLINKS+=AG_Threads.3:AG_ThreadKeyTrySet.3
+MANLINKS+=AG_Threads.3:AG_TaskPool.3
+MANLINKS+=AG_Threads.3:AG_TaskGroup.3
+MANLINKS+=AG_Threads.3:AG_TaskPoolNew.3
+MANLINKS+=AG_Threads.3:AG_TaskPoolDestroy.3
+MANLINKS+=AG_Threads.3:AG_TaskPoolDefault.3
+MANLINKS+=AG_Threads.3:AG_TaskPoolGetStats.3
+MANLINKS+=AG_Threads.3:AG_TaskGroupInit.3
+MANLINKS+=AG_Threads.3:AG_TaskSubmit.3
+MANLINKS+=AG_Threads.3:AG_TaskWait.3
+MANLINKS+=AG_Threads.3:AG_TaskParallelFor.3
 MANLINKS+=AG_Time.3:AG_GetTicks.3
 MANLINKS+=AG_Time.3:AG_Delay.3
 MANLINKS+=AG_Time.3:AG_SetTimeOps.3
@@ -464,6 +480,13 @@ MANLINKS+=AG_Timer.3:AG_UnlockTimers.3
 MANLINKS+=AG_Timer.3:AG_TimerIsRunning.3
 MANLINKS+=AG_Timer.3:AG_ExecTimer.3
 MANLINKS+=AG_Timer.3:AG_ProcessTimeouts.3
+MANLINKS+=AG_Trace.3:AG_TraceEnable.3
+MANLINKS+=AG_Trace.3:AG_TraceDisable.3
+MANLINKS+=AG_Trace.3:AG_TraceClear.3
+MANLINKS+=AG_Trace.3:AG_TraceDump.3
+MANLINKS+=AG_Trace.3:AG_TraceBegin.3
+MANLINKS+=AG_Trace.3:AG_TraceEnd.3
+MANLINKS+=AG_Trace.3:AG_TraceCounter.3
 MANLINKS+=AG_User.3:AG_UserNew.3
 MANLINKS+=AG_User.3:AG_GetUserByName.3
 MANLINKS+=AG_User.3:AG_GetUserByUID.3
@@ -19,6 +19,8 @@ typedef Uint32 (*AG_TimerFn)(struct ag_timer *_Nonnull, AG_Event *_Nonnull);
 typedef struct ag_timer_pvt {
 	AG_TAILQ_ENTRY(ag_timer) timers;
 	AG_TAILQ_ENTRY(ag_timer) change;
+	int heapIdx;			/* Index in soft timer heap (or -1) */
+	Uint32 _pad;
 } AG_TimerPvt;
 
 typedef struct ag_timer {
@@ -94,6 +96,7 @@ int  AG_TimerIsRunning(void *_Nullable, AG_Timer *_Nonnull)
                       _Pure_Attribute;
 Uint32 AG_ExecTimer(AG_Timer *_Nonnull);
 void AG_ProcessTimeouts(Uint32);
+Uint32 AG_GetNextTimeout(Uint32);
 
 # ifdef AG_LEGACY
 #  define AG_Timeout AG_Timer
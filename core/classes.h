@@ -27,6 +27,7 @@ typedef enum ag_class {
 	AGC_DB_HASH         = 0x03010001,      /* AG_DbHash */
 	AGC_DB_BTREE        = 0x03020001,      /* AG_DbBtree */
 	AGC_DB_MYSQL        = 0x03040001,      /* AG_DbMySQL */
+	AGC_DB_FILE         = 0x03080001,      /* AG_DbFile */
 	AGC_DB_OBJECT       = 0x04000001,  /* AG_DbObject */
 	/* Agar-GUI */
 	AGC_DRIVER          = 0x05000001,  /* AG_Driver (non-instantiatable) */
@@ -35,6 +36,7 @@ typedef enum ag_class {
 	AGC_DRIVER_SDLGL    = 0x05010002,      /* AG_DriverSDLGL */
 	AGC_DRIVER_SDL2FB   = 0x05010003,      /* AG_DriverSDL2FB */
 	AGC_DRIVER_SDL2GL   = 0x05010004,      /* AG_DriverSDL2GL */
+	AGC_DRIVER_MEMFB    = 0x05010005,      /* AG_DriverMemFB */
 	AGC_DRIVER_MW       = 0x05020000,  /* AG_Driver -> AG_DriverMw (non-instantiatable) */
 	AGC_DRIVER_DUMMY    = 0x05020001,      /* AG_DriverDUMMY */
 	AGC_DRIVER_GLX      = 0x05020002,      /* AG_DriverGLX */
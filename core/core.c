@@ -128,6 +128,9 @@ AG_InitCore(const char *progname, Uint flags)
 	    AG_InitStringSubsystem() == -1)
 		return (-1);
 
+	/* Initialize the table of interned event names. */
+	AG_InitEventAtoms();
+
 	/* Initialize the AG_Event(3) subsystem. */
 #ifdef AG_EVENT_LOOP
 	if (AG_InitEventSubsystem(flags) == -1)
@@ -136,6 +139,12 @@ AG_InitCore(const char *progname, Uint flags)
 	/* Fetch CPU information. */
 	AG_GetCPUInfo(&agCPU);
 
+#if AG_MODEL != AG_SMALL && defined(AG_HAVE_64BIT)
+	/* Record AG_Trace(3) events if $AG_TRACE names an output file. */
+	if (getenv("AG_TRACE") != NULL)
+		AG_TraceEnable(0);
+#endif
+
 	/* Initialize POSIX threads. */
 #ifdef AG_THREADS
 	agEventThread = AG_ThreadSelf();		/* Main thread */
@@ -153,11 +162,17 @@ AG_InitCore(const char *progname, Uint flags)
 # endif
 #endif /* AG_THREADS */
 
+	/* Initialize the AG_QueueEvent() queue (uses a recursive mutex). */
+#if AG_MODEL != AG_SMALL
+	AG_InitEventQueue();
+#endif
+
 	/* Initialize core Agar object classes. */
 	AG_InitClassTbl();
 #ifdef AG_SERIALIZATION
 	AG_RegisterClass(&agConfigClass);
 	AG_RegisterClass(&agDbClass);
+	AG_RegisterClass(&agDbFileClass);
 # if defined(HAVE_DB4)
 	AG_RegisterClass(&agDbHashClass);
 	AG_RegisterClass(&agDbBtreeClass);
@@ -296,6 +311,16 @@ AG_Destroy(void)
 #endif
 	if (agAtexitFunc != NULL) { agAtexitFunc(); }
 	if (agAtexitFuncEv != NULL) { agAtexitFuncEv(NULL); }
+#if AG_MODEL != AG_SMALL
+	AG_TaskPoolDestroyDefault();
+#endif
+#if AG_MODEL != AG_SMALL && defined(AG_HAVE_64BIT)
+	if (agTraceEnabled && getenv("AG_TRACE") != NULL &&
+	    AG_TraceDump(getenv("AG_TRACE")) == -1) {
+		AG_Verbose("AG_TRACE: %s\n", AG_GetError());
+	}
+	AG_TraceDestroy();
+#endif
 #ifdef AG_USER
 	if (agUserOps != NULL && agUserOps->destroy != NULL) {
 		agUserOps->destroy();
@@ -105,6 +105,8 @@
 # include <agar/core/db.h>
 # include <agar/core/exec.h>
 # include <agar/core/user.h>
+# include <agar/core/task.h>
+# include <agar/core/trace.h>
 
 #endif /* _AGAR_INTERNAL */
 
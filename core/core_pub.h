@@ -36,5 +36,7 @@
 #include <agar/core/getopt.h>
 #include <agar/core/exec.h>
 #include <agar/core/user.h>
+#include <agar/core/task.h>
+#include <agar/core/trace.h>
 
 #endif /* !_AGAR_CORE_PUBLIC_H_ */
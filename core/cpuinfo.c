@@ -40,6 +40,16 @@
 # include <proto/exec.h>
 #endif
 
+#if defined(_WIN32) && !defined(_XBOX)
+# undef SLIST_ENTRY
+# include <windows.h>
+#else
+# include <agar/config/_mk_have_unistd_h.h>
+# ifdef _MK_HAVE_UNISTD_H
+#  include <unistd.h>
+# endif
+#endif
+
 struct cpuid_regs {
 	Uint32 a;
 	Uint32 b;
@@ -140,6 +150,26 @@ AG_GetCPUInfo(AG_CPUInfo *_Nonnull cpu)
 	cpu->vendorID[0] = '\0';
 	cpu->ext = 0;
 	cpu->icon = 0;
+	cpu->nCores = 1;
+	cpu->_pad2 = 0;
+
+	/* Count the logical processors available to us. */
+#if defined(_WIN32) && !defined(_XBOX)
+	{
+		SYSTEM_INFO si;
+
+		GetSystemInfo(&si);
+		if (si.dwNumberOfProcessors > 0)
+			cpu->nCores = (Uint32)si.dwNumberOfProcessors;
+	}
+#elif defined(_SC_NPROCESSORS_ONLN)
+	{
+		long n;
+
+		if ((n = sysconf(_SC_NPROCESSORS_ONLN)) > 0)
+			cpu->nCores = (Uint32)n;
+	}
+#endif
 
 #if defined(__CC65__)
 	cpu->arch = "6502";		/* Use getcpu() in <6502.h> */
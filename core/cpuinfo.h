@@ -43,6 +43,8 @@ typedef struct ag_cpuinfo {
 	/* TODO: AVX */
 
 	Uint32 icon;                         /* Graphical Icon (Unicode) */
+	Uint32 nCores;                       /* Logical processors online */
+	Uint32 _pad2;
 } AG_CPUInfo;
 
 __BEGIN_DECLS
@@ -33,11 +33,25 @@
 #include <agar/core/core.h>
 
 #include <agar/config/have_fdclose.h>
+#include <agar/config/have_mmap.h>
+#include <agar/config/have_zlib.h>
 
 #include <stdio.h>
 #include <string.h>
 #include <stdarg.h>
 
+#ifdef HAVE_ZLIB
+# include <zlib.h>
+#endif
+#ifdef HAVE_MMAP
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <errno.h>
+#endif
+
 static AG_Object errorMgr;
 
 void
@@ -183,6 +197,23 @@ AG_Seek(AG_DataSource *ds, AG_Offset pos, enum ag_seek_mode mode)
 	return (rv);
 }
 
+/*
+ * Pass any data buffered by a data source (and by the data sources it
+ * wraps) on to the underlying file or connection.
+ */
+int
+AG_Flush(AG_DataSource *ds)
+{
+	int rv = 0;
+
+	AG_MutexLock(&ds->lock);
+	if (ds->flush != NULL) {
+		rv = ds->flush(ds);
+	}
+	AG_MutexUnlock(&ds->lock);
+	return (rv);
+}
+
 /* Close a datasource of any type. */
 void
 AG_CloseDataSource(AG_DataSource *ds)
@@ -202,28 +233,35 @@ AG_DataSourceDestroy(AG_DataSource *ds)
  * No-ops
  */
 static int
-WriteNotSup(AG_DataSource *_Nonnull ds, const void *_Nonnull buf,
+ReadNotSup(AG_DataSource *_Nonnull ds, void *_Nonnull buf,
     AG_Size size, AG_Size *_Nonnull rv)
 {
 	AG_SetErrorS(_("Operation not supported"));
 	return (-1);
 }
 static int
-WriteAtNotSup(AG_DataSource *_Nonnull ds, const void *_Nonnull buf,
+ReadAtNotSup(AG_DataSource *_Nonnull ds, void *_Nonnull buf,
     AG_Size size, AG_Offset pos, AG_Size *_Nonnull rv)
 {
 	AG_SetErrorS(_("Operation not supported"));
 	return (-1);
 }
-
-#ifdef AG_NETWORK
 static int
-ReadAtNotSup(AG_DataSource *_Nonnull ds, void *_Nonnull buf,
+WriteNotSup(AG_DataSource *_Nonnull ds, const void *_Nonnull buf,
+    AG_Size size, AG_Size *_Nonnull rv)
+{
+	AG_SetErrorS(_("Operation not supported"));
+	return (-1);
+}
+static int
+WriteAtNotSup(AG_DataSource *_Nonnull ds, const void *_Nonnull buf,
     AG_Size size, AG_Offset pos, AG_Size *_Nonnull rv)
 {
 	AG_SetErrorS(_("Operation not supported"));
 	return (-1);
 }
+
+#ifdef AG_NETWORK
 static AG_Offset
 TellNotSup(AG_DataSource *_Nonnull ds)
 {
@@ -329,6 +367,15 @@ FileSeek(AG_DataSource *_Nonnull ds, AG_Offset offs, enum ag_seek_mode mode)
 	}
 	return (0);
 }
+static int
+FileFlush(AG_DataSource *_Nonnull ds)
+{
+	if (fflush(AG_FILE_SOURCE(ds)->file) != 0) {
+		AG_SetErrorS(_("Write error"));
+		return (-1);
+	}
+	return (0);
+}
 
 /*
  * Memory operations. Core operates on fixed-length memory. AutoCore operates
@@ -340,10 +387,8 @@ CoreRead(AG_DataSource *_Nonnull ds, void *_Nonnull buf, AG_Size len,
 {
 	AG_CoreSource *cs = AG_CORE_SOURCE(ds);
 
-	if (cs->offs+len > cs->size) {
-		AG_SetError("Out of bounds (%lu+%lu > %lu)", (Ulong)cs->offs,
-		    (Ulong)len, (Ulong)cs->size);
-		return (-1);
+	if (cs->offs+len > cs->size) {			/* Partial read */
+		len = (cs->offs < cs->size) ? cs->size - cs->offs : 0;
 	}
 	memcpy(buf, &cs->data[cs->offs], len);
 	*rv = len;
@@ -467,6 +512,21 @@ CoreSeek(AG_DataSource *_Nonnull ds, AG_Offset offs, enum ag_seek_mode mode)
 	cs->offs = nOffs;
 	return (0);
 }
+static const void *
+CoreBorrow(AG_DataSource *_Nonnull ds, AG_Size len)
+{
+	AG_CoreSource *cs = AG_CORE_SOURCE(ds);
+	const Uint8 *p;
+
+	if (cs->offs+len > cs->size) {
+		AG_SetError("Out of bounds (%lu+%lu > %lu)", (Ulong)cs->offs,
+		    (Ulong)len, (Ulong)cs->size);
+		return (NULL);
+	}
+	p = &cs->data[cs->offs];
+	cs->offs += len;
+	return (p);
+}
 void
 AG_CloseCore(AG_DataSource *_Nonnull ds)
 {
@@ -533,6 +593,8 @@ AG_DataSourceInit(AG_DataSource *_Nonnull ds)
 	ds->tell = NULL;
 	ds->seek = NULL;
 	ds->close = NULL;
+	ds->borrow = NULL;
+	ds->flush = NULL;
 	AG_DataSourceSetErrorFn(ds, ErrorDefault, "%p", ds);
 }
 
@@ -553,6 +615,7 @@ AG_OpenFileHandle(void *_Nonnull pf)
 	fs->ds.tell = FileTell;
 	fs->ds.seek = FileSeek;
 	fs->ds.close = AG_CloseFileHandle;
+	fs->ds.flush = FileFlush;
 	return (&fs->ds);
 }
 
@@ -603,9 +666,165 @@ AG_OpenFile(const char *_Nonnull path, const char *_Nonnull mode)
 	fs->ds.tell = FileTell;
 	fs->ds.seek = FileSeek;
 	fs->ds.close = AG_CloseFile;
+	fs->ds.flush = FileFlush;
 	return (&fs->ds);
 }
 
+/*
+ * Seek in a mapped file. Unlike CoreSeek(), follow fseek(3) semantics
+ * (AG_SEEK_END is relative to the end and the end itself is reachable).
+ */
+static int
+MappedSeek(AG_DataSource *_Nonnull ds, AG_Offset offs, enum ag_seek_mode mode)
+{
+	AG_MappedFileSource *ms = AG_MAPPED_FILE_SOURCE(ds);
+	AG_Offset nOffs;
+
+	switch (mode) {
+	case AG_SEEK_SET:
+		nOffs = offs;
+		break;
+	case AG_SEEK_CUR:
+		nOffs = ms->offs + offs;
+		break;
+	case AG_SEEK_END:
+	default:
+		nOffs = ms->size + offs;
+		break;
+	}
+	if (nOffs < 0 || nOffs > ms->size) {
+		AG_SetError("Bad offset %ld", (long)nOffs);
+		return (-1);
+	}
+	ms->offs = nOffs;
+	return (0);
+}
+
+/*
+ * Create a read-only data source from the contents of a file. Where mmap()
+ * is available the file is mapped into memory, otherwise it is read in
+ * completely. Reads are served from memory without any system calls,
+ * and AG_ReadBorrow() may be used to access the contents without copying.
+ */
+AG_DataSource *
+AG_OpenFileMapped(const char *_Nonnull path)
+{
+	static const Uint8 emptyFile[1] = { 0 };
+	AG_MappedFileSource *ms;
+	void *data;
+	AG_Size size;
+	int mapped = 0;
+#ifdef HAVE_MMAP
+	struct stat sb;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) == -1) {
+		AG_SetError(_("Unable to open %s"), path);
+		return (NULL);
+	}
+	if (fstat(fd, &sb) == -1) {
+		AG_SetError("%s: %s", path, AG_Strerror(errno));
+		goto fail_close;
+	}
+	size = (AG_Size)sb.st_size;
+	if ((off_t)size != sb.st_size) {
+		AG_SetError("%s: File too large", path);
+		goto fail_close;
+	}
+	if (size > 0) {
+		data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			AG_SetError("%s: %s", path, AG_Strerror(errno));
+			goto fail_close;
+		}
+		mapped = 1;
+	} else {
+		data = (void *)emptyFile;
+	}
+	close(fd);
+#else /* !HAVE_MMAP */
+	FILE *f;
+	long len;
+
+	if ((f = fopen(path, "rb")) == NULL) {
+		AG_SetError(_("Unable to open %s"), path);
+		return (NULL);
+	}
+	if (fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) < 0 ||
+	    fseek(f, 0, SEEK_SET) != 0) {
+		AG_SetError("%s: Seek failed", path);
+		fclose(f);
+		return (NULL);
+	}
+	size = (AG_Size)len;
+	if (size > 0) {
+		if ((data = TryMalloc(size)) == NULL) {
+			fclose(f);
+			return (NULL);
+		}
+		if (fread(data, 1, size, f) != size) {
+			AG_SetError("%s: Short read", path);
+			free(data);
+			fclose(f);
+			return (NULL);
+		}
+	} else {
+		data = (void *)emptyFile;
+	}
+	fclose(f);
+#endif /* HAVE_MMAP */
+
+	if ((ms = TryMalloc(sizeof(AG_MappedFileSource))) == NULL) {
+		goto fail_unmap;
+	}
+	AG_DataSourceInit(&ms->ds);
+	ms->data = (const Uint8 *)data;
+	ms->size = size;
+	ms->offs = 0;
+	ms->path = TryStrdup(path);
+	ms->mapped = mapped;
+	ms->ds.read = CoreRead;
+	ms->ds.read_at = CoreReadAt;
+	ms->ds.write = WriteNotSup;
+	ms->ds.write_at = WriteAtNotSup;
+	ms->ds.tell = CoreTell;
+	ms->ds.seek = MappedSeek;
+	ms->ds.close = AG_CloseFileMapped;
+	ms->ds.borrow = CoreBorrow;
+	return (&ms->ds);
+fail_unmap:
+#ifdef HAVE_MMAP
+	if (mapped)
+		munmap(data, size);
+#else
+	if (size > 0)
+		free(data);
+#endif
+	return (NULL);
+#ifdef HAVE_MMAP
+fail_close:
+	close(fd);
+	return (NULL);
+#endif
+}
+
+/* Close a data source created by AG_OpenFileMapped() */
+void
+AG_CloseFileMapped(AG_DataSource *_Nonnull ds)
+{
+	AG_MappedFileSource *ms = AG_MAPPED_FILE_SOURCE(ds);
+
+#ifdef HAVE_MMAP
+	if (ms->mapped)
+		munmap((void *)ms->data, ms->size);
+#else
+	if (ms->size > 0)
+		free((void *)ms->data);
+#endif
+	AG_Free(ms->path);
+	AG_DataSourceDestroy(ds);
+}
+
 /* Create a data source from a specified chunk of memory. */
 AG_DataSource *
 AG_OpenCore(void *_Nonnull data, AG_Size size)
@@ -626,6 +845,7 @@ AG_OpenCore(void *_Nonnull data, AG_Size size)
 	cs->ds.tell = CoreTell;
 	cs->ds.seek = CoreSeek;
 	cs->ds.close = AG_CloseCore;
+	cs->ds.borrow = CoreBorrow;
 	return (&cs->ds);
 }
 
@@ -649,6 +869,7 @@ AG_OpenConstCore(const void *_Nonnull data, AG_Size size)
 	cs->ds.tell = CoreTell;
 	cs->ds.seek = CoreSeek;
 	cs->ds.close = AG_CloseCore;
+	cs->ds.borrow = CoreBorrow;
 	return (&cs->ds);
 }
 
@@ -672,6 +893,7 @@ AG_OpenAutoCore(void)
 	cs->ds.tell = CoreTell;
 	cs->ds.seek = CoreSeek;
 	cs->ds.close = AG_CloseAutoCore;
+	cs->ds.borrow = CoreBorrow;
 	return (&cs->ds);
 }
 
@@ -698,6 +920,673 @@ AG_OpenNetSocket(AG_NetSocket *_Nonnull ns)
 }
 #endif /* AG_NETWORK */
 
+/*
+ * Buffered stream operations. Reads are served from a read-ahead buffer
+ * refilled in bufSize chunks from the underlying source. Small writes are
+ * combined and passed on in bufSize chunks.
+ */
+static int
+BufferedFlushWrites(AG_BufferedSource *_Nonnull bs)
+{
+	AG_Size pos = 0, nWrote;
+
+	while (pos < bs->wrLen) {
+		if (AG_WriteP(bs->sub, &bs->wrBuf[pos], bs->wrLen - pos,
+		    &nWrote) == -1) {
+			goto fail;
+		}
+		if (nWrote == 0) {
+			AG_SetErrorS("Short write");
+			goto fail;
+		}
+		pos += nWrote;
+	}
+	bs->wrLen = 0;
+	return (0);
+fail:
+	if (pos > 0) {
+		memmove(bs->wrBuf, &bs->wrBuf[pos], bs->wrLen - pos);
+		bs->wrLen -= pos;
+	}
+	return (-1);
+}
+
+/*
+ * Discard any read-ahead data and move the underlying source back to the
+ * logical position. Sources which cannot seek (sockets) have independent
+ * read and write streams, so their read-ahead data is kept. If the seek
+ * fails, the read-ahead data is discarded all the same (leaving us at the
+ * position of the underlying source) and -1 is returned.
+ */
+static int
+BufferedDiscardReads(AG_BufferedSource *_Nonnull bs)
+{
+	const AG_Size nAhead = bs->rdLen - bs->rdPos;
+
+#ifdef AG_NETWORK
+	if (bs->sub->seek == SeekNotSup) {
+		return (0);
+	}
+#endif
+	bs->rdPos = 0;
+	bs->rdLen = 0;
+	if (nAhead > 0 &&
+	    AG_Seek(bs->sub, -(AG_Offset)nAhead, AG_SEEK_CUR) == -1) {
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+BufferedRead(AG_DataSource *_Nonnull ds, void *_Nonnull buf, AG_Size size,
+    AG_Size *_Nonnull rv)
+{
+	AG_BufferedSource *bs = AG_BUFFERED_SOURCE(ds);
+	Uint8 *dst = buf;
+	AG_Size nAvail, nRead, nDone = 0;
+
+	if (bs->wrLen > 0 && BufferedFlushWrites(bs) == -1) {
+		*rv = 0;
+		return (-1);
+	}
+	while (nDone < size) {
+		if ((nAvail = bs->rdLen - bs->rdPos) > 0) {
+			if (nAvail > size - nDone) {
+				nAvail = size - nDone;
+			}
+			memcpy(&dst[nDone], &bs->rdBuf[bs->rdPos], nAvail);
+			bs->rdPos += nAvail;
+			nDone += nAvail;
+			continue;
+		}
+		if (size - nDone >= bs->bufSize) {	/* Bypass the buffer */
+			if (AG_ReadP(bs->sub, &dst[nDone], size - nDone,
+			    &nRead) == -1) {
+				goto fail;
+			}
+			nDone += nRead;
+			if (nRead == 0) {
+				break;
+			}
+			continue;
+		}
+		if (AG_ReadP(bs->sub, bs->rdBuf, bs->bufSize, &nRead) == -1) {
+			goto fail;
+		}
+		bs->rdPos = 0;
+		bs->rdLen = nRead;
+		if (nRead == 0)				/* End of data */
+			break;
+	}
+	*rv = nDone;
+	return (0);
+fail:
+	*rv = nDone;
+	return (nDone > 0) ? 0 : -1;
+}
+
+static int
+BufferedReadAt(AG_DataSource *_Nonnull ds, void *_Nonnull buf, AG_Size size,
+    AG_Offset pos, AG_Size *_Nonnull rv)
+{
+	AG_BufferedSource *bs = AG_BUFFERED_SOURCE(ds);
+
+	if (bs->wrLen > 0 && BufferedFlushWrites(bs) == -1) {
+		*rv = 0;
+		return (-1);
+	}
+	return AG_ReadAtP(bs->sub, buf, size, pos, rv);
+}
+
+static int
+BufferedWrite(AG_DataSource *_Nonnull ds, const void *_Nonnull buf,
+    AG_Size size, AG_Size *_Nonnull rv)
+{
+	AG_BufferedSource *bs = AG_BUFFERED_SOURCE(ds);
+
+	if (bs->rdLen > 0 && BufferedDiscardReads(bs) == -1) {
+		*rv = 0;
+		return (-1);
+	}
+	if (bs->wrLen+size > bs->bufSize &&
+	    BufferedFlushWrites(bs) == -1) {
+		*rv = 0;
+		return (-1);
+	}
+	if (size >= bs->bufSize) {			/* Bypass the buffer */
+		return AG_WriteP(bs->sub, buf, size, rv);
+	}
+	memcpy(&bs->wrBuf[bs->wrLen], buf, size);
+	bs->wrLen += size;
+	*rv = size;
+	return (0);
+}
+
+static int
+BufferedWriteAt(AG_DataSource *_Nonnull ds, const void *_Nonnull buf,
+    AG_Size size, AG_Offset pos, AG_Size *_Nonnull rv)
+{
+	AG_BufferedSource *bs = AG_BUFFERED_SOURCE(ds);
+	AG_Offset base;
+
+	if (bs->wrLen > 0) {
+		base = AG_Tell(bs->sub);
+		if (pos >= base && pos+size <= base+bs->wrLen) {
+			/* Patch the pending data in place. */
+			memcpy(&bs->wrBuf[pos - base], buf, size);
+			*rv = size;
+			return (0);
+		}
+		if (BufferedFlushWrites(bs) == -1) {
+			*rv = 0;
+			return (-1);
+		}
+	}
+	if (bs->rdLen > 0 && BufferedDiscardReads(bs) == -1) {
+		*rv = 0;
+		return (-1);
+	}
+	return AG_WriteAtP(bs->sub, buf, size, pos, rv);
+}
+
+static AG_Offset
+BufferedTell(AG_DataSource *_Nonnull ds)
+{
+	AG_BufferedSource *bs = AG_BUFFERED_SOURCE(ds);
+
+	return AG_Tell(bs->sub) + bs->wrLen - (bs->rdLen - bs->rdPos);
+}
+
+static int
+BufferedSeek(AG_DataSource *_Nonnull ds, AG_Offset offs,
+    enum ag_seek_mode mode)
+{
+	AG_BufferedSource *bs = AG_BUFFERED_SOURCE(ds);
+	AG_Offset base;
+
+	if (mode == AG_SEEK_CUR) {
+		offs += BufferedTell(ds);
+		mode = AG_SEEK_SET;
+	}
+	if (mode == AG_SEEK_SET && bs->rdLen > 0) {
+		base = AG_Tell(bs->sub) - bs->rdLen;
+		if (offs >= base && offs <= base + (AG_Offset)bs->rdLen) {
+			bs->rdPos = (AG_Size)(offs - base);  /* Within buffer */
+			return (0);
+		}
+	}
+	if (bs->wrLen > 0 && BufferedFlushWrites(bs) == -1) {
+		return (-1);
+	}
+	bs->rdPos = 0;
+	bs->rdLen = 0;
+	return AG_Seek(bs->sub, offs, mode);
+}
+
+static int
+BufferedFlush(AG_DataSource *_Nonnull ds)
+{
+	AG_BufferedSource *bs = AG_BUFFERED_SOURCE(ds);
+
+	if (bs->wrLen > 0 && BufferedFlushWrites(bs) == -1) {
+		return (-1);
+	}
+	return AG_Flush(bs->sub);
+}
+
+/* Close a data source created by AG_OpenBuffered(). */
+void
+AG_CloseBuffered(AG_DataSource *_Nonnull ds)
+{
+	AG_BufferedSource *bs = AG_BUFFERED_SOURCE(ds);
+
+	if (bs->wrLen > 0 && BufferedFlushWrites(bs) == -1) {
+		AG_Verbose("AG_CloseBuffered: %s; data lost\n", AG_GetError());
+	}
+	if (bs->rdLen > 0) {
+		(void)BufferedDiscardReads(bs);
+	}
+	if (bs->flags & AG_DATA_SOURCE_CLOSE_SUB) {
+		AG_CloseDataSource(bs->sub);
+	}
+	free(bs->rdBuf);
+	free(bs->wrBuf);
+	AG_DataSourceDestroy(ds);
+}
+
+/*
+ * Create a buffered data source over sub, using read-ahead and
+ * write-combining buffers of bufSize bytes (or AG_DATA_SOURCE_BUFSIZE if 0).
+ * If AG_DATA_SOURCE_CLOSE_SUB is given, sub is closed along with it.
+ */
+AG_DataSource *
+AG_OpenBuffered(AG_DataSource *_Nonnull sub, AG_Size bufSize, Uint flags)
+{
+	AG_BufferedSource *bs;
+
+	if (bufSize == 0) {
+		bufSize = AG_DATA_SOURCE_BUFSIZE;
+	}
+	if ((bs = TryMalloc(sizeof(AG_BufferedSource))) == NULL) {
+		return (NULL);
+	}
+	if ((bs->rdBuf = TryMalloc(bufSize)) == NULL) {
+		goto fail;
+	}
+	if ((bs->wrBuf = TryMalloc(bufSize)) == NULL) {
+		free(bs->rdBuf);
+		goto fail;
+	}
+	AG_DataSourceInit(&bs->ds);
+	bs->ds.byte_order = sub->byte_order;
+	bs->ds.debug = sub->debug;
+	bs->sub = sub;
+	bs->bufSize = bufSize;
+	bs->rdPos = 0;
+	bs->rdLen = 0;
+	bs->wrLen = 0;
+	bs->flags = flags;
+	bs->ds.read = BufferedRead;
+	bs->ds.read_at = BufferedReadAt;
+	bs->ds.write = BufferedWrite;
+	bs->ds.write_at = BufferedWriteAt;
+	bs->ds.tell = BufferedTell;
+	bs->ds.seek = BufferedSeek;
+	bs->ds.close = AG_CloseBuffered;
+	bs->ds.flush = BufferedFlush;
+	return (&bs->ds);
+fail:
+	free(bs);
+	return (NULL);
+}
+
+#ifdef HAVE_ZLIB
+/*
+ * zlib stream operations. A compressing stream is write-only and an
+ * inflating stream is read-only. Both are sequential. A compressing stream
+ * holds back the last AG_ZLIB_WINDOW bytes of uncompressed data until it is
+ * flushed or closed, such that AG_WriteAt() can fill in offsets written
+ * shortly before (as AG_ObjectSerialize() does).
+ */
+
+/* Largest chunk passed to zlib in one call (avail_in is a uInt). */
+#define AG_ZLIB_CHUNK_MAX 0x40000000
+
+/* Write out any compressed data accumulated in the output buffer. */
+static int
+ZlibDrain(AG_ZlibSource *_Nonnull zs)
+{
+	z_stream *z = zs->zs;
+	AG_Size len = zs->bufSize - z->avail_out;
+
+	if (len > 0 && AG_Write(zs->sub, zs->buf, len) == -1) {
+		return (-1);
+	}
+	z->next_out = zs->buf;
+	z->avail_out = (uInt)zs->bufSize;
+	return (0);
+}
+
+static int
+ZlibDeflate(AG_ZlibSource *_Nonnull zs, int flush)
+{
+	z_stream *z = zs->zs;
+	int rc;
+
+	for (;;) {
+		if (z->avail_out == 0 && ZlibDrain(zs) == -1) {
+			return (-1);
+		}
+		rc = deflate(z, flush);
+		if (rc == Z_STREAM_ERROR) {
+			AG_SetError("zlib: %s", (z->msg != NULL) ? z->msg :
+			                                           "Stream error");
+			return (-1);
+		}
+		if (flush == Z_FINISH) {
+			if (rc == Z_STREAM_END)
+				break;
+		} else if (flush == Z_NO_FLUSH) {
+			if (z->avail_in == 0)
+				break;
+		} else {
+			if (z->avail_out != 0)
+				break;
+		}
+	}
+	return (0);
+}
+
+/* Compress len bytes of uncompressed data. */
+static int
+ZlibDeflateData(AG_ZlibSource *_Nonnull zs, const Uint8 *_Nullable p,
+    AG_Size len)
+{
+	z_stream *z = zs->zs;
+	AG_Size chunk;
+	int rv = 0;
+
+	while (len > 0) {
+		chunk = MIN(len, AG_ZLIB_CHUNK_MAX);
+		z->next_in = (Uint8 *)p;
+		z->avail_in = (uInt)chunk;
+		if (ZlibDeflate(zs, Z_NO_FLUSH) == -1) {
+			rv = -1;
+			break;
+		}
+		p += chunk;
+		len -= chunk;
+	}
+	z->next_in = NULL;
+	z->avail_in = 0;
+	return (rv);
+}
+
+/* Compress the held data, then apply the given zlib flush mode. */
+static int
+ZlibDeflateHeld(AG_ZlibSource *_Nonnull zs, int flush)
+{
+	int rv;
+
+	rv = ZlibDeflateData(zs, zs->hold, zs->holdLen);
+	zs->holdLen = 0;
+	if (rv == 0 && flush != Z_NO_FLUSH) {
+		rv = ZlibDeflate(zs, flush);
+	}
+	return (rv);
+}
+
+/*
+ * Append to the held data. Once the held data would exceed twice the
+ * window, compress everything but the last AG_ZLIB_WINDOW bytes (so the
+ * hold buffer never grows past 2*AG_ZLIB_WINDOW).
+ */
+static int
+ZlibWrite(AG_DataSource *_Nonnull ds, const void *_Nonnull buf, AG_Size size,
+    AG_Size *_Nonnull rv)
+{
+	AG_ZlibSource *zs = AG_ZLIB_SOURCE(ds);
+	const Uint8 *p = buf;
+	AG_Size nOut, nHold, nCopy = size;
+
+	if (zs->hold == NULL) {
+		if ((zs->hold = TryMalloc(AG_ZLIB_WINDOW << 1)) == NULL) {
+			goto fail;
+		}
+		zs->holdSize = AG_ZLIB_WINDOW << 1;
+	}
+	if (zs->holdLen+size > zs->holdSize) {
+		nOut = zs->holdLen + size - AG_ZLIB_WINDOW;
+		nHold = MIN(nOut, zs->holdLen);
+		if (ZlibDeflateData(zs, zs->hold, nHold) == -1) {
+			goto fail;
+		}
+		memmove(zs->hold, &zs->hold[nHold], zs->holdLen - nHold);
+		zs->holdLen -= nHold;
+		if (ZlibDeflateData(zs, p, nOut - nHold) == -1) {
+			goto fail;
+		}
+		p += (nOut - nHold);
+		nCopy -= (nOut - nHold);
+	}
+	memcpy(&zs->hold[zs->holdLen], p, nCopy);
+	zs->holdLen += nCopy;
+	zs->offs += size;
+	*rv = size;
+	return (0);
+fail:
+	*rv = 0;
+	return (-1);
+}
+
+/* Patch data which has not been compressed yet. */
+static int
+ZlibWriteAt(AG_DataSource *_Nonnull ds, const void *_Nonnull buf,
+    AG_Size size, AG_Offset pos, AG_Size *_Nonnull rv)
+{
+	AG_ZlibSource *zs = AG_ZLIB_SOURCE(ds);
+	const AG_Offset base = zs->offs - (AG_Offset)zs->holdLen;
+
+	if (pos < base || pos + (AG_Offset)size > zs->offs) {
+		AG_SetError("zlib: Cannot write at %ld (compressed or past end)",
+		    (long)pos);
+		*rv = 0;
+		return (-1);
+	}
+	memcpy(&zs->hold[pos - base], buf, size);
+	*rv = size;
+	return (0);
+}
+
+static int
+ZlibRead(AG_DataSource *_Nonnull ds, void *_Nonnull buf, AG_Size size,
+    AG_Size *_Nonnull rv)
+{
+	AG_ZlibSource *zs = AG_ZLIB_SOURCE(ds);
+	z_stream *z = zs->zs;
+	Uint8 *dst = buf;
+	AG_Size nDone = 0, nRead, chunk;
+	int rc;
+
+	while (nDone < size && !zs->eof) {
+		if (z->avail_in == 0) {
+			if (AG_ReadP(zs->sub, zs->buf, zs->bufSize,
+			    &nRead) == -1) {
+				goto fail;
+			}
+			if (nRead == 0) {
+				AG_SetErrorS("zlib: Truncated stream");
+				goto fail;
+			}
+			z->next_in = zs->buf;
+			z->avail_in = (uInt)nRead;
+		}
+		chunk = MIN(size - nDone, AG_ZLIB_CHUNK_MAX);
+		z->next_out = &dst[nDone];
+		z->avail_out = (uInt)chunk;
+		rc = inflate(z, Z_NO_FLUSH);
+		nDone += chunk - z->avail_out;
+		if (rc == Z_STREAM_END) {
+			zs->eof = 1;
+		} else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+			AG_SetError("zlib: %s", (z->msg != NULL) ? z->msg :
+			                                           "Data error");
+			goto fail;
+		}
+	}
+	zs->offs += nDone;
+	*rv = nDone;
+	return (0);
+fail:
+	zs->offs += nDone;
+	*rv = nDone;
+	return (nDone > 0) ? 0 : -1;
+}
+
+static AG_Offset
+ZlibTell(AG_DataSource *_Nonnull ds)
+{
+	return AG_ZLIB_SOURCE(ds)->offs;
+}
+
+/* Only forward seeks are supported (by skipping data on input). */
+static int
+ZlibSeek(AG_DataSource *_Nonnull ds, AG_Offset offs, enum ag_seek_mode mode)
+{
+	AG_ZlibSource *zs = AG_ZLIB_SOURCE(ds);
+	Uint8 skip[256];
+	AG_Offset target;
+	AG_Size nRead;
+
+	switch (mode) {
+	case AG_SEEK_SET:
+		target = offs;
+		break;
+	case AG_SEEK_CUR:
+		target = zs->offs + offs;
+		break;
+	default:
+		AG_SetErrorS(_("Seek not supported by data source"));
+		return (-1);
+	}
+	if (target == zs->offs) {
+		return (0);
+	}
+	if (zs->deflate || target < zs->offs) {
+		AG_SetErrorS(_("Seek not supported by data source"));
+		return (-1);
+	}
+	while (zs->offs < target) {
+		if (ZlibRead(ds, skip, MIN(sizeof(skip), target - zs->offs),
+		    &nRead) == -1) {
+			return (-1);
+		}
+		if (nRead == 0) {
+			AG_SetError("Bad offset %ld", (long)target);
+			return (-1);
+		}
+	}
+	return (0);
+}
+
+static int
+ZlibFlush(AG_DataSource *_Nonnull ds)
+{
+	AG_ZlibSource *zs = AG_ZLIB_SOURCE(ds);
+
+	if (zs->deflate) {
+		if (ZlibDeflateHeld(zs, Z_SYNC_FLUSH) == -1 ||
+		    ZlibDrain(zs) == -1)
+			return (-1);
+	}
+	return AG_Flush(zs->sub);
+}
+
+static AG_DataSource *_Nullable
+OpenZlib(AG_DataSource *_Nonnull sub, int deflate, int level, Uint flags)
+{
+	AG_ZlibSource *zs;
+	z_stream *z;
+	int rc;
+
+	if ((zs = TryMalloc(sizeof(AG_ZlibSource))) == NULL) {
+		return (NULL);
+	}
+	if ((z = zs->zs = TryMalloc(sizeof(z_stream))) == NULL) {
+		goto fail;
+	}
+	zs->bufSize = AG_DATA_SOURCE_BUFSIZE;
+	if ((zs->buf = TryMalloc(zs->bufSize)) == NULL) {
+		goto fail_zs;
+	}
+	memset(z, 0, sizeof(z_stream));
+	if (deflate) {
+		/* Write gzip-compatible streams. */
+		rc = deflateInit2(z, level, Z_DEFLATED, 15+16, 8,
+		    Z_DEFAULT_STRATEGY);
+		z->next_out = zs->buf;
+		z->avail_out = (uInt)zs->bufSize;
+	} else {
+		/* Accept either zlib or gzip streams. */
+		rc = inflateInit2(z, 15+32);
+	}
+	if (rc != Z_OK) {
+		AG_SetError("zlib: %s", (z->msg != NULL) ? z->msg :
+		                                           "Init failed");
+		goto fail_buf;
+	}
+	AG_DataSourceInit(&zs->ds);
+	zs->ds.byte_order = sub->byte_order;
+	zs->ds.debug = sub->debug;
+	zs->sub = sub;
+	zs->offs = 0;
+	zs->hold = NULL;
+	zs->holdLen = 0;
+	zs->holdSize = 0;
+	zs->flags = flags;
+	zs->deflate = deflate;
+	zs->eof = 0;
+	zs->ds.read = deflate ? ReadNotSup : ZlibRead;
+	zs->ds.read_at = ReadAtNotSup;
+	zs->ds.write = deflate ? ZlibWrite : WriteNotSup;
+	zs->ds.write_at = deflate ? ZlibWriteAt : WriteAtNotSup;
+	zs->ds.tell = ZlibTell;
+	zs->ds.seek = ZlibSeek;
+	zs->ds.close = AG_CloseZlib;
+	zs->ds.flush = ZlibFlush;
+	return (&zs->ds);
+fail_buf:
+	free(zs->buf);
+fail_zs:
+	free(zs->zs);
+fail:
+	free(zs);
+	return (NULL);
+}
+#endif /* HAVE_ZLIB */
+
+/*
+ * Create a write-only data source which compresses data (in gzip format)
+ * and writes it to sub. The compression level ranges from 1 (fastest) to
+ * 9 (best). A level of -1 selects the zlib default.
+ */
+AG_DataSource *
+AG_OpenZlibCompress(AG_DataSource *_Nonnull sub, int level, Uint flags)
+{
+#ifdef HAVE_ZLIB
+	return OpenZlib(sub, 1, level, flags);
+#else
+	AG_SetErrorS(_("zlib support not compiled in"));
+	return (NULL);
+#endif
+}
+
+/*
+ * Create a read-only data source which decompresses zlib or gzip
+ * formatted data read from sub.
+ */
+AG_DataSource *
+AG_OpenZlibDecompress(AG_DataSource *_Nonnull sub, Uint flags)
+{
+#ifdef HAVE_ZLIB
+	return OpenZlib(sub, 0, 0, flags);
+#else
+	AG_SetErrorS(_("zlib support not compiled in"));
+	return (NULL);
+#endif
+}
+
+/*
+ * Close a data source created by AG_OpenZlibCompress() or
+ * AG_OpenZlibDecompress(). For compressing streams, this completes the
+ * stream.
+ */
+void
+AG_CloseZlib(AG_DataSource *_Nonnull ds)
+{
+#ifdef HAVE_ZLIB
+	AG_ZlibSource *zs = AG_ZLIB_SOURCE(ds);
+
+	if (zs->deflate) {
+		if (ZlibDeflateHeld(zs, Z_FINISH) == -1 ||
+		    ZlibDrain(zs) == -1) {
+			AG_Verbose("AG_CloseZlib: %s; data lost\n",
+			    AG_GetError());
+		}
+		deflateEnd(zs->zs);
+	} else {
+		inflateEnd(zs->zs);
+	}
+	if (zs->flags & AG_DATA_SOURCE_CLOSE_SUB) {
+		AG_CloseDataSource(zs->sub);
+	}
+	Free(zs->hold);
+	free(zs->buf);
+	free(zs->zs);
+#endif
+	AG_DataSourceDestroy(ds);
+}
+
 /*
  * Select the byte order of a data source. Return the previous setting.
  *
@@ -790,6 +1679,34 @@ AG_ReadAtP(AG_DataSource *_Nonnull ds, void *_Nonnull ptr, AG_Size size, AG_Offs
 	return (rv);
 }
 
+/*
+ * Return a pointer to the next size bytes of the data source and advance
+ * the current position, without copying. Only memory-backed sources
+ * (Core, ConstCore, AutoCore and FileMapped) support this operation.
+ * The pointer remains valid until the data source is closed (or until
+ * the next write for an AutoCore source).
+ */
+const void *
+AG_ReadBorrow(AG_DataSource *_Nonnull ds, AG_Size size)
+{
+	const void *p;
+
+	AG_MutexLock(&ds->lock);
+	if (ds->borrow == NULL) {
+		AG_SetErrorS("Operation not supported");
+		AG_MutexUnlock(&ds->lock);
+		return (NULL);
+	}
+	if ((p = ds->borrow(ds, size)) != NULL) {
+		ds->rdLast = size;
+		ds->rdTotal += size;
+	} else {
+		ds->rdLast = 0;
+	}
+	AG_MutexUnlock(&ds->lock);
+	return (p);
+}
+
 /* Standard write operation (write complete or fail). */
 int
 AG_Write(AG_DataSource *_Nonnull ds, const void *_Nonnull ptr, AG_Size size)
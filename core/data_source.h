@@ -70,8 +70,19 @@ typedef struct ag_data_source {
 	int   (*_Nullable seek)(struct ag_data_source *_Nonnull, AG_Offset,
 	                        enum ag_seek_mode);
 	void  (*_Nullable close)(struct ag_data_source *_Nonnull);
+	const void *_Nullable (*_Nullable borrow)(struct ag_data_source *_Nonnull,
+	                                          AG_Size);
+	int   (*_Nullable flush)(struct ag_data_source *_Nonnull);
 } AG_DataSource;
 
+#ifndef AG_DATA_SOURCE_BUFSIZE		/* Default buffer size for filters */
+# if AG_MODEL == AG_SMALL
+#  define AG_DATA_SOURCE_BUFSIZE 256
+# else
+#  define AG_DATA_SOURCE_BUFSIZE 16384
+# endif
+#endif
+
 /* File */
 typedef struct ag_file_source {
 	struct ag_data_source ds;
@@ -95,6 +106,52 @@ typedef struct ag_const_core_source {
 	AG_Offset offs;			/* Current position */
 } AG_ConstCoreSource;
 
+/* Memory-mapped file (read-only) */
+typedef struct ag_mapped_file_source {
+	struct ag_data_source ds;
+	const Uint8 *_Nonnull data;	/* Mapped file contents */
+	AG_Size size;			/* Size of file */
+	AG_Offset offs;			/* Current position */
+	char *_Nullable path;		/* Mapped file path */
+	int mapped;			/* Contents are mmap()'ed */
+	Uint32 _pad;
+} AG_MappedFileSource;
+
+/* Read-ahead / write-combining buffer over another data source */
+typedef struct ag_buffered_source {
+	struct ag_data_source ds;
+	struct ag_data_source *_Nonnull sub;	/* Underlying data source */
+	Uint8 *_Nonnull rdBuf;			/* Read-ahead buffer */
+	Uint8 *_Nonnull wrBuf;			/* Write-combining buffer */
+	AG_Size bufSize;			/* Size of each buffer (bytes) */
+	AG_Size rdPos;				/* Read position in buffer */
+	AG_Size rdLen;				/* Read-ahead bytes in buffer */
+	AG_Size wrLen;				/* Pending write bytes */
+	Uint flags;
+#define AG_DATA_SOURCE_CLOSE_SUB 0x01		/* Close sub on close */
+	Uint32 _pad;
+} AG_BufferedSource;
+
+/* Uncompressed bytes which AG_WriteAt() can patch in a zlib stream */
+#define AG_ZLIB_WINDOW 0x40000
+
+/* zlib compression or decompression over another data source */
+typedef struct ag_zlib_source {
+	struct ag_data_source ds;
+	struct ag_data_source *_Nonnull sub;	/* Underlying data source */
+	void *_Nonnull zs;			/* zlib stream (z_stream) */
+	Uint8 *_Nonnull buf;			/* Compressed data buffer */
+	AG_Size bufSize;			/* Buffer size (bytes) */
+	AG_Offset offs;				/* Uncompressed position */
+	Uint8 *_Nullable hold;			/* Data not yet compressed */
+	AG_Size holdLen;			/* Held bytes */
+	AG_Size holdSize;			/* Hold buffer size (2*AG_ZLIB_WINDOW) */
+	Uint flags;				/* AG_DATA_SOURCE_* flags */
+	int deflate;				/* Compressing (not inflating) */
+	int eof;				/* End of stream reached */
+	Uint32 _pad;
+} AG_ZlibSource;
+
 /* Network socket */
 typedef struct ag_net_socket_source {
 	struct ag_data_source ds;
@@ -105,6 +162,9 @@ typedef struct ag_net_socket_source {
 #define AG_FILE_SOURCE(ds) ((AG_FileSource *)(ds))
 #define AG_CORE_SOURCE(ds) ((AG_CoreSource *)(ds))
 #define AG_CONST_CORE_SOURCE(ds) ((AG_ConstCoreSource *)(ds))
+#define AG_BUFFERED_SOURCE(ds) ((AG_BufferedSource *)(ds))
+#define AG_ZLIB_SOURCE(ds) ((AG_ZlibSource *)(ds))
+#define AG_MAPPED_FILE_SOURCE(ds) ((AG_MappedFileSource *)(ds))
 #define AG_NET_SOCKET_SOURCE(ds) ((AG_NetSocketSource *)(ds))
 
 /* For AG_Write<Type>At() */
@@ -131,16 +191,24 @@ int          AG_SetSourceDebug(AG_DataSource *_Nonnull, int);
 AG_DataSource *_Nullable AG_OpenFile(const char *_Nonnull, const char *_Nonnull)
                                      _Warn_Unused_Result;
 AG_DataSource *_Nullable AG_OpenFileHandle(void *_Nonnull) _Warn_Unused_Result;
+AG_DataSource *_Nullable AG_OpenFileMapped(const char *_Nonnull) _Warn_Unused_Result;
 AG_DataSource *_Nullable AG_OpenCore(void *_Nonnull, AG_Size) _Warn_Unused_Result;
 AG_DataSource *_Nullable AG_OpenConstCore(const void *_Nonnull, AG_Size) _Warn_Unused_Result;
 AG_DataSource *_Nullable AG_OpenAutoCore(void) _Warn_Unused_Result;
 AG_DataSource *_Nullable AG_OpenNetSocket(struct ag_net_socket *_Nonnull) _Warn_Unused_Result;
+AG_DataSource *_Nullable AG_OpenBuffered(AG_DataSource *_Nonnull, AG_Size, Uint)
+                                         _Warn_Unused_Result;
+AG_DataSource *_Nullable AG_OpenZlibCompress(AG_DataSource *_Nonnull, int, Uint)
+                                             _Warn_Unused_Result;
+AG_DataSource *_Nullable AG_OpenZlibDecompress(AG_DataSource *_Nonnull, Uint)
+                                               _Warn_Unused_Result;
 
 int AG_Read(AG_DataSource *_Nonnull, void *_Nonnull, AG_Size);
 int AG_ReadP(AG_DataSource *_Nonnull, void *_Nonnull, AG_Size, AG_Size *_Nonnull);
 int AG_ReadAt(AG_DataSource *_Nonnull, void *_Nonnull, AG_Size, AG_Offset);
 int AG_ReadAtP(AG_DataSource *_Nonnull, void *_Nonnull, AG_Size, AG_Offset,
 	       AG_Size *_Nullable);
+const void *_Nullable AG_ReadBorrow(AG_DataSource *_Nonnull, AG_Size);
 
 int AG_Write(AG_DataSource *_Nonnull, const void *_Nonnull, AG_Size);
 int AG_WriteP(AG_DataSource *_Nonnull, const void *_Nonnull, AG_Size, AG_Size *_Nullable);
@@ -150,10 +218,13 @@ int AG_WriteAtP(AG_DataSource *_Nonnull, const void *_Nonnull, AG_Size, AG_Offse
 
 void    AG_CloseFile(AG_DataSource *_Nonnull);
 void    AG_CloseFileHandle(AG_DataSource *_Nonnull);
+void    AG_CloseFileMapped(AG_DataSource *_Nonnull);
 void    AG_CloseCore(AG_DataSource *_Nonnull);
 #define AG_CloseConstCore(ds) AG_CloseCore(ds)
 void    AG_CloseAutoCore(AG_DataSource *_Nonnull);
 void    AG_CloseNetSocket(AG_DataSource *_Nonnull);
+void    AG_CloseBuffered(AG_DataSource *_Nonnull);
+void    AG_CloseZlib(AG_DataSource *_Nonnull);
 
 void    AG_WriteTypeCode(AG_DataSource *_Nonnull, Uint32);
 void    AG_WriteTypeCodeAt(AG_DataSource *_Nonnull, Uint32, AG_Offset);
@@ -166,6 +237,7 @@ int     AG_CheckTypeCode(AG_DataSource *_Nonnull, Uint32);
 int       AG_DataSourceRealloc(void *_Nonnull, AG_Size);
 AG_Offset AG_Tell(AG_DataSource *_Nonnull);
 int       AG_Seek(AG_DataSource *_Nonnull, AG_Offset, enum ag_seek_mode);
+int       AG_Flush(AG_DataSource *_Nonnull);
 void      AG_CloseDataSource(AG_DataSource *_Nonnull);
 void      AG_DataSourceDestroy(AG_DataSource *_Nonnull);
 __END_DECLS
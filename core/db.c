@@ -36,10 +36,13 @@ AG_DbNew(const char *_Nonnull backend)
 	AG_Db *db;
 	AG_DbClass *dbc = NULL;
 
+	if (strcmp(backend, "file") == 0) {
+		dbc = &agDbFileClass;
+	}
 #if defined(HAVE_DB4)
-	if (strcmp(backend, "hash")) {
+	else if (strcmp(backend, "hash") == 0) {
 		dbc = &agDbHashClass;
-	} else if (strcmp(backend, "btree")) {
+	} else if (strcmp(backend, "btree") == 0) {
 		dbc = &agDbBtreeClass;
 	}
 #endif
@@ -47,7 +50,7 @@ AG_DbNew(const char *_Nonnull backend)
 		AG_SetError("No such database backend: %s", backend);
 		return (NULL);
 	}
-	if ((db = TryMalloc(sizeof(AG_Db))) == NULL) {
+	if ((db = TryMalloc(dbc->_inherit.size)) == NULL) {
 		return (NULL);
 	}
 	AG_ObjectInit(db, dbc);
@@ -70,7 +73,7 @@ AG_DbOpen(AG_Db *db, const char *path, Uint flags)
 	if (rv != 0) {
 		goto fail;
 	}
-	db->flags |= AG_DB_OPEN;
+	db->flags |= AG_DB_OPEN | (flags & AG_DB_READONLY);
 	AG_ObjectUnlock(db);
 	return (0);
 fail:
@@ -89,7 +92,7 @@ AG_DbClose(AG_Db *db)
 		if (dbc->close != NULL) {
 			dbc->close(db);
 		}
-		db->flags &= ~(AG_DB_OPEN);
+		db->flags &= ~(AG_DB_OPEN | AG_DB_READONLY);
 	}
 	AG_ObjectUnlock(db);
 }
@@ -69,6 +69,7 @@ typedef struct ag_db {
 
 __BEGIN_DECLS
 extern AG_DbClass agDbClass;
+extern AG_DbClass agDbFileClass;
 extern AG_DbClass agDbHashClass;
 extern AG_DbClass agDbBtreeClass;
 extern AG_DbClass agDbMySQLClass;
@@ -0,0 +1,948 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Built-in single-file database backend ("file").
+ *
+ * The file is an append-only log of records, grouped into batches which
+ * are terminated by a commit record carrying the CRC32 of the batch. A
+ * batch is either entirely replayed when the file is opened, or discarded
+ * (along with anything following it). An in-memory hash table maps keys
+ * to the offset of their latest record. Reads are served from a mapping
+ * of the file (where mmap() is available) or from the pending batch.
+ *
+ *	Header:  "AGDB" version:32
+ *	Record:  keyLen:32 valLen:32 key[keyLen] val[valLen]
+ *	Delete:  keyLen:32 0xffffffff key[keyLen]
+ *	Commit:  0:32 crc32:32
+ *
+ * All integers are little-endian. Sync compacts the log by rewriting the
+ * live records to a new file once more than half of it is garbage.
+ */
+
+#include <agar/config/ag_serialization.h>
+#ifdef AG_SERIALIZATION
+
+#include <agar/core/crc32.h>
+#include <agar/core/core.h>
+#include <agar/config/have_mmap.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef _WIN32
+# include <io.h>
+#else
+# include <sys/types.h>
+# include <unistd.h>
+#endif
+#ifdef HAVE_MMAP
+# include <sys/mman.h>
+#endif
+
+#define DBFILE_MAGIC      "AGDB"
+#define DBFILE_VERSION    1
+#define DBFILE_HDR_SIZE   8
+#define DBFILE_REC_SIZE   8			/* Record header size */
+#define DBFILE_TOMBSTONE  0xffffffffU		/* valLen of deletions */
+#define DBFILE_COMPACT_MIN 65536		/* Minimum size to compact */
+
+/* Index entry (hash 0 = empty slot). */
+typedef struct ag_db_file_ent {
+	Uint32 hash;			/* Key hash */
+	Uint32 keyLen;			/* Key size in bytes */
+	Uint32 valLen;			/* Value size in bytes */
+	Uint32 _pad;
+	AG_Size off;			/* Offset of latest record in log */
+} AG_DbFileEnt;
+
+typedef struct ag_db_file {
+	struct ag_db _inherit;
+	char *_Nullable path;		/* Database file */
+	FILE *_Nullable f;
+	const Uint8 *_Nullable map;	/* Mapping of the committed log */
+	AG_Size mapSize;
+	AG_Size fileSize;		/* Committed log size */
+	AG_Size liveBytes;		/* Bytes of live records */
+	Uint8 *_Nullable batch;		/* Pending (uncommitted) records */
+	AG_Size batchLen, batchMax;
+	AG_DbFileEnt *_Nullable ents;	/* Index (open addressing) */
+	Uint nEnts, maxEnts;
+} AG_DbFile;
+
+static __inline__ void
+Put32(Uint8 *p, Uint32 v)
+{
+	p[0] = (Uint8)(v);
+	p[1] = (Uint8)(v >> 8);
+	p[2] = (Uint8)(v >> 16);
+	p[3] = (Uint8)(v >> 24);
+}
+
+static __inline__ Uint32
+Get32(const Uint8 *p)
+{
+	return ((Uint32)p[0]) | ((Uint32)p[1] << 8) |
+	       ((Uint32)p[2] << 16) | ((Uint32)p[3] << 24);
+}
+
+/* Hash a key (never 0). */
+static __inline__ Uint32
+HashKey(const void *_Nonnull key, AG_Size len)
+{
+	const Uint32 h = AG_HashBuffer(key, len);
+
+	return (h != 0) ? h : 1;
+}
+
+static __inline__ AG_Size
+RecordSize(Uint32 keyLen, Uint32 valLen)
+{
+	return (DBFILE_REC_SIZE + keyLen +
+	        ((valLen != DBFILE_TOMBSTONE) ? valLen : 0));
+}
+
+/*
+ * Return a pointer to len bytes of the log at off, if they are in memory
+ * (mapped or pending). Otherwise read them into buf and return buf.
+ */
+static const Uint8 *_Nullable
+LogData(AG_DbFile *_Nonnull db, AG_Size off, AG_Size len, Uint8 *_Nullable buf)
+{
+	if (off >= db->fileSize) {
+		return &db->batch[off - db->fileSize];
+	}
+	if (off + len <= db->mapSize) {
+		return &db->map[off];
+	}
+	if (buf == NULL || db->f == NULL ||
+	    fseek(db->f, (long)off, SEEK_SET) != 0 ||
+	    fread(buf, 1, len, db->f) != len) {
+		AG_SetError("%s: Read error", db->path);
+		return (NULL);
+	}
+	return (buf);
+}
+
+/* Compare a key against the key of the record at off. */
+static int
+KeyEquals(AG_DbFile *_Nonnull db, const AG_DbFileEnt *_Nonnull ent,
+    const AG_Dbt *_Nonnull key)
+{
+	const Uint8 *k;
+	Uint8 *buf = NULL;
+	int rv;
+
+	if (ent->off + DBFILE_REC_SIZE + ent->keyLen > db->mapSize &&
+	    ent->off < db->fileSize &&
+	    (buf = TryMalloc(ent->keyLen + 1)) == NULL) {
+		return (0);
+	}
+	k = LogData(db, ent->off + DBFILE_REC_SIZE, ent->keyLen, buf);
+	rv = (k != NULL && memcmp(k, key->data, key->size) == 0);
+	Free(buf);
+	return (rv);
+}
+
+/* Look up a key in the index. Return the slot or -1. */
+static int
+IndexFind(AG_DbFile *_Nonnull db, const AG_Dbt *_Nonnull key, Uint32 h)
+{
+	const Uint mask = db->maxEnts - 1;
+	Uint i;
+
+	if (db->maxEnts == 0) {
+		return (-1);
+	}
+	for (i = h & mask; db->ents[i].hash != 0; i = (i+1) & mask) {
+		const AG_DbFileEnt *ent = &db->ents[i];
+
+		if (ent->hash == h && ent->keyLen == key->size &&
+		    KeyEquals(db, ent, key))
+			return (int)i;
+	}
+	return (-1);
+}
+
+/* Grow the index to the given size (a power of 2). */
+static int
+IndexResize(AG_DbFile *_Nonnull db, Uint maxNew)
+{
+	AG_DbFileEnt *entsNew;
+	const Uint mask = maxNew - 1;
+	Uint i, j;
+
+	if ((entsNew = TryMalloc(maxNew*sizeof(AG_DbFileEnt))) == NULL) {
+		return (-1);
+	}
+	memset(entsNew, 0, maxNew*sizeof(AG_DbFileEnt));
+	for (i = 0; i < db->maxEnts; i++) {
+		if (db->ents[i].hash == 0) {
+			continue;
+		}
+		for (j = db->ents[i].hash & mask;
+		     entsNew[j].hash != 0;
+		     j = (j+1) & mask)
+			;;
+		entsNew[j] = db->ents[i];
+	}
+	Free(db->ents);
+	db->ents = entsNew;
+	db->maxEnts = maxNew;
+	return (0);
+}
+
+/* Point key at the record at off (inserting it if needed). */
+static int
+IndexPut(AG_DbFile *_Nonnull db, const AG_Dbt *_Nonnull key, Uint32 valLen,
+    AG_Size off)
+{
+	const Uint32 h = HashKey(key->data, key->size);
+	AG_DbFileEnt *ent;
+	int i;
+	Uint j;
+
+	if ((i = IndexFind(db, key, h)) != -1) {
+		ent = &db->ents[i];
+		db->liveBytes -= RecordSize(ent->keyLen, ent->valLen);
+	} else {
+		if ((db->nEnts+1)*4 > db->maxEnts*3 &&
+		    IndexResize(db, (db->maxEnts > 0) ? db->maxEnts<<1 : 64) == -1) {
+			return (-1);
+		}
+		for (j = h & (db->maxEnts-1);
+		     db->ents[j].hash != 0;
+		     j = (j+1) & (db->maxEnts-1))
+			;;
+		ent = &db->ents[j];
+		ent->hash = h;
+		ent->keyLen = (Uint32)key->size;
+		db->nEnts++;
+	}
+	ent->valLen = valLen;
+	ent->off = off;
+	db->liveBytes += RecordSize(ent->keyLen, valLen);
+	return (0);
+}
+
+/* Remove a slot from the index (backward shift deletion). */
+static void
+IndexRemove(AG_DbFile *_Nonnull db, Uint i)
+{
+	const Uint mask = db->maxEnts - 1;
+	Uint j, k;
+
+	db->liveBytes -= RecordSize(db->ents[i].keyLen, db->ents[i].valLen);
+	for (j = (i+1) & mask; db->ents[j].hash != 0; j = (j+1) & mask) {
+		k = db->ents[j].hash & mask;
+		if ((j > i && (k <= i || k > j)) ||
+		    (j < i && (k <= i && k > j))) {
+			db->ents[i] = db->ents[j];
+			i = j;
+		}
+	}
+	db->ents[i].hash = 0;
+	db->nEnts--;
+}
+
+/* Replay the committed batches of a log held in memory. */
+static AG_Size
+Replay(AG_DbFile *_Nonnull db, const Uint8 *_Nonnull log, AG_Size size)
+{
+	AG_Size pos = DBFILE_HDR_SIZE, start = DBFILE_HDR_SIZE, p;
+
+	while (pos + DBFILE_REC_SIZE <= size) {
+		const Uint32 keyLen = Get32(&log[pos]);
+		const Uint32 valLen = Get32(&log[pos+4]);
+		AG_Size len;
+
+		if (keyLen != 0) {
+			len = RecordSize(keyLen, valLen);
+			if (len > size - pos) {
+				break;				/* Truncated */
+			}
+			pos += len;
+			continue;
+		}
+		if (AG_GetCRC32(&log[start], pos - start) != valLen)
+			break;					/* Corrupt */
+
+		for (p = start; p < pos; ) {
+			AG_Dbt key;
+			const Uint32 kLen = Get32(&log[p]);
+			const Uint32 vLen = Get32(&log[p+4]);
+			int i;
+
+			key.data = (void *)&log[p + DBFILE_REC_SIZE];
+			key.size = kLen;
+			if (vLen == DBFILE_TOMBSTONE) {
+				if ((i = IndexFind(db, &key,
+				    HashKey(key.data, key.size))) != -1)
+					IndexRemove(db, (Uint)i);
+			} else {
+				if (IndexPut(db, &key, vLen, p) == -1)
+					return (0);
+			}
+			p += RecordSize(kLen, vLen);
+		}
+		pos += DBFILE_REC_SIZE;
+		start = pos;
+	}
+	return (start);
+}
+
+static void
+Unmap(AG_DbFile *_Nonnull db)
+{
+#ifdef HAVE_MMAP
+	if (db->map != NULL)
+		munmap((void *)db->map, db->mapSize);
+#endif
+	db->map = NULL;
+	db->mapSize = 0;
+}
+
+/* Map the committed log into memory (if mmap() is available). */
+static void
+Remap(AG_DbFile *_Nonnull db)
+{
+#ifdef HAVE_MMAP
+	void *p;
+
+	Unmap(db);
+	if (db->fileSize == 0 || db->f == NULL) {
+		return;
+	}
+	p = mmap(NULL, db->fileSize, PROT_READ, MAP_SHARED, fileno(db->f), 0);
+	if (p != MAP_FAILED) {
+		db->map = p;
+		db->mapSize = db->fileSize;
+	}
+#endif
+}
+
+static int
+TruncateFile(FILE *_Nonnull f, AG_Size size)
+{
+	fflush(f);
+#ifdef _WIN32
+	return (_chsize_s(_fileno(f), (__int64)size) == 0) ? 0 : -1;
+#else
+	return ftruncate(fileno(f), (off_t)size);
+#endif
+}
+
+static int
+SyncFile(FILE *_Nonnull f)
+{
+	if (fflush(f) != 0) {
+		return (-1);
+	}
+#ifdef _WIN32
+	return _commit(_fileno(f));
+#else
+	return fsync(fileno(f));
+#endif
+}
+
+/* Append records and their commit record to a file at off. */
+static int
+WriteBatch(FILE *_Nonnull f, AG_Size off, const Uint8 *_Nonnull data,
+    AG_Size len)
+{
+	Uint8 commit[DBFILE_REC_SIZE];
+
+	Put32(&commit[0], 0);
+	Put32(&commit[4], AG_GetCRC32(data, len));
+	if (fseek(f, (long)off, SEEK_SET) != 0 ||
+	    fwrite(data, 1, len, f) != len ||
+	    fwrite(commit, 1, sizeof(commit), f) != sizeof(commit) ||
+	    fflush(f) != 0) {
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Fail if the database file is not open (which happens if it could not be
+ * reopened after a compaction).
+ */
+static int
+CheckFile(AG_DbFile *_Nonnull db)
+{
+	if (db->f == NULL) {
+		AG_SetError("%s: Database file is not open", db->path);
+		return (-1);
+	}
+	return (0);
+}
+
+/* Commit the pending batch to the file. */
+static int
+Flush(AG_DbFile *_Nonnull db)
+{
+	if (db->batchLen == 0) {
+		return (0);
+	}
+	if (CheckFile(db) == -1) {
+		return (-1);
+	}
+	if (WriteBatch(db->f, db->fileSize, db->batch, db->batchLen) == -1) {
+		AG_SetError("%s: %s", db->path, AG_Strerror(errno));
+		(void)TruncateFile(db->f, db->fileSize);
+		return (-1);
+	}
+	db->fileSize += db->batchLen + DBFILE_REC_SIZE;
+	db->batchLen = 0;
+	Remap(db);
+	return (0);
+}
+
+/* Append a record to the pending batch. */
+static int
+AppendRecord(AG_DbFile *_Nonnull db, const AG_Dbt *_Nonnull key,
+    const AG_Dbt *_Nullable val, AG_Size *_Nonnull off)
+{
+	const Uint32 valLen = (val != NULL) ? (Uint32)val->size :
+	                                      DBFILE_TOMBSTONE;
+	const AG_Size len = RecordSize((Uint32)key->size, valLen);
+	Uint8 *p;
+
+	if (key->size == 0 || key->size >= DBFILE_TOMBSTONE ||
+	    (val != NULL && val->size >= DBFILE_TOMBSTONE)) {
+		AG_SetErrorS("Bad key or value size");
+		return (-1);
+	}
+	if (db->batchLen + len > db->batchMax) {
+		AG_Size maxNew = (db->batchMax > 0) ? db->batchMax : 4096;
+		Uint8 *batchNew;
+
+		while (maxNew < db->batchLen + len) {
+			maxNew <<= 1;
+		}
+		if ((batchNew = TryRealloc(db->batch, maxNew)) == NULL) {
+			return (-1);
+		}
+		db->batch = batchNew;
+		db->batchMax = maxNew;
+	}
+	p = &db->batch[db->batchLen];
+	Put32(&p[0], (Uint32)key->size);
+	Put32(&p[4], valLen);
+	memcpy(&p[DBFILE_REC_SIZE], key->data, key->size);
+	if (val != NULL && val->size > 0) {
+		memcpy(&p[DBFILE_REC_SIZE + key->size], val->data, val->size);
+	}
+	*off = db->fileSize + db->batchLen;
+	db->batchLen += len;
+	return (0);
+}
+
+/* Commit the batch if it has reached db-batch-size. */
+static int
+FlushIfFull(AG_DbFile *_Nonnull db)
+{
+	if (db->batchLen >= (AG_Size)AG_GetUint(db, "db-batch-size")) {
+		return Flush(db);
+	}
+	return (0);
+}
+
+/* Rewrite the live records to a new file, replacing the database file. */
+static int
+Compact(AG_DbFile *_Nonnull db)
+{
+	Uint8 hdr[DBFILE_HDR_SIZE], *buf, *rec;
+	AG_Size *offs, pos = DBFILE_HDR_SIZE, bufLen = 0;
+	const AG_Size bufMax = AG_GetUint(db, "db-batch-size");
+	char *pathTmp;
+	FILE *f, *fNew;
+	Uint i;
+
+	if (Flush(db) == -1 || CheckFile(db) == -1) {
+		return (-1);
+	}
+	if ((offs = TryMalloc((db->maxEnts + 1)*sizeof(AG_Size))) == NULL) {
+		return (-1);
+	}
+	if ((buf = TryMalloc(bufMax + DBFILE_REC_SIZE)) == NULL) {
+		free(offs);
+		return (-1);
+	}
+	if ((pathTmp = TryStrdup(db->path)) == NULL ||
+	    (pathTmp = TryRealloc(pathTmp, strlen(db->path)+5)) == NULL) {
+		free(buf);
+		free(offs);
+		return (-1);
+	}
+	Strlcat(pathTmp, ".tmp", strlen(db->path)+5);
+	if ((f = fopen(pathTmp, "w+b")) == NULL) {
+		AG_SetError("%s: %s", pathTmp, AG_Strerror(errno));
+		goto fail;
+	}
+	memcpy(hdr, DBFILE_MAGIC, 4);
+	Put32(&hdr[4], DBFILE_VERSION);
+	if (fwrite(hdr, 1, sizeof(hdr), f) != sizeof(hdr))
+		goto fail_write;
+
+	for (i = 0; i < db->maxEnts; i++) {
+		const AG_DbFileEnt *ent = &db->ents[i];
+		const AG_Size len = RecordSize(ent->keyLen, ent->valLen);
+
+		if (ent->hash == 0) {
+			continue;
+		}
+		if (bufLen > 0 && bufLen + len > bufMax) {
+			if (WriteBatch(f, pos, buf, bufLen) == -1) {
+				goto fail_write;
+			}
+			pos += bufLen + DBFILE_REC_SIZE;
+			bufLen = 0;
+		}
+		if (len > bufMax) {
+			/* Oversized record: Write it in a batch of its own. */
+			if ((rec = TryMalloc(len)) == NULL ||
+			    LogData(db, ent->off, len, rec) != rec ||
+			    WriteBatch(f, pos, rec, len) == -1) {
+				Free(rec);
+				goto fail_write;
+			}
+			free(rec);
+			offs[i] = pos;
+			pos += len + DBFILE_REC_SIZE;
+			continue;
+		}
+		if ((rec = (Uint8 *)LogData(db, ent->off, len, &buf[bufLen]))
+		    == NULL) {
+			goto fail_write;
+		}
+		if (rec != &buf[bufLen]) {
+			memcpy(&buf[bufLen], rec, len);
+		}
+		offs[i] = pos + bufLen;
+		bufLen += len;
+	}
+	if (bufLen > 0) {
+		if (WriteBatch(f, pos, buf, bufLen) == -1) {
+			goto fail_write;
+		}
+		pos += bufLen + DBFILE_REC_SIZE;
+	}
+	if (SyncFile(f) != 0) {
+		goto fail_write;
+	}
+	fclose(f);
+
+	Unmap(db);
+#ifdef _WIN32
+	/* An open file cannot be replaced. */
+	fclose(db->f);
+	db->f = NULL;
+	remove(db->path);
+#endif
+	if (rename(pathTmp, db->path) != 0) {
+		AG_SetError("%s: %s", db->path, AG_Strerror(errno));
+		remove(pathTmp);
+#ifdef _WIN32
+		db->f = fopen(db->path, "r+b");
+#endif
+		Remap(db);			/* Keep using the old file */
+		free(pathTmp);
+		free(buf);
+		free(offs);
+		return (-1);
+	}
+	if ((fNew = fopen(db->path, "r+b")) == NULL) {
+		/*
+		 * The old file (if still open) was replaced and further
+		 * writes to it would be lost. Fail all further operations.
+		 */
+		AG_SetError("%s: %s", db->path, AG_Strerror(errno));
+		if (db->f != NULL) {
+			fclose(db->f);
+			db->f = NULL;
+		}
+		free(pathTmp);
+		free(buf);
+		free(offs);
+		return (-1);
+	}
+	if (db->f != NULL) {
+		fclose(db->f);
+	}
+	db->f = fNew;
+	for (i = 0; i < db->maxEnts; i++) {
+		if (db->ents[i].hash != 0)
+			db->ents[i].off = offs[i];
+	}
+	db->fileSize = pos;
+	Remap(db);
+
+	free(pathTmp);
+	free(buf);
+	free(offs);
+	return (0);
+fail_write:
+	AG_SetError("%s: %s", pathTmp, AG_Strerror(errno));
+	fclose(f);
+	remove(pathTmp);
+fail:
+	free(pathTmp);
+	free(buf);
+	free(offs);
+	return (-1);
+}
+
+static void
+Init(void *_Nonnull obj)
+{
+	AG_DbFile *db = obj;
+
+	db->path = NULL;
+	db->f = NULL;
+	db->map = NULL;
+	db->mapSize = 0;
+	db->fileSize = 0;
+	db->liveBytes = 0;
+	db->batch = NULL;
+	db->batchLen = 0;
+	db->batchMax = 0;
+	db->ents = NULL;
+	db->nEnts = 0;
+	db->maxEnts = 0;
+
+	AG_SetInt(db, "db-create", 1);
+	AG_SetInt(db, "db-truncate", 0);
+	AG_SetInt(db, "db-fsync", 1);
+	AG_SetUint(db, "db-batch-size", 262144);
+}
+
+static int
+Open(void *_Nonnull obj, const char *_Nonnull path, Uint flags)
+{
+	AG_DbFile *db = obj;
+	const int readOnly = (flags & AG_DB_READONLY);
+	Uint8 hdr[DBFILE_HDR_SIZE], *log = NULL;
+	AG_Size size, committed;
+	long len;
+
+	if (AG_GetInt(db, "db-truncate") && !readOnly) {
+		db->f = fopen(path, "w+b");
+	} else if ((db->f = fopen(path, readOnly ? "rb" : "r+b")) == NULL &&
+	           errno == ENOENT && AG_GetInt(db, "db-create") && !readOnly) {
+		db->f = fopen(path, "w+b");
+	}
+	if (db->f == NULL) {
+		AG_SetError("%s: %s", path, AG_Strerror(errno));
+		return (-1);
+	}
+	if ((db->path = TryStrdup(path)) == NULL) {
+		goto fail;
+	}
+	if (fseek(db->f, 0, SEEK_END) != 0 || (len = ftell(db->f)) < 0) {
+		AG_SetError("%s: %s", path, AG_Strerror(errno));
+		goto fail;
+	}
+	size = (AG_Size)len;
+
+	if (size < DBFILE_HDR_SIZE) {				/* New database */
+		if (readOnly) {
+			AG_SetError("%s: Not a database file", path);
+			goto fail;
+		}
+		memcpy(hdr, DBFILE_MAGIC, 4);
+		Put32(&hdr[4], DBFILE_VERSION);
+		if (fseek(db->f, 0, SEEK_SET) != 0 ||
+		    fwrite(hdr, 1, sizeof(hdr), db->f) != sizeof(hdr) ||
+		    TruncateFile(db->f, sizeof(hdr)) != 0) {
+			AG_SetError("%s: %s", path, AG_Strerror(errno));
+			goto fail;
+		}
+		db->fileSize = DBFILE_HDR_SIZE;
+		Remap(db);
+		return (0);
+	}
+
+	db->fileSize = size;
+	Remap(db);
+	if (db->map == NULL) {
+		if ((log = TryMalloc(size)) == NULL) {
+			goto fail;
+		}
+		if (fseek(db->f, 0, SEEK_SET) != 0 ||
+		    fread(log, 1, size, db->f) != size) {
+			AG_SetError("%s: Read error", path);
+			goto fail;
+		}
+	}
+	if (memcmp((log != NULL) ? log : db->map, DBFILE_MAGIC, 4) != 0 ||
+	    Get32(((log != NULL) ? log : db->map) + 4) != DBFILE_VERSION) {
+		AG_SetError("%s: Not a database file (or bad version)", path);
+		goto fail;
+	}
+	committed = Replay(db, (log != NULL) ? log : db->map, size);
+	Free(log);
+	log = NULL;
+	if (committed == 0) {
+		goto fail;
+	}
+	if (committed < size) {
+		/* Discard the incomplete or damaged batch at the end. */
+		if (!readOnly && TruncateFile(db->f, committed) != 0) {
+			AG_SetError("%s: %s", path, AG_Strerror(errno));
+			goto fail;
+		}
+		db->fileSize = committed;
+	}
+	return (0);
+fail:
+	Free(log);
+	Unmap(db);
+	fclose(db->f);
+	db->f = NULL;
+	Free(db->ents);
+	db->ents = NULL;
+	db->nEnts = 0;
+	db->maxEnts = 0;
+	db->liveBytes = 0;
+	Free(db->path);
+	db->path = NULL;
+	return (-1);
+}
+
+static void
+Close(void *_Nonnull obj)
+{
+	AG_DbFile *db = obj;
+
+	if (Flush(db) == -1) {
+		AG_Verbose("%s; ignoring\n", AG_GetError());
+	} else if (AG_GetInt(db, "db-fsync") && db->batch != NULL &&
+	           db->f != NULL) {
+		(void)SyncFile(db->f);
+	}
+	Unmap(db);
+	if (db->f != NULL) {
+		fclose(db->f);
+		db->f = NULL;
+	}
+	Free(db->batch);
+	db->batch = NULL;
+	db->batchLen = 0;
+	db->batchMax = 0;
+	Free(db->ents);
+	db->ents = NULL;
+	db->nEnts = 0;
+	db->maxEnts = 0;
+	db->liveBytes = 0;
+	db->fileSize = 0;
+	Free(db->path);
+	db->path = NULL;
+}
+
+/*
+ * Commit the pending batch (and flush it to disk if db-fsync is set).
+ * Compact the file if most of it is garbage.
+ */
+static int
+Sync(void *_Nonnull obj)
+{
+	AG_DbFile *db = obj;
+
+	if (db->path == NULL || (AGDB(db)->flags & AG_DB_READONLY)) {
+		return (0);				/* Not open */
+	}
+	if (Flush(db) == -1 || CheckFile(db) == -1) {
+		return (-1);
+	}
+	if (db->fileSize > DBFILE_COMPACT_MIN &&
+	    db->liveBytes*2 < db->fileSize - DBFILE_HDR_SIZE) {
+		return Compact(db);
+	}
+	if (AG_GetInt(db, "db-fsync") && SyncFile(db->f) != 0) {
+		AG_SetError("%s: %s", db->path, AG_Strerror(errno));
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+Exists(void *_Nonnull obj, const AG_Dbt *_Nonnull key)
+{
+	AG_DbFile *db = obj;
+
+	return (IndexFind(db, key, HashKey(key->data, key->size)) != -1);
+}
+
+static int
+Get(void *_Nonnull obj, const AG_Dbt *_Nonnull key, AG_Dbt *_Nonnull val)
+{
+	AG_DbFile *db = obj;
+	const AG_DbFileEnt *ent;
+	const Uint8 *data;
+	int i;
+
+	if ((i = IndexFind(db, key, HashKey(key->data, key->size))) == -1) {
+		AG_SetErrorS("No such key");
+		return (-1);
+	}
+	ent = &db->ents[i];
+	if ((val->data = TryMalloc(ent->valLen + 1)) == NULL) {
+		return (-1);
+	}
+	data = LogData(db, ent->off + DBFILE_REC_SIZE + ent->keyLen,
+	    ent->valLen, val->data);
+	if (data == NULL) {
+		free(val->data);
+		return (-1);
+	}
+	if (data != val->data) {
+		memcpy(val->data, data, ent->valLen);
+	}
+	val->size = ent->valLen;
+	return (0);
+}
+
+static int
+Put(void *_Nonnull obj, const AG_Dbt *_Nonnull key, const AG_Dbt *_Nonnull val)
+{
+	AG_DbFile *db = obj;
+	AG_Size off;
+
+	if (AGDB(db)->flags & AG_DB_READONLY) {
+		AG_SetErrorS("Database is read-only");
+		return (-1);
+	}
+	if (AppendRecord(db, key, val, &off) == -1) {
+		return (-1);
+	}
+	if (IndexPut(db, key, (Uint32)val->size, off) == -1) {
+		db->batchLen = off - db->fileSize;
+		return (-1);
+	}
+	return FlushIfFull(db);
+}
+
+static int
+Del(void *_Nonnull obj, const AG_Dbt *_Nonnull key)
+{
+	AG_DbFile *db = obj;
+	AG_Size off;
+	int i;
+
+	if (AGDB(db)->flags & AG_DB_READONLY) {
+		AG_SetErrorS("Database is read-only");
+		return (-1);
+	}
+	if ((i = IndexFind(db, key, HashKey(key->data, key->size))) == -1) {
+		AG_SetErrorS("No such key");
+		return (-1);
+	}
+	if (AppendRecord(db, key, NULL, &off) == -1) {
+		return (-1);
+	}
+	IndexRemove(db, (Uint)i);
+	return FlushIfFull(db);
+}
+
+/*
+ * Iterate over all entries (in no particular order). The key and value
+ * are only valid for the duration of the call, and the database must
+ * not be modified from fn.
+ */
+static int
+Iterate(void *_Nonnull obj, AG_DbIterateFn fn, void *_Nullable arg)
+{
+	AG_DbFile *db = obj;
+	Uint8 *buf = NULL;
+	AG_Size bufSize = 0;
+	Uint i;
+	int rv = 0;
+
+	for (i = 0; i < db->maxEnts; i++) {
+		const AG_DbFileEnt *ent = &db->ents[i];
+		const AG_Size len = DBFILE_REC_SIZE + ent->keyLen + ent->valLen;
+		const Uint8 *rec;
+		AG_Dbt key, val;
+
+		if (ent->hash == 0) {
+			continue;
+		}
+		if (ent->off + len > db->mapSize && ent->off < db->fileSize &&
+		    len > bufSize) {
+			Uint8 *bufNew;
+
+			if ((bufNew = TryRealloc(buf, len)) == NULL) {
+				rv = -1;
+				break;
+			}
+			buf = bufNew;
+			bufSize = len;
+		}
+		if ((rec = LogData(db, ent->off, len, buf)) == NULL) {
+			rv = -1;
+			break;
+		}
+		key.data = (void *)&rec[DBFILE_REC_SIZE];
+		key.size = ent->keyLen;
+		val.data = (void *)&rec[DBFILE_REC_SIZE + ent->keyLen];
+		val.size = ent->valLen;
+		if (fn(&key, &val, arg) == -1) {
+			rv = -1;
+			break;
+		}
+	}
+	Free(buf);
+	return (rv);
+}
+
+AG_DbClass agDbFileClass = {
+	{
+		"AG_Db:AG_DbFile",
+		sizeof(AG_DbFile),
+		{ 1,0, AGC_DB_FILE, 0xE030 },
+		Init,
+		NULL,		/* free */
+		NULL,		/* destroy */
+		NULL,		/* load */
+		NULL,		/* save */
+		NULL		/* edit */
+	},
+	"file",
+	N_("Single-file log-structured storage"),
+	AG_DB_KEY_DATA,		/* Key is variable data */
+	AG_DB_REC_VARIABLE,	/* Variable-sized records */
+	Open,
+	Close,
+	Sync,
+	Exists,
+	Get,
+	Put,
+	Del,
+	Iterate
+};
+
+#endif /* AG_SERIALIZATION */
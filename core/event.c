@@ -36,6 +36,12 @@
 #include <agar/config/have_kqueue.h>
 #include <agar/config/have_timerfd.h>
 #include <agar/config/have_select.h>
+#include <agar/config/have_epoll.h>
+
+/* The epoll(7) event sink relies on timerfd for kernel-based timers. */
+#if defined(HAVE_EPOLL) && (defined(HAVE_KQUEUE) || !defined(HAVE_TIMERFD))
+# undef HAVE_EPOLL
+#endif
 
 #if defined(HAVE_KQUEUE)
 # ifdef __NetBSD__
@@ -50,6 +56,13 @@
 # include <sys/timerfd.h>
 # include <errno.h>
 #endif
+#if defined(HAVE_EPOLL)
+# include <sys/types.h>
+# include <sys/epoll.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+# include <errno.h>
+#endif
 #if defined(HAVE_SELECT)
 # include <sys/types.h>
 # include <sys/time.h>
@@ -58,6 +71,15 @@
 # include <errno.h>
 #endif
 
+/* Wake the event loop for AG_QueueEvent() through a pipe(2) sink. */
+#if AG_MODEL != AG_SMALL && defined(AG_EVENT_LOOP) && !defined(_WIN32) && \
+    (defined(HAVE_KQUEUE) || defined(HAVE_EPOLL) || defined(HAVE_TIMERFD) || \
+     defined(HAVE_SELECT))
+# define AG_EVENT_QUEUE_PIPE
+# include <unistd.h>
+# include <fcntl.h>
+#endif
+
 /* Expensive debugging output related to event delivery. */
 /* #define DEBUG_EVENTS */
 
@@ -91,6 +113,41 @@ typedef struct ag_event_source_kqueue {
 static int GrowKqChangelist(AG_EventSourceKQUEUE *_Nonnull, Uint);
 #endif /* HAVE_KQUEUE */
 
+#ifdef HAVE_EPOLL
+
+/* Size of epoll input event buffer (in epoll_events). */
+# ifndef AG_EPOLL_EVBUFSIZE
+# define AG_EPOLL_EVBUFSIZE 32
+# endif
+
+/*
+ * File descriptor registered with epoll. Every sink and timer using a given
+ * fd shares one watch, since epoll allows only one registration per fd.
+ */
+typedef struct ag_epoll_watch {
+	AG_EventSink *_Nonnull *_Nullable sinks; /* Sinks watching this fd */
+	Uint nSinks;
+	Uint32 events;                          /* Registered EPOLL* mask */
+# ifdef AG_TIMERS
+	struct ag_timer *_Nullable timer;       /* Timer (if fd is a timerfd) */
+# endif
+} AG_EpollWatch;
+
+typedef struct ag_event_source_epoll {
+	struct ag_event_source _inherit;  /* EventSource -> EventSourceEPOLL */
+	AG_EpollWatch *_Nullable watches; /* Watches (indexed by fd) */
+	int nWatches;
+	int fd;                           /* epoll_create1() fd */
+# ifdef AG_THREADS
+	_Nonnull_Mutex AG_Mutex lock;     /* Lock on watches[] */
+# endif
+	struct epoll_event events[AG_EPOLL_EVBUFSIZE]; /* Input event buffer */
+} AG_EventSourceEPOLL;
+
+static int  AddSinkEPOLL(AG_EventSourceEPOLL *_Nonnull, AG_EventSink *_Nonnull);
+static void DelSinkEPOLL(AG_EventSourceEPOLL *_Nonnull, AG_EventSink *_Nonnull);
+#endif /* HAVE_EPOLL */
+
 /* #define DEBUG_TIMERS */
 
 #ifdef __NetBSD__
@@ -143,6 +200,7 @@ InitEvent(AG_Event *_Nonnull ev, AG_Object *_Nullable ob)
 	ev->name[0] = '\0';
 #endif
 	ev->fn = NULL;
+	ev->atom = 0;
 	ev->argc = 1;
 	ev->argc0 = 1;
 	InitPointerArg(&ev->argv[0], ob);
@@ -153,6 +211,301 @@ InitEvent(AG_Event *_Nonnull ev, AG_Object *_Nullable ob)
 #endif
 }
 
+/*
+ * Interned event names. Names passed to AG_SetEvent() and AG_AddEvent() are
+ * mapped to non-zero integer atoms, so that handlers can be matched without
+ * string comparisons. The table persists across AG_Destroy() such that atoms
+ * cached by the application remain valid.
+ */
+typedef struct ag_event_atom_ent {
+	Uint32 hash;				/* Hash of name */
+	AG_EventAtom atom;			/* Atom (0 = empty slot) */
+	char *_Nullable name;			/* Name string */
+} AG_EventAtomEnt;
+
+static AG_EventAtomEnt *_Nullable agEventAtoms = NULL;
+static Uint                       agEventAtomsSize = 0;    /* Slots (2^n) */
+static AG_EventAtom               agEventAtomLast = 0;     /* Last allocated */
+#ifdef AG_THREADS
+static AG_Mutex                   agEventAtomsLock;
+static int                        agEventAtomsInited = 0;
+#endif
+
+/* Initialize the table of interned event names (called by AG_InitCore()). */
+void
+AG_InitEventAtoms(void)
+{
+#ifdef AG_THREADS
+	if (!agEventAtomsInited) {
+		AG_MutexInit(&agEventAtomsLock);
+		agEventAtomsInited = 1;
+	}
+#endif
+}
+
+/* Return the slot for the given name (or the empty slot ending the probe). */
+static AG_EventAtomEnt *_Nonnull
+ProbeEventAtom(const char *_Nonnull name, Uint32 h)
+{
+	const Uint mask = agEventAtomsSize - 1;
+	Uint i;
+
+	for (i = h & mask; agEventAtoms[i].atom != 0; i = (i+1) & mask) {
+		if (agEventAtoms[i].hash == h &&
+		    strcmp(agEventAtoms[i].name, name) == 0)
+			break;
+	}
+	return (&agEventAtoms[i]);
+}
+
+static void
+GrowEventAtoms(void)
+{
+	AG_EventAtomEnt *entsOld = agEventAtoms, *ent;
+	const Uint sizeOld = agEventAtomsSize;
+	Uint i;
+
+	agEventAtomsSize = (sizeOld > 0) ? (sizeOld << 1) : 128;
+	agEventAtoms = Malloc(agEventAtomsSize * sizeof(AG_EventAtomEnt));
+	memset(agEventAtoms, 0, agEventAtomsSize * sizeof(AG_EventAtomEnt));
+
+	for (i = 0; i < sizeOld; i++) {
+		if (entsOld[i].atom == 0) {
+			continue;
+		}
+		ent = ProbeEventAtom(entsOld[i].name, entsOld[i].hash);
+		memcpy(ent, &entsOld[i], sizeof(AG_EventAtomEnt));
+	}
+	Free(entsOld);
+}
+
+static AG_EventAtom
+GetEventAtom(const char *_Nonnull name, int create)
+{
+	AG_EventAtomEnt *ent;
+	AG_EventAtom atom = 0;
+	Uint32 h;
+
+	h = AG_HashString(name);
+#ifdef AG_THREADS
+	AG_MutexLock(&agEventAtomsLock);
+#endif
+	if (agEventAtomsSize > 0) {
+		ent = ProbeEventAtom(name, h);
+		if (ent->atom != 0) {
+			atom = ent->atom;
+			goto out;
+		}
+	}
+	if (!create) {
+		goto out;
+	}
+	if ((agEventAtomLast + 1) << 1 > agEventAtomsSize) {   /* Load <= .5 */
+		GrowEventAtoms();
+	}
+	ent = ProbeEventAtom(name, h);
+	ent->hash = h;
+	ent->atom = atom = ++agEventAtomLast;
+	ent->name = Strdup(name);
+out:
+#ifdef AG_THREADS
+	AG_MutexUnlock(&agEventAtomsLock);
+#endif
+	return (atom);
+}
+
+/* Return the atom for the given event name (interning the name if needed). */
+AG_EventAtom
+AG_GetEventAtom(const char *name)
+{
+	return GetEventAtom(name, 1);
+}
+
+/* Return the atom for the given event name or 0 if it was never interned. */
+AG_EventAtom
+AG_LookupEventAtom(const char *name)
+{
+	return GetEventAtom(name, 0);
+}
+
+#if AG_MODEL != AG_SMALL
+/*
+ * Objects with at least AG_EVENT_INDEX_MIN event handlers maintain an
+ * open-addressing (linear probing) index of handlers keyed by atom.
+ */
+# ifndef AG_EVENT_INDEX_MIN
+# define AG_EVENT_INDEX_MIN 8
+# endif
+# define EVINDEX_SLOT(atom,mask) (((Uint32)(atom) * 2654435761U) & (mask))
+
+static __inline__ AG_EventIndexEnt *_Nonnull
+EvIndexProbe(const AG_EventIndex *_Nonnull idx, AG_EventAtom atom)
+{
+	const Uint mask = idx->size - 1;
+	Uint i;
+
+	for (i = EVINDEX_SLOT(atom, mask);
+	     idx->ents[i].atom != 0 && idx->ents[i].atom != atom;
+	     i = (i+1) & mask)
+		;
+	return (&idx->ents[i]);
+}
+
+/* Rebuild the index from the object's list of event handlers. */
+static void
+EvIndexRebuild(AG_Object *_Nonnull ob, Uint sizeNew)
+{
+	AG_EventIndex *idx = &ob->evIndex;
+	AG_EventIndexEnt *entsNew, *ent;
+	AG_Event *ev;
+
+	if ((entsNew = TryMalloc(sizeNew * sizeof(AG_EventIndexEnt))) == NULL) {
+		Free(idx->ents);		/* Fall back to linear search */
+		idx->ents = NULL;
+		idx->size = 0;
+		idx->nUsed = 0;
+		return;
+	}
+	memset(entsNew, 0, sizeNew * sizeof(AG_EventIndexEnt));
+	Free(idx->ents);
+	idx->ents = entsNew;
+	idx->size = sizeNew;
+	idx->nUsed = 0;
+
+	TAILQ_FOREACH(ev, &ob->events, events) {
+		ent = EvIndexProbe(idx, ev->atom);
+		if (ent->atom == 0) {
+			ent->atom = ev->atom;
+			ent->first = ev;
+			idx->nUsed++;
+		}
+		ent->nHandlers++;
+	}
+}
+
+/* Index an event handler just appended to the object's list. */
+static void
+EvIndexInsert(AG_Object *_Nonnull ob, AG_Event *_Nonnull ev)
+{
+	AG_EventIndex *idx = &ob->evIndex;
+	AG_EventIndexEnt *ent;
+
+	idx->nEvents++;
+	if (idx->ents == NULL) {
+		if (idx->nEvents >= AG_EVENT_INDEX_MIN) {
+			EvIndexRebuild(ob, AG_EVENT_INDEX_MIN << 2);
+		}
+		return;
+	}
+	ent = EvIndexProbe(idx, ev->atom);
+	if (ent->atom == ev->atom) {
+		ent->nHandlers++;
+		return;
+	}
+	if ((idx->nUsed + 1) << 1 > idx->size) {
+		EvIndexRebuild(ob, idx->size << 1);
+		return;
+	}
+	ent->atom = ev->atom;
+	ent->nHandlers = 1;
+	ent->first = ev;
+	idx->nUsed++;
+}
+
+/* Remove an event handler (which is still in the object's list). */
+static void
+EvIndexRemove(AG_Object *_Nonnull ob, AG_Event *_Nonnull ev)
+{
+	AG_EventIndex *idx = &ob->evIndex;
+	AG_EventIndexEnt *ents = idx->ents;
+	AG_Event *evNext;
+	Uint i, j, k, mask;
+
+	idx->nEvents--;
+	if (ents == NULL) {
+		return;
+	}
+	i = (Uint)(EvIndexProbe(idx, ev->atom) - ents);
+	if (ents[i].atom != ev->atom) {
+		return;
+	}
+	if (--ents[i].nHandlers > 0) {
+		if (ents[i].first == ev) {
+			for (evNext = TAILQ_NEXT(ev, events);
+			     evNext != NULL;
+			     evNext = TAILQ_NEXT(evNext, events)) {
+				if (evNext->atom == ev->atom)
+					break;
+			}
+			ents[i].first = evNext;
+		}
+		return;
+	}
+
+	/* Backward-shift deletion. */
+	mask = idx->size - 1;
+	for (j = i; ; ) {
+		j = (j+1) & mask;
+		if (ents[j].atom == 0) {
+			break;
+		}
+		k = EVINDEX_SLOT(ents[j].atom, mask);
+		if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+			continue;
+		}
+		ents[i] = ents[j];
+		i = j;
+	}
+	ents[i].atom = 0;
+	ents[i].nHandlers = 0;
+	ents[i].first = NULL;
+	idx->nUsed--;
+}
+
+/* Release an event handler index. */
+void
+AG_EventIndexFree(AG_EventIndex *idx)
+{
+	Free(idx->ents);
+	idx->ents = NULL;
+	idx->size = 0;
+	idx->nUsed = 0;
+	idx->nEvents = 0;
+}
+#else /* AG_SMALL */
+# define EvIndexInsert(ob,ev)
+# define EvIndexRemove(ob,ev)
+#endif /* !AG_SMALL */
+
+/*
+ * Return the first event handler matching atom, and the number of matching
+ * handlers in the list (or ~0 if unknown).
+ */
+static __inline__ AG_Event *_Nullable
+FindFirstHandler(AG_Object *_Nonnull ob, AG_EventAtom atom, Uint *_Nonnull n)
+{
+	AG_Event *ev;
+
+#if AG_MODEL != AG_SMALL
+	if (ob->evIndex.ents != NULL) {
+		const AG_EventIndexEnt *ent = EvIndexProbe(&ob->evIndex, atom);
+
+		if (ent->atom != atom) {
+			*n = 0;
+			return (NULL);
+		}
+		*n = ent->nHandlers;
+		return (ent->first);
+	}
+#endif
+	TAILQ_FOREACH(ev, &ob->events, events) {
+		if (ev->atom == atom)
+			break;
+	}
+	*n = ~0U;
+	return (ev);
+}
+
 /* Initialize an AG_Event structure. */
 void
 AG_EventInit(AG_Event *_Nonnull ev)
@@ -217,6 +570,7 @@ AG_EventCopy(AG_Event *dst, const AG_Event *src)
 
 	memcpy(dst->name, src->name, sizeof(dst->name));
 	dst->fn = src->fn;
+	dst->atom = src->atom;
 	dst->argc = src->argc;
 	dst->argc0 = src->argc0;
 	for (i = 0; i < src->argc; i++) {
@@ -235,18 +589,16 @@ AG_SetEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 {
 	AG_Object *ob = p;
 	AG_Event *ev;
+	AG_EventAtom atom;
+	Uint n;
+
+	atom = AG_GetEventAtom((name != NULL) ? name : "");
 
 	AG_ObjectLock(ob);
 
-	if (name != NULL) {
-		TAILQ_FOREACH(ev, &ob->events, events)
-			if (strcmp(ev->name, name) == 0)
-				break;
-	} else {
-		ev = NULL;
-	}
+	ev = (name != NULL) ? FindFirstHandler(ob, atom, &n) : NULL;
 	if (ev == NULL) {
-		ev = Malloc(sizeof(AG_Event));
+		ev = AG_ObjectSubAlloc(ob, &agEventPool);
 		InitEvent(ev, ob);
 		if (name != NULL) {
 			if (Strlcpy(ev->name, name, sizeof(ev->name)) >= sizeof(ev->name))
@@ -254,7 +606,9 @@ AG_SetEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 		} else {
 			ev->name[0] = '\0';
 		}
+		ev->atom = atom;
 		TAILQ_INSERT_TAIL(&ob->events, ev, events);
+		EvIndexInsert(ob, ev);
 	} else {
 		ev->argc = 1;
 		ev->argc0 = 1;
@@ -284,23 +638,20 @@ AG_Event *
 AG_AddEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 {
 	AG_Object *ob = p;
-	AG_Event *ev, *evOther;
+	AG_Event *ev;
 
 	AG_ObjectLock(ob);
 
-	ev = Malloc(sizeof(AG_Event));
+	ev = AG_ObjectSubAlloc(ob, &agEventPool);
 	InitEvent(ev, ob);
 
 	if (name != NULL) {
-		TAILQ_FOREACH(evOther, &ob->events, events) {
-			if (strcmp(evOther->name, name) == 0)
-				break;
-		}
 		if (Strlcpy(ev->name, name, sizeof(ev->name)) >= sizeof(ev->name))
 			AG_FatalError("Event name too big");
 	} else {
 		ev->name[0] = '\0';
 	}
+	ev->atom = AG_GetEventAtom(ev->name);
 
 	ev->fn = fn;
 
@@ -314,6 +665,7 @@ AG_AddEvent(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 	ev->argc0 = ev->argc;
 
 	TAILQ_INSERT_TAIL(&ob->events, ev, events);
+	EvIndexInsert(ob, ev);
 	AG_ObjectUnlock(ob);
 	return (ev);
 }
@@ -324,17 +676,19 @@ AG_UnsetEvent(void *p, const char *name)
 {
 	AG_Object *ob = p;
 	AG_Event *ev;
+	AG_EventAtom atom;
+	Uint n;
 
-	AG_ObjectLock(ob);
-	TAILQ_FOREACH(ev, &ob->events, events) {
-		if (strcmp(name, ev->name) == 0)
-			break;
+	if ((atom = AG_LookupEventAtom(name)) == 0) {
+		return;
 	}
-	if (ev == NULL) {
+	AG_ObjectLock(ob);
+	if ((ev = FindFirstHandler(ob, atom, &n)) == NULL) {
 		goto out;
 	}
+	EvIndexRemove(ob, ev);
 	TAILQ_REMOVE(&ob->events, ev, events);
-	free(ev);
+	AG_ObjectSubFree(ob, &agEventPool, ev);
 out:
 	AG_ObjectUnlock(ob);
 }
@@ -346,10 +700,11 @@ AG_UnsetEventByPtr(void *p, AG_Event *ev)
 	AG_Object *ob = p;
 
 	AG_ObjectLock(ob);
+	EvIndexRemove(ob, ev);
 	TAILQ_REMOVE(&ob->events, ev, events);
 	AG_ObjectUnlock(ob);
 
-	free(ev);
+	AG_ObjectSubFree(ob, &agEventPool, ev);
 }
 
 /* Look up an AG_Event by name. */
@@ -358,12 +713,14 @@ AG_FindEventHandler(void *p, const char *name)
 {
 	AG_Object *ob = p;
 	AG_Event *ev;
-	
-	AG_ObjectLock(ob);
-	TAILQ_FOREACH(ev, &ob->events, events) {
-		if (strcmp(name, ev->name) == 0)
-			break;
+	AG_EventAtom atom;
+	Uint n;
+
+	if ((atom = AG_LookupEventAtom(name)) == 0) {
+		return (NULL);
 	}
+	AG_ObjectLock(ob);
+	ev = FindFirstHandler(ob, atom, &n);
 	AG_ObjectUnlock(ob);
 	return (ev);
 }
@@ -378,21 +735,22 @@ EventTimeout(AG_Timer *_Nonnull to, AG_Event *_Nonnull event)
 	AG_Object *obj = AG_OBJECT_SELF();
 	const char *eventName = AG_STRING(1);
 	AG_Event *ev;
+	AG_EventAtom atom;
+	Uint n;
 
 # ifdef DEBUG_EVENTS
 	Debug(obj, "Event <%s> timeout (%u ticks)\n", eventName,
 	    (Uint)to->ival);
 # endif
-	TAILQ_FOREACH(ev, &obj->events, events) {
-		if (strcmp(eventName, ev->name) == 0)
-			break;
-	}
-	if (ev == NULL) {
+	if ((atom = AG_LookupEventAtom(eventName)) == 0 ||
+	    (ev = FindFirstHandler(obj, atom, &n)) == NULL) {
 		return (0);
 	}
 	/* Invoke the event handler routine. */
 	if (ev->fn != NULL) {
+		AG_TRACE_BEGIN(ev->name, obj);
 		ev->fn(ev);
+		AG_TRACE_END();
 	}
 	return (0);
 }
@@ -437,45 +795,51 @@ AG_PostEventByPtr(void *pObj, AG_Event *ev, const char *fmt, ...)
 			AG_EventGetArgs(&evTmp, fmt, ap);
 			va_end(ap);
 		}
-		if (evTmp.fn != NULL)
+		if (evTmp.fn != NULL) {
+			AG_TRACE_BEGIN(evTmp.name, obj);
 			evTmp.fn(&evTmp);
+			AG_TRACE_END();
+		}
 	}
 # endif /* MEDIUM or LARGE */
 
 	AG_ObjectUnlock(obj);
 }
 
+/* Append the arguments of evArgs to the argument vector of ev. */
+static __inline__ void
+AppendEventArgs(AG_Event *_Nonnull ev, const AG_Event *_Nonnull evArgs)
+{
+	int i;
+
+	for (i = 1; i < evArgs->argc; i++) {
+		AG_EVENT_PUSH_ARG_PRECOND(ev)
+		memcpy(&ev->argv[ev->argc++], &evArgs->argv[i],
+		    sizeof(AG_Variable));
+	}
+}
+
 /*
- * Post an event (by name) to an object. If fmt is given, append the
- * given arguments (specified in the same format as AG_SetEvent(3)),
- * to the end of the argument vector.
+ * Invoke the n handlers matching atom, starting at ev. The arguments
+ * of evArgs (if any) are appended to the argument vector of each handler.
+ * The object must be locked.
  */
-void
-AG_PostEvent(void *pObj, const char *evname, const char *fmt, ...)
+static void
+InvokeHandlers(AG_Object *_Nonnull obj, AG_Event *_Nullable ev,
+    AG_EventAtom atom, Uint n, const AG_Event *_Nullable evArgs)
 {
-	AG_Object *obj = pObj;
-	AG_Event *ev;
-	va_list ap;
-
-#ifdef AG_DEBUG
-	if (obj == NULL) { AG_FatalError("NULL object"); }
-#endif
-#ifdef DEBUG_EVENTS
-	Debug(obj, "PostEvent <%s>\n", evname);
-#endif
-	AG_ObjectLock(obj);
-	TAILQ_FOREACH(ev, &obj->events, events) {
-		if (strcmp(evname, ev->name) != 0)
+	for (; ev != NULL && n > 0; ev = TAILQ_NEXT(ev, events)) {
+		if (ev->atom != atom) {
 			continue;
+		}
+		n--;
 #if AG_MODEL == AG_SMALL
 		{
 			AG_Event *evTmp = Malloc(sizeof(AG_Event));
 
 			memcpy(evTmp, ev, sizeof(AG_Event));
-			if (fmt) {
-				va_start(ap, fmt);
-				AG_EventGetArgs(evTmp, fmt, ap);
-				va_end(ap);
+			if (evArgs != NULL) {
+				AppendEventArgs(evTmp, evArgs);
 			}
 			if (evTmp->fn != NULL) {
 				evTmp->fn(evTmp);
@@ -487,16 +851,117 @@ AG_PostEvent(void *pObj, const char *evname, const char *fmt, ...)
 			AG_Event evTmp;			/* Fits the stack */
 
 			memcpy(&evTmp, ev, sizeof(AG_Event));
-			if (fmt) {
-				va_start(ap, fmt);
-				AG_EventGetArgs(&evTmp, fmt, ap);
-				va_end(ap);
+			if (evArgs != NULL) {
+				AppendEventArgs(&evTmp, evArgs);
 			}
-			if (evTmp.fn != NULL)
+			if (evTmp.fn != NULL) {
+				AG_TRACE_BEGIN(evTmp.name, obj);
 				evTmp.fn(&evTmp);
+				AG_TRACE_END();
+			}
 		}
 #endif /* MEDIUM or LARGE */
 	}
+}
+
+/*
+ * Post an event (by atom) to an object. Unlike AG_PostEvent(), the
+ * arguments are parsed only once (and only if there are handlers).
+ */
+void
+AG_PostEventByAtom(void *pObj, AG_EventAtom atom, const char *fmt, ...)
+{
+	AG_Object *obj = pObj;
+	AG_Event *ev;
+	va_list ap;
+	Uint n;
+
+#ifdef AG_DEBUG
+	if (obj == NULL) { AG_FatalError("NULL object"); }
+#endif
+#ifdef DEBUG_EVENTS
+	Debug(obj, "PostEvent <#%u>\n", (Uint)atom);
+#endif
+	AG_ObjectLock(obj);
+	if ((ev = FindFirstHandler(obj, atom, &n)) == NULL) {
+		goto out;
+	}
+	if (fmt) {
+#if AG_MODEL == AG_SMALL
+		AG_Event *evArgs = Malloc(sizeof(AG_Event));
+
+		InitEvent(evArgs, NULL);
+		va_start(ap, fmt);
+		AG_EventGetArgs(evArgs, fmt, ap);
+		va_end(ap);
+		InvokeHandlers(obj, ev, atom, n, evArgs);
+		free(evArgs);
+#else
+		AG_Event evArgs;
+
+		InitEvent(&evArgs, NULL);
+		va_start(ap, fmt);
+		AG_EventGetArgs(&evArgs, fmt, ap);
+		va_end(ap);
+		InvokeHandlers(obj, ev, atom, n, &evArgs);
+#endif
+	} else {
+		InvokeHandlers(obj, ev, atom, n, NULL);
+	}
+out:
+	AG_ObjectUnlock(obj);
+}
+
+/*
+ * Post an event (by name) to an object. If fmt is given, append the
+ * given arguments (specified in the same format as AG_SetEvent(3)),
+ * to the end of the argument vector.
+ */
+void
+AG_PostEvent(void *pObj, const char *evname, const char *fmt, ...)
+{
+	AG_Object *obj = pObj;
+	AG_Event *ev;
+	AG_EventAtom atom;
+	va_list ap;
+	Uint n;
+
+#ifdef AG_DEBUG
+	if (obj == NULL) { AG_FatalError("NULL object"); }
+#endif
+#ifdef DEBUG_EVENTS
+	Debug(obj, "PostEvent <%s>\n", evname);
+#endif
+	if ((atom = AG_LookupEventAtom(evname)) == 0)
+		return;				/* No handlers anywhere */
+
+	AG_ObjectLock(obj);
+	if ((ev = FindFirstHandler(obj, atom, &n)) == NULL) {
+		goto out;
+	}
+	if (fmt) {
+#if AG_MODEL == AG_SMALL
+		AG_Event *evArgs = Malloc(sizeof(AG_Event));
+
+		InitEvent(evArgs, NULL);
+		va_start(ap, fmt);
+		AG_EventGetArgs(evArgs, fmt, ap);
+		va_end(ap);
+		InvokeHandlers(obj, ev, atom, n, evArgs);
+		free(evArgs);
+#else
+		AG_Event evArgs;
+
+		InitEvent(&evArgs, NULL);
+		va_start(ap, fmt);
+		AG_EventGetArgs(&evArgs, fmt, ap);
+		va_end(ap);
+		InvokeHandlers(obj, ev, atom, n, &evArgs);
+#endif
+	} else {
+		InvokeHandlers(obj, ev, atom, n, NULL);
+	}
+out:
 	AG_ObjectUnlock(obj);
 }
 
@@ -524,14 +989,24 @@ AG_ForwardEvent(void *pObj, const AG_Event *event)
 {
 	AG_Object *obj = pObj;
 	AG_Event *ev;
+	AG_EventAtom atom;
+	Uint n;
 
 #ifdef DEBUG_EVENTS
 	Debug(obj, "Event <%s> forwarded\n", event->name);
 #endif
+	if ((atom = event->atom) == 0 &&
+	    (atom = AG_LookupEventAtom(event->name)) == 0)
+		return;
+
 	AG_ObjectLock(obj);
-	TAILQ_FOREACH(ev, &obj->events, events) {
-		if (strcmp(event->name, ev->name) != 0)
+	for (ev = FindFirstHandler(obj, atom, &n);
+	     ev != NULL && n > 0;
+	     ev = TAILQ_NEXT(ev, events)) {
+		if (ev->atom != atom) {
 			continue;
+		}
+		n--;
 #if AG_MODEL == AG_SMALL
 		{
 			AG_Event *evTmp = Malloc(sizeof(AG_Event));
@@ -552,8 +1027,11 @@ AG_ForwardEvent(void *pObj, const AG_Event *event)
 			InitPointerArg(&evTmp.argv[0], obj);
 			InitDebugName (&evTmp.argv[0], "self");
 
-			if (ev->fn != NULL)
+			if (ev->fn != NULL) {
+				AG_TRACE_BEGIN(evTmp.name, obj);
 				ev->fn(&evTmp);
+				AG_TRACE_END();
+			}
 		}
 #endif /* MEDIUM or LARGE */
 	}
@@ -577,7 +1055,7 @@ AG_SchedEvent(void *pObj, Uint32 ticks, const char *evname, const char *fmt, ...
 	AG_Timer *to;
 	va_list ap;
 
-	if ((to = TryMalloc(sizeof(AG_Timer))) == NULL) {
+	if ((to = AG_ObjectTrySubAlloc(obj, &agTimerPool)) == NULL) {
 		return (-1);
 	}
 	AG_InitTimer(to, evname, AG_TIMER_AUTO_FREE);
@@ -586,7 +1064,7 @@ AG_SchedEvent(void *pObj, Uint32 ticks, const char *evname, const char *fmt, ...
 	AG_ObjectLock(obj);
 	
 	if (AG_AddTimer(obj, to, ticks, EventTimeout, "%s", evname) == -1) {
-		free(to);
+		AG_ObjectSubFree(obj, &agTimerPool, to);
 		goto fail;
 	}
 	ev = &to->fnEvent;
@@ -609,6 +1087,326 @@ fail:
 }
 #endif /* AG_TIMERS */
 
+#if AG_MODEL != AG_SMALL
+/*
+ * Deferred cross-thread event delivery. AG_QueueEvent() pushes onto a
+ * per-object LIFO with a compare-and-swap (producers never take a lock),
+ * and the first event queued on an idle object also pushes the object onto
+ * a global LIFO of pending objects. The event loop thread detaches either
+ * list with an atomic exchange, restores FIFO order and delivers the events.
+ */
+# if defined(AG_THREADS) && defined(__ATOMIC_ACQUIRE)
+#  define QUEUE_PUSH(head, node, link, old) do {			\
+	(old) = __atomic_load_n((head), __ATOMIC_RELAXED);		\
+	do {								\
+		(node)->link = (old);					\
+	} while (!__atomic_compare_exchange_n((head), &(old), (node),	\
+	    1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));			\
+} while (0)
+#  define QUEUE_TAKE(head, out) \
+	(out) = __atomic_exchange_n((head), NULL, __ATOMIC_ACQUIRE)
+#  define QUEUE_PEEK(head, out) \
+	(out) = __atomic_load_n((head), __ATOMIC_ACQUIRE)
+#  define QUEUE_SET_FLAG(flag, old) \
+	(old) = __atomic_exchange_n((flag), 1, __ATOMIC_SEQ_CST)
+#  define QUEUE_CLEAR_FLAG(flag) \
+	__atomic_store_n((flag), 0, __ATOMIC_SEQ_CST)
+# elif defined(AG_THREADS)
+/* No atomic builtins; serialize the producers with a mutex instead. */
+#  define QUEUE_PUSH(head, node, link, old) do {			\
+	AG_MutexLock(&agEventQueuePushLock);				\
+	(old) = *(head);						\
+	(node)->link = (old);						\
+	*(head) = (node);						\
+	AG_MutexUnlock(&agEventQueuePushLock);				\
+} while (0)
+#  define QUEUE_TAKE(head, out) do {					\
+	AG_MutexLock(&agEventQueuePushLock);				\
+	(out) = *(head);						\
+	*(head) = NULL;							\
+	AG_MutexUnlock(&agEventQueuePushLock);				\
+} while (0)
+#  define QUEUE_PEEK(head, out) do {					\
+	AG_MutexLock(&agEventQueuePushLock);				\
+	(out) = *(head);						\
+	AG_MutexUnlock(&agEventQueuePushLock);				\
+} while (0)
+#  define QUEUE_SET_FLAG(flag, old) do {				\
+	AG_MutexLock(&agEventQueuePushLock);				\
+	(old) = *(flag);						\
+	*(flag) = 1;							\
+	AG_MutexUnlock(&agEventQueuePushLock);				\
+} while (0)
+#  define QUEUE_CLEAR_FLAG(flag) do {					\
+	AG_MutexLock(&agEventQueuePushLock);				\
+	*(flag) = 0;							\
+	AG_MutexUnlock(&agEventQueuePushLock);				\
+} while (0)
+# else
+#  define QUEUE_PUSH(head, node, link, old) do {			\
+	(old) = *(head);						\
+	(node)->link = (old);						\
+	*(head) = (node);						\
+} while (0)
+#  define QUEUE_TAKE(head, out)     do { (out) = *(head); *(head) = NULL; } while (0)
+#  define QUEUE_PEEK(head, out)     (out) = *(head)
+#  define QUEUE_SET_FLAG(flag, old) do { (old) = *(flag); *(flag) = 1; } while (0)
+#  define QUEUE_CLEAR_FLAG(flag)    *(flag) = 0
+# endif
+
+static AG_Object *_Nullable agEventQueuePending = NULL; /* Objects to process */
+static int                  agEventQueueWakeup = 0;     /* Wakeup is pending */
+static AG_Object *_Nullable agEventQueueDraining = NULL; /* Left to process */
+static AG_Object *_Nullable agEventQueueCurrent = NULL; /* Being processed */
+# ifdef AG_THREADS
+static AG_Mutex             agEventQueueLock;           /* Serializes consumers */
+#  ifndef __ATOMIC_ACQUIRE
+static AG_Mutex             agEventQueuePushLock;       /* Serializes producers */
+#  endif
+static int                  agEventQueueInited = 0;
+# endif
+# ifdef AG_EVENT_QUEUE_PIPE
+static int agEventQueuePipe[2] = { -1, -1 };            /* Wakeup pipe */
+# endif
+
+/* Initialize the deferred event queue (called by AG_InitCore()). */
+void
+AG_InitEventQueue(void)
+{
+# ifdef AG_THREADS
+	if (!agEventQueueInited) {
+		AG_MutexInitRecursive(&agEventQueueLock);
+#  ifndef __ATOMIC_ACQUIRE
+		AG_MutexInit(&agEventQueuePushLock);
+#  endif
+		agEventQueueInited = 1;
+	}
+# endif
+}
+
+/* Wake up the event loop thread (unless a wakeup is already pending). */
+static void
+WakeEventQueue(void)
+{
+	int wakeupPending;
+
+	QUEUE_SET_FLAG(&agEventQueueWakeup, wakeupPending);
+	if (wakeupPending) {
+		return;
+	}
+# ifdef AG_EVENT_QUEUE_PIPE
+	if (agEventQueuePipe[1] != -1) {
+		const Uint8 c = 0;
+
+		if (write(agEventQueuePipe[1], &c, 1) == -1) {
+			/* Pipe is full, so the loop will wake up regardless. */
+		}
+	}
+# endif
+}
+
+static int
+QueueEvent(AG_Object *_Nonnull obj, AG_EventAtom atom,
+    const char *_Nullable fmt, va_list ap)
+{
+	AG_QueuedEvent *qe, *qeOld;
+	AG_Object *objOld;
+
+#ifdef AG_DEBUG
+	if (obj == NULL) { AG_FatalError("NULL object"); }
+#endif
+	if ((qe = TryMalloc(sizeof(AG_QueuedEvent))) == NULL) {
+		return (-1);
+	}
+	qe->atom = atom;
+	InitEvent(&qe->args, NULL);
+	if (fmt) {
+		AG_EventGetArgs(&qe->args, fmt, ap);
+	}
+	QUEUE_PUSH(&obj->evQueue, qe, next, qeOld);
+	if (qeOld == NULL) {
+		/*
+		 * The object was idle. Only we may link it into the pending
+		 * list until the consumer takes its queue again.
+		 */
+		QUEUE_PUSH(&agEventQueuePending, obj, evQueueNext, objOld);
+		WakeEventQueue();
+	}
+	return (0);
+}
+
+/*
+ * Queue an event (by name) for delivery to an object by the event loop
+ * thread. This is safe to call from any thread without holding the object
+ * lock. Arguments are parsed immediately; string and pointer arguments
+ * must remain valid until the event has been delivered.
+ */
+int
+AG_QueueEvent(void *pObj, const char *evname, const char *fmt, ...)
+{
+	AG_EventAtom atom;
+	va_list ap;
+	int rv;
+
+#ifdef DEBUG_EVENTS
+	Debug(pObj, "QueueEvent <%s>\n", evname);
+#endif
+	atom = AG_GetEventAtom(evname);
+	va_start(ap, fmt);
+	rv = QueueEvent(pObj, atom, fmt, ap);
+	va_end(ap);
+	return (rv);
+}
+
+/* Variant of AG_QueueEvent() which accepts an interned event name. */
+int
+AG_QueueEventByAtom(void *pObj, AG_EventAtom atom, const char *fmt, ...)
+{
+	va_list ap;
+	int rv;
+
+	va_start(ap, fmt);
+	rv = QueueEvent(pObj, atom, fmt, ap);
+	va_end(ap);
+	return (rv);
+}
+
+/* Reverse a detached queue (newest first) into delivery order. */
+static __inline__ AG_QueuedEvent *_Nullable
+ReverseQueuedEvents(AG_QueuedEvent *_Nullable qe)
+{
+	AG_QueuedEvent *qePrev = NULL, *qeNext;
+
+	for (; qe != NULL; qe = qeNext) {
+		qeNext = qe->next;
+		qe->next = qePrev;
+		qePrev = qe;
+	}
+	return (qePrev);
+}
+
+/*
+ * Deliver all events queued by AG_QueueEvent(). This is called by the
+ * event loop whenever it is woken up by a producer; applications using a
+ * custom event loop should call it periodically. Returns the number of
+ * events processed.
+ *
+ * The handlers may destroy objects whose events are still waiting to be
+ * delivered, so the remaining objects are kept in agEventQueueDraining
+ * (and the object being processed in agEventQueueCurrent), where
+ * AG_CancelQueuedEvents() can find them.
+ */
+Uint
+AG_ProcessQueuedEvents(void)
+{
+	AG_Object *obj, *objNext, *objPrev, *pending;
+	AG_QueuedEvent *qe, *qeNext, *qeFirst;
+	AG_Event *ev;
+	Uint n, count = 0;
+
+# ifdef AG_THREADS
+	AG_MutexLock(&agEventQueueLock);
+# endif
+	if (agEventQueueCurrent != NULL) {
+		/* Called recursively from a handler; leave it to the caller. */
+		goto out;
+	}
+	QUEUE_CLEAR_FLAG(&agEventQueueWakeup);
+	QUEUE_TAKE(&agEventQueuePending, pending);
+
+	for (objPrev = NULL, obj = pending; obj != NULL; obj = objNext) {
+		objNext = obj->evQueueNext;		/* Restore FIFO order */
+		obj->evQueueNext = objPrev;
+		objPrev = obj;
+	}
+	agEventQueueDraining = objPrev;
+
+	while ((obj = agEventQueueDraining) != NULL) {
+		/*
+		 * Producers may relink obj into the pending list as soon
+		 * as its queue is taken, so unlink it first.
+		 */
+		agEventQueueDraining = obj->evQueueNext;
+		agEventQueueCurrent = obj;
+		QUEUE_TAKE(&obj->evQueue, qeFirst);
+
+		AG_ObjectLock(obj);
+		for (qe = ReverseQueuedEvents(qeFirst); qe != NULL; qe = qeNext) {
+			qeNext = qe->next;
+			if (agEventQueueCurrent == obj &&
+			    (ev = FindFirstHandler(obj, qe->atom, &n)) != NULL) {
+				InvokeHandlers(obj, ev, qe->atom, n, &qe->args);
+			}
+			free(qe);
+			count++;
+		}
+		/*
+		 * Even if a handler cancelled obj's events, obj cannot have
+		 * been destroyed while we hold its lock.
+		 */
+		AG_ObjectUnlock(obj);
+	}
+	agEventQueueCurrent = NULL;
+out:
+# ifdef AG_THREADS
+	AG_MutexUnlock(&agEventQueueLock);
+# endif
+	return (count);
+}
+
+/*
+ * Discard any events queued for the given object, and remove it from the
+ * lists of pending objects. Called by AG_ObjectDestroy().
+ *
+ * If the object is being processed by AG_ProcessQueuedEvents() (i.e., we
+ * are called from one of its handlers), its remaining events are skipped.
+ */
+void
+AG_CancelQueuedEvents(void *pObj)
+{
+	AG_Object *obj = pObj, *o, *oNext, *oPrev, *oOld, *pending;
+	AG_Object **pLink;
+	AG_QueuedEvent *qe, *qeNext;
+
+	QUEUE_PEEK(&obj->evQueue, qe);
+	if (qe == NULL && obj != agEventQueueCurrent)
+		return;
+# ifdef AG_THREADS
+	AG_MutexLock(&agEventQueueLock);
+# endif
+	QUEUE_TAKE(&agEventQueuePending, pending);
+	for (oPrev = NULL, o = pending; o != NULL; o = oNext) {
+		oNext = o->evQueueNext;
+		o->evQueueNext = oPrev;
+		oPrev = o;
+	}
+	for (o = oPrev; o != NULL; o = oNext) {       /* Oldest first */
+		oNext = o->evQueueNext;
+		if (o != obj)
+			QUEUE_PUSH(&agEventQueuePending, o, evQueueNext, oOld);
+	}
+	for (pLink = &agEventQueueDraining; *pLink != NULL;
+	     pLink = &(*pLink)->evQueueNext) {
+		if (*pLink == obj) {
+			*pLink = obj->evQueueNext;
+			break;
+		}
+	}
+	if (agEventQueueCurrent == obj) {
+		agEventQueueCurrent = NULL;
+	}
+	QUEUE_TAKE(&obj->evQueue, qe);
+	for (; qe != NULL; qe = qeNext) {
+		qeNext = qe->next;
+		free(qe);
+	}
+	obj->evQueueNext = NULL;
+# ifdef AG_THREADS
+	AG_MutexUnlock(&agEventQueueLock);
+# endif
+}
+#endif /* !AG_SMALL */
+
 #ifdef AG_EVENT_LOOP
 /*
  * Create a new event source.
@@ -616,9 +1414,12 @@ fail:
 static AG_EventSource *_Nullable
 CreateEventSource(void)
 {
-# ifdef HAVE_KQUEUE
+# if defined(HAVE_KQUEUE)
 	AG_EventSourceKQUEUE *kq = TryMalloc(sizeof(AG_EventSourceKQUEUE));
 	AG_EventSource *src = (AG_EventSource *)kq;
+# elif defined(HAVE_EPOLL)
+	AG_EventSourceEPOLL *ep = TryMalloc(sizeof(AG_EventSourceEPOLL));
+	AG_EventSource *src = (AG_EventSource *)ep;
 # else
 	AG_EventSource *src = TryMalloc(sizeof(AG_EventSource));
 # endif
@@ -660,6 +1461,29 @@ CreateEventSource(void)
 	if (GrowKqChangelist(kq, AG_KQ_INIT_MAXCHANGES) == -1) {
 		AG_FatalError("GrowKqChangelist");
 	}
+# elif defined(HAVE_EPOLL)
+	if ((ep->fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+		AG_SetError("epoll_create1: %s", AG_Strerror(errno));
+		free(ep);
+		return (NULL);
+	}
+	ep->watches = NULL;
+	ep->nWatches = 0;
+#  ifdef AG_THREADS
+	AG_MutexInit(&ep->lock);
+#  endif
+	memset(ep->events, 0, AG_EPOLL_EVBUFSIZE*sizeof(struct epoll_event));
+	src->sinkFn = AG_EventSinkEPOLL;
+#  ifdef AG_TIMERS
+	src->addTimerFn = AG_AddTimerEPOLL;
+	src->delTimerFn = AG_DelTimerEPOLL;
+#  endif
+	src->caps[AG_SINK_TIMER] = 1;		/* Provides timers internally */
+	src->caps[AG_SINK_READ] = 1;
+	src->caps[AG_SINK_WRITE] = 1;
+#  ifdef SYS_pidfd_open
+	src->caps[AG_SINK_PROCEVENT] = 1;	/* Process exit through pidfd */
+#  endif
 # elif defined(HAVE_TIMERFD)
 	src->sinkFn = AG_EventSinkTIMERFD;
 #  ifdef AG_TIMERS
@@ -711,6 +1535,22 @@ DestroyEventSource(void *_Nullable pEventSource)
 		}
 		Free(kq->changes);
 	}
+# elif defined(HAVE_EPOLL)
+	{
+		AG_EventSourceEPOLL *ep = pEventSource;
+		int i;
+
+		if (ep->fd != -1) {
+			close(ep->fd);
+		}
+		for (i = 0; i < ep->nWatches; i++) {
+			Free(ep->watches[i].sinks);
+		}
+		Free(ep->watches);
+#  ifdef AG_THREADS
+		AG_MutexDestroy(&ep->lock);
+#  endif
+	}
 # endif
 	for (es = TAILQ_FIRST(&src->prologues);
 	     es != TAILQ_END(&src->prologues);
@@ -718,26 +1558,79 @@ DestroyEventSource(void *_Nullable pEventSource)
 		esNext = TAILQ_NEXT(es, sinks);
 		free(es);
 	}
-	for (es = TAILQ_FIRST(&src->epilogues);
-	     es != TAILQ_END(&src->epilogues);
-	     es = esNext) {
-		esNext = TAILQ_NEXT(es, sinks);
-		free(es);
+	for (es = TAILQ_FIRST(&src->epilogues);
+	     es != TAILQ_END(&src->epilogues);
+	     es = esNext) {
+		esNext = TAILQ_NEXT(es, sinks);
+		free(es);
+	}
+	for (es = TAILQ_FIRST(&src->spinners);
+	     es != TAILQ_END(&src->spinners);
+	     es = esNext) {
+		esNext = TAILQ_NEXT(es, sinks);
+		free(es);
+	}
+	for (es = TAILQ_FIRST(&src->sinks);
+	     es != TAILQ_END(&src->sinks);
+	     es = esNext) {
+		esNext = TAILQ_NEXT(es, sinks);
+		free(es);
+	}
+	free(src);
+}
+
+# if AG_MODEL != AG_SMALL
+/* Deliver events queued by AG_QueueEvent() once the loop is woken up. */
+static int
+EventQueueSink(AG_EventSink *_Nonnull es, AG_Event *_Nonnull event)
+{
+#  ifdef AG_EVENT_QUEUE_PIPE
+	if (es->type == AG_SINK_READ) {
+		Uint8 buf[64];
+
+		while (read(es->ident, buf, sizeof(buf)) > 0)
+			;
+	}
+#  endif
+	AG_ProcessQueuedEvents();
+	return (0);
+}
+
+/*
+ * Register the sink which drains the AG_QueueEvent() queue. If the event
+ * source can watch a wakeup pipe, producers interrupt the blocking wait.
+ * Otherwise the queue is drained after every iteration of the loop.
+ */
+static int
+InitEventQueueSink(void)
+{
+#  ifdef AG_EVENT_QUEUE_PIPE
+	int i;
+
+	if (pipe(agEventQueuePipe) == -1) {
+		AG_SetError("pipe: %s", AG_Strerror(errno));
+		return (-1);
+	}
+	for (i = 0; i < 2; i++) {
+		fcntl(agEventQueuePipe[i], F_SETFL,
+		    fcntl(agEventQueuePipe[i], F_GETFL) | O_NONBLOCK);
+		fcntl(agEventQueuePipe[i], F_SETFD, FD_CLOEXEC);
 	}
-	for (es = TAILQ_FIRST(&src->spinners);
-	     es != TAILQ_END(&src->spinners);
-	     es = esNext) {
-		esNext = TAILQ_NEXT(es, sinks);
-		free(es);
+	if (AG_AddEventSink(AG_SINK_READ, agEventQueuePipe[0], 0,
+	    EventQueueSink, NULL) != NULL) {
+		return (0);
 	}
-	for (es = TAILQ_FIRST(&src->sinks);
-	     es != TAILQ_END(&src->sinks);
-	     es = esNext) {
-		esNext = TAILQ_NEXT(es, sinks);
-		free(es);
+	close(agEventQueuePipe[0]);
+	close(agEventQueuePipe[1]);
+	agEventQueuePipe[0] = -1;
+	agEventQueuePipe[1] = -1;
+#  endif
+	if (AG_AddEventEpilogue(EventQueueSink, NULL) == NULL) {
+		return (-1);
 	}
-	free(src);
+	return (0);
 }
+# endif /* !AG_SMALL */
 
 int
 AG_InitEventSubsystem(Uint flags)
@@ -751,12 +1644,25 @@ AG_InitEventSubsystem(Uint flags)
 	if ((agEventSource = AG_GetEventSource()) == NULL) {
 		return (-1);
 	}
+#if AG_MODEL != AG_SMALL
+	if (InitEventQueueSink() == -1) {
+		return (-1);
+	}
+#endif
 	return (0);
 }
 
 void
 AG_DestroyEventSubsystem(void)
 {
+#ifdef AG_EVENT_QUEUE_PIPE
+	if (agEventQueuePipe[0] != -1) {
+		close(agEventQueuePipe[0]);
+		close(agEventQueuePipe[1]);
+		agEventQueuePipe[0] = -1;
+		agEventQueuePipe[1] = -1;
+	}
+#endif
 	if (agEventSource != NULL) {
 		DestroyEventSource(agEventSource);
 		agEventSource = NULL;
@@ -1017,6 +1923,12 @@ AG_AddEventSink(enum ag_event_sink_type type, int ident, Uint flags,
 		va_end(ap);
 	}
 	es->fnArgs.argc0 = es->fnArgs.argc;
+# ifdef HAVE_EPOLL
+	if (AddSinkEPOLL((AG_EventSourceEPOLL *)src, es) == -1) {
+		free(es);
+		return (NULL);
+	}
+# endif
 	TAILQ_INSERT_TAIL(&src->sinks, es, sinks);
 	return (es);
 }
@@ -1071,7 +1983,9 @@ AG_DelEventSink(AG_EventSink *es)
 		break;
 	}
 # endif /* HAVE_KQUEUE */
-
+# ifdef HAVE_EPOLL
+	DelSinkEPOLL((AG_EventSourceEPOLL *)src, es);
+# endif
 	TAILQ_REMOVE(&src->sinks, es, sinks);
 	free(es);
 }
@@ -1152,7 +2066,9 @@ restart:
 		    (to = (AG_Timer *)kev->udata) == NULL) {
 			continue;
 		}
+		AG_TRACE_TIMER_BEGIN(to);
 		rvt = to->fn(to, &to->fnEvent);
+		AG_TRACE_END();
 		if (rvt > 0) {				/* Restart timer */
 			struct kevent *kev;
 #  ifdef DEBUG_TIMERS
@@ -1180,7 +2096,7 @@ restart:
 				TAILQ_REMOVE(&agTimerObjQ, ob, tobjs);
 			}
 			if (to->flags & AG_TIMER_AUTO_FREE) {
-				free(to);
+				AG_ObjectSubFree(ob, &agTimerPool, to);
 			} else {
 				to->ival = 0;
 				to->id = -1;
@@ -1298,6 +2214,419 @@ AG_DelTimerKQUEUE(AG_Timer *to)
 #  endif /* AG_TIMERS */
 # endif /* HAVE_KQUEUE */
 
+# ifdef HAVE_EPOLL
+/*
+ * Make sure that watches[] can be indexed by fd.
+ * The caller must hold the event source lock.
+ */
+static int
+GrowEpollWatches(AG_EventSourceEPOLL *_Nonnull ep, int fd)
+{
+	AG_EpollWatch *watchesNew;
+	int nNew;
+
+	if (fd < ep->nWatches) {
+		return (0);
+	}
+	nNew = (ep->nWatches > 0) ? ep->nWatches : 16;
+	while (nNew <= fd) {
+		nNew <<= 1;
+	}
+	if ((watchesNew = TryRealloc(ep->watches, nNew*sizeof(AG_EpollWatch)))
+	    == NULL) {
+		return (-1);
+	}
+	memset(&watchesNew[ep->nWatches], 0,
+	    (nNew - ep->nWatches)*sizeof(AG_EpollWatch));
+	ep->watches = watchesNew;
+	ep->nWatches = nNew;
+	return (0);
+}
+
+/*
+ * Compute the epoll event mask from the sinks and timer sharing a watch and
+ * register, modify or remove the fd as needed. Readiness is level-triggered
+ * (like select(2)) unless every sink on the fd requested AG_IOEVENT_EDGE.
+ * The caller must hold the event source lock.
+ */
+static int
+UpdateEpollWatch(AG_EventSourceEPOLL *_Nonnull ep, int fd)
+{
+	AG_EpollWatch *w = &ep->watches[fd];
+	struct epoll_event ev;
+	Uint32 events = 0;
+	int op, edge = (w->nSinks > 0);
+	Uint i;
+
+	for (i = 0; i < w->nSinks; i++) {
+		const AG_EventSink *es = w->sinks[i];
+
+		switch (es->type) {
+		case AG_SINK_READ:
+		case AG_SINK_PROCEVENT:
+			events |= EPOLLIN;
+			break;
+		case AG_SINK_WRITE:
+			events |= EPOLLOUT;
+			break;
+		default:
+			break;
+		}
+		if ((es->flags & AG_IOEVENT_EDGE) == 0)
+			edge = 0;
+	}
+#  ifdef AG_TIMERS
+	if (w->timer != NULL) {
+		events |= EPOLLIN;
+		edge = 0;
+	}
+#  endif
+	if (events != 0 && edge) {
+		events |= EPOLLET;
+	}
+	if (events == w->events) {
+		return (0);
+	}
+	if (events == 0) {
+		/*
+		 * The fd may have been closed already (which implicitly
+		 * removes it from the epoll set), so ignore any error.
+		 */
+		(void)epoll_ctl(ep->fd, EPOLL_CTL_DEL, fd, NULL);
+		w->events = 0;
+		return (0);
+	}
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.fd = fd;
+	op = (w->events == 0) ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+	if (epoll_ctl(ep->fd, op, fd, &ev) == -1) {
+		/* Recover from a registration that was implicitly dropped. */
+		if ((op == EPOLL_CTL_MOD && errno == ENOENT &&
+		     epoll_ctl(ep->fd, EPOLL_CTL_ADD, fd, &ev) == 0) ||
+		    (op == EPOLL_CTL_ADD && errno == EEXIST &&
+		     epoll_ctl(ep->fd, EPOLL_CTL_MOD, fd, &ev) == 0)) {
+			goto out;
+		}
+		AG_SetError("epoll_ctl(%d): %s", fd, AG_Strerror(errno));
+		return (-1);
+	}
+out:
+	w->events = events;
+	return (0);
+}
+
+/* Remove a sink from the watch on fd. Caller must hold the lock. */
+static void
+RemoveEpollWatchSink(AG_EventSourceEPOLL *_Nonnull ep, int fd,
+    const AG_EventSink *_Nonnull es)
+{
+	AG_EpollWatch *w = &ep->watches[fd];
+	Uint i;
+
+	for (i = 0; i < w->nSinks; i++) {
+		if (w->sinks[i] == es)
+			break;
+	}
+	if (i == w->nSinks) {
+		return;
+	}
+	if (i < w->nSinks-1) {
+		memmove(&w->sinks[i], &w->sinks[i+1],
+		    (w->nSinks - i - 1)*sizeof(AG_EventSink *));
+	}
+	if (--w->nSinks == 0) {
+		Free(w->sinks);
+		w->sinks = NULL;
+	}
+	(void)UpdateEpollWatch(ep, fd);
+}
+
+/* Register a new event sink with epoll. */
+static int
+AddSinkEPOLL(AG_EventSourceEPOLL *_Nonnull ep, AG_EventSink *_Nonnull es)
+{
+	AG_EventSink **sinksNew;
+	AG_EpollWatch *w;
+	int fd;
+
+	switch (es->type) {
+	case AG_SINK_READ:
+	case AG_SINK_WRITE:
+		fd = es->ident;
+		break;
+#  ifdef SYS_pidfd_open
+	case AG_SINK_PROCEVENT:
+		if (es->flags & (AG_PROCEVENT_FORK | AG_PROCEVENT_EXEC)) {
+			AG_SetErrorS("epoll: Only AG_PROCEVENT_EXIT is supported");
+			return (-1);
+		}
+		if ((fd = (int)syscall(SYS_pidfd_open, (pid_t)es->ident, 0)) == -1) {
+			AG_SetError("pidfd_open(%d): %s", es->ident,
+			    AG_Strerror(errno));
+			return (-1);
+		}
+		break;
+#  endif
+	default:
+		return (0);
+	}
+	if (fd < 0) {
+		AG_SetErrorS("Bad file descriptor");
+		return (-1);
+	}
+	AG_MutexLock(&ep->lock);
+	if (GrowEpollWatches(ep, fd) == -1) {
+		goto fail;
+	}
+	w = &ep->watches[fd];
+	if ((sinksNew = TryRealloc(w->sinks, (w->nSinks+1)*sizeof(AG_EventSink *)))
+	    == NULL) {
+		goto fail;
+	}
+	w->sinks = sinksNew;
+	w->sinks[w->nSinks++] = es;
+	if (UpdateEpollWatch(ep, fd) == -1) {
+		RemoveEpollWatchSink(ep, fd, es);
+		goto fail;
+	}
+	AG_MutexUnlock(&ep->lock);
+	return (0);
+fail:
+	AG_MutexUnlock(&ep->lock);
+	if (es->type == AG_SINK_PROCEVENT) {
+		close(fd);
+	}
+	return (-1);
+}
+
+/* Unregister an event sink from epoll. */
+static void
+DelSinkEPOLL(AG_EventSourceEPOLL *_Nonnull ep, AG_EventSink *_Nonnull es)
+{
+	int fd;
+
+	AG_MutexLock(&ep->lock);
+	switch (es->type) {
+	case AG_SINK_READ:
+	case AG_SINK_WRITE:
+		if (es->ident >= 0 && es->ident < ep->nWatches) {
+			RemoveEpollWatchSink(ep, es->ident, es);
+		}
+		break;
+	case AG_SINK_PROCEVENT:
+		/* The pidfd is our own; look it up (unless already reaped). */
+		for (fd = 0; fd < ep->nWatches; fd++) {
+			AG_EpollWatch *w = &ep->watches[fd];
+
+			if (w->nSinks == 1 && w->sinks[0] == es) {
+				RemoveEpollWatchSink(ep, fd, es);
+				close(fd);
+				break;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+	AG_MutexUnlock(&ep->lock);
+}
+
+/*
+ * Standard event sink using epoll(7) and fd-based timers, available on Linux.
+ * Unlike select(2), descriptors remain registered with the kernel across
+ * iterations and only the ready ones are returned.
+ */
+int
+AG_EventSinkEPOLL(void)
+{
+	AG_EventSourceEPOLL *ep = (AG_EventSourceEPOLL *)agEventSource;
+	int rv, i;
+
+restart:
+	rv = epoll_wait(ep->fd, ep->events, AG_EPOLL_EVBUFSIZE,
+	    TAILQ_EMPTY(&agEventSource->spinners) ? -1 : 0);
+	if (rv == -1) {
+		if (errno == EINTR) {
+			goto restart;
+		}
+		AG_SetError("epoll_wait: %s", AG_Strerror(errno));
+		return (-1);
+	}
+
+#  ifdef AG_TIMERS
+	/* 1. Process timer expirations. */
+	AG_LockTiming();
+	for (i = 0; i < rv; i++) {
+		const int fd = ep->events[i].data.fd;
+		Uint64 nExpired;
+		AG_Timer *to;
+		AG_Object *ob;
+		Uint32 rvt;
+
+		AG_MutexLock(&ep->lock);
+		to = (fd < ep->nWatches) ? ep->watches[fd].timer : NULL;
+		AG_MutexUnlock(&ep->lock);
+		if (to == NULL) {
+			continue;
+		}
+		/*
+		 * The timer may have been deleted (and its fd reused by
+		 * a new timer) by a callback earlier in this batch.
+		 */
+		if (read(fd, &nExpired, sizeof(nExpired)) != sizeof(nExpired)) {
+			continue;
+		}
+		ob = to->obj;
+		AG_ObjectLock(ob);
+		AG_TRACE_TIMER_BEGIN(to);
+		rvt = to->fn(to, &to->fnEvent);
+		AG_TRACE_END();
+		if (rvt > 0) {
+			struct itimerspec its;
+
+			its.it_value.tv_sec = rvt/1000;
+			its.it_value.tv_nsec = (rvt % 1000)*1000000L;
+			its.it_interval.tv_sec = 0;
+			its.it_interval.tv_nsec = 0L;
+			if (timerfd_settime(fd, 0, &its, NULL) == -1) {
+				Verbose("timerfd_settime: %s\n", AG_Strerror(errno));
+				AG_DelTimer(ob, to);
+			} else {
+				to->ival = rvt;
+			}
+		} else {
+			AG_DelTimer(ob, to);
+		}
+		AG_ObjectUnlock(ob);
+	}
+	AG_UnlockTiming();
+#  endif /* AG_TIMERS */
+
+	/* 2. Process I/O and process events. */
+	for (i = 0; i < rv; i++) {
+		const int fd = ep->events[i].data.fd;
+		const Uint32 revents = ep->events[i].events;
+		AG_EventSink *es;
+		Uint j;
+
+		for (j = 0; ; ) {
+			/* Sink functions may add or delete sinks. */
+			AG_MutexLock(&ep->lock);
+			if (fd >= ep->nWatches || j >= ep->watches[fd].nSinks) {
+				AG_MutexUnlock(&ep->lock);
+				break;
+			}
+			es = ep->watches[fd].sinks[j];
+			if (es->type == AG_SINK_PROCEVENT) {
+				/* Exit notifications are one-shot like kqueue. */
+				RemoveEpollWatchSink(ep, fd, es);
+				close(fd);
+			}
+			AG_MutexUnlock(&ep->lock);
+
+			switch (es->type) {
+			case AG_SINK_READ:
+				if (revents & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+					es->fn(es, &es->fnArgs);
+				}
+				break;
+			case AG_SINK_WRITE:
+				if (revents & (EPOLLOUT | EPOLLERR)) {
+					es->fn(es, &es->fnArgs);
+				}
+				break;
+			case AG_SINK_PROCEVENT:
+				es->flagsMatched = AG_PROCEVENT_EXIT;
+				es->fn(es, &es->fnArgs);
+				continue;		/* Already removed */
+			default:
+				break;
+			}
+
+			/*
+			 * Advance unless the sink deleted itself (in which
+			 * case the next sink has moved into slot j).
+			 */
+			AG_MutexLock(&ep->lock);
+			if (fd < ep->nWatches && j < ep->watches[fd].nSinks &&
+			    ep->watches[fd].sinks[j] == es) {
+				j++;
+			}
+			AG_MutexUnlock(&ep->lock);
+		}
+	}
+	return (0);
+}
+
+#  ifdef AG_TIMERS
+/*
+ * Add/remove a timerfd-based timer watched by epoll.
+ */
+int
+AG_AddTimerEPOLL(AG_Timer *to, Uint32 ival, int newTimer)
+{
+	AG_EventSourceEPOLL *ep = (AG_EventSourceEPOLL *)agEventSource;
+	struct itimerspec its;
+
+	if (newTimer) {
+		/* Create a timerfd. Store the file descriptor as ID. */
+		if ((to->id = timerfd_create(CLOCK_MONOTONIC,
+		    TFD_NONBLOCK | TFD_CLOEXEC)) == -1) {
+			AG_SetError("timerfd_create: %s", AG_Strerror(errno));
+			return (-1);
+		}
+		AG_MutexLock(&ep->lock);
+		if (GrowEpollWatches(ep, to->id) == -1) {
+			goto fail;
+		}
+		ep->watches[to->id].timer = to;
+		if (UpdateEpollWatch(ep, to->id) == -1) {
+			ep->watches[to->id].timer = NULL;
+			goto fail;
+		}
+		AG_MutexUnlock(&ep->lock);
+	}
+	its.it_value.tv_sec = ival/1000;
+	its.it_value.tv_nsec = (ival % 1000)*1000000L;
+	its.it_interval.tv_sec = 0;
+	its.it_interval.tv_nsec = 0L;
+	if (timerfd_settime(to->id, 0, &its, NULL) == -1) {
+		AG_SetError("timerfd_settime: %s", AG_Strerror(errno));
+		if (newTimer) {
+			AG_DelTimerEPOLL(to);
+			to->id = -1;
+		}
+		return (-1);
+	}
+	to->ival = ival;
+	return (0);
+fail:
+	AG_MutexUnlock(&ep->lock);
+	close(to->id);
+	to->id = -1;
+	return (-1);
+}
+void
+AG_DelTimerEPOLL(AG_Timer *to)
+{
+	AG_EventSourceEPOLL *ep = (AG_EventSourceEPOLL *)agEventSource;
+
+#   ifdef AG_DEBUG
+	if (to->id == -1)
+		AG_FatalError("timerfd inconsistency");
+#   endif
+	AG_MutexLock(&ep->lock);
+	if (to->id < ep->nWatches && ep->watches[to->id].timer == to) {
+		ep->watches[to->id].timer = NULL;
+		(void)UpdateEpollWatch(ep, to->id);
+	}
+	AG_MutexUnlock(&ep->lock);
+	close(to->id);
+}
+#  endif /* AG_TIMERS */
+# endif /* HAVE_EPOLL */
+
 # ifdef HAVE_TIMERFD
 /*
  * Standard event sink using select(2) and fd-based timers,
@@ -1373,7 +2702,9 @@ restart:
 			if (!FD_ISSET(to->id, &rdFds)) {
 				continue;
 			}
+			AG_TRACE_TIMER_BEGIN(to);
 			rvt = to->fn(to, &to->fnEvent);
+			AG_TRACE_END();
 			if (rvt > 0) {
 				its.it_value.tv_sec = rvt/1000;
 				its.it_value.tv_nsec = (rvt % 1000)*1000000L;
@@ -1470,11 +2801,9 @@ AG_EventSinkTIMEDSELECT(void)
 	fd_set rdFds, wrFds;
 	int i, nFds, rv;
 	AG_EventSink *es;
+	struct timeval timeo;
 #  ifdef AG_TIMERS
-	AG_Object *ob, *obNext;
-	AG_Timer *to, *toNext;
-	struct timeval timeo, *pTimeo;
-	Uint32 t, tSoonest;
+	Uint32 tSoonest;
 #  endif
 
 restart:
@@ -1499,14 +2828,7 @@ restart:
 		timeo.tv_usec = 0;
 	} else {
 		AG_LockTiming();
-		t = AG_GetTicks();
-		tSoonest = 0xfffffffe;
-		TAILQ_FOREACH(ob, &agTimerObjQ, tobjs) {
-			TAILQ_FOREACH(to, &ob->timers, pvt.timers) {
-				if ((to->tSched - t) < tSoonest)
-					tSoonest = (to->tSched - t);
-			}
-		}
+		tSoonest = AG_GetNextTimeout(AG_GetTicks());
 		timeo.tv_sec = tSoonest/1000;
 		timeo.tv_usec = (tSoonest % 1000)*1000;
 		AG_UnlockTiming();
@@ -1526,7 +2848,7 @@ restart:
 #  ifdef AG_TIMERS
 	AG_LockTiming();
 	/* 1. Process timer expirations. */
-	AG_ProcessTimeouts(t);
+	AG_ProcessTimeouts(AG_GetTicks());
 #  endif
 	if (rv > 0) {
 		/* 2. Process I/O events */
@@ -84,9 +84,12 @@ struct ag_timer;
 struct ag_event_sink;
 
 /* Event handler / virtual function */
+typedef Uint32 AG_EventAtom;		/* Interned event name (0 = none) */
+
 typedef struct ag_event {
 	char name[AG_EVENT_NAME_MAX];		/* String identifier */
 	AG_VoidFn fn;				/* Callback function */
+	AG_EventAtom atom;			/* Interned name */
 #if AG_MODEL == AG_SMALL
 	Uint8 argc, argc0;			/* Argument count & offset */
 #else
@@ -99,6 +102,31 @@ typedef struct ag_event {
 #define AGEVENT(ev)    ((struct ag_event *)(ev))
 #define AGFUNCTION(ev) ((struct ag_event *)(ev))
 
+#if AG_MODEL != AG_SMALL
+/* Per-object index of event handlers (by atom). */
+typedef struct ag_event_index_ent {
+	AG_EventAtom atom;			/* Atom (0 = empty slot) */
+	Uint nHandlers;				/* Handlers with this atom */
+	struct ag_event *_Nullable first;	/* First handler in list */
+} AG_EventIndexEnt;
+
+typedef struct ag_event_index {
+	AG_EventIndexEnt *_Nullable ents;	/* Slots (or NULL = no index) */
+	Uint size;				/* Number of slots (2^n) */
+	Uint nUsed;				/* Used slots */
+	Uint nEvents;				/* Total event handlers */
+	Uint32 _pad;
+} AG_EventIndex;
+
+/* Event queued by AG_QueueEvent() for delivery by the event loop thread. */
+typedef struct ag_queued_event {
+	struct ag_queued_event *_Nullable next;	/* Next in object's queue */
+	AG_EventAtom atom;			/* Event name (interned) */
+	Uint32 _pad;
+	AG_Event args;				/* Arguments (parsed once) */
+} AG_QueuedEvent;
+#endif /* !AG_SMALL */
+
 /* Low-level event sink */
 enum ag_event_sink_type {
 	AG_SINK_NONE,
@@ -129,6 +157,7 @@ typedef struct ag_event_sink {
 #define AG_FSEVENT_LINK		0x0010		/* Link count changed */
 #define AG_FSEVENT_RENAME	0x0020		/* Referenced file renamed */
 #define AG_FSEVENT_REVOKE	0x0040		/* Filesystem unmount / revoke() */
+#define AG_IOEVENT_EDGE		0x0100		/* Edge-triggered readiness (epoll) */
 #define AG_PROCEVENT_EXIT	0x1000		/* Process exited */
 #define AG_PROCEVENT_FORK	0x2000		/* Process forked */
 #define AG_PROCEVENT_EXEC	0x4000		/* Process exec'd */
@@ -397,11 +426,28 @@ void AG_PostEventByPtr(void *_Nonnull, AG_Event *_Nonnull,
                        const char *_Nullable, ...);
 void AG_PostEvent(void *_Nonnull, const char *_Nonnull,
                   const char *_Nullable, ...);
+void AG_PostEventByAtom(void *_Nonnull, AG_EventAtom,
+                        const char *_Nullable, ...);
 void AG_EventGetArgs(AG_Event *_Nonnull, const char *_Nullable, va_list);
 void AG_ForwardEvent(void *_Nonnull, const AG_Event *_Nonnull);
 
 AG_Event *_Nullable AG_FindEventHandler(void *_Nonnull, const char *_Nonnull);
 
+void         AG_InitEventAtoms(void);
+AG_EventAtom AG_GetEventAtom(const char *_Nonnull);
+AG_EventAtom AG_LookupEventAtom(const char *_Nonnull);
+#if AG_MODEL != AG_SMALL
+void         AG_EventIndexFree(AG_EventIndex *_Nonnull);
+
+void AG_InitEventQueue(void);
+int  AG_QueueEvent(void *_Nonnull, const char *_Nonnull,
+                   const char *_Nullable, ...);
+int  AG_QueueEventByAtom(void *_Nonnull, AG_EventAtom,
+                         const char *_Nullable, ...);
+Uint AG_ProcessQueuedEvents(void);
+void AG_CancelQueuedEvents(void *_Nonnull);
+#endif
+
 #ifdef AG_TIMERS
 int AG_SchedEvent(void *_Nonnull, Uint32, const char *_Nullable,
                   const char *_Nullable, ...);
@@ -428,10 +474,13 @@ void                     AG_TerminateEv(AG_Event *_Nonnull);
 # ifdef AG_TIMERS
 int                      AG_AddTimerKQUEUE(struct ag_timer *_Nonnull, Uint32, int);
 void                     AG_DelTimerKQUEUE(struct ag_timer *_Nonnull);
+int                      AG_AddTimerEPOLL(struct ag_timer *_Nonnull, Uint32, int);
+void                     AG_DelTimerEPOLL(struct ag_timer *_Nonnull);
 int                      AG_AddTimerTIMERFD(struct ag_timer *_Nonnull, Uint32, int);
 void                     AG_DelTimerTIMERFD(struct ag_timer *_Nonnull);
 # endif
 int                      AG_EventSinkKQUEUE(void);
+int                      AG_EventSinkEPOLL(void);
 int                      AG_EventSinkTIMERFD(void);
 int                      AG_EventSinkTIMEDSELECT(void);
 int                      AG_EventSinkSELECT(void);
@@ -147,13 +147,10 @@ ag_object_find_child(void *pParent, const char *name)
 #endif
 {
 	AG_Object *pObj = AGOBJECT(pParent);
-	AG_Object *cObj;
+	void *cObj;
 
 	AG_LockVFS(pObj);
-	AGOBJECT_FOREACH_CHILD(cObj, pObj, ag_object) {
-		if (strcmp(cObj->name, name) == 0)
-			break;
-	}
+	cObj = AG_ObjectFindChildLockless(pObj, name);
 	AG_UnlockVFS(pObj);
 	return (cObj);
 }
@@ -267,14 +264,7 @@ int
 ag_defined(void *pObj, const char *name)
 #endif
 {
-	AG_Object *obj = AGOBJECT(pObj);
-	AG_Variable *V;
-
-	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(name, V->name) == 0)
-			return (1);
-	}
-	return (0);
+	return (AG_LookupVariable(pObj, name) != NULL);
 }
 
 /*
@@ -290,17 +280,12 @@ AG_Variable *
 ag_fetch_variable(void *pObj, const char *name, enum ag_variable_type type)
 #endif
 {
-	AG_Object *obj = (AG_Object *)pObj;
 	AG_Variable *V;
 
-	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0)
-			break;
-	}
-	if (V == NULL) {
-		V = AG_Malloc(sizeof(AG_Variable));
+	if ((V = AG_LookupVariable(pObj, name)) == NULL) {
+		V = AG_ObjectSubAlloc(pObj, &agVariablePool);
 		AG_InitVariable(V, type, name);
-		AG_TAILQ_INSERT_TAIL(&obj->vars, V, vars);
+		AG_InsertVariable(pObj, V);
 	}
 	return (V);
 }
@@ -354,14 +339,9 @@ AG_Variable *
 ag_access_variable(void *pObj, const char *name)
 #endif
 {
-	AG_Object *obj = AGOBJECT(pObj);
 	AG_Variable *V, *Vtgt;
 
-	AG_TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(name, V->name) == 0)
-			break;
-	}
-	if (V == NULL) {
+	if ((V = AG_LookupVariable(pObj, name)) == NULL) {
 		return (NULL);
 	}
 	AG_LockVariable(V);
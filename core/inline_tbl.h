@@ -1,6 +1,51 @@
 /*	Public domain	*/
 
-/* General hash function */
+/*
+ * Hash a NUL-terminated string (32-bit FNV-1a).
+ */
+#ifdef AG_INLINE_HEADER
+static __inline__ Uint32 _Pure_Attribute
+AG_HashString(const char *_Nonnull s)
+#else
+Uint32
+ag_hash_string(const char *s)
+#endif
+{
+	Uint32 h = 2166136261U;
+	const Uchar *p;
+
+	for (p = (const Uchar *)s; *p != '\0'; p++) {
+		h ^= (Uint32)*p;
+		h *= 16777619U;
+	}
+	return (h);
+}
+
+/*
+ * Hash len bytes of arbitrary data (32-bit FNV-1a).
+ */
+#ifdef AG_INLINE_HEADER
+static __inline__ Uint32 _Pure_Attribute
+AG_HashBuffer(const void *_Nonnull buf, AG_Size len)
+#else
+Uint32
+ag_hash_buffer(const void *buf, AG_Size len)
+#endif
+{
+	Uint32 h = 2166136261U;
+	const Uchar *p = buf;
+
+	while (len--) {
+		h ^= (Uint32)*p++;
+		h *= 16777619U;
+	}
+	return (h);
+}
+
+/*
+ * General hash function (FNV-1a). In GROWABLE mode, the full hash is
+ * returned. Otherwise, the result is the bucket index.
+ */
 #ifdef AG_INLINE_HEADER
 static __inline__ Uint _Pure_Attribute
 AG_TblHash(AG_Tbl *_Nonnull tbl, const char *_Nonnull key)
@@ -9,13 +54,12 @@ Uint
 ag_tbl_hash(AG_Tbl *tbl, const char *key)
 #endif
 {
-	Uint h;
-	Uchar *p;
+	const Uint32 h = AG_HashString(key);
 
-	for (h = 0, p = (Uchar *)key; *p != '\0'; p++) {
-		h = 31*h + *p;
+	if (tbl->flags & AG_TBL_GROWABLE) {
+		return (Uint)(h);
 	}
-	return (h % tbl->nBuckets);
+	return (Uint)(h % tbl->nBuckets);
 }
 
 /*
@@ -69,6 +69,11 @@ AG_Mutex         agClassLock;           /* Lock on class tables */
 AG_ObjectClass **agClasses;		/* Class table (flat array) */
 Uint             agClassCount = 0;
 AG_Tbl          *agClassTbl = NULL;	/* Class table (hash) */
+AG_Pool          agEventPool;		/* Event handlers of pooled objects */
+AG_Pool          agVariablePool;	/* Variables of pooled objects */
+#ifdef AG_TIMERS
+AG_Pool          agTimerPool;		/* Auto-free timers of pooled objects */
+#endif
 #ifdef AG_NAMESPACES
 AG_Namespace *agNamespaceTbl = NULL;	/* Namespace table */
 int           agNamespaceCount = 0;
@@ -89,7 +94,7 @@ AG_ObjectInit(void *pObj, void *pClass)
 	AG_Object *ob = pObj;
 	AG_ObjectClass *C = (pClass != NULL) ? AGOBJECTCLASS(pClass) :
 	                                       &agObjectClass;
-	AG_ObjectClass **hier;
+	AG_ObjectClass *const *hier;
 	int i, nHier;
 	
 	ob->tag = agObjectSignature;
@@ -104,24 +109,36 @@ AG_ObjectInit(void *pObj, void *pClass)
 	ob->parent = NULL;
 	ob->root = ob;
 	ob->flags = 0;
+	/*
+	 * Flag instances carved out of the class pool by AG_ObjectAlloc(), so
+	 * that AG_ObjectDestroy() can tell them from malloc()'d or static ones.
+	 */
+	if (C->pool != NULL && AG_PoolOwns(C->pool, ob))
+		ob->flags |= AG_OBJECT_POOLED;
 
 	AG_MutexInitRecursive(&ob->lock);
 	
 	TAILQ_INIT(&ob->events);
+#if AG_MODEL != AG_SMALL
+	memset(&ob->evIndex, 0, sizeof(AG_EventIndex));
+	ob->evQueue = NULL;
+	ob->evQueueNext = NULL;
+	ob->chldIndex = NULL;
+#endif
 #ifdef AG_TIMERS
 	TAILQ_INIT(&ob->timers);
 #endif
 	TAILQ_INIT(&ob->vars);
+	memset(&ob->varIndex, 0, sizeof(AG_VariableIndex));
 	TAILQ_INIT(&ob->children);
 
-	if (AG_ObjectGetInheritHier(ob, &hier, &nHier) != 0) {
+	if (AG_ObjectGetInheritHierCached(ob, &hier, &nHier) != 0) {
 		AG_FatalError(NULL);
 	}
 	for (i = 0; i < nHier; i++) {
 		if (hier[i]->init != NULL)
 			hier[i]->init(ob);
 	}
-	free(hier);
 }
 
 /* Initialize an AG_Object instance (and set the STATIC flag on it). */
@@ -152,7 +169,7 @@ AG_ObjectNew(void *parent, const char *name, AG_ObjectClass *C)
 		}
 	}
 
-	if ((obj = TryMalloc(C->size)) == NULL) {
+	if ((obj = AG_ObjectTryAlloc(C)) == NULL) {
 		return (NULL);
 	}
 	AG_ObjectInit(obj, C);
@@ -163,6 +180,68 @@ AG_ObjectNew(void *parent, const char *name, AG_ObjectClass *C)
 	return (obj);
 }
 
+/*
+ * Allocate uninitialized storage for an instance of class C, from the
+ * class pool if pooling is enabled (see AG_ClassSetPooling()).
+ * AG_ObjectDestroy() returns the storage to where it came from.
+ */
+void *
+AG_ObjectTryAlloc(void *pClass)
+{
+	AG_ObjectClass *C = pClass;
+
+	if (C->pool != NULL) {
+		return AG_PoolTryAlloc(C->pool);
+	}
+	return TryMalloc(C->size);
+}
+
+void *
+AG_ObjectAlloc(void *pClass)
+{
+	void *p;
+
+	if ((p = AG_ObjectTryAlloc(pClass)) == NULL) {
+		AG_FatalError(NULL);
+	}
+	return (p);
+}
+
+/*
+ * Allocate a structure owned by an object (such as an event handler or
+ * a variable) from the given pool if the object is AG_OBJECT_POOLED.
+ * It must be released with AG_ObjectSubFree().
+ */
+void *
+AG_ObjectTrySubAlloc(void *obj, AG_Pool *pool)
+{
+	if (OBJECT(obj)->flags & AG_OBJECT_POOLED) {
+		return AG_PoolTryAlloc(pool);
+	}
+	return TryMalloc(pool->size);
+}
+
+void *
+AG_ObjectSubAlloc(void *obj, AG_Pool *pool)
+{
+	void *p;
+
+	if ((p = AG_ObjectTrySubAlloc(obj, pool)) == NULL) {
+		AG_FatalError(NULL);
+	}
+	return (p);
+}
+
+void
+AG_ObjectSubFree(void *obj, AG_Pool *pool, void *p)
+{
+	if (OBJECT(obj)->flags & AG_OBJECT_POOLED) {
+		AG_PoolFree(pool, p);
+	} else {
+		free(p);
+	}
+}
+
 /*
  * Restore an object to an initial state prior to deserialization or release.
  */
@@ -170,12 +249,12 @@ void
 AG_ObjectReset(void *p)
 {
 	AG_Object *ob = p;
-	AG_ObjectClass **hier;
+	AG_ObjectClass *const *hier;
 	int i, nHier;
 
 	AG_ObjectLock(ob);
 
-	if (AG_ObjectGetInheritHier(ob, &hier, &nHier) != 0) {
+	if (AG_ObjectGetInheritHierCached(ob, &hier, &nHier) != 0) {
 		AG_FatalError(NULL);
 	}
 	for (i = nHier-1; i >= 0; i--) {
@@ -184,7 +263,6 @@ AG_ObjectReset(void *p)
 	}
 	AG_ObjectUnlock(ob);
 
-	free(hier);
 }
 
 #if AG_MODEL != AG_SMALL
@@ -358,6 +436,229 @@ AG_SetFn(void *p, const char *name, AG_EventFn fn, const char *fmt, ...)
 	return (V);
 }
 
+#if AG_MODEL != AG_SMALL
+/*
+ * Index of the child objects of a parent by name. It is created on demand
+ * by lookups which had to scan at least AG_OBJECT_INDEX_MIN children, and
+ * is then kept up to date by AG_ObjectAttach(), AG_ObjectDetach() and
+ * AG_ObjectSetName(). Unnamed children are not indexed. Names shared by
+ * more than one child are flagged ambiguous and resolved by a linear search
+ * (so that the first match in the children list wins).
+ */
+typedef struct ag_object_index_ent {
+	AG_Object *_Nullable obj;	/* Child object (NULL = empty) */
+	Uint32 hash;			/* Hash of name */
+	Uint32 ambiguous;		/* Name is shared by other children */
+} AG_ObjectIndexEnt;
+
+struct ag_object_index {
+	AG_ObjectIndexEnt *_Nonnull ents;
+	Uint nEnts;			/* Table size (power of two) */
+	Uint nUsed;			/* Used entries */
+};
+
+static AG_ObjectIndexEnt *_Nullable
+IndexFind(struct ag_object_index *_Nonnull idx, Uint32 h,
+    const char *_Nonnull name)
+{
+	const Uint mask = idx->nEnts - 1;
+	AG_ObjectIndexEnt *ent;
+	Uint i;
+
+	for (i = h & mask; (ent = &idx->ents[i])->obj != NULL; i = (i+1) & mask) {
+		if (ent->hash == h && strcmp(ent->obj->name, name) == 0)
+			return (ent);
+	}
+	return (NULL);
+}
+
+static void
+IndexPut(struct ag_object_index *_Nonnull idx, AG_Object *_Nonnull obj,
+    Uint32 h, Uint32 ambiguous)
+{
+	const Uint mask = idx->nEnts - 1;
+	Uint i;
+
+	for (i = h & mask; idx->ents[i].obj != NULL; i = (i+1) & mask)
+		;;
+	idx->ents[i].obj = obj;
+	idx->ents[i].hash = h;
+	idx->ents[i].ambiguous = ambiguous;
+	idx->nUsed++;
+}
+
+static int
+IndexResize(struct ag_object_index *_Nonnull idx, Uint nEntsNew)
+{
+	AG_ObjectIndexEnt *entsOld = idx->ents, *entsNew;
+	Uint i, nEntsOld = idx->nEnts;
+
+	if ((entsNew = TryMalloc(nEntsNew*sizeof(AG_ObjectIndexEnt))) == NULL) {
+		return (-1);
+	}
+	memset(entsNew, 0, nEntsNew*sizeof(AG_ObjectIndexEnt));
+	idx->ents = entsNew;
+	idx->nEnts = nEntsNew;
+	idx->nUsed = 0;
+	for (i = 0; i < nEntsOld; i++) {
+		if (entsOld[i].obj != NULL)
+			IndexPut(idx, entsOld[i].obj, entsOld[i].hash,
+			    entsOld[i].ambiguous);
+	}
+	free(entsOld);
+	return (0);
+}
+
+static void
+IndexFree(AG_Object *_Nonnull parent)
+{
+	if (parent->chldIndex != NULL) {
+		free(parent->chldIndex->ents);
+		free(parent->chldIndex);
+		parent->chldIndex = NULL;
+	}
+}
+
+/* Enter a newly attached (or renamed) child into its parent's index. */
+static void
+IndexInsert(AG_Object *_Nonnull parent, AG_Object *_Nonnull chld)
+{
+	struct ag_object_index *idx = parent->chldIndex;
+	AG_ObjectIndexEnt *ent;
+	Uint32 h;
+
+	if (idx == NULL || chld->name[0] == '\0')
+		return;
+
+	h = AG_HashString(chld->name);
+	if ((ent = IndexFind(idx, h, chld->name)) != NULL) {
+		ent->ambiguous = 1;
+		return;
+	}
+	if ((idx->nUsed+1) << 1 > idx->nEnts &&
+	    IndexResize(idx, idx->nEnts << 1) == -1) {
+		IndexFree(parent);			/* Fall back to scanning */
+		return;
+	}
+	IndexPut(idx, chld, h, 0);
+}
+
+/* Remove a child which is about to be detached (or renamed). */
+static void
+IndexRemove(AG_Object *_Nonnull parent, AG_Object *_Nonnull chld)
+{
+	struct ag_object_index *idx = parent->chldIndex;
+	AG_ObjectIndexEnt *ent, *entNext;
+	AG_Object *other, *otherFirst = NULL;
+	Uint i, j, k, mask, nOthers = 0;
+
+	if (idx == NULL || chld->name[0] == '\0' ||
+	    (ent = IndexFind(idx, AG_HashString(chld->name),
+	                     chld->name)) == NULL)
+		return;
+
+	if (ent->ambiguous) {
+		AGOBJECT_FOREACH_CHILD(other, parent, ag_object) {
+			if (other == chld ||
+			    strcmp(other->name, chld->name) != 0) {
+				continue;
+			}
+			if (otherFirst == NULL) {
+				otherFirst = other;
+			}
+			nOthers++;
+		}
+		if (otherFirst != NULL) {
+			ent->obj = otherFirst;
+			ent->ambiguous = (nOthers > 1);
+			return;
+		}
+	}
+
+	/* Delete with backward shift to keep the probe sequences intact. */
+	mask = idx->nEnts - 1;
+	i = (Uint)(ent - idx->ents);
+	for (j = (i+1) & mask; (entNext = &idx->ents[j])->obj != NULL;
+	     j = (j+1) & mask) {
+		k = entNext->hash & mask;
+		if ((j > i && (k <= i || k > j)) ||
+		    (j < i && (k <= i && k > j))) {
+			idx->ents[i] = *entNext;
+			i = j;
+		}
+	}
+	idx->ents[i].obj = NULL;
+	idx->nUsed--;
+}
+
+/* Build the index of a parent's children. */
+static void
+IndexBuild(AG_Object *_Nonnull parent, Uint nChildren)
+{
+	struct ag_object_index *idx;
+	AG_Object *chld;
+	Uint nEnts = 32;
+
+	while (nEnts < (nChildren << 1)) {
+		nEnts <<= 1;
+	}
+	if ((idx = TryMalloc(sizeof(struct ag_object_index))) == NULL) {
+		return;
+	}
+	if ((idx->ents = TryMalloc(nEnts*sizeof(AG_ObjectIndexEnt))) == NULL) {
+		free(idx);
+		return;
+	}
+	memset(idx->ents, 0, nEnts*sizeof(AG_ObjectIndexEnt));
+	idx->nEnts = nEnts;
+	idx->nUsed = 0;
+	parent->chldIndex = idx;
+
+	AGOBJECT_FOREACH_CHILD(chld, parent, ag_object) {
+		IndexInsert(parent, chld);
+	}
+}
+#endif /* !AG_SMALL */
+
+/*
+ * Lookup a direct child object by name.
+ * The VFS of the parent object must be locked.
+ */
+void *
+AG_ObjectFindChildLockless(AG_Object *parent, const char *name)
+{
+	AG_Object *chld;
+#if AG_MODEL != AG_SMALL
+	AG_ObjectIndexEnt *ent;
+	Uint nScanned = 0;
+
+	if (parent->chldIndex != NULL && name[0] != '\0') {
+		if ((ent = IndexFind(parent->chldIndex, AG_HashString(name),
+		    name)) == NULL) {
+			return (NULL);
+		}
+		if (!ent->ambiguous) {
+			return (ent->obj);
+		}
+	}
+	AGOBJECT_FOREACH_CHILD(chld, parent, ag_object) {
+		if (strcmp(chld->name, name) == 0) {
+			break;
+		}
+		nScanned++;
+	}
+	if (nScanned >= AG_OBJECT_INDEX_MIN && parent->chldIndex == NULL) {
+		IndexBuild(parent, nScanned);
+	}
+#else
+	AGOBJECT_FOREACH_CHILD(chld, parent, ag_object) {
+		if (strcmp(chld->name, name) == 0)
+			break;
+	}
+#endif
+	return (chld);
+}
+
 /* Attach an object to another object. */
 void
 AG_ObjectAttach(void *parentp, void *pChld)
@@ -393,6 +694,10 @@ AG_ObjectAttach(void *parentp, void *pChld)
 		     ev->fn != NULL) {
 			ev->fn(ev);
 		}
+#if AG_MODEL != AG_SMALL
+		if (chld->parent == parent)
+			IndexInsert(parent, chld);
+#endif
 		goto out;
 	}
 
@@ -404,6 +709,9 @@ AG_ObjectAttach(void *parentp, void *pChld)
 	
 	/* Attach the object. */
 	TAILQ_INSERT_TAIL(&parent->children, chld, cobjs);
+#if AG_MODEL != AG_SMALL
+	IndexInsert(parent, chld);
+#endif
       
 	/* Notify the child object. */
 	AG_PostEvent(chld, "attached", "%p", parent);
@@ -450,6 +758,9 @@ AG_ObjectDetach(void *pChld)
 	AG_LockVFS(root);
 	AG_ObjectLock(parent);
 	AG_ObjectLock(chld);
+#endif
+#if AG_MODEL != AG_SMALL
+	IndexRemove(parent, chld);
 #endif
 	/* Call the detach function if one is defined. */
 	if (AG_Defined(chld, "detach-fn")) {
@@ -511,6 +822,9 @@ AG_ObjectDetachLockless(void *pChld)
 #ifdef AG_TYPE_SAFETY
 	if (!AG_OBJECT_VALID(chld)) { AG_FatalErrorV("E36a", "Child object is invalid"); }
 	if (!AG_OBJECT_VALID(parent)) { AG_FatalErrorV("E36b", "Parent object is invalid"); }
+#endif
+#if AG_MODEL != AG_SMALL
+	IndexRemove(parent, chld);
 #endif
 	if (AG_Defined(chld, "detach-fn")) {
 		AG_Event *ev;
@@ -548,38 +862,37 @@ AG_ObjectDetachLockless(void *pChld)
 }
 
 /* Traverse the object tree using a pathname. */
-static void *_Nullable _Pure_Attribute
-FindObjectByName(const AG_Object *_Nonnull parent, const char *_Nonnull name)
+static void *_Nullable
+FindObjectByName(AG_Object *_Nonnull parent, const char *_Nonnull name)
 {
-	char chldName[AG_OBJECT_PATH_MAX];
-	void *rv;
-	char *s;
-	AG_Object *child;
+	char chldName[AG_OBJECT_NAME_MAX];
+	AG_Object *ob = parent;
+	const char *s, *sep;
+	AG_Size len;
 
-	if (Strlcpy(chldName, name, sizeof(chldName)) >= sizeof(chldName)) {
+	if (strlen(name) >= AG_OBJECT_PATH_MAX) {
 		AG_SetErrorS(_("Path overflow"));
 		return (NULL);
 	}
+	for (s = name; ; s = &sep[1]) {
+		if ((sep = strchr(s, AG_PATHSEPCHAR)) != NULL) {
+			len = (AG_Size)(sep - s);
+		} else {
+			len = strlen(s);
+		}
+		if (len >= sizeof(chldName)) {
+			return (NULL);
+		}
+		memcpy(chldName, s, len);
+		chldName[len] = '\0';
 
-	if ((s = strchr(chldName, AG_PATHSEPCHAR)) != NULL) {
-		*s = '\0';
-	}
-	TAILQ_FOREACH(child, &parent->children, cobjs) {
-		if (strcmp(child->name, chldName) != 0)
-			continue;
-
-		if ((s = strchr(name, AG_PATHSEPCHAR)) != NULL &&
-		    s[1] != '\0') {
-			rv = FindObjectByName(child, &s[1]);
-			if (rv != NULL) {
-				return (rv);
-			} else {
-				return (NULL);
-			}
+		if ((ob = AG_ObjectFindChildLockless(ob, chldName)) == NULL) {
+			return (NULL);
 		}
-		return (child);
+		if (sep == NULL || sep[1] == '\0')
+			break;
 	}
-	return (NULL);
+	return (ob);
 }
 
 /*
@@ -778,9 +1091,10 @@ AG_ObjectFreeVariables(void *pObj)
 	     V = Vnext) {
 		Vnext = TAILQ_NEXT(V, vars);
 		AG_FreeVariable(V);
-		free(V);
+		AG_ObjectSubFree(ob, &agVariablePool, V);
 	}
 	TAILQ_INIT(&ob->vars);
+	AG_VariableIndexFree(&ob->varIndex);
 	AG_ObjectUnlock(ob);
 }
 
@@ -795,9 +1109,12 @@ AG_ObjectFreeEvents(AG_Object *ob)
 	     ev != TAILQ_END(&ob->events);
 	     ev = evNext) {
 		evNext = TAILQ_NEXT(ev, events);
-		free(ev);
+		AG_ObjectSubFree(ob, &agEventPool, ev);
 	}
 	TAILQ_INIT(&ob->events);
+#if AG_MODEL != AG_SMALL
+	AG_EventIndexFree(&ob->evIndex);
+#endif
 	AG_ObjectUnlock(ob);
 }
 
@@ -811,7 +1128,7 @@ void
 AG_ObjectDestroy(void *p)
 {
 	AG_Object *ob = p;
-	AG_ObjectClass **hier;
+	AG_ObjectClass *const *hier;
 	AG_Object *child, *childNext;
 	AG_Variable *V, *Vnext;
 	AG_Event *ev, *evNext;
@@ -845,11 +1162,17 @@ AG_ObjectDestroy(void *p)
 		AG_ObjectDestroy(child);
 	}
 
+#if AG_MODEL != AG_SMALL
+	IndexFree(ob);
+
+	/* Discard any events still queued by AG_QueueEvent(). */
+	AG_CancelQueuedEvents(ob);
+#endif
 	/*
 	 * Invoke reset() and destroy() for every class in the object's
 	 * inheritance hierarchy.
 	 */
-	if (AG_ObjectGetInheritHier(ob, &hier, &nHier) != 0) {
+	if (AG_ObjectGetInheritHierCached(ob, &hier, &nHier) != 0) {
 		AG_FatalError(NULL);
 	}
 	for (i = nHier-1; i >= 0; i--) {
@@ -858,7 +1181,6 @@ AG_ObjectDestroy(void *p)
 		if (hier[i]->destroy != NULL)
 			hier[i]->destroy(ob);
 	}
-	free(hier);
 
 	/*
 	 * Release defined variables and event handler structures.
@@ -868,14 +1190,18 @@ AG_ObjectDestroy(void *p)
 	     V = Vnext) {
 		Vnext = TAILQ_NEXT(V, vars);
 		AG_FreeVariable(V);
-		free(V);
+		AG_ObjectSubFree(ob, &agVariablePool, V);
 	}
+	AG_VariableIndexFree(&ob->varIndex);
 	for (ev = TAILQ_FIRST(&ob->events);
 	     ev != TAILQ_END(&ob->events);
 	     ev = evNext) {
 		evNext = TAILQ_NEXT(ev, events);
-		free(ev);
+		AG_ObjectSubFree(ob, &agEventPool, ev);
 	}
+#if AG_MODEL != AG_SMALL
+	AG_EventIndexFree(&ob->evIndex);
+#endif
 
 	/* Invalidate the validity tag and class ID. */
 	ob->tag = 0;
@@ -885,8 +1211,13 @@ AG_ObjectDestroy(void *p)
 	AG_MutexDestroy(&ob->lock);
 
 	/* Release the object structure (if dynamically allocated). */
-	if ((ob->flags & AG_OBJECT_STATIC) == 0)
-		free(ob);
+	if ((ob->flags & AG_OBJECT_STATIC) == 0) {
+		if (ob->flags & AG_OBJECT_POOLED) {
+			AG_PoolFree(ob->cls->pool, ob);
+		} else {
+			free(ob);
+		}
+	}
 }
 
 #ifdef AG_SERIALIZATION
@@ -1248,7 +1579,7 @@ AG_ObjectLoadGenericFromFile(void *p, const char *pPath)
 #ifdef DEBUG_SERIALIZATION
 	Debug(ob, "Loading generic data from %s\n", path);
 #endif
-	if ((ds = AG_OpenFile(path, "rb")) == NULL)
+	if ((ds = AG_OpenFileMapped(path)) == NULL)
 		goto fail_unlock;
 
 	/* Free any resident dataset in order to clear the dependencies. */
@@ -1342,13 +1673,13 @@ AG_ObjectLoadGenericFromFile(void *p, const char *pPath)
 			goto fail;
 	}
 
-	AG_CloseFile(ds);
+	AG_CloseDataSource(ds);
 	AG_ObjectUnlock(ob);
 	AG_UnlockVFS(ob);
 	return (0);
 fail:
 	AG_ObjectReset(ob);
-	AG_CloseFile(ds);
+	AG_CloseDataSource(ds);
 fail_unlock:
 	AG_ObjectUnlock(ob);
 	AG_UnlockVFS(ob);
@@ -1364,7 +1695,7 @@ AG_ObjectLoadDataFromFile(void *p, int *dataFound, const char *pPath)
 	AG_Object *ob = p;
 	AG_DataSource *ds;
 	AG_Version ver;
-	AG_ObjectClass **hier;
+	AG_ObjectClass *const *hier;
 	int i, nHier;
 
 	AG_LockVFS(ob);
@@ -1384,7 +1715,7 @@ AG_ObjectLoadDataFromFile(void *p, int *dataFound, const char *pPath)
 #ifdef DEBUG_SERIALIZATION
 	Debug(ob, "Loading dataset from %s\n", path);
 #endif
-	if ((ds = AG_OpenFile(path, "rb")) == NULL) {
+	if ((ds = AG_OpenFileMapped(path)) == NULL) {
 		*dataFound = 0;
 		goto fail_unlock;
 	}
@@ -1401,7 +1732,7 @@ AG_ObjectLoadDataFromFile(void *p, int *dataFound, const char *pPath)
 		goto fail;
 #endif
 	}
-	if (AG_ObjectGetInheritHier(ob, &hier, &nHier) == -1)
+	if (AG_ObjectGetInheritHierCached(ob, &hier, &nHier) == -1)
 		goto fail;
 
 	AG_ObjectReset(ob);
@@ -1418,19 +1749,17 @@ AG_ObjectLoadDataFromFile(void *p, int *dataFound, const char *pPath)
 #else
 			AG_SetErrorS("E16");
 #endif
-			free(hier);
 			goto fail;
 		}
 	}
-	free(hier);
 
-	AG_CloseFile(ds);
+	AG_CloseDataSource(ds);
 	AG_PostEvent(ob->root, "object-post-load", "%p,%s", ob, path);
 	AG_ObjectUnlock(ob);
 	AG_UnlockVFS(ob);
 	return (0);
 fail:
-	AG_CloseFile(ds);
+	AG_CloseDataSource(ds);
 fail_unlock:
 	AG_ObjectUnlock(ob);
 	AG_UnlockVFS(ob);
@@ -1485,7 +1814,7 @@ AG_ObjectSerialize(void *p, AG_DataSource *ds)
 {
 	AG_Object *ob = p;
 	AG_Offset dataOffs;
-	AG_ObjectClass **hier;
+	AG_ObjectClass *const *hier;
 	int i, nHier;
 #ifdef AG_DEBUG
 	int debugSave;
@@ -1524,7 +1853,7 @@ AG_ObjectSerialize(void *p, AG_DataSource *ds)
 		debugSave = 0;
 	}
 #endif
-	if (AG_ObjectGetInheritHier(ob, &hier, &nHier) == -1) {
+	if (AG_ObjectGetInheritHierCached(ob, &hier, &nHier) == -1) {
 		goto fail;
 	}
 	for (i = 0; i < nHier; i++) {
@@ -1533,12 +1862,9 @@ AG_ObjectSerialize(void *p, AG_DataSource *ds)
 #endif
 		if (hier[i]->save == NULL)
 			continue;
-		if (hier[i]->save(ob, ds) == -1) {
-			free(hier);
+		if (hier[i]->save(ob, ds) == -1)
 			goto fail;
-		}
 	}
-	free(hier);
 
 #ifdef AG_DEBUG
 	if (ob->flags & AG_OBJECT_DEBUG_DATA)
@@ -1565,7 +1891,7 @@ AG_ObjectUnserialize(void *p, AG_DataSource *ds)
 	AG_Object *ob = p;
 	AG_ObjectHeader oh;
 	AG_Version ver;
-	AG_ObjectClass **hier = NULL;
+	AG_ObjectClass *const *hier = NULL;
 	Uint32 count;
 	int i, nHier;
 #ifdef AG_DEBUG
@@ -1612,7 +1938,7 @@ AG_ObjectUnserialize(void *p, AG_DataSource *ds)
 		debugSave = 0;
 #endif
 	}
-	if (AG_ObjectGetInheritHier(ob, &hier, &nHier) == -1) {
+	if (AG_ObjectGetInheritHierCached(ob, &hier, &nHier) == -1) {
 		goto fail_dbg;
 	}
 	for (i = 0; i < nHier; i++) {
@@ -1627,11 +1953,9 @@ AG_ObjectUnserialize(void *p, AG_DataSource *ds)
 #else
 			AG_SetErrorS("E18");
 #endif
-			free(hier);
 			goto fail_dbg;
 		}
 	}
-	free(hier);
 
 #ifdef AG_DEBUG
 	if (ob->flags & AG_OBJECT_DEBUG_DATA)
@@ -1739,12 +2063,16 @@ AG_ObjectLoadFromDB(void *obj, AG_Db *db, const AG_Dbt *key)
 		return (-1);
 	}
 	if ((ds = AG_OpenCore(val.data, val.size)) == NULL) {
+		free(val.data);
 		return (-1);
 	}
 	if (AG_ObjectUnserialize(obj, ds) == -1) {
 		AG_CloseCore(ds);
+		free(val.data);
 		return (-1);
 	}
+	AG_CloseCore(ds);
+	free(val.data);
 	return (0);
 }
 
@@ -1754,7 +2082,7 @@ AG_ObjectSaveToDB(void *pObj, AG_Db *db, const AG_Dbt *key)
 {
 	AG_Object *obj = pObj;
 	AG_DataSource *ds;
-	AG_Dbt dbKey, dbVal;
+	AG_Dbt dbVal;
 	int rv;
 
 	if ((ds = AG_OpenAutoCore()) == NULL)
@@ -1769,11 +2097,9 @@ AG_ObjectSaveToDB(void *pObj, AG_Db *db, const AG_Dbt *key)
 	if (rv == -1)
 		goto fail;
 
-	dbKey.data = obj->name;
-	dbKey.size = strlen(obj->name)+1;
 	dbVal.data = AG_CORE_SOURCE(ds)->data;
 	dbVal.size = AG_CORE_SOURCE(ds)->size;
-	rv = AG_DbPut(db, &dbKey, &dbVal);
+	rv = AG_DbPut(db, key, &dbVal);
 	AG_CloseAutoCore(ds);
 	return (rv);
 fail:
@@ -1794,6 +2120,10 @@ AG_ObjectSetNameS(void *p, const char *name)
 	char *c;
 
 	AG_ObjectLock(ob);
+#if AG_MODEL != AG_SMALL
+	if (ob->parent != NULL)
+		IndexRemove(ob->parent, ob);
+#endif
 	if (name == NULL) {
 		ob->name[0] = '\0';
 	} else {
@@ -1808,6 +2138,10 @@ AG_ObjectSetNameS(void *p, const char *name)
 				*c = '_';
 		}
 	}
+#if AG_MODEL != AG_SMALL
+	if (ob->parent != NULL)
+		IndexInsert(ob->parent, ob);
+#endif
 	AG_ObjectUnlock(ob);
 }
 
@@ -1823,6 +2157,10 @@ AG_ObjectSetName(void *p, const char *fmt, ...)
 	char *c;
 
 	AG_ObjectLock(ob);
+#if AG_MODEL != AG_SMALL
+	if (ob->parent != NULL)
+		IndexRemove(ob->parent, ob);
+#endif
 	if (fmt != NULL) {
 		va_start(ap, fmt);
 		Vsnprintf(ob->name, sizeof(ob->name), fmt, ap);
@@ -1834,6 +2172,10 @@ AG_ObjectSetName(void *p, const char *fmt, ...)
 		if (*c == '/' || *c == '\\')		/* Pathname separator */
 			*c = '_';
 	}
+#if AG_MODEL != AG_SMALL
+	if (ob->parent != NULL)
+		IndexInsert(ob->parent, ob);
+#endif
 	AG_ObjectUnlock(ob);
 }
 
@@ -2065,10 +2407,7 @@ tryname:
 	StrlcpyUint(dBase, i, len);
 	if (pobj != NULL) {
 		AG_LockVFS(pobj);
-		TAILQ_FOREACH(chld, &pobj->children, cobjs) {
-			if (strcmp(chld->name, name) == 0)
-				break;
-		}
+		chld = AG_ObjectFindChildLockless(pobj, name);
 		AG_UnlockVFS(pobj);
 
 		if (chld != NULL) {
@@ -2092,10 +2431,7 @@ tryname:
 	StrlcatUint(name, i, len);
 	if (pobj != NULL) {
 		AG_LockVFS(pobj);
-		TAILQ_FOREACH(ch, &pobj->children, cobjs) {
-			if (strcmp(ch->name, name) == 0)
-				break;
-		}
+		ch = AG_ObjectFindChildLockless(pobj, name);
 		AG_UnlockVFS(pobj);
 		if (ch != NULL) {
 			i++;
@@ -2136,6 +2472,50 @@ too_big:
 	AG_FatalError("Class name overflow");
 }
 
+/*
+ * Resolve the inheritance hierarchy of a class from that of its superclass.
+ * C->super must be set (or C must have no superclass in its hier string).
+ */
+static void
+InitClassHier(AG_ObjectClass *_Nonnull C)
+{
+	AG_ObjectClass *Csuper = C->super;
+
+	if (strchr(C->hier, ':') == NULL) {
+		C->hierArr[0] = C;
+		C->nHier = 1;
+		return;
+	}
+	if (Csuper->nHier+1 > AG_OBJECT_HIER_DEPTH_MAX) {
+		AG_FatalError("Class hierarchy too deep");
+	}
+	memcpy(C->hierArr, Csuper->hierArr,
+	    Csuper->nHier*sizeof(AG_ObjectClass *));
+	C->hierArr[Csuper->nHier] = C;
+	C->nHier = Csuper->nHier+1;
+}
+
+/*
+ * Release the instance pool of a class unless instances remain allocated
+ * from it, in which case it is kept (disabled) so they can be freed later.
+ */
+static void
+FreeClassPool(AG_ObjectClass *_Nonnull C)
+{
+	AG_Pool *pool = C->pool;
+
+	if (pool == NULL) {
+		return;
+	}
+	pool->flags |= AG_POOL_DISABLED;
+	if (pool->nInUse > 0) {
+		return;
+	}
+	AG_PoolDestroy(pool);
+	free(pool);
+	C->pool = NULL;
+}
+
 /*
  * Initialize the object class description table.
  * Invoked internally by AG_InitCore().
@@ -2156,11 +2536,12 @@ AG_InitClassTbl(void)
 #endif
 	/* Initialize the class tree */
 	InitClass(&agObjectClass, "AG_Object");
+	InitClassHier(&agObjectClass);
 #ifdef AG_ENABLE_DSO
 	agObjectClass.libs[0] = '\0';
 #endif
 	/* Initialize the class table. */
-	agClassTbl = AG_TblNew(AG_OBJECT_CLASSTBLSIZE, 0);
+	agClassTbl = AG_TblNew(AG_OBJECT_CLASSTBLSIZE, AG_TBL_GROWABLE);
 
 	/* AG_Object -> agObjectClass */
 	AG_InitPointer(&V, &agObjectClass);
@@ -2168,6 +2549,18 @@ AG_InitClassTbl(void)
 		AG_FatalError(NULL);
 
 	AG_MutexInitRecursive(&agClassLock);
+
+	/*
+	 * AG_InsertVariable() and AG_TIMER_AUTO_FREE accept structures
+	 * allocated by the caller, so those pools must check ownership.
+	 */
+	AG_PoolInit(&agEventPool, sizeof(AG_Event), 0);
+	AG_PoolInit(&agVariablePool, sizeof(AG_Variable), 0);
+	agVariablePool.flags |= AG_POOL_FOREIGN;
+#ifdef AG_TIMERS
+	AG_PoolInit(&agTimerPool, sizeof(AG_Timer), 0);
+	agTimerPool.flags |= AG_POOL_FOREIGN;
+#endif
 }
 
 /*
@@ -2198,6 +2591,13 @@ AG_DestroyClassTbl(void)
 	free(agClassTbl); agClassTbl = NULL;
 	
 	AG_MutexDestroy(&agClassLock);
+
+	AG_PoolDestroy(&agEventPool);
+	AG_PoolDestroy(&agVariablePool);
+#ifdef AG_TIMERS
+	AG_PoolDestroy(&agTimerPool);
+#endif
+	FreeClassPool(&agObjectClass);
 }
 
 #ifdef AG_NAMESPACES
@@ -2381,6 +2781,7 @@ AG_RegisterClass(void *p)
 		C->super = &agObjectClass;	/* Base AG_Object class */
 	}
 	TAILQ_INSERT_TAIL(&C->super->sub, C, subclasses);
+	InitClassHier(C);
 
 	/* Insert into the class table. */
 	AG_InitPointer(&V, C);
@@ -2407,6 +2808,8 @@ AG_UnregisterClass(void *p)
 		/* Remove from the class tree. */
 		TAILQ_REMOVE(&Csuper->sub, C, subclasses);
 		C->super = NULL;
+		C->nHier = 0;
+		FreeClassPool(C);
 
 		/* Remove from the class table. */
 		AG_TblDeleteHash(agClassTbl, h, C->hier);
@@ -2414,6 +2817,61 @@ AG_UnregisterClass(void *p)
 	AG_MutexUnlock(&agClassLock);
 }
 
+/*
+ * Enable or disable pooled allocation for a class. Instances allocated
+ * by AG_ObjectNew() or AG_ObjectAlloc() are then carved out of slabs
+ * dedicated to the class (and flagged AG_OBJECT_POOLED), and their event
+ * handlers, variables and auto-free timers are drawn from shared pools
+ * (agEventPool, agVariablePool and agTimerPool). Disabling pooling defers
+ * new allocations to malloc() and releases the empty slabs; instances still
+ * allocated from the pool remain valid and are returned to it when destroyed.
+ */
+int
+AG_ClassSetPooling(void *p, int enable)
+{
+	AG_ObjectClass *C = p;
+	AG_Pool *pool;
+
+	AG_MutexLock(&agClassLock);
+	if ((pool = C->pool) == NULL) {
+		if (!enable) {
+			goto out;
+		}
+		if ((pool = TryMalloc(sizeof(AG_Pool))) == NULL) {
+			AG_MutexUnlock(&agClassLock);
+			return (-1);
+		}
+		AG_PoolInit(pool, C->size, 0);
+		C->pool = pool;
+		goto out;
+	}
+	AG_MutexLock(&pool->lock);
+	AG_SETFLAGS(pool->flags, AG_POOL_DISABLED, !enable);
+	AG_MutexUnlock(&pool->lock);
+	if (!enable)
+		AG_PoolTrim(pool);
+out:
+	AG_MutexUnlock(&agClassLock);
+	return (0);
+}
+
+/*
+ * Return allocation statistics for the instance pool of a class.
+ * Return -1 if pooling was never enabled for the class.
+ */
+int
+AG_ClassGetPoolStats(const void *p, AG_PoolStats *st)
+{
+	const AG_ObjectClass *C = p;
+
+	if (C->pool == NULL) {
+		AG_SetErrorS("Class is not pooled");
+		return (-1);
+	}
+	AG_PoolGetStats(C->pool, st);
+	return (0);
+}
+
 #if AG_MODEL != AG_SMALL
 /*
  * Allocate, initialize and zero an AG_ObjectClass (or derivative thereof).
@@ -2707,6 +3165,33 @@ AG_ClassIsNamedGeneral(const AG_ObjectClass *C, const char *cn)
 {
 	char cname[AG_OBJECT_HIER_MAX], *cp, *c;
 	char nname[AG_OBJECT_HIER_MAX], *np, *s;
+	const char *pat, *pe;
+	AG_Size len;
+	int i;
+
+	if (C->nHier > 0) {
+		/*
+		 * Match each component of the pattern against the name of
+		 * the corresponding class in the resolved hierarchy.
+		 */
+		for (pat = cn, i = 0; i < C->nHier; i++) {
+			if ((pe = strchr(pat, ':')) != NULL) {
+				len = pe - pat;
+			} else {
+				len = strlen(pat);
+			}
+			if (!(len == 1 && pat[0] == '*') &&
+			    (strncmp(C->hierArr[i]->name, pat, len) != 0 ||
+			     C->hierArr[i]->name[len] != '\0')) {
+				return (0);
+			}
+			if (pe == NULL) {
+				break;
+			}
+			pat = &pe[1];
+		}
+		return (1);
+	}
 
 	Strlcpy(cname, cn, sizeof(cname));
 	Strlcpy(nname, C->hier, sizeof(nname));
@@ -2724,55 +3209,60 @@ AG_ClassIsNamedGeneral(const AG_ObjectClass *C, const char *cn)
 }
 
 /*
- * Return an array of class description pointers ("AG_ObjectClass *") for
- * each class in the inheritance hierarchy of obj. For example:
+ * Return a pointer to the array of class description pointers for each
+ * class in the inheritance hierarchy of obj. For example:
  *
  *   "AG_Widget:AG_Box:AG_Titlebar" -> { &agWidgetClass,
  *                                       &agBoxClass,
  *                                       &agTitlebarClass }
  *
- * The caller should release the returned array using free() after use.
+ * The array is resolved once by AG_RegisterClass() and is owned by the
+ * class. It remains valid until the class is unregistered.
  */
 int
-AG_ObjectGetInheritHier(void *obj, AG_ObjectClass ***hier, int *nHier)
+AG_ObjectGetInheritHierCached(void *obj, AG_ObjectClass *const **hier,
+    int *nHier)
 {
-	char cname[AG_OBJECT_HIER_MAX], *c;
-	AG_ObjectClass *C, **pHier;
-	int i, stop = 0;
+	AG_ObjectClass *C = AGOBJECT(obj)->cls;
 
-	if (AGOBJECT(obj)->cls->hier[0] == '\0') {
-		(*nHier) = 0;
-		return (0);
-	}
-	(*nHier) = 1;
-	Strlcpy(cname, AGOBJECT(obj)->cls->hier, sizeof(cname));
-	for (c = &cname[0]; *c != '\0'; c++) {
-		if (*c == ':')
-			(*nHier)++;
-	}
-	pHier = (*hier) = Malloc((*nHier)*sizeof(AG_ObjectClass *));
-	for (c = &cname[0], i = 0; ; c++) {
-		if (*c != ':' && *c != '\0') {
-			continue;
-		}
-		if (*c == '\0') {
-			stop++;
-		} else {
-			*c = '\0';
+	if (C->nHier == 0) {
+		if (C->hier[0] == '\0') {
+			*hier = C->hierArr;
+			*nHier = 0;
+			return (0);
 		}
-		if ((C = AG_LookupClass(cname)) == NULL) {
+		/* Not registered; borrow from the registered class of that name. */
+		if ((C = AG_LookupClass(C->hier)) == NULL || C->nHier == 0) {
 			AG_SetError(
 			    _("No such class " AGSI_BR_CYAN "%s" AGSI_RST ". "
 			      "Missing AG_RegisterClass(3) call?"),
 			    AGOBJECT(obj)->cls->hier);
-			free(pHier);
 			return (-1);
 		}
-		*c = ':';
-		pHier[i++] = C;
-		
-		if (stop)
-			break;
 	}
+	*hier = C->hierArr;
+	*nHier = C->nHier;
+	return (0);
+}
+
+/*
+ * Return a newly-allocated copy of the inheritance hierarchy of obj
+ * (see AG_ObjectGetInheritHierCached()).
+ *
+ * The caller should release the returned array using free() after use.
+ */
+int
+AG_ObjectGetInheritHier(void *obj, AG_ObjectClass ***hier, int *nHier)
+{
+	AG_ObjectClass *const *hierCached;
+
+	if (AG_ObjectGetInheritHierCached(obj, &hierCached, nHier) == -1) {
+		return (-1);
+	}
+	if (*nHier == 0) {
+		return (0);
+	}
+	*hier = Malloc((*nHier)*sizeof(AG_ObjectClass *));
+	memcpy(*hier, hierCached, (*nHier)*sizeof(AG_ObjectClass *));
 	return (0);
 }
@@ -25,6 +25,13 @@
 #  define AG_OBJECT_HIER_MAX 96
 # endif
 #endif
+#ifndef AG_OBJECT_HIER_DEPTH_MAX     /* Max depth of inheritance hierarchy */
+# if AG_MODEL == AG_SMALL
+#  define AG_OBJECT_HIER_DEPTH_MAX 4
+# else
+#  define AG_OBJECT_HIER_DEPTH_MAX 8
+# endif
+#endif
 #ifndef AG_OBJECT_PATH_MAX   /* Max length of a complete path name in a VFS */
 # if AG_MODEL == AG_SMALL
 #  define AG_OBJECT_PATH_MAX 64
@@ -39,7 +46,10 @@
 #  define AG_OBJECT_LIBS_MAX 32
 # endif
 #endif
-#ifndef AG_OBJECT_CLASSTBLSIZE     /* Number of buckets for the class table */
+#ifndef AG_OBJECT_INDEX_MIN   /* Min children before indexing them by name */
+#define AG_OBJECT_INDEX_MIN 16
+#endif
+#ifndef AG_OBJECT_CLASSTBLSIZE     /* Initial size of the class table */
 # if AG_MODEL == AG_SMALL
 #  define AG_OBJECT_CLASSTBLSIZE 8
 # elif AG_MODEL == AG_MEDIUM
@@ -52,6 +62,7 @@
 #include <agar/core/begin.h>
 
 struct ag_object;
+struct ag_object_index;
 struct ag_tbl;
 struct ag_db;
 struct ag_dbt;
@@ -60,6 +71,7 @@ struct ag_dbt;
 #include <agar/core/event.h>
 #include <agar/core/agtime.h>
 #include <agar/core/classes.h>
+#include <agar/core/pool.h>
 
 /* Normalized object class specification. */
 typedef struct ag_object_class_spec {
@@ -111,6 +123,11 @@ typedef struct ag_object_class {              /* --- Required fields --- */
 	char libs[AG_OBJECT_LIBS_MAX];              /* List of required modules */
 	AG_TAILQ_HEAD_(ag_object_class) sub;        /* Direct subclasses */
 	AG_TAILQ_ENTRY(ag_object_class) subclasses; /* Subclass entry */
+	struct ag_object_class *_Nullable hierArr[AG_OBJECT_HIER_DEPTH_MAX];
+	                                            /* Resolved hierarchy */
+	int nHier;                                  /* Entries in hierArr[] */
+	Uint32 _pad;
+	AG_Pool *_Nullable pool;                    /* Instance pool (or NULL) */
 } AG_ObjectClass;
 
 AG_TAILQ_HEAD(ag_objectq, ag_object);
@@ -137,15 +154,23 @@ typedef struct ag_object {
 #define AG_OBJECT_DEBUG_DATA     0x10     /* Datafiles contain debug info */
 #define AG_OBJECT_NAME_ONATTACH  0x20     /* Generate name on attach */
 #define AG_OBJECT_BOUND_EVENTS   0x40     /* Raise "bound" events in AG_Bind*() */
+#define AG_OBJECT_POOLED         0x80     /* Allocated from class pool (read-only) */
 #define AG_OBJECT_SAVED_FLAGS (AG_OBJECT_INDESTRUCTIBLE | AG_OBJECT_READONLY | \
                                AG_OBJECT_DEBUG | AG_OBJECT_BOUND_EVENTS)
 
 	AG_ObjectClass *_Nonnull cls;     /* Class description structure */
 	AG_TAILQ_HEAD_(ag_event) events;  /* Event handlers */
+#if AG_MODEL != AG_SMALL
+	AG_EventIndex evIndex;            /* Event handlers (by atom) */
+	AG_QueuedEvent *_Nullable evQueue; /* Queued events (newest first) */
+	struct ag_object *_Nullable evQueueNext; /* In list of pending objects */
+	struct ag_object_index *_Nullable chldIndex; /* Children (by name) */
+#endif
 #ifdef AG_TIMERS
 	AG_TAILQ_HEAD_(ag_timer) timers;  /* Registered timers */
 #endif
 	AG_TAILQ_HEAD_(ag_variable) vars; /* Properties / Variables */
+	AG_VariableIndex varIndex;        /* Variables (by name) */
 	struct ag_objectq children;       /* List of child objects */
 	AG_TAILQ_ENTRY(ag_object) cobjs;  /* Entry in parent's children list */
 	void *_Nullable parent;           /* Parent in VFS (NULL = is root) */
@@ -300,6 +325,11 @@ extern AG_ObjectClass            agObjectClass;        /* Base Object class */
 extern _Nonnull_Mutex AG_Mutex   agClassLock;        /* Lock on class table */
 #endif
 extern struct ag_tbl  *_Nullable agClassTbl;    /* Class table (hash table) */
+extern AG_Pool                   agEventPool;  /* Pooled AG_Event handlers */
+extern AG_Pool                   agVariablePool;     /* Pooled AG_Variables */
+#ifdef AG_TIMERS
+extern AG_Pool                   agTimerPool;  /* Pooled auto-free AG_Timers */
+#endif
 #ifdef AG_NAMESPACES
 extern AG_Namespace *_Nullable   agNamespaceTbl;   /* Registered namespaces */
 extern int                       agNamespaceCount;
@@ -338,14 +368,26 @@ _Nullable AG_ObjectSaveFn    AG_ClassSetSave(void *_Nonnull, _Nullable AG_Object
 _Nullable AG_ObjectEditFn    AG_ClassSetEdit(void *_Nonnull, _Nullable AG_ObjectEditFn);
 #endif /* !AG_SMALL */
 
+int AG_ClassSetPooling(void *_Nonnull, int);
+int AG_ClassGetPoolStats(const void *_Nonnull, AG_PoolStats *_Nonnull);
+
 int AG_ParseClassSpec(AG_ObjectClassSpec *_Nonnull, const char *_Nonnull);
 int AG_ClassIsNamedGeneral(const AG_ObjectClass *_Nonnull, const char *_Nonnull);
 int AG_ObjectGetInheritHier(void *_Nonnull,
                             AG_ObjectClass *_Nonnull *_Nonnull *_Nullable,
                             int *_Nonnull);
+int AG_ObjectGetInheritHierCached(void *_Nonnull,
+                                  AG_ObjectClass *_Nonnull const *_Nonnull *_Nonnull,
+                                  int *_Nonnull);
 
 void *_Nullable AG_ObjectNew(void *_Nullable, const char *_Nullable,
                              AG_ObjectClass *_Nonnull);
+void *_Nonnull  AG_ObjectAlloc(void *_Nonnull);
+void *_Nullable AG_ObjectTryAlloc(void *_Nonnull);
+void *_Nonnull  AG_ObjectSubAlloc(void *_Nonnull, AG_Pool *_Nonnull);
+void *_Nullable AG_ObjectTrySubAlloc(void *_Nonnull, AG_Pool *_Nonnull);
+void            AG_ObjectSubFree(void *_Nonnull, AG_Pool *_Nonnull,
+                                 void *_Nullable);
 
 void AG_ObjectAttach(void *_Nullable _Restrict, void *_Nonnull _Restrict);
 void AG_ObjectInit(void *_Nonnull _Restrict, void *_Nullable _Restrict);
@@ -371,6 +413,10 @@ void *_Nullable AG_ObjectFind(void *_Nonnull, const char *_Nonnull, ...)
 			     _Pure_Attribute_If_Unthreaded
 			     _Warn_Unused_Result;
 
+void *_Nullable AG_ObjectFindChildLockless(AG_Object *_Nonnull,
+                                           const char *_Nonnull)
+                                          _Warn_Unused_Result;
+
 void *_Nullable AG_ObjectFindParent(void *_Nonnull, const char *_Nonnull,
 				    const char *_Nonnull)
 				   _Warn_Unused_Result;
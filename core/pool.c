@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Fixed-size chunk allocator. Chunks are carved out of slabs of about
+ * AG_POOL_SLAB_SIZE bytes and recycled through a free list, which keeps
+ * objects of a given size class packed together instead of scattering
+ * them across the malloc() heap.
+ */
+
+#include <agar/core/core.h>
+
+#include <string.h>
+
+/* Alignment of chunks (suitable for any AG_Object or AG_Variable). */
+#define POOL_ALIGN 16
+
+/* Initialize a pool of chunks of the given size. */
+void
+AG_PoolInit(AG_Pool *pool, AG_Size size, Uint nPerSlab)
+{
+	if (size < sizeof(void *)) {
+		size = sizeof(void *);
+	}
+	pool->size = (size + POOL_ALIGN-1) & ~((AG_Size)POOL_ALIGN-1);
+	if (nPerSlab == 0) {
+		nPerSlab = (Uint)(AG_POOL_SLAB_SIZE / pool->size);
+		if (nPerSlab < AG_POOL_SLAB_MIN)
+			nPerSlab = AG_POOL_SLAB_MIN;
+	}
+	pool->nPerSlab = nPerSlab;
+	pool->flags = 0;
+	pool->freeList = NULL;
+	pool->slabs = NULL;
+	pool->nSlabs = 0;
+	pool->maxSlabs = 0;
+	pool->nInUse = 0;
+	pool->nPeak = 0;
+	pool->nAllocs = 0;
+	AG_MutexInit(&pool->lock);
+}
+
+/* Release all slabs. Chunks still in use become invalid. */
+void
+AG_PoolDestroy(AG_Pool *pool)
+{
+	Uint i;
+
+	for (i = 0; i < pool->nSlabs; i++) {
+		free(pool->slabs[i]);
+	}
+	Free(pool->slabs);
+	pool->slabs = NULL;
+	pool->nSlabs = 0;
+	pool->maxSlabs = 0;
+	pool->freeList = NULL;
+	pool->nInUse = 0;
+	AG_MutexDestroy(&pool->lock);
+}
+
+/*
+ * Return the index of the slab containing p, or -1. If the chunk is not
+ * in any slab and ins is non-NULL, return the insertion index into ins.
+ */
+static int
+FindSlab(const AG_Pool *_Nonnull pool, const void *_Nonnull p,
+    Uint *_Nullable ins)
+{
+	const Uint8 *c = p;
+	const AG_Size slabSize = pool->nPerSlab * pool->size;
+	Uint lo = 0, hi = pool->nSlabs;
+
+	while (lo < hi) {
+		Uint mid = (lo + hi) >> 1;
+		const Uint8 *slab = pool->slabs[mid];
+
+		if (c < slab) {
+			hi = mid;
+		} else if (c >= slab + slabSize) {
+			lo = mid + 1;
+		} else {
+			return (int)mid;
+		}
+	}
+	if (ins != NULL) {
+		*ins = lo;
+	}
+	return (-1);
+}
+
+/* Allocate a new slab and thread its chunks onto the free list. */
+static int
+GrowPool(AG_Pool *_Nonnull pool)
+{
+	Uint8 *slab, *c;
+	Uint i, ins;
+
+	if (pool->nSlabs+1 > pool->maxSlabs) {
+		Uint maxNew = (pool->maxSlabs > 0) ? (pool->maxSlabs << 1) : 8;
+		Uint8 **slabsNew;
+
+		if ((slabsNew = TryRealloc(pool->slabs,
+		    maxNew*sizeof(Uint8 *))) == NULL) {
+			return (-1);
+		}
+		pool->slabs = slabsNew;
+		pool->maxSlabs = maxNew;
+	}
+	if ((slab = TryMalloc(pool->nPerSlab * pool->size)) == NULL) {
+		return (-1);
+	}
+	(void)FindSlab(pool, slab, &ins);
+	if (ins < pool->nSlabs) {
+		memmove(&pool->slabs[ins+1], &pool->slabs[ins],
+		    (pool->nSlabs - ins)*sizeof(Uint8 *));
+	}
+	pool->slabs[ins] = slab;
+	pool->nSlabs++;
+
+	for (i = pool->nPerSlab, c = &slab[(i-1)*pool->size];
+	     i > 0;
+	     i--, c -= pool->size) {
+		*(void **)c = pool->freeList;
+		pool->freeList = c;
+	}
+	return (0);
+}
+
+/*
+ * Allocate a chunk from the pool. If the pool is disabled, fall back
+ * to malloc() (AG_PoolFree() handles either).
+ */
+void *
+AG_PoolTryAlloc(AG_Pool *pool)
+{
+	void *p;
+
+	AG_MutexLock(&pool->lock);
+	if (pool->flags & AG_POOL_DISABLED) {
+		pool->flags |= AG_POOL_FOREIGN;
+		AG_MutexUnlock(&pool->lock);
+		return TryMalloc(pool->size);
+	}
+	if (pool->freeList == NULL && GrowPool(pool) == -1) {
+		AG_MutexUnlock(&pool->lock);
+		return (NULL);
+	}
+	p = pool->freeList;
+	pool->freeList = *(void **)p;
+	if (++pool->nInUse > pool->nPeak) {
+		pool->nPeak = pool->nInUse;
+	}
+	pool->nAllocs++;
+	AG_MutexUnlock(&pool->lock);
+	return (p);
+}
+
+void *
+AG_PoolAlloc(AG_Pool *pool)
+{
+	void *p;
+
+	if ((p = AG_PoolTryAlloc(pool)) == NULL) {
+		AG_FatalError(NULL);
+	}
+	return (p);
+}
+
+/*
+ * Return a chunk to the pool. If the pool is AG_POOL_FOREIGN, pointers
+ * which were not allocated from one of its slabs are passed to free().
+ */
+void
+AG_PoolFree(AG_Pool *pool, void *p)
+{
+	if (p == NULL) {
+		return;
+	}
+	AG_MutexLock(&pool->lock);
+	if ((pool->flags & AG_POOL_FOREIGN) &&
+	    FindSlab(pool, p, NULL) == -1) {
+		AG_MutexUnlock(&pool->lock);
+		free(p);
+		return;
+	}
+#ifdef AG_DEBUG
+	memset(p, 0xdd, pool->size);
+#endif
+	*(void **)p = pool->freeList;
+	pool->freeList = p;
+	pool->nInUse--;
+	AG_MutexUnlock(&pool->lock);
+}
+
+/* Return 1 if p lies within one of the pool's slabs. */
+int
+AG_PoolOwns(AG_Pool *pool, const void *p)
+{
+	int rv;
+
+	AG_MutexLock(&pool->lock);
+	rv = (FindSlab(pool, p, NULL) != -1);
+	AG_MutexUnlock(&pool->lock);
+	return (rv);
+}
+
+/*
+ * Release the slabs whose chunks are all free. Return the number of
+ * slabs released.
+ */
+int
+AG_PoolTrim(AG_Pool *pool)
+{
+	Uint *nFree, i, j;
+	void *p, *pNext;
+	int nReleased = 0;
+
+	AG_MutexLock(&pool->lock);
+	if (pool->nSlabs == 0 ||
+	    (nFree = TryMalloc(pool->nSlabs*sizeof(Uint))) == NULL) {
+		goto out;
+	}
+	memset(nFree, 0, pool->nSlabs*sizeof(Uint));
+	for (p = pool->freeList; p != NULL; p = *(void **)p) {
+		nFree[FindSlab(pool, p, NULL)]++;
+	}
+	/* Drop the chunks of empty slabs from the free list. */
+	for (p = pool->freeList, pool->freeList = NULL; p != NULL; p = pNext) {
+		pNext = *(void **)p;
+		if (nFree[FindSlab(pool, p, NULL)] < pool->nPerSlab) {
+			*(void **)p = pool->freeList;
+			pool->freeList = p;
+		}
+	}
+	for (i = 0, j = 0; i < pool->nSlabs; i++) {
+		if (nFree[i] == pool->nPerSlab) {
+			free(pool->slabs[i]);
+			nReleased++;
+		} else {
+			pool->slabs[j++] = pool->slabs[i];
+		}
+	}
+	pool->nSlabs = j;
+	free(nFree);
+out:
+	AG_MutexUnlock(&pool->lock);
+	return (nReleased);
+}
+
+/* Return allocation statistics for the pool. */
+void
+AG_PoolGetStats(AG_Pool *pool, AG_PoolStats *st)
+{
+	AG_MutexLock(&pool->lock);
+	st->size = pool->size;
+	st->nAllocs = pool->nAllocs;
+	st->nPerSlab = pool->nPerSlab;
+	st->nSlabs = pool->nSlabs;
+	st->nInUse = pool->nInUse;
+	st->nPeak = pool->nPeak;
+	AG_MutexUnlock(&pool->lock);
+}
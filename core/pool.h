@@ -0,0 +1,52 @@
+/*	Public domain	*/
+/*
+ * Fixed-size chunk allocator (slab pool).
+ */
+
+#ifndef _AGAR_CORE_OBJECT_H_
+# error "Must be included by object.h"
+#endif
+
+#ifndef AG_POOL_SLAB_SIZE
+#define AG_POOL_SLAB_SIZE 16384		/* Target size of a slab in bytes */
+#endif
+#ifndef AG_POOL_SLAB_MIN
+#define AG_POOL_SLAB_MIN 8		/* Minimum chunks per slab */
+#endif
+
+/* Allocation statistics. */
+typedef struct ag_pool_stats {
+	AG_Size size;			/* Chunk size in bytes */
+	AG_Size nAllocs;		/* Total allocations */
+	Uint nPerSlab;			/* Chunks per slab */
+	Uint nSlabs;			/* Slabs currently allocated */
+	Uint nInUse;			/* Chunks currently allocated */
+	Uint nPeak;			/* Highest value of nInUse */
+} AG_PoolStats;
+
+typedef struct ag_pool {
+	AG_Size size;			/* Chunk size (aligned) */
+	Uint nPerSlab;			/* Chunks per slab */
+	Uint flags;
+#define AG_POOL_DISABLED 0x01		/* Defer new allocations to malloc() */
+#define AG_POOL_FOREIGN  0x02		/* May be passed malloc()'d chunks */
+	void *_Nullable freeList;	/* Free chunks */
+	Uint8 *_Nonnull *_Nullable slabs; /* Slabs (sorted by address) */
+	Uint nSlabs;			/* Slab count */
+	Uint maxSlabs;			/* Allocated slab pointers */
+	Uint nInUse;			/* Chunks in use */
+	Uint nPeak;			/* Highest value of nInUse */
+	AG_Size nAllocs;		/* Total allocations */
+	_Nonnull_Mutex AG_Mutex lock;
+} AG_Pool;
+
+__BEGIN_DECLS
+void            AG_PoolInit(AG_Pool *_Nonnull, AG_Size, Uint);
+void            AG_PoolDestroy(AG_Pool *_Nonnull);
+void *_Nonnull  AG_PoolAlloc(AG_Pool *_Nonnull);
+void *_Nullable AG_PoolTryAlloc(AG_Pool *_Nonnull);
+void            AG_PoolFree(AG_Pool *_Nonnull, void *_Nullable);
+int             AG_PoolOwns(AG_Pool *_Nonnull, const void *_Nonnull);
+int             AG_PoolTrim(AG_Pool *_Nonnull);
+void            AG_PoolGetStats(AG_Pool *_Nonnull, AG_PoolStats *_Nonnull);
+__END_DECLS
@@ -69,6 +69,10 @@
 #ifdef HAVE_ICONV
 # include <iconv.h>
 #endif
+#if defined(AG_UNICODE) && defined(__SSE2__)
+# include <emmintrin.h>
+# define UNICODE_SSE2
+#endif
 
 /* TODO */
 #undef HAVE_ICONV_CONST
@@ -81,6 +85,7 @@ static AG_ThreadKey agPrintBufKey[AG_STRING_BUFFERS_MAX];
 # endif
 static AG_FmtStringExt *_Nullable agFmtExtensions = NULL;
 static Uint                       agFmtExtensionCount = 0;
+static Uint                       agFmtExtensionsGen = 0;
 # ifdef AG_THREADS
 static _Nullable_Mutex AG_Mutex   agFmtExtensionsLock;
 # endif
@@ -193,6 +198,7 @@ AG_RegisterFmtStringExt(const char *fmt, AG_FmtStringExtFn fn)
 	fs->fmt = Strdup(fmt);
 	fs->fmtLen = strlen(fmt);
 	fs->fn = fn;
+	agFmtExtensionsGen++;
 	AG_MutexUnlock(&agFmtExtensionsLock);
 }
 
@@ -214,6 +220,7 @@ AG_UnregisterFmtStringExt(const char *fmt)
 			    (agFmtExtensionCount-i-1)*sizeof(AG_FmtStringExt));
 		}
 		agFmtExtensionCount--;
+		agFmtExtensionsGen++;
 	}
 	AG_MutexUnlock(&agFmtExtensionsLock);
 }
@@ -222,126 +229,182 @@ AG_UnregisterFmtStringExt(const char *fmt)
 void
 AG_FreeFmtString(AG_FmtString *fs)
 {
+	if (fs->prog != NULL) {
+		AG_FmtFree(fs->prog);
+	}
 	Free(fs->s);
 	free(fs);
 }
 
 /*
- * Implementation of AG_ProcessFmtString().
+ * Compiled format strings.
+ *
+ * AG_FmtCompile() parses an AG_Printf() format string once into a list of
+ * operations (literal runs, conversions with their printf(3) spec already
+ * built, and extended specifiers with their handlers already resolved).
+ * AG_FmtPrint() then executes it against a fixed-size buffer without any
+ * further parsing or memory allocation. AG_ProcessFmtString() compiles the
+ * AG_PrintfP() syntax in the same way, the first time it is called on a
+ * given AG_FmtString.
  */
+enum ag_fmt_opcode {
+	AG_FMTOP_LITERAL,		/* Copy text[off..off+len] */
+	AG_FMTOP_EXT,			/* Extended specifier (%[...]) */
+	AG_FMTOP_INT,			/* %d (int) */
+	AG_FMTOP_UINT,			/* %u (Uint) */
+	AG_FMTOP_CHAR,			/* %c (int) */
+	AG_FMTOP_STRING,		/* %s (char *) */
+	AG_FMTOP_SPEC_UINT,		/* Spec at text[off] (Uint) */
+	AG_FMTOP_SPEC_CHAR,		/* Spec at text[off] (char) */
+	AG_FMTOP_SPEC_STRING,		/* Spec at text[off] (char *) */
+	AG_FMTOP_SPEC_LONG,		/* Spec at text[off] (long) */
+	AG_FMTOP_SPEC_ULONG,		/* Spec at text[off] (Ulong) */
+	AG_FMTOP_SPEC_PTR,		/* Spec at text[off] (void *) */
+#ifdef HAVE_FLOAT
+	AG_FMTOP_SPEC_DOUBLE,		/* Spec at text[off] (double) */
+	AG_FMTOP_FLOAT,			/* %f, %g of AG_PrintfP() (float *) */
+	AG_FMTOP_DOUBLE,		/* %lf, %lg of AG_PrintfP() (double *) */
+#endif
+#ifdef HAVE_64BIT
+	AG_FMTOP_SPEC_SINT64,		/* Spec at text[off] (Sint64) */
+	AG_FMTOP_SPEC_UINT64,		/* Spec at text[off] (Uint64) */
+#endif
+	AG_FMTOP_LAST
+};
 
-#undef FSARG
-#define FSARG(fs,_type) (*(_type *)(fs)->p[fs->curArg++])
+/* Operation flags */
+#define FMTOP_INF_NEG 0x01		/* Print AG_*_MAX as "-inf" */
 
-#ifdef HAVE_64BIT
-static AG_Size
-ProcessFmtString64(AG_FmtString *_Nonnull fs, const char *_Nonnull f,
-    char *_Nonnull dst, AG_Size dstSize)
+/* Look up an extended specifier matching the start of s. */
+static AG_FmtStringExt *_Nullable
+FindFmtExtension(const char *_Nonnull s)
 {
-	switch (*f) {
-	case 'd':
-	case 'i':
-		return Snprintf(dst, dstSize, "%lld", (long long)FSARG(fs,Sint64));
-	case 'o':
-		return Snprintf(dst, dstSize, "%llo", (unsigned long long)FSARG(fs,Uint64));
-	case 'u':
-		return Snprintf(dst, dstSize, "%llu", (unsigned long long)FSARG(fs,Uint64));
-	case 'x':
-		return Snprintf(dst, dstSize, "%llx", (unsigned long long)FSARG(fs,Uint64));
-	case 'X':
-		return Snprintf(dst, dstSize, "%llX", (unsigned long long)FSARG(fs,Uint64));
+	Uint i;
+
+	for (i = 0; i < agFmtExtensionCount; i++) {
+		AG_FmtStringExt *fExt = &agFmtExtensions[i];
+
+		if (strncmp(fExt->fmt, s, fExt->fmtLen) == 0)
+			return (fExt);
 	}
-	return (0);
+	return (NULL);
 }
-#endif /* HAVE_64BIT */
 
-/*
- * Construct a string from the given AG_FmtString. The arguments are
- * dereferenced, and the resulting string is written to a fixed-size
- * buffer dst of dstSize bytes. Returns the number of characters that
- * would have been copied were dstSize unlimited.
- */
-AG_Size
-AG_ProcessFmtString(AG_FmtString *fs, char *dst, AG_Size dstSize)
+static AG_FmtOp *_Nullable
+FmtAddOp(AG_FmtProgram *_Nonnull prog, Uint *_Nonnull maxOps, int type,
+    Uint off, Uint len)
 {
-	char *pDst = &dst[0];
-	char *pEnd = &dst[dstSize-1];
-	char *f;
-	AG_Size rv;
-	Uint i;
+	AG_FmtOp *op;
 
-	fs->curArg = 0;
+	if (prog->nOps+1 > *maxOps) {
+		Uint maxNew = (*maxOps > 0) ? (*maxOps << 1) : 8;
+		AG_FmtOp *opsNew;
 
-	if (dstSize < 1) {
-		return (0);
+		if ((opsNew = TryRealloc(prog->ops,
+		    maxNew*sizeof(AG_FmtOp))) == NULL) {
+			return (NULL);
+		}
+		prog->ops = opsNew;
+		*maxOps = maxNew;
 	}
-	*pDst = '\0';
+	op = &prog->ops[prog->nOps++];
+	op->type = (Uint8)type;
+	op->flags = 0;
+	op->len = (Uint16)len;
+	op->off = (Uint32)off;
+	op->fn = NULL;
+	return (op);
+}
+
+/* Append a literal character at text[off], merging with a preceding run. */
+static int
+FmtAddLiteral(AG_FmtProgram *_Nonnull prog, Uint *_Nonnull maxOps, Uint off)
+{
+	AG_FmtOp *op;
+
+	if (prog->nOps > 0) {
+		op = &prog->ops[prog->nOps-1];
+		if (op->type == AG_FMTOP_LITERAL && op->off+op->len == off &&
+		    op->len < 0xffff) {
+			op->len++;
+			return (0);
+		}
+	}
+	return (FmtAddOp(prog, maxOps, AG_FMTOP_LITERAL, off, 1) != NULL) ?
+	       0 : -1;
+}
 
-	for (f = &fs->s[0]; *f != '\0'; f++) {
+/* Compile the AG_PrintfP() syntax (mirrors the former interpreter). */
+static int
+FmtCompilePolled(AG_FmtProgram *_Nonnull prog, Uint *_Nonnull maxOps)
+{
+	const char *fmt = prog->text, *f;
+	AG_FmtStringExt *fExt;
+	AG_FmtOp *op = NULL;
+	char *pSpec = &prog->text[strlen(fmt)+1];
+
+	for (f = &fmt[0]; *f != '\0'; f++) {
 		if (f[0] != '%' || f[1] == '\0') {
-			*pDst = *f;
-			if (++pDst >= pEnd) {
-				*pEnd = '\0';			/* Truncate */
-				goto out;
+			if (FmtAddLiteral(prog, maxOps, (Uint)(f - fmt)) == -1) {
+				return (-1);
 			}
 			continue;
 		}
-		rv = 0;
 		switch (f[1]) {
 		case '[':
-			for (i = 0; i < agFmtExtensionCount; i++) {
-				AG_FmtStringExt *fExt = &agFmtExtensions[i];
-
-				if (strncmp(fExt->fmt, &f[2], fExt->fmtLen) != 0) {
-					continue;
-				}
-				rv = fExt->fn(fs, pDst, (pEnd-pDst));
-				f += fExt->fmtLen + 1;	/* Closing "]" */
+			if ((fExt = FindFmtExtension(&f[2])) == NULL) {
 				break;
 			}
+			if ((op = FmtAddOp(prog, maxOps, AG_FMTOP_EXT,
+			    (Uint)(&f[2] - fmt), (Uint)fExt->fmtLen)) == NULL) {
+				return (-1);
+			}
+			op->fn = fExt->fn;
+			prog->nArgs++;
+			f += fExt->fmtLen + 1;		/* Closing "]" */
 			break;
 #if defined(HAVE_FLOAT) || defined(HAVE_64BIT)
 		case 'l':
 			switch (f[2]) {
 # ifdef HAVE_FLOAT
 			case 'f':
-				{
-					const double val = FSARG(fs,double);
-
-					if (val == AG_DBL_MAX) {
-						rv = Strlcpy(pDst, AGSI_INFINITY,
-						    (pEnd-pDst));
-					} else if (val == AG_DBL_MIN) {
-						rv = Strlcpy(pDst, "-" AGSI_INFINITY,
-						    (pEnd-pDst));
-					} else {
-						rv = Snprintf(pDst, (pEnd-pDst),
-						    "%.2f", val);
-					}
-				}
-				f++;
-				break;
 			case 'g':
-				{
-					const double val = FSARG(fs,double);
-
-					if (val == AG_DBL_MAX) {
-						rv = Strlcpy(pDst, "-" AGSI_INFINITY,
-						    (pEnd-pDst));
-					} else if (val == AG_DBL_MIN) {
-						rv = Strlcpy(pDst, AGSI_INFINITY,
-						    (pEnd-pDst));
-					} else {
-						rv = Snprintf(pDst, (pEnd-pDst), "%g", val);
-					}
+				if ((op = FmtAddOp(prog, maxOps, AG_FMTOP_DOUBLE,
+				    (Uint)(&f[2] - fmt), 1)) == NULL) {
+					return (-1);
 				}
+				if (f[2] == 'g') { op->flags |= FMTOP_INF_NEG; }
+				prog->nArgs++;
 				f++;
 				break;
 # endif
 # ifdef HAVE_64BIT
 			case 'l':
-				rv = ProcessFmtString64(fs, &f[3], pDst, (pEnd-pDst));
-				f+=2;
+				switch (f[3]) {
+				case 'd':
+				case 'i':
+				case 'o':
+				case 'u':
+				case 'x':
+				case 'X':
+					if ((op = FmtAddOp(prog, maxOps,
+					    (f[3] == 'd' || f[3] == 'i') ?
+					    AG_FMTOP_SPEC_SINT64 :
+					    AG_FMTOP_SPEC_UINT64,
+					    (Uint)(pSpec - prog->text),
+					    0)) == NULL) {
+						return (-1);
+					}
+					pSpec[0] = '%';
+					pSpec[1] = 'l';
+					pSpec[2] = 'l';
+					pSpec[3] = (f[3] == 'i') ? 'd' : f[3];
+					pSpec[4] = '\0';
+					pSpec += 5;
+					prog->nArgs++;
+					break;
+				}
+				f += 2;
 				break;
 # endif
 			}
@@ -349,83 +412,513 @@ AG_ProcessFmtString(AG_FmtString *fs, char *dst, AG_Size dstSize)
 #endif /* HAVE_FLOAT or HAVE_64BIT */
 		case 'd':
 		case 'i':
-			rv = StrlcpyInt(pDst, FSARG(fs,int), (pEnd-pDst));
+			if (FmtAddOp(prog, maxOps, AG_FMTOP_INT, 0,0) == NULL) {
+				return (-1);
+			}
+			prog->nArgs++;
 			break;
 		case 'u':
-			rv = StrlcpyUint(pDst, FSARG(fs,Uint), (pEnd-pDst));
+			if (FmtAddOp(prog, maxOps, AG_FMTOP_UINT, 0,0) == NULL) {
+				return (-1);
+			}
+			prog->nArgs++;
 			break;
 #ifdef HAVE_FLOAT
 		case 'f':
-			{
-				const float val = FSARG(fs,float);
-
-				if (val == AG_FLT_MAX) {
-					rv = Strlcpy(pDst, "-" AGSI_INFINITY,
-					    (pEnd-pDst));
-				} else if (val == AG_FLT_MIN) {
-					rv = Strlcpy(pDst, AGSI_INFINITY,
-					    (pEnd-pDst));
-				} else {
-					rv = Snprintf(pDst, (pEnd-pDst), "%.2f", val);
-				}
-			}
-			break;
 		case 'g':
-			{
-				const float val = FSARG(fs,float);
-
-				if (val == AG_FLT_MAX) {
-					rv = Strlcpy(pDst, "-" AGSI_INFINITY,
-					    (pEnd-pDst));
-				} else if (val == AG_FLT_MIN) {
-					rv = Strlcpy(pDst, AGSI_INFINITY,
-					    (pEnd-pDst));
-				} else {
-					rv = Snprintf(pDst, (pEnd-pDst), "%g", val);
-				}
+			if ((op = FmtAddOp(prog, maxOps, AG_FMTOP_FLOAT,
+			    (Uint)(&f[1] - fmt), 1)) == NULL) {
+				return (-1);
 			}
+			op->flags |= FMTOP_INF_NEG;
+			prog->nArgs++;
 			break;
 #endif
 		case 's':
-			rv = Strlcpy(pDst, &FSARG(fs,char), (pEnd-pDst));
+			if (FmtAddOp(prog, maxOps, AG_FMTOP_STRING, 0,0) == NULL) {
+				return (-1);
+			}
+			prog->nArgs++;
 			break;
 		case 'o':
-			rv = Snprintf(pDst, (pEnd-pDst), "%o", FSARG(fs,Uint));
-			break;
 		case 'x':
-			rv = Snprintf(pDst, (pEnd-pDst), "%x", FSARG(fs,Uint));
-			break;
 		case 'X':
-			rv = Snprintf(pDst, (pEnd-pDst), "%X", FSARG(fs,Uint));
-			break;
 		case 'p':
-			rv = Snprintf(pDst, (pEnd-pDst), "%p", FSARG(fs,void *));
+			if (FmtAddOp(prog, maxOps, (f[1] == 'p') ?
+			    AG_FMTOP_SPEC_PTR : AG_FMTOP_SPEC_UINT,
+			    (Uint)(pSpec - prog->text), 0) == NULL) {
+				return (-1);
+			}
+			pSpec[0] = '%';
+			pSpec[1] = f[1];
+			pSpec[2] = '\0';
+			pSpec += 3;
+			prog->nArgs++;
 			break;
 		case 'c':
-			*pDst = FSARG(fs,char);
-			rv = 1;
+			if (FmtAddOp(prog, maxOps, AG_FMTOP_CHAR, 0,0) == NULL) {
+				return (-1);
+			}
+			prog->nArgs++;
 			break;
 		case '%':
-			*pDst = '%';
-			rv = 1;
+			if (FmtAddOp(prog, maxOps, AG_FMTOP_LITERAL,
+			    (Uint)(&f[1] - fmt), 1) == NULL) {
+				return (-1);
+			}
 			break;
 		}
-		if ((pDst += rv) > pEnd) {
-			*pEnd = '\0';				/* Truncate */
-			goto out;
+		f++;
+	}
+	return (0);
+}
+
+/* Compile the AG_Printf() syntax (mirrors AG_DoPrintf()). */
+static int
+FmtCompilePrintf(AG_FmtProgram *_Nonnull prog, Uint *_Nonnull maxOps)
+{
+	const char *fmt = prog->text, *f;
+	AG_FmtStringExt *fExt;
+	AG_FmtOp *op;
+	char *pSpecBase = &prog->text[strlen(fmt)+1], *pSpec;
+	int type;
+
+	for (f = &fmt[0]; *f != '\0'; f++) {
+		if (f[0] != '%' || f[1] == '\0') {
+			if (FmtAddLiteral(prog, maxOps, (Uint)(f - fmt)) == -1) {
+				return (-1);
+			}
+			continue;
+		}
+		pSpec = pSpecBase;
+		*pSpec++ = '%';
+next_char:
+		type = -1;
+		switch (f[1]) {
+		case '[':
+			if ((fExt = FindFmtExtension(&f[2])) == NULL) {
+				break;
+			}
+			if ((op = FmtAddOp(prog, maxOps, AG_FMTOP_EXT,
+			    (Uint)(&f[2] - fmt), (Uint)fExt->fmtLen)) == NULL) {
+				return (-1);
+			}
+			op->fn = fExt->fn;
+			prog->nArgs++;
+			f += fExt->fmtLen + 1;		/* Closing "]" */
+			break;
+		case 'd':
+		case 'i':
+			type = (pSpec == &pSpecBase[1]) ? AG_FMTOP_INT :
+			                                  AG_FMTOP_SPEC_UINT;
+			*pSpec++ = f[1];
+			break;
+		case 'u':
+			type = (pSpec == &pSpecBase[1]) ? AG_FMTOP_UINT :
+			                                  AG_FMTOP_SPEC_UINT;
+			*pSpec++ = f[1];
+			break;
+		case 'o':
+		case 'x':
+		case 'X':
+			type = AG_FMTOP_SPEC_UINT;
+			*pSpec++ = f[1];
+			break;
+		case 'c':
+			type = (pSpec == &pSpecBase[1]) ? AG_FMTOP_CHAR :
+			                                  AG_FMTOP_SPEC_CHAR;
+			*pSpec++ = f[1];
+			break;
+#ifdef HAVE_FLOAT
+		case 'f':
+		case 'g':
+			type = AG_FMTOP_SPEC_DOUBLE;
+			*pSpec++ = f[1];
+			break;
+#endif
+		case 's':
+			type = (pSpec == &pSpecBase[1]) ? AG_FMTOP_STRING :
+			                                  AG_FMTOP_SPEC_STRING;
+			*pSpec++ = f[1];
+			break;
+		case 'l':
+			*pSpec++ = f[1];
+			switch (f[2]) {
+			case 'd':
+			case 'i':
+				type = AG_FMTOP_SPEC_LONG;
+				*pSpec++ = f[2];
+				break;
+			case 'o':
+			case 'u':
+			case 'x':
+			case 'X':
+				type = AG_FMTOP_SPEC_ULONG;
+				*pSpec++ = f[2];
+				break;
+#ifdef HAVE_FLOAT
+			case 'f':
+			case 'g':
+				type = AG_FMTOP_SPEC_DOUBLE;
+				*pSpec++ = f[2];
+				break;
+#endif
+#ifdef HAVE_64BIT
+			case 'l':
+				*pSpec++ = f[2];
+				switch (f[3]) {
+				case 'd':
+				case 'i':
+					type = AG_FMTOP_SPEC_SINT64;
+					*pSpec++ = f[3];
+					break;
+				case 'o':
+				case 'u':
+				case 'x':
+				case 'X':
+					type = AG_FMTOP_SPEC_UINT64;
+					*pSpec++ = f[3];
+					break;
+				}
+				f++;
+#endif /* HAVE_64BIT */
+			}
+			f++;
+			break;
+		case '#':
+		case '0':
+		case '-':
+		case ' ':
+		case '+':
+		case '\'':
+		case '.':
+		case '1':
+		case '2':
+		case '3':
+		case '4':
+		case '5':
+		case '6':
+		case '7':
+		case '8':
+		case '9':
+			*pSpec++ = f[1];
+			f++;
+			goto next_char;
+		case '%':
+			if (FmtAddOp(prog, maxOps, AG_FMTOP_LITERAL,
+			    (Uint)(&f[1] - fmt), 1) == NULL) {
+				return (-1);
+			}
+			break;
+		}
+		if (type != -1) {
+			*pSpec++ = '\0';
+			if (FmtAddOp(prog, maxOps, type,
+			    (Uint)(pSpecBase - prog->text), 0) == NULL) {
+				return (-1);
+			}
+			prog->nArgs++;
+			if (type >= AG_FMTOP_SPEC_UINT)
+				pSpecBase = pSpec;	/* Keep the spec */
 		}
 		f++;
 	}
-out:
-	if (pDst < pEnd) {
-		*pDst = '\0';
+	return (0);
+}
+
+static AG_FmtProgram *_Nullable
+FmtCompile(const char *_Nonnull fmt, Uint flags)
+{
+	AG_FmtProgram *prog;
+	AG_Size len = strlen(fmt);
+	Uint maxOps = 0;
+	int rv;
+
+	if ((prog = TryMalloc(sizeof(AG_FmtProgram))) == NULL) {
+		return (NULL);
+	}
+	/*
+	 * The text holds a copy of the format, followed by the NUL-terminated
+	 * printf(3) specs of the conversions. Each spec is at most one byte
+	 * longer than its source once terminated, and every conversion is at
+	 * least 2 bytes long, so 2*len + 2 bytes always suffice for the specs.
+	 */
+	if ((prog->text = TryMalloc((len+1) + len*2 + 2)) == NULL) {
+		free(prog);
+		return (NULL);
+	}
+	memcpy(prog->text, fmt, len+1);
+	prog->ops = NULL;
+	prog->nOps = 0;
+	prog->nArgs = 0;
+	prog->flags = flags;
+
+	AG_MutexLock(&agFmtExtensionsLock);
+	prog->extGen = agFmtExtensionsGen;
+	if (flags & AG_FMT_POLLED) {
+		rv = FmtCompilePolled(prog, &maxOps);
 	} else {
-		*pEnd = '\0';
+		rv = FmtCompilePrintf(prog, &maxOps);
 	}
-	return (pDst - dst);
+	AG_MutexUnlock(&agFmtExtensionsLock);
+	if (rv == -1) {
+		AG_FmtFree(prog);
+		return (NULL);
+	}
+	return (prog);
+}
+
+/*
+ * Compile an AG_Printf() format string into a reusable program.
+ * Return NULL if insufficient memory is available.
+ */
+AG_FmtProgram *
+AG_FmtCompile(const char *fmt)
+{
+	return FmtCompile(fmt, 0);
+}
+
+/* Release a compiled format string. */
+void
+AG_FmtFree(AG_FmtProgram *prog)
+{
+	Free(prog->ops);
+	free(prog->text);
+	free(prog);
+}
+
+/*
+ * Return the handler of an extended specifier. If extensions were
+ * (un)registered since compilation, look it up again by name.
+ */
+static _Nullable AG_FmtStringExtFn
+FmtGetExtension(const AG_FmtProgram *_Nonnull prog,
+    const AG_FmtOp *_Nonnull op)
+{
+	const char *name = &prog->text[op->off];
+	AG_FmtStringExtFn fn = NULL;
+	Uint i;
+
+	if (prog->extGen == agFmtExtensionsGen) {
+		return (op->fn);
+	}
+	AG_MutexLock(&agFmtExtensionsLock);
+	for (i = 0; i < agFmtExtensionCount; i++) {
+		AG_FmtStringExt *fExt = &agFmtExtensions[i];
+
+		if (fExt->fmtLen == op->len &&
+		    strncmp(fExt->fmt, name, op->len) == 0) {
+			fn = fExt->fn;
+			break;
+		}
+	}
+	AG_MutexUnlock(&agFmtExtensionsLock);
+	return (fn);
 }
 
-#undef FSARG
+#ifdef HAVE_FLOAT
+static AG_Size
+FmtPrintReal(char *_Nonnull dst, AG_Size dstSize, double val, int isMax,
+    int isMin, const AG_FmtOp *_Nonnull op, char conv)
+{
+	const int neg = (op->flags & FMTOP_INF_NEG);
+
+	if (isMax) {
+		return Strlcpy(dst, neg ? "-" AGSI_INFINITY : AGSI_INFINITY,
+		    dstSize);
+	} else if (isMin) {
+		return Strlcpy(dst, neg ? AGSI_INFINITY : "-" AGSI_INFINITY,
+		    dstSize);
+	}
+	return Snprintf(dst, dstSize, (conv == 'g') ? "%g" : "%.2f", val);
+}
+#endif
+
+/*
+ * Execute a compiled program. Arguments are taken from fs if it is not
+ * NULL (AG_PrintfP() pointers), otherwise from ap.
+ */
+static AG_Size
+FmtExec(const AG_FmtProgram *_Nonnull prog, AG_FmtString *_Nullable fs,
+    va_list *_Nullable ap, char *_Nonnull dst, AG_Size dstSize)
+{
+	AG_FmtString fsExt;
+	char tmp[AG_FMTSTRING_BUFFER_INIT];
+	AG_Size pos = 0, rv;
+	Uint i;
+
+	if (fs != NULL) {
+		fs->curArg = 0;
+	} else {
+		fsExt.s = NULL;
+		fsExt.prog = NULL;
+	}
+	for (i = 0; i < prog->nOps; i++) {
+		const AG_FmtOp *op = &prog->ops[i];
+		const char *spec = &prog->text[op->off];
+		const AG_Size avail = (pos+1 < dstSize) ? (dstSize - pos) : 0;
+		char *pDst = (avail > 0) ? &dst[pos] : tmp;
+		const AG_Size size = (avail > 0) ? avail : sizeof(tmp);
+		AG_FmtStringExtFn fn;
+		void *p = NULL;
+
+		if (op->type == AG_FMTOP_LITERAL) {
+			if (avail > 0) {
+				memcpy(pDst, spec, AG_MIN(op->len, avail-1));
+			}
+			pos += op->len;
+			continue;
+		}
+		if (fs != NULL && op->type != AG_FMTOP_EXT) {
+			p = fs->p[fs->curArg++];
+		}
+		switch (op->type) {
+		case AG_FMTOP_EXT:
+			if (fs == NULL) {
+				fsExt.curArg = 0;
+				fsExt.p[0] = va_arg(*ap, void *);
+			}
+			rv = ((fn = FmtGetExtension(prog, op)) != NULL) ?
+			     fn((fs != NULL) ? fs : &fsExt, pDst, size) : 0;
+			break;
+		case AG_FMTOP_INT:
+			rv = StrlcpyInt(tmp, (fs != NULL) ? *(int *)p :
+			                     va_arg(*ap, int), sizeof(tmp));
+			if (avail > 0) { Strlcpy(pDst, tmp, size); }
+			break;
+		case AG_FMTOP_UINT:
+			rv = StrlcpyUint(tmp, (fs != NULL) ? *(Uint *)p :
+			                      va_arg(*ap, Uint), sizeof(tmp));
+			if (avail > 0) { Strlcpy(pDst, tmp, size); }
+			break;
+		case AG_FMTOP_CHAR:
+			if (avail > 0) {
+				*pDst = (fs != NULL) ? *(char *)p :
+				                       (char)va_arg(*ap, int);
+			} else if (fs == NULL) {
+				(void)va_arg(*ap, int);
+			}
+			rv = 1;
+			break;
+		case AG_FMTOP_STRING:
+			rv = Strlcpy(pDst, (fs != NULL) ? (const char *)p :
+			                   va_arg(*ap, const char *), size);
+			break;
+		case AG_FMTOP_SPEC_UINT:
+			rv = Snprintf(pDst, size, spec, (fs != NULL) ?
+			    *(Uint *)p : va_arg(*ap, Uint));
+			break;
+		case AG_FMTOP_SPEC_CHAR:
+			rv = Snprintf(pDst, size, spec, (char)va_arg(*ap, int));
+			break;
+		case AG_FMTOP_SPEC_STRING:
+			rv = Snprintf(pDst, size, spec, va_arg(*ap, char *));
+			break;
+		case AG_FMTOP_SPEC_LONG:
+			rv = Snprintf(pDst, size, spec, va_arg(*ap, long));
+			break;
+		case AG_FMTOP_SPEC_ULONG:
+			rv = Snprintf(pDst, size, spec, va_arg(*ap, Ulong));
+			break;
+		case AG_FMTOP_SPEC_PTR:
+			rv = Snprintf(pDst, size, spec, *(void **)p);
+			break;
+#ifdef HAVE_FLOAT
+		case AG_FMTOP_SPEC_DOUBLE:
+			rv = Snprintf(pDst, size, spec, va_arg(*ap, double));
+			break;
+		case AG_FMTOP_FLOAT:
+			{
+				const float val = *(float *)p;
+
+				rv = FmtPrintReal(pDst, size, (double)val,
+				    (val == AG_FLT_MAX), (val == AG_FLT_MIN),
+				    op, *spec);
+			}
+			break;
+		case AG_FMTOP_DOUBLE:
+			{
+				const double val = *(double *)p;
+
+				rv = FmtPrintReal(pDst, size, val,
+				    (val == AG_DBL_MAX), (val == AG_DBL_MIN),
+				    op, *spec);
+			}
+			break;
+#endif
+#ifdef HAVE_64BIT
+		case AG_FMTOP_SPEC_SINT64:
+			rv = Snprintf(pDst, size, spec, (fs != NULL) ?
+			    (long long)*(Sint64 *)p :
+			    (long long)va_arg(*ap, Sint64));
+			break;
+		case AG_FMTOP_SPEC_UINT64:
+			rv = Snprintf(pDst, size, spec, (fs != NULL) ?
+			    (unsigned long long)*(Uint64 *)p :
+			    (unsigned long long)va_arg(*ap, Uint64));
+			break;
+#endif
+		default:
+			rv = 0;
+			break;
+		}
+		pos += rv;
+	}
+	if (dstSize > 0) {
+		dst[AG_MIN(pos, dstSize-1)] = '\0';
+	}
+	return (pos);
+}
+
+/*
+ * Execute a compiled format string with the given arguments, writing the
+ * output to a fixed-size buffer (which is always NUL-terminated). Return
+ * the length of the complete output (if it is >= dstSize, the output was
+ * truncated).
+ */
+AG_Size
+AG_FmtPrint(const AG_FmtProgram *prog, char *dst, AG_Size dstSize, ...)
+{
+	va_list ap;
+	AG_Size rv;
+
+	va_start(ap, dstSize);
+	rv = FmtExec(prog, NULL, &ap, dst, dstSize);
+	va_end(ap);
+	return (rv);
+}
+
+AG_Size
+AG_FmtPrintV(const AG_FmtProgram *prog, char *dst, AG_Size dstSize,
+    va_list ap)
+{
+	va_list apCopy;
+	AG_Size rv;
+
+	va_copy(apCopy, ap);
+	rv = FmtExec(prog, NULL, &apCopy, dst, dstSize);
+	va_end(apCopy);
+	return (rv);
+}
+
+/*
+ * Construct a string from the given AG_FmtString. The arguments are
+ * dereferenced, and the resulting string is written to a fixed-size
+ * buffer dst of dstSize bytes. Returns the number of characters that
+ * would have been copied were dstSize unlimited.
+ *
+ * The format string is compiled on the first call.
+ */
+AG_Size
+AG_ProcessFmtString(AG_FmtString *fs, char *dst, AG_Size dstSize)
+{
+	if (fs->prog == NULL &&
+	    (fs->prog = FmtCompile(fs->s, AG_FMT_POLLED)) == NULL) {
+		if (dstSize > 0) { dst[0] = '\0'; }
+		return (0);
+	}
+	return FmtExec(fs->prog, fs, NULL, dst, dstSize);
+}
 
 #undef CAT_SPEC
 #define CAT_SPEC(c) \
@@ -739,6 +1232,7 @@ AG_PrintfP(const char *_Nonnull fmt, ...)
 		AG_FatalError(NULL);
 	}
 	fs->s = Strdup(fmt);
+	fs->prog = NULL;
 	fs->n = 0;
 
 	va_start(ap, fmt);
@@ -1003,12 +1497,161 @@ fail:
 
 # endif /* HAVE_ICONV */
 
+/*
+ * Widen n bytes (US-ASCII or ISO-8859-1) to UCS-4.
+ */
+static void
+WidenBytes(AG_Char *_Nonnull ucs, const Uchar *_Nonnull s, AG_Size n)
+{
+	AG_Size i = 0;
+#ifdef UNICODE_SSE2
+	const __m128i z = _mm_setzero_si128();
+
+	for (; i+16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)&s[i]);
+		__m128i lo = _mm_unpacklo_epi8(v, z);
+		__m128i hi = _mm_unpackhi_epi8(v, z);
+
+		_mm_storeu_si128((__m128i *)&ucs[i], _mm_unpacklo_epi16(lo,z));
+		_mm_storeu_si128((__m128i *)&ucs[i+4], _mm_unpackhi_epi16(lo,z));
+		_mm_storeu_si128((__m128i *)&ucs[i+8], _mm_unpacklo_epi16(hi,z));
+		_mm_storeu_si128((__m128i *)&ucs[i+12], _mm_unpackhi_epi16(hi,z));
+	}
+#endif
+	for (; i < n; i++)
+		ucs[i] = (AG_Char)s[i];
+}
+
+/* Return the length of the run of US-ASCII characters at the start of s. */
+static __inline__ AG_Size
+LengthASCII(const Uchar *_Nonnull s, AG_Size n)
+{
+	AG_Size i = 0;
+#ifdef UNICODE_SSE2
+	for (; i+16 <= n; i += 16) {
+		int mask = _mm_movemask_epi8(_mm_loadu_si128(
+		                             (const __m128i *)&s[i]));
+		if (mask != 0)
+			return (i + (AG_Size)__builtin_ctz((Uint)mask));
+	}
+#else
+	for (; i+sizeof(Uint32) <= n; i += sizeof(Uint32)) {
+		Uint32 w;
+
+		memcpy(&w, &s[i], sizeof(w));
+		if (w & 0x80808080U)
+			break;
+	}
+#endif
+	while (i < n && s[i] < 0x80) {
+		i++;
+	}
+	return (i);
+}
+
+/*
+ * Decode n bytes of UTF-8 into ucs (which must hold n characters) and
+ * return the number of characters written. Runs of US-ASCII are widened
+ * in blocks. Invalid, truncated or overlong sequences are replaced by
+ * U+FFFD. The legacy 5- and 6-byte forms are accepted.
+ */
+static AG_Size
+DecodeUTF8(AG_Char *_Nonnull ucs, const Uchar *_Nonnull s, AG_Size n)
+{
+	static const Uint32 minChar[6] = {
+		0, 0x80, 0x800, 0x10000, 0x200000, 0x4000000
+	};
+	const Uchar *p = s, *pEnd = &s[n];
+	AG_Char *d = ucs;
+
+	while (p < pEnd) {
+		AG_Size nASCII;
+		AG_Char ch;
+		Uchar c;
+		int i, nCont;
+
+		if ((nASCII = LengthASCII(p, (AG_Size)(pEnd - p))) > 0) {
+			WidenBytes(d, p, nASCII);
+			d += nASCII;
+			if ((p += nASCII) == pEnd)
+				break;
+		}
+		c = *p;
+		if      ((c & 0xe0) == 0xc0) { nCont = 1; ch = c & 0x1f; }
+		else if ((c & 0xf0) == 0xe0) { nCont = 2; ch = c & 0x0f; }
+		else if ((c & 0xf8) == 0xf0) { nCont = 3; ch = c & 0x07; }
+		else if ((c & 0xfc) == 0xf8) { nCont = 4; ch = c & 0x03; }
+		else if ((c & 0xfe) == 0xfc) { nCont = 5; ch = c & 0x01; }
+		else                         { goto invalid; }
+
+		if (pEnd - p <= nCont) {
+			goto invalid;
+		}
+		for (i = 1; i <= nCont; i++) {
+			if ((p[i] & 0xc0) != 0x80) {
+				goto invalid;
+			}
+			ch = (ch << 6) | (p[i] & 0x3f);
+		}
+		if (ch < minChar[nCont]) {
+			goto invalid;
+		}
+		*d++ = ch;
+		p += nCont+1;
+		continue;
+invalid:
+		*d++ = 0xfffd;
+		p++;
+	}
+	return (AG_Size)(d - ucs);
+}
+
+/* Decode a NUL-terminated UTF-16 string (little or big endian). */
+static AG_Char *_Nullable
+ImportUTF16(const Uchar *_Nonnull s, int bigEndian, AG_Size *_Nullable pOutLen,
+    AG_Size *_Nullable pOutSize)
+{
+	const int lo = bigEndian ? 1 : 0, hi = bigEndian ? 0 : 1;
+	AG_Char *ucs, *d;
+	AG_Size i, n, bufLen;
+	Uint32 u, u2;
+
+	for (n = 0; s[n*2] != '\0' || s[n*2+1] != '\0'; n++)
+		;;
+	bufLen = (n + 1)*sizeof(AG_Char);
+	if ((ucs = TryMalloc(bufLen)) == NULL) {
+		return (NULL);
+	}
+	for (i = 0, d = ucs; i < n; i++) {
+		u = (Uint32)s[i*2+lo] | ((Uint32)s[i*2+hi] << 8);
+		if (u >= 0xd800 && u <= 0xdbff && i+1 < n) {
+			u2 = (Uint32)s[i*2+2+lo] | ((Uint32)s[i*2+2+hi] << 8);
+			if (u2 >= 0xdc00 && u2 <= 0xdfff) {
+				*d++ = 0x10000 + ((u - 0xd800) << 10) +
+				       (u2 - 0xdc00);
+				i++;
+				continue;
+			}
+		}
+		*d++ = (u >= 0xd800 && u <= 0xdfff) ? 0xfffd : u;
+	}
+	*d = '\0';
+	if (pOutLen != NULL) { *pOutLen = (AG_Size)(d - ucs); }
+	if (pOutSize != NULL) { *pOutSize = bufLen; }
+	return (ucs);
+}
+
 /*
  * Convert s from the given encoding to a newly-allocated UCS-4 buffer.
  *
  * Return the number of characters converted into pOutLen (if not NULL).
  * Return the total allocated buffer size into pOutSize (if not NULL).
  *
+ * UTF-8 is decoded in a single pass (invalid sequences are replaced by
+ * U+FFFD). US-ASCII, ISO-8859-1, UTF-16LE and UTF-16BE are also handled
+ * internally; other encodings are converted with iconv(3) if available.
+ * UTF-16 input is terminated by a 16-bit NUL.
+ *
  * Return NULL if insufficient memory is available, or if the encoding
  * is not valid.
  */
@@ -1016,74 +1659,46 @@ AG_Char *
 AG_ImportUnicode(const char *encoding, const char *s, AG_Size *pOutLen,
     AG_Size *pOutSize)
 {
-	AG_Char *ucs;
-	AG_Size i, j;
-	AG_Size sLen = strlen(s);
-	AG_Size bufLen, utf8len;
+	AG_Char *ucs, *ucsNew;
+	AG_Size sLen, bufLen, len;
 
 	if (strcmp(encoding, "UTF-8") == 0) {
-		utf8len = AG_LengthUTF8(s);
-		bufLen = (utf8len + 1)*sizeof(AG_Char);
+		sLen = strlen(s);
+		bufLen = (sLen + 1)*sizeof(AG_Char);
 		if ((ucs = TryMalloc(bufLen)) == NULL) {
 			return (NULL);
 		}
-		for (i = 0, j = 0; i < sLen; i++, j++) {
-			switch (AG_CharLengthUTF8(s[i])) {
-			case 1:
-				ucs[j] = (AG_Char)s[i];
-				break;
-			case 2:
-				ucs[j]  = (AG_Char)(s[i]   & 0x1f) << 6;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f);
-				break;
-			case 3:
-				ucs[j]  = (AG_Char)(s[i]   & 0x0f) << 12;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 6;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f);
-				break;
-			case 4:
-				ucs[j]  = (AG_Char)(s[i]   & 0x07) << 18;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 12;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 6;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f);
-				break;
-			case 5:
-				ucs[j]  = (AG_Char)(s[i]   & 0x03) << 24;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 18;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 12;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 6;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f);
-				break;
-			case 6:
-				ucs[j]  = (AG_Char)(s[i]   & 0x01) << 30;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 24;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 18;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 12;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f) << 6;
-				ucs[j] |= (AG_Char)(s[++i] & 0x3f);
-				break;
-			case -1:
-				Free(ucs);
-				return (NULL);
+		len = DecodeUTF8(ucs, (const Uchar *)s, sLen);
+		if (len < sLen) {
+			/* Shrink the buffer down to the actual length. */
+			if ((ucsNew = TryRealloc(ucs,
+			    (len+1)*sizeof(AG_Char))) != NULL) {
+				ucs = ucsNew;
+				bufLen = (len+1)*sizeof(AG_Char);
 			}
 		}
-		ucs[j] = '\0';
-		if (pOutLen != NULL) { *pOutLen = j; }
+		ucs[len] = '\0';
+		if (pOutLen != NULL) { *pOutLen = len; }
 		if (pOutSize != NULL) { *pOutSize = bufLen; }
-	} else if (strcmp(encoding, "US-ASCII") == 0) {
+	} else if (strcmp(encoding, "US-ASCII") == 0 ||
+	           strcmp(encoding, "ISO-8859-1") == 0) {
+		sLen = strlen(s);
 		bufLen = (sLen + 1)*sizeof(AG_Char);
 		if ((ucs = TryMalloc(bufLen)) == NULL) {
 			return (NULL);
 		}
-		for (i = 0; i < sLen; i++) {
-			ucs[i] = ((const unsigned char *)s)[i];
-		}
-		ucs[i] = '\0';
-		if (pOutLen != NULL) { *pOutLen = i; }
+		WidenBytes(ucs, (const Uchar *)s, sLen);
+		ucs[sLen] = '\0';
+		if (pOutLen != NULL) { *pOutLen = sLen; }
 		if (pOutSize != NULL) { *pOutSize = bufLen; }
+	} else if (strcmp(encoding, "UTF-16LE") == 0) {
+		ucs = ImportUTF16((const Uchar *)s, 0, pOutLen, pOutSize);
+	} else if (strcmp(encoding, "UTF-16BE") == 0) {
+		ucs = ImportUTF16((const Uchar *)s, 1, pOutLen, pOutSize);
 	} else {
 # ifdef HAVE_ICONV
-		ucs = ImportUnicodeICONV(encoding, s, sLen, pOutLen, pOutSize);
+		ucs = ImportUnicodeICONV(encoding, s, strlen(s), pOutLen,
+		    pOutSize);
 # else
 		AG_SetError("No such encoding: \"%s\"", encoding);
 		return (NULL);
@@ -1149,10 +1764,64 @@ ExportUnicodeICONV(const char *_Nonnull encoding, char *_Nonnull dst,
 
 # endif /* HAVE_ICONV */
 
+/* Encode to UTF-16 (little or big endian), with a 16-bit NUL terminator. */
+static int
+ExportUTF16(Uchar *_Nonnull dst, const AG_Char *_Nonnull ucs, AG_Size dstSize,
+    int bigEndian)
+{
+	const int lo = bigEndian ? 1 : 0, hi = bigEndian ? 0 : 1;
+	AG_Size len = 0;
+	Uint32 u[2];
+	int i, n;
+
+	if (dstSize < 2) {
+		goto nospace;
+	}
+	for (; *ucs != '\0'; ucs++) {
+		if (*ucs < 0x10000) {
+			if (*ucs >= 0xd800 && *ucs <= 0xdfff) {
+				goto bad;
+			}
+			u[0] = *ucs;
+			n = 1;
+		} else if (*ucs <= 0x10ffff) {
+			u[0] = 0xd800 + ((*ucs - 0x10000) >> 10);
+			u[1] = 0xdc00 + ((*ucs - 0x10000) & 0x3ff);
+			n = 2;
+		} else {
+			goto bad;
+		}
+		if (len + n*2 + 2 > dstSize) {
+			goto nospace;
+		}
+		for (i = 0; i < n; i++) {
+			dst[len+lo] = (Uchar)(u[i] & 0xff);
+			dst[len+hi] = (Uchar)(u[i] >> 8);
+			len += 2;
+		}
+	}
+	dst[len] = '\0';
+	dst[len+1] = '\0';
+	return (0);
+bad:
+	AG_SetErrorS("Character not representable in UTF-16");
+	goto fail;
+nospace:
+	AG_SetErrorS("Out of space");
+fail:
+	if (dstSize >= 2) {
+		dst[len] = '\0';
+		dst[len+1] = '\0';
+	} else {
+		dst[0] = '\0';
+	}
+	return (-1);
+}
+
 /*
  * Convert an internal UCS-4 string to a fixed-size buffer using the specified
  * encoding. At most dstSize-1 bytes will be copied. The string is always
- * NUL-terminated.
+ * NUL-terminated (UTF-16 output is terminated by a 16-bit NUL).
  */
 int
 AG_ExportUnicode(const char *encoding, char *dst, const AG_Char *ucs,
@@ -1160,14 +1829,21 @@ AG_ExportUnicode(const char *encoding, char *dst, const AG_Char *ucs,
 {
 	AG_Size len;
 
+	if (dstSize == 0) {
+		AG_SetErrorS("Out of space");
+		return (-1);
+	}
 	if (strcmp(encoding, "UTF-8") == 0) {
-		for (len = 0; *ucs != '\0' && len < dstSize; ucs++) {
+		for (len = 0; *ucs != '\0'; ucs++) {
 			AG_Char uch = *ucs;
 			int chlen, ch1, i;
 
 			if (uch < 0x80) {
-				chlen = 1;
-				ch1 = 0;
+				if (len+2 > dstSize) {
+					break;
+				}
+				dst[len++] = (char)uch;
+				continue;
 			} else if (uch < 0x800) {	
 				chlen = 2;
 				ch1 = 0xc0;
@@ -1184,35 +1860,49 @@ AG_ExportUnicode(const char *encoding, char *dst, const AG_Char *ucs,
 				chlen = 6;
 				ch1 = 0xfc;
 			} else {
+				dst[len] = '\0';
 				AG_SetErrorS("Bad UTF-8 sequence");
 				return (-1);
 			}
 			if (len+chlen+1 > dstSize) {
-				AG_SetErrorS("Out of space");
-				return (-1);
+				break;
 			}
 			for (i = chlen - 1; i > 0; i--) {
-				dst[i] = (uch & 0x3f) | 0x80;
+				dst[len+i] = (uch & 0x3f) | 0x80;
 				uch >>= 6;
 			}
-			dst[0] = uch | ch1;
-			dst += chlen;
+			dst[len] = uch | ch1;
 			len += chlen;
 		}
-		*dst = '\0';
+		dst[len] = '\0';
+		if (*ucs != '\0') {
+			AG_SetErrorS("Out of space");
+			return (-1);
+		}
 		return (0);
-	} else if (strcmp(encoding, "US-ASCII") == 0) {
-		for (len = 0; *ucs != '\0' && len < dstSize; ucs++) {
-			if ((*ucs) & ~0x7f) {
-				AG_SetErrorS("Non-ASCII character");
+	} else if (strcmp(encoding, "US-ASCII") == 0 ||
+	           strcmp(encoding, "ISO-8859-1") == 0) {
+		const AG_Char max = (encoding[0] == 'U') ? 0x7f : 0xff;
+
+		for (len = 0; *ucs != '\0' && len+1 < dstSize; ucs++) {
+			if (*ucs > max) {
+				dst[len] = '\0';
+				AG_SetErrorS("Character not representable "
+				             "in the target encoding");
 				return (-1);
 			}
-			*dst = (char)*ucs;
-			dst++;
-			len++;
+			dst[len++] = (char)*ucs;
+		}
+		dst[len] = '\0';
+		if (*ucs != '\0') {
+			AG_SetErrorS("Out of space");
+			return (-1);
 		}
-		*dst = '\0';
 		return (0);
+	} else if (strcmp(encoding, "UTF-16LE") == 0) {
+		return ExportUTF16((Uchar *)dst, ucs, dstSize, 0);
+	} else if (strcmp(encoding, "UTF-16BE") == 0) {
+		return ExportUTF16((Uchar *)dst, ucs, dstSize, 1);
 	} else {
 # ifdef HAVE_ICONV
 		return ExportUnicodeICONV(encoding, dst, ucs, dstSize);
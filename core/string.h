@@ -33,6 +33,8 @@
 #ifndef	_AGAR_CORE_STRING_H_
 #define	_AGAR_CORE_STRING_H_
 
+#include <stdarg.h>
+
 #include <agar/core/begin.h>
 
 #ifdef AG_ENABLE_STRING
@@ -43,8 +45,11 @@
 # define AG_STRING_POINTERS_MAX	32			/* For AG_Printf */
 # endif
 
+struct ag_fmt_program;
+
 typedef struct ag_fmt_string {
 	char *_Nonnull  s;			       /* Format string */
+	struct ag_fmt_program *_Nullable prog;	       /* Compiled format */
 	void *_Nullable p[AG_STRING_POINTERS_MAX];     /* Variable references */
 	_Nullable_Mutex AG_Mutex *_Nullable mu[AG_STRING_POINTERS_MAX];
 	Uint n;
@@ -61,6 +66,26 @@ typedef struct ag_fmt_string_ext {
 	_Nonnull AG_FmtStringExtFn fn;	/* Callback function */
 } AG_FmtStringExt;
 
+/* Operation of a compiled format string. */
+typedef struct ag_fmt_op {
+	Uint8  type;			/* Operation (private) */
+	Uint8  flags;			/* Operation flags (private) */
+	Uint16 len;			/* Literal or extension name length */
+	Uint32 off;			/* Offset of literal or spec in text */
+	_Nullable AG_FmtStringExtFn fn;	/* Resolved extension (or NULL) */
+} AG_FmtOp;
+
+/* Compiled format string (see AG_FmtCompile()). */
+typedef struct ag_fmt_program {
+	char *_Nonnull text;		/* Format string and printf(3) specs */
+	AG_FmtOp *_Nullable ops;	/* Operations */
+	Uint nOps;			/* Operation count */
+	Uint nArgs;			/* Arguments consumed */
+	Uint flags;
+#define AG_FMT_POLLED 0x01		/* AG_PrintfP() syntax (pointer args) */
+	Uint extGen;			/* Extension table generation */
+} AG_FmtProgram;
+
 # define AG_FMTSTRING_ARG(fs) ((fs)->p[fs->curArg++])
 # define AG_FMTSTRING_BUFFER_INIT 128
 # define AG_FMTSTRING_BUFFER_GROW 128
@@ -108,6 +133,13 @@ void    AG_RegisterFmtStringExt(const char *_Nonnull, _Nonnull AG_FmtStringExtFn
 void    AG_UnregisterFmtStringExt(const char *_Nonnull);
 AG_Size AG_ProcessFmtString(AG_FmtString *_Nonnull, char *_Nonnull, AG_Size);
 void    AG_FreeFmtString(AG_FmtString *_Nonnull);
+
+AG_FmtProgram *_Nullable AG_FmtCompile(const char *_Nonnull);
+void                     AG_FmtFree(AG_FmtProgram *_Nonnull);
+AG_Size                  AG_FmtPrint(const AG_FmtProgram *_Nonnull,
+                                     char *_Nonnull, AG_Size, ...);
+AG_Size                  AG_FmtPrintV(const AG_FmtProgram *_Nonnull,
+                                      char *_Nonnull, AG_Size, va_list);
 #endif /* AG_ENABLE_STRING */
 
 char *_Nullable AG_Strsep(char *_Nonnull *_Nullable, const char *_Nonnull);
@@ -0,0 +1,93 @@
+/*	Public domain	*/
+/*
+ * Work-stealing task pool.
+ */
+
+#ifndef _AGAR_CORE_TASK_H_
+#define _AGAR_CORE_TASK_H_
+
+#include <agar/core/begin.h>
+
+#if AG_MODEL != AG_SMALL
+
+typedef void (*AG_TaskFn)(void *_Nullable);
+typedef void (*AG_TaskRangeFn)(void *_Nullable, int, int);
+
+/* Set of tasks which can be waited on with AG_TaskWait(). */
+typedef struct ag_task_group {
+	int nPending;			/* Submitted but not yet completed */
+	Uint32 _pad;
+} AG_TaskGroup;
+
+#define AG_TASK_GROUP_INITIALIZER { 0, 0 }
+
+/* Queued task. */
+typedef struct ag_task {
+	_Nonnull AG_TaskFn fn;		/* Task routine */
+	void *_Nullable arg;		/* User argument */
+	AG_TaskGroup *_Nullable grp;	/* Group to notify on completion */
+} AG_Task;
+
+/* Double-ended queue of tasks (owned by a worker thread). */
+typedef struct ag_task_deque {
+	_Nonnull_Mutex AG_Mutex lock;
+	AG_Task *_Nullable tasks;	/* Ring buffer of tasks */
+	Uint maxTasks;			/* Ring buffer size (power of 2) */
+	Uint head;			/* Oldest task (stolen first) */
+	Uint tail;			/* Next free slot (owner pops here) */
+	Uint32 _pad;
+	AG_Size nExecuted;		/* Tasks executed by this worker */
+	AG_Size nStolen;		/* Tasks stolen by this worker */
+	struct ag_task_pool *_Nonnull pool;
+	_Nullable_Thread AG_Thread th;	/* Worker thread */
+} AG_TaskDeque;
+
+/* Task pool statistics. */
+typedef struct ag_task_pool_stats {
+	Uint nThreads;			/* Worker threads */
+	Uint nQueued;			/* Tasks currently queued */
+	AG_Size nSubmitted;		/* Total tasks submitted */
+	AG_Size nExecuted;		/* Total tasks executed */
+	AG_Size nStolen;		/* Tasks stolen from another deque */
+	AG_Size nInline;		/* Tasks run by non-worker threads */
+	AG_Size nSleeps;		/* Times a thread blocked for work */
+} AG_TaskPoolStats;
+
+/* Pool of worker threads. */
+typedef struct ag_task_pool {
+	Uint flags;
+#define AG_TASK_POOL_EXITING 0x01	/* Workers are shutting down */
+	Uint nWorkers;			/* Worker thread count */
+	AG_TaskDeque *_Nullable deques;	/* Per-worker deques (+1 for
+					   tasks from other threads) */
+	int nQueued;			/* Tasks in all deques */
+	int nSleeping;			/* Threads blocked on cond */
+	AG_Size nSubmitted;		/* Statistics */
+	AG_Size nInline;
+	AG_Size nSleeps;
+	_Nonnull_Mutex AG_Mutex lock;	/* For sleeping and wakeups */
+	_Nonnull_Cond AG_Cond cond;	/* Work queued or group completed */
+	AG_ThreadKey workerKey;		/* Deque of the calling worker */
+	Uint32 _pad;
+} AG_TaskPool;
+
+__BEGIN_DECLS
+AG_TaskPool *_Nullable AG_TaskPoolNew(Uint);
+void                   AG_TaskPoolDestroy(AG_TaskPool *_Nonnull);
+AG_TaskPool *_Nonnull  AG_TaskPoolDefault(void);
+void                   AG_TaskPoolDestroyDefault(void);
+void                   AG_TaskPoolGetStats(AG_TaskPool *_Nonnull,
+                                           AG_TaskPoolStats *_Nonnull);
+
+void AG_TaskGroupInit(AG_TaskGroup *_Nonnull);
+int  AG_TaskSubmit(AG_TaskPool *_Nonnull, AG_TaskGroup *_Nullable,
+                   _Nonnull AG_TaskFn, void *_Nullable);
+void AG_TaskWait(AG_TaskPool *_Nonnull, AG_TaskGroup *_Nonnull);
+void AG_TaskParallelFor(AG_TaskPool *_Nonnull, int, int, int,
+                        _Nonnull AG_TaskRangeFn, void *_Nullable);
+__END_DECLS
+
+#endif /* AG_MODEL != AG_SMALL */
+
+#include <agar/core/close.h>
+#endif /* _AGAR_CORE_TASK_H_ */
@@ -44,13 +44,32 @@ AG_TblNew(Uint nBuckets, Uint flags)
 	return (t);
 }
 
-/* Initialize a table structure. */
+/*
+ * Initialize a table structure. In GROWABLE mode, nBuckets is a hint for
+ * the expected number of entries.
+ */
 void
 AG_TblInit(AG_Tbl *tbl, Uint nBuckets, Uint flags)
 {
 	Uint i;
 
 	tbl->flags = flags;
+	tbl->slots = NULL;
+	tbl->nSlots = 0;
+
+	if (flags & AG_TBL_GROWABLE) {
+		Uint nSlots;
+
+		for (nSlots = 16;
+		     nSlots*AG_TBL_LOAD_MAX/100 < nBuckets;
+		     nSlots <<= 1)
+			;
+		tbl->slots = Malloc(nSlots*sizeof(AG_TblSlot));
+		memset(tbl->slots, 0, nSlots*sizeof(AG_TblSlot));
+		tbl->nSlots = nSlots;
+		nBuckets = 1;
+	}
+
 	tbl->nBuckets = nBuckets;
 	tbl->buckets = Malloc(nBuckets*sizeof(AG_TblBucket));
 
@@ -59,6 +78,7 @@ AG_TblInit(AG_Tbl *tbl, Uint nBuckets, Uint flags)
 		buck->keys = NULL;
 		buck->ents = NULL;
 		buck->nEnts = 0;
+		buck->maxEnts = 0;
 	}
 }
 
@@ -79,15 +99,119 @@ AG_TblDestroy(AG_Tbl *t)
 		free(buck->ents);
 	}
 	free(t->buckets);
+	Free(t->slots);
+}
+
+/* Grow the arrays of a bucket (in powers of two). */
+static int
+GrowBucket(AG_TblBucket *_Nonnull buck)
+{
+	const Uint maxNew = (buck->maxEnts > 0) ? (buck->maxEnts << 1) : 4;
+	AG_Variable *entsNew;
+	char **keysNew;
+
+	if ((entsNew = TryRealloc(buck->ents, maxNew*sizeof(AG_Variable))) == NULL) {
+		return (-1);
+	}
+	buck->ents = entsNew;
+	if ((keysNew = TryRealloc(buck->keys, maxNew*sizeof(char *))) == NULL) {
+		return (-1);
+	}
+	buck->keys = keysNew;
+	buck->maxEnts = maxNew;
+	return (0);
+}
+
+/*
+ * Return the index slot matching key (or the empty slot ending the probe).
+ * GROWABLE mode only.
+ */
+static __inline__ AG_TblSlot *_Nonnull
+ProbeSlot(const AG_Tbl *_Nonnull tbl, Uint32 h, const char *_Nonnull key)
+{
+	const AG_TblBucket *buck = &tbl->buckets[0];
+	const Uint mask = tbl->nSlots - 1;
+	AG_TblSlot *slots = tbl->slots;
+	Uint i;
+
+	for (i = h & mask; slots[i].ent != 0; i = (i+1) & mask) {
+		if (slots[i].hash == h &&
+		    strcmp(buck->keys[slots[i].ent - 1], key) == 0)
+			break;
+	}
+	return (&slots[i]);
+}
+
+/* Double the size of the index. GROWABLE mode only. */
+static int
+GrowSlots(AG_Tbl *_Nonnull tbl)
+{
+	const Uint nSlotsNew = tbl->nSlots << 1;
+	const Uint mask = nSlotsNew - 1;
+	AG_TblSlot *slotsNew;
+	Uint i, j;
+
+	if ((slotsNew = TryMalloc(nSlotsNew*sizeof(AG_TblSlot))) == NULL) {
+		return (-1);
+	}
+	memset(slotsNew, 0, nSlotsNew*sizeof(AG_TblSlot));
+
+	for (i = 0; i < tbl->nSlots; i++) {
+		const AG_TblSlot *slot = &tbl->slots[i];
+
+		if (slot->ent == 0) {
+			continue;
+		}
+		for (j = slot->hash & mask; slotsNew[j].ent != 0; j = (j+1) & mask)
+			;
+		slotsNew[j] = *slot;
+	}
+	free(tbl->slots);
+	tbl->slots = slotsNew;
+	tbl->nSlots = nSlotsNew;
+	return (0);
+}
+
+/* Clear an index slot (backward-shift deletion). GROWABLE mode only. */
+static void
+RemoveSlot(AG_Tbl *_Nonnull tbl, Uint i)
+{
+	AG_TblSlot *slots = tbl->slots;
+	const Uint mask = tbl->nSlots - 1;
+	Uint j, k;
+
+	for (j = i; ; ) {
+		j = (j+1) & mask;
+		if (slots[j].ent == 0) {
+			break;
+		}
+		k = slots[j].hash & mask;
+		if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+			continue;
+		}
+		slots[i] = slots[j];
+		i = j;
+	}
+	slots[i].hash = 0;
+	slots[i].ent = 0;
 }
 
 /* Look up a named table entry. */
 AG_Variable *
 AG_TblLookupHash(AG_Tbl *tbl, Uint h, const char *key)
 {
-	AG_TblBucket *buck = &tbl->buckets[h];
+	AG_TblBucket *buck;
 	Uint i;
 
+	if (tbl->flags & AG_TBL_GROWABLE) {
+		const AG_TblSlot *slot = ProbeSlot(tbl, (Uint32)h, key);
+
+		if (slot->ent == 0) {
+			return (NULL);
+		}
+		return (&tbl->buckets[0].ents[slot->ent - 1]);
+	}
+	buck = &tbl->buckets[h];
 	for (i = 0; i < buck->nEnts; i++) {
 		if (strcmp(buck->keys[i], key) == 0)
 			break;
@@ -102,9 +226,13 @@ AG_TblLookupHash(AG_Tbl *tbl, Uint h, const char *key)
 int
 AG_TblExistsHash(AG_Tbl *tbl, Uint h, const char *key)
 {
-	AG_TblBucket *buck = &tbl->buckets[h];
+	AG_TblBucket *buck;
 	Uint i;
-	
+
+	if (tbl->flags & AG_TBL_GROWABLE) {
+		return (ProbeSlot(tbl, (Uint32)h, key)->ent != 0);
+	}
+	buck = &tbl->buckets[h];
 	for (i = 0; i < buck->nEnts; i++) {
 		if (strcmp(buck->keys[i], key) == 0)
 			return (1);
@@ -119,52 +247,98 @@ AG_TblExistsHash(AG_Tbl *tbl, Uint h, const char *key)
 int
 AG_TblInsertHash(AG_Tbl *tbl, Uint h, const char *key, const AG_Variable *V)
 {
-	AG_TblBucket *buck = &tbl->buckets[h];
-	AG_Variable *entsNew;
-	char **keysNew;
+	AG_TblBucket *buck;
 	Uint i;
 
-	for (i = 0; i < buck->nEnts; i++) {
-		if (strcmp(buck->keys[i], key) == 0)
-			break;
-	}
-	if (!(tbl->flags & AG_TBL_DUPLICATES) && i < buck->nEnts) {
-		AG_SetErrorV("E27", "Table entry exists");
-		return (-1);
-	}
+	if (tbl->flags & AG_TBL_GROWABLE) {
+		Uint mask;
 
-	if ((entsNew = TryRealloc(buck->ents,
-	    (buck->nEnts+1)*sizeof(AG_Variable))) == NULL) {
-		return (-1);
-	}
-	if ((keysNew = TryRealloc(buck->keys,
-	    (buck->nEnts+1)*sizeof(char *))) == NULL) {
-		free(entsNew);
-		return (-1);
+		buck = &tbl->buckets[0];
+		if (!(tbl->flags & AG_TBL_DUPLICATES) &&
+		    ProbeSlot(tbl, (Uint32)h, key)->ent != 0) {
+			AG_SetErrorV("E27", "Table entry exists");
+			return (-1);
+		}
+		if ((buck->nEnts + 1)*100 > tbl->nSlots*AG_TBL_LOAD_MAX &&
+		    GrowSlots(tbl) == -1) {
+			return (-1);
+		}
+		if (buck->nEnts == buck->maxEnts && GrowBucket(buck) == -1) {
+			return (-1);
+		}
+		mask = tbl->nSlots - 1;
+		for (i = h & mask; tbl->slots[i].ent != 0; i = (i+1) & mask)
+			;
+		tbl->slots[i].hash = (Uint32)h;
+		tbl->slots[i].ent = buck->nEnts + 1;
+	} else {
+		buck = &tbl->buckets[h];
+		if (!(tbl->flags & AG_TBL_DUPLICATES)) {
+			for (i = 0; i < buck->nEnts; i++) {
+				if (strcmp(buck->keys[i], key) == 0) {
+					AG_SetErrorV("E27", "Table entry exists");
+					return (-1);
+				}
+			}
+		}
+		if (buck->nEnts == buck->maxEnts && GrowBucket(buck) == -1)
+			return (-1);
 	}
-	buck->ents = entsNew;
-	buck->keys = keysNew;
 	buck->keys[buck->nEnts] = Strdup(key);
 	AG_CopyVariable(&buck->ents[buck->nEnts], V);
 	buck->nEnts++;
 	return (0);
 }
 
-/* Remove a named table entry. */
+/*
+ * Remove a named table entry. In GROWABLE mode, the last entry is moved
+ * into the place of the deleted one.
+ */
 int
 AG_TblDeleteHash(AG_Tbl *tbl, Uint h, const char *key)
 {
-	AG_TblBucket *buck = &tbl->buckets[h];
+	AG_TblBucket *buck;
 	Uint i;
 
+	if (tbl->flags & AG_TBL_GROWABLE) {
+		AG_TblSlot *slot = ProbeSlot(tbl, (Uint32)h, key);
+		Uint j;
+
+		if (slot->ent == 0) {
+			goto fail_noent;
+		}
+		buck = &tbl->buckets[0];
+		i = slot->ent - 1;
+		RemoveSlot(tbl, (Uint)(slot - tbl->slots));
+
+		free(buck->keys[i]);
+		AG_FreeVariable(&buck->ents[i]);
+
+		/*
+		 * Compact the entries to preserve insertion order, and
+		 * renumber the slots of the entries which moved down.
+		 */
+		if (i < buck->nEnts-1) {
+			memmove(&buck->ents[i], &buck->ents[i+1],
+			    (buck->nEnts - i - 1)*sizeof(AG_Variable));
+			memmove(&buck->keys[i], &buck->keys[i+1],
+			    (buck->nEnts - i - 1)*sizeof(char *));
+			for (j = 0; j < tbl->nSlots; j++) {
+				if (tbl->slots[j].ent > i+1)
+					tbl->slots[j].ent--;
+			}
+		}
+		buck->nEnts--;
+		return (0);
+	}
+
+	buck = &tbl->buckets[h];
 	for (i = 0; i < buck->nEnts; i++) {
 		if (strcmp(buck->keys[i], key) == 0)
 			break;
 	}
-	if (i == buck->nEnts) {
-		AG_SetErrorV("E28", "No such table entry");
-		return (-1);
-	}
+	if (i == buck->nEnts)
+		goto fail_noent;
 
 	free(buck->keys[i]);
 	AG_FreeVariable(&buck->ents[i]);
@@ -177,4 +351,7 @@ AG_TblDeleteHash(AG_Tbl *tbl, Uint h, const char *key)
 	}
 	buck->nEnts--;
 	return (0);
+fail_noent:
+	AG_SetErrorV("E28", "No such table entry");
+	return (-1);
 }
@@ -11,17 +11,31 @@ typedef struct ag_tbl_bucket {
 	char *_Nullable *_Nonnull keys;
 	AG_Variable *_Nullable    ents;
 	Uint                     nEnts;
-	Uint32 _pad;
+	Uint                     maxEnts;	/* Allocated entries */
 } AG_TblBucket;
 
+/* Slot of the open-addressing index (in GROWABLE mode). */
+typedef struct ag_tbl_slot {
+	Uint32 hash;				/* Full hash of key */
+	Uint32 ent;				/* Entry index + 1 (0 = empty) */
+} AG_TblSlot;
+
 typedef struct ag_tbl {
 	Uint flags;
 #define AG_TBL_DUPLICATES	0x01	/* Allow duplicate entries */
+#define AG_TBL_GROWABLE		0x02	/* Open addressing with auto-resize */
 
 	Uint                  nBuckets;		/* Bucket count */
 	AG_TblBucket *_Nonnull buckets;		/* Hash buckets */
+	AG_TblSlot *_Nullable  slots;		/* Index (in GROWABLE mode) */
+	Uint                   nSlots;		/* Slot count (2^n) */
+	Uint32 _pad;
 } AG_Tbl;
 
+#ifndef AG_TBL_LOAD_MAX
+#define AG_TBL_LOAD_MAX 50		/* Max load (%) before resize */
+#endif
+
 __BEGIN_DECLS
 AG_Tbl *_Nonnull AG_TblNew(Uint, Uint);
 void             AG_TblInit(AG_Tbl *_Nonnull, Uint, Uint);
@@ -35,7 +49,10 @@ int                    AG_TblInsertHash(AG_Tbl *_Nonnull, Uint, const char *_Non
                                         const AG_Variable *_Nonnull);
 int                    AG_TblDeleteHash(AG_Tbl *_Nonnull, Uint, const char *_Nonnull);
 
-/* Iterate over each entry. */
+/*
+ * Iterate over each entry. In GROWABLE mode, all entries are stored
+ * in a single bucket in insertion order (which is preserved by resizes).
+ */
 #define AG_TBL_FOREACH(var, i,j, tbl)					\
 	for ((i) = 0; ((i) < (tbl)->nBuckets); (i)++)			\
 		for ((j) = 0;						\
@@ -45,6 +62,9 @@ int                    AG_TblDeleteHash(AG_Tbl *_Nonnull, Uint, const char *_Non
 /*
  * Inlinables
  */
+Uint32                 ag_hash_string(const char *_Nonnull) _Pure_Attribute;
+Uint32                 ag_hash_buffer(const void *_Nonnull, AG_Size)
+                                     _Pure_Attribute;
 Uint                   ag_tbl_hash(AG_Tbl *_Nonnull, const char *_Nonnull)
                                   _Pure_Attribute;
 AG_Variable *_Nullable ag_tbl_lookup(AG_Tbl *_Nonnull, const char *_Nonnull)
@@ -59,6 +79,8 @@ int ag_tbl_delete(AG_Tbl *_Nonnull, const char *_Nonnull);
 # define AG_INLINE_HEADER
 # include <agar/core/inline_tbl.h>
 #else
+# define AG_HashString(s)           ag_hash_string(s)
+# define AG_HashBuffer(p,len)       ag_hash_buffer((p),(len))
 # define AG_TblHash(t,k)            ag_tbl_hash((t),(k))
 # define AG_TblLookup(t,k)          ag_tbl_lookup((t),(k))
 # define AG_TblLookupPointer(t,k,p) ag_tbl_lookup_pointer((t),(k),(p))
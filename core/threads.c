@@ -34,3 +34,546 @@
 # undef AG_INLINE_HEADER
 # include <agar/core/inline_threads.h>
 #endif /* AG_THREADS */
+
+#if AG_MODEL != AG_SMALL
+/*
+ * Work-stealing task pool. Each worker thread owns a deque of tasks: it
+ * pushes and pops at the tail (LIFO, for locality), and idle workers steal
+ * from the head of other deques (FIFO, taking the oldest and usually
+ * largest units of work). Tasks submitted from outside the pool go to an
+ * extra deque which every worker steals from. Threads waiting on a group
+ * execute queued tasks instead of blocking.
+ *
+ * Without AG_THREADS, or with a pool of zero workers, tasks are simply
+ * executed by the thread which submits them.
+ */
+# if defined(AG_THREADS) && defined(__ATOMIC_SEQ_CST)
+#  define TASK_ADD(p, n)   __atomic_add_fetch((p), (n), __ATOMIC_SEQ_CST)
+#  define TASK_LOAD(p)     __atomic_load_n((p), __ATOMIC_SEQ_CST)
+# elif defined(AG_THREADS)
+/* No atomic builtins; serialize the counters with a mutex instead. */
+static AG_Mutex agTaskCountersLock = AG_MUTEX_INITIALIZER;
+
+static __inline__ AG_Size
+TaskAdd(void *_Nonnull p, AG_Size size, int n)
+{
+	AG_Size rv;
+
+	AG_MutexLock(&agTaskCountersLock);
+	if (size == sizeof(int)) {
+		rv = (AG_Size)(*(int *)p += n);
+	} else {
+		rv = (*(AG_Size *)p += n);
+	}
+	AG_MutexUnlock(&agTaskCountersLock);
+	return (rv);
+}
+static __inline__ int
+TaskLoad(const int *_Nonnull p)
+{
+	int rv;
+
+	AG_MutexLock(&agTaskCountersLock);
+	rv = *p;
+	AG_MutexUnlock(&agTaskCountersLock);
+	return (rv);
+}
+#  define TASK_ADD(p, n)   TaskAdd((p), sizeof(*(p)), (n))
+#  define TASK_LOAD(p)     TaskLoad(p)
+# else
+#  define TASK_ADD(p, n)   (*(p) += (n))
+#  define TASK_LOAD(p)     (*(p))
+# endif
+
+/* Initial size of deque ring buffers. */
+# define TASK_DEQUE_INIT 64
+
+static AG_TaskPool *_Nullable agTaskPool = NULL;	/* Default pool */
+# ifdef AG_THREADS
+static AG_Mutex agTaskPoolLock = AG_MUTEX_INITIALIZER;
+# endif
+
+static void
+RunTask(AG_TaskPool *_Nonnull pool, const AG_Task *_Nonnull t)
+{
+	AG_TaskGroup *grp = t->grp;
+
+	t->fn(t->arg);
+
+	if (grp != NULL && TASK_ADD(&grp->nPending, -1) == 0 &&
+	    TASK_LOAD(&pool->nSleeping) > 0) {
+		AG_MutexLock(&pool->lock);		/* Wake up waiters */
+		AG_CondBroadcast(&pool->cond);
+		AG_MutexUnlock(&pool->lock);
+	}
+}
+
+# ifdef AG_THREADS
+
+/* Push a task onto the tail of a deque. */
+static int
+DequePush(AG_TaskDeque *_Nonnull dq, const AG_Task *_Nonnull t)
+{
+	AG_MutexLock(&dq->lock);
+	if (dq->tail - dq->head == dq->maxTasks) {
+		Uint maxNew = (dq->maxTasks > 0) ? (dq->maxTasks << 1) :
+		                                   TASK_DEQUE_INIT;
+		AG_Task *tasksNew;
+		Uint i;
+
+		if ((tasksNew = TryMalloc(maxNew*sizeof(AG_Task))) == NULL) {
+			AG_MutexUnlock(&dq->lock);
+			return (-1);
+		}
+		for (i = 0; i < dq->tail - dq->head; i++) {
+			tasksNew[i] =
+			    dq->tasks[(dq->head + i) & (dq->maxTasks-1)];
+		}
+		Free(dq->tasks);
+		dq->tasks = tasksNew;
+		dq->tail -= dq->head;
+		dq->head = 0;
+		dq->maxTasks = maxNew;
+	}
+	dq->tasks[(dq->tail++) & (dq->maxTasks-1)] = *t;
+	AG_MutexUnlock(&dq->lock);
+	return (0);
+}
+
+/* Pop the most recently pushed task (or steal the oldest one). */
+static int
+DequeTake(AG_TaskDeque *_Nonnull dq, AG_Task *_Nonnull t, int steal)
+{
+	if (dq->tail == dq->head) {			/* Unlocked peek */
+		return (0);
+	}
+	AG_MutexLock(&dq->lock);
+	if (dq->tail == dq->head) {
+		AG_MutexUnlock(&dq->lock);
+		return (0);
+	}
+	if (steal) {
+		*t = dq->tasks[(dq->head++) & (dq->maxTasks-1)];
+	} else {
+		*t = dq->tasks[(--dq->tail) & (dq->maxTasks-1)];
+	}
+	AG_MutexUnlock(&dq->lock);
+	return (1);
+}
+
+/*
+ * Find a task for the calling thread: first from its own deque, then
+ * from the others (starting with the next one, to spread contention).
+ * The shared deque (index nWorkers) is treated as "own" by non-workers.
+ */
+static int
+GetTask(AG_TaskPool *_Nonnull pool, AG_TaskDeque *_Nullable self,
+    AG_Task *_Nonnull t)
+{
+	const Uint nDeques = pool->nWorkers + 1;
+	Uint i, idx;
+
+	idx = (self != NULL) ? (Uint)(self - pool->deques) : pool->nWorkers;
+	if (DequeTake(&pool->deques[idx], t, (self == NULL))) {
+		goto found;
+	}
+	for (i = 1; i < nDeques; i++) {
+		if (DequeTake(&pool->deques[(idx + i) % nDeques], t, 1)) {
+			if (self != NULL) {
+				self->nStolen++;
+			}
+			goto found;
+		}
+	}
+	return (0);
+found:
+	TASK_ADD(&pool->nQueued, -1);
+	return (1);
+}
+
+static void *_Nullable
+TaskWorkerMain(void *_Nullable arg)
+{
+	AG_TaskDeque *self = arg;
+	AG_TaskPool *pool = self->pool;
+	AG_Task t;
+
+	AG_ThreadKeySet(pool->workerKey, self);
+	for (;;) {
+		if (GetTask(pool, self, &t)) {
+			RunTask(pool, &t);
+			self->nExecuted++;
+			continue;
+		}
+		AG_MutexLock(&pool->lock);
+		TASK_ADD(&pool->nSleeping, +1);
+		while (TASK_LOAD(&pool->nQueued) == 0 &&
+		       !(pool->flags & AG_TASK_POOL_EXITING)) {
+			pool->nSleeps++;
+			AG_CondWait(&pool->cond, &pool->lock);
+		}
+		TASK_ADD(&pool->nSleeping, -1);
+		if ((pool->flags & AG_TASK_POOL_EXITING) &&
+		    TASK_LOAD(&pool->nQueued) == 0) {
+			AG_MutexUnlock(&pool->lock);
+			break;
+		}
+		AG_MutexUnlock(&pool->lock);
+	}
+	return (NULL);
+}
+# endif /* AG_THREADS */
+
+/*
+ * Create a new task pool with the given number of worker threads. If
+ * nThreads is 0, use one worker per logical processor less one (the
+ * thread calling AG_TaskWait() executes tasks as well).
+ */
+AG_TaskPool *
+AG_TaskPoolNew(Uint nThreads)
+{
+	AG_TaskPool *pool;
+	Uint i;
+
+	if ((pool = TryMalloc(sizeof(AG_TaskPool))) == NULL) {
+		return (NULL);
+	}
+# ifdef AG_THREADS
+	if (nThreads == 0)
+		nThreads = (agCPU.nCores > 1) ? agCPU.nCores-1 : 0;
+# else
+	nThreads = 0;
+# endif
+	if ((pool->deques = TryMalloc((nThreads+1)*sizeof(AG_TaskDeque)))
+	    == NULL) {
+		free(pool);
+		return (NULL);
+	}
+	pool->flags = 0;
+	pool->nWorkers = 0;
+	pool->nQueued = 0;
+	pool->nSleeping = 0;
+	pool->nSubmitted = 0;
+	pool->nInline = 0;
+	pool->nSleeps = 0;
+	AG_MutexInit(&pool->lock);
+	AG_CondInit(&pool->cond);
+	for (i = 0; i < nThreads+1; i++) {
+		AG_TaskDeque *dq = &pool->deques[i];
+
+		AG_MutexInit(&dq->lock);
+		dq->tasks = NULL;
+		dq->maxTasks = 0;
+		dq->head = 0;
+		dq->tail = 0;
+		dq->nExecuted = 0;
+		dq->nStolen = 0;
+		dq->pool = pool;
+	}
+# ifdef AG_THREADS
+	if (AG_ThreadKeyTryCreate(&pool->workerKey, NULL) == -1) {
+		goto fail;
+	}
+	/*
+	 * The shared deque is indexed after the workers; publish nWorkers
+	 * before starting any thread so that all of them agree on it.
+	 */
+	pool->nWorkers = nThreads;
+	for (i = 0; i < nThreads; i++) {
+		if (AG_ThreadTryCreate(&pool->deques[i].th, TaskWorkerMain,
+		    &pool->deques[i]) == -1) {
+			Uint j;
+
+			AG_MutexLock(&pool->lock);
+			pool->flags |= AG_TASK_POOL_EXITING;
+			AG_CondBroadcast(&pool->cond);
+			AG_MutexUnlock(&pool->lock);
+			for (j = 0; j < i; j++) {
+				void *rv;
+
+				AG_ThreadJoin(pool->deques[j].th, &rv);
+			}
+			AG_ThreadKeyDelete(pool->workerKey);
+			goto fail;
+		}
+	}
+# endif
+	return (pool);
+# ifdef AG_THREADS
+fail:
+	for (i = 0; i < nThreads+1; i++) {
+		AG_MutexDestroy(&pool->deques[i].lock);
+	}
+	AG_CondDestroy(&pool->cond);
+	AG_MutexDestroy(&pool->lock);
+	free(pool->deques);
+	free(pool);
+	return (NULL);
+# endif
+}
+
+/*
+ * Wait for the queued tasks to complete, terminate the worker threads
+ * and release the pool.
+ */
+void
+AG_TaskPoolDestroy(AG_TaskPool *pool)
+{
+# ifdef AG_THREADS
+	AG_Task t;
+# endif
+	Uint i;
+
+# ifdef AG_THREADS
+	AG_MutexLock(&pool->lock);
+	pool->flags |= AG_TASK_POOL_EXITING;
+	AG_CondBroadcast(&pool->cond);
+	AG_MutexUnlock(&pool->lock);
+	for (i = 0; i < pool->nWorkers; i++) {
+		void *rv;
+
+		AG_ThreadJoin(pool->deques[i].th, &rv);
+	}
+	while (GetTask(pool, NULL, &t))			/* Leftovers */
+		RunTask(pool, &t);
+
+	AG_ThreadKeyDelete(pool->workerKey);
+# endif
+	for (i = 0; i < pool->nWorkers+1; i++) {
+		AG_TaskDeque *dq = &pool->deques[i];
+
+		Free(dq->tasks);
+		AG_MutexDestroy(&dq->lock);
+	}
+	AG_CondDestroy(&pool->cond);
+	AG_MutexDestroy(&pool->lock);
+	free(pool->deques);
+	free(pool);
+}
+
+/*
+ * Return the default task pool, shared by all Agar subsystems (created
+ * on first use, with one worker per logical processor less one).
+ */
+AG_TaskPool *
+AG_TaskPoolDefault(void)
+{
+	AG_TaskPool *pool;
+
+# ifdef AG_THREADS
+	AG_MutexLock(&agTaskPoolLock);
+# endif
+	if ((pool = agTaskPool) == NULL) {
+		if ((pool = agTaskPool = AG_TaskPoolNew(0)) == NULL)
+			AG_FatalError(NULL);
+	}
+# ifdef AG_THREADS
+	AG_MutexUnlock(&agTaskPoolLock);
+# endif
+	return (pool);
+}
+
+/* Destroy the default task pool (if it was created). */
+void
+AG_TaskPoolDestroyDefault(void)
+{
+# ifdef AG_THREADS
+	AG_MutexLock(&agTaskPoolLock);
+# endif
+	if (agTaskPool != NULL) {
+		AG_TaskPoolDestroy(agTaskPool);
+		agTaskPool = NULL;
+	}
+# ifdef AG_THREADS
+	AG_MutexUnlock(&agTaskPoolLock);
+# endif
+}
+
+/* Return statistics for the pool (counters are read without locking). */
+void
+AG_TaskPoolGetStats(AG_TaskPool *pool, AG_TaskPoolStats *st)
+{
+	Uint i;
+
+	st->nThreads = pool->nWorkers;
+	st->nQueued = (Uint)TASK_LOAD(&pool->nQueued);
+	st->nSubmitted = pool->nSubmitted;
+	st->nInline = pool->nInline;
+	st->nSleeps = pool->nSleeps;
+	st->nExecuted = pool->nInline;
+	st->nStolen = 0;
+	for (i = 0; i < pool->nWorkers; i++) {
+		st->nExecuted += pool->deques[i].nExecuted;
+		st->nStolen += pool->deques[i].nStolen;
+	}
+}
+
+/* Initialize a task group. */
+void
+AG_TaskGroupInit(AG_TaskGroup *grp)
+{
+	grp->nPending = 0;
+}
+
+/*
+ * Submit a task for execution by the pool. If grp is not NULL, the task
+ * is accounted for by AG_TaskWait() on that group. Return -1 if the task
+ * could not be queued (insufficient memory).
+ */
+int
+AG_TaskSubmit(AG_TaskPool *pool, AG_TaskGroup *grp, AG_TaskFn fn, void *arg)
+{
+	AG_Task t;
+# ifdef AG_THREADS
+	AG_TaskDeque *self;
+# endif
+
+	t.fn = fn;
+	t.arg = arg;
+	t.grp = grp;
+
+	TASK_ADD(&pool->nSubmitted, 1);
+	if (pool->nWorkers == 0) {
+		TASK_ADD(&pool->nInline, 1);
+		fn(arg);
+		return (0);
+	}
+# ifdef AG_THREADS
+	if (grp != NULL) {
+		TASK_ADD(&grp->nPending, +1);
+	}
+	self = (AG_TaskDeque *)AG_ThreadKeyGet(pool->workerKey);
+	if (DequePush((self != NULL) ? self : &pool->deques[pool->nWorkers],
+	    &t) == -1) {
+		if (grp != NULL) {
+			TASK_ADD(&grp->nPending, -1);
+		}
+		return (-1);
+	}
+	TASK_ADD(&pool->nQueued, +1);
+
+	if (TASK_LOAD(&pool->nSleeping) > 0) {
+		AG_MutexLock(&pool->lock);
+		AG_CondSignal(&pool->cond);
+		AG_MutexUnlock(&pool->lock);
+	}
+# endif
+	return (0);
+}
+
+/*
+ * Wait for all tasks of a group to complete. The calling thread executes
+ * queued tasks (of any group) while it waits.
+ */
+void
+AG_TaskWait(AG_TaskPool *pool, AG_TaskGroup *grp)
+{
+# ifdef AG_THREADS
+	AG_TaskDeque *self;
+	AG_Task t;
+
+	if (pool->nWorkers == 0) {
+		return;
+	}
+	self = (AG_TaskDeque *)AG_ThreadKeyGet(pool->workerKey);
+
+	while (TASK_LOAD(&grp->nPending) > 0) {
+		if (GetTask(pool, self, &t)) {
+			RunTask(pool, &t);
+			if (self != NULL) {
+				self->nExecuted++;
+			} else {
+				TASK_ADD(&pool->nInline, 1);
+			}
+			continue;
+		}
+		AG_MutexLock(&pool->lock);
+		TASK_ADD(&pool->nSleeping, +1);
+		if (TASK_LOAD(&grp->nPending) > 0 &&
+		    TASK_LOAD(&pool->nQueued) == 0) {
+			pool->nSleeps++;
+			AG_CondWait(&pool->cond, &pool->lock);
+		}
+		TASK_ADD(&pool->nSleeping, -1);
+		AG_MutexUnlock(&pool->lock);
+	}
+# endif
+}
+
+/* Range of a parallel loop. */
+typedef struct ag_task_range {
+	AG_TaskRangeFn fn;
+	void *arg;
+	int start, end;
+} AG_TaskRange;
+
+static void
+RunTaskRange(void *_Nullable p)
+{
+	AG_TaskRange *r = p;
+
+	r->fn(r->arg, r->start, r->end);
+}
+
+/*
+ * Execute fn(arg, i, j) over consecutive subranges [i,j) of [start,end)
+ * of at least grain iterations (or an automatic size if grain is 0), in
+ * parallel, and wait for completion.
+ */
+void
+AG_TaskParallelFor(AG_TaskPool *pool, int start, int end, int grain,
+    AG_TaskRangeFn fn, void *arg)
+{
+	AG_TaskRange rangesStatic[64], *ranges = rangesStatic;
+	AG_TaskGroup grp = AG_TASK_GROUP_INITIALIZER;
+	const int n = end - start;
+	int i, nRanges;
+
+	if (n <= 0) {
+		return;
+	}
+	if (grain <= 0) {		/* About 4 subranges per thread */
+		grain = n / ((int)(pool->nWorkers+1) << 2);
+	}
+	if (grain < 1) {
+		grain = 1;
+	}
+	nRanges = (n + grain-1) / grain;
+	if (pool->nWorkers == 0 || nRanges == 1) {
+		TASK_ADD(&pool->nSubmitted, 1);
+		TASK_ADD(&pool->nInline, 1);
+		fn(arg, start, end);
+		return;
+	}
+	if (nRanges > 64 &&
+	    (ranges = TryMalloc(nRanges*sizeof(AG_TaskRange))) == NULL) {
+		ranges = rangesStatic;		/* Use coarser subranges */
+		grain = (n + 63) / 64;
+		nRanges = (n + grain-1) / grain;
+	}
+	for (i = 0; i < nRanges; i++) {
+		AG_TaskRange *r = &ranges[i];
+
+		r->fn = fn;
+		r->arg = arg;
+		r->start = start + i*grain;
+		r->end = (i == nRanges-1) ? end : MIN(r->start + grain, end);
+	}
+	/* Queue all but the first subrange, which we execute ourselves. */
+	for (i = 1; i < nRanges; i++) {
+		if (AG_TaskSubmit(pool, &grp, RunTaskRange, &ranges[i]) == -1)
+			RunTaskRange(&ranges[i]);
+	}
+	TASK_ADD(&pool->nSubmitted, 1);
+	TASK_ADD(&pool->nInline, 1);
+	RunTaskRange(&ranges[0]);
+
+	AG_TaskWait(pool, &grp);
+
+	if (ranges != rangesStatic)
+		free(ranges);
+}
+
+# undef TASK_ADD
+# undef TASK_LOAD
+#endif /* AG_MODEL != AG_SMALL */
@@ -37,6 +37,122 @@ AG_Object agTimerMgr;
 AG_Mutex agTimerLock;
 #endif
 
+/*
+ * Soft timers (used when the event source does not provide timers of its
+ * own) are kept in a binary min-heap ordered by expiration time, so the
+ * soonest timer is found in constant time and a timer is inserted, rescheduled
+ * or cancelled in O(log n), regardless of the number of objects owning timers.
+ */
+static AG_Timer *_Nonnull *_Nullable agTimerHeap = NULL;
+static int agTimerHeapCount = 0;
+static int agTimerHeapMax = 0;
+
+/* Compare expiration times (wraparound-safe). */
+#define TIMER_BEFORE(a,b) ((int)((a)->tSched - (b)->tSched) < 0)
+
+static void
+TimerHeapUp(int i)
+{
+	AG_Timer *to = agTimerHeap[i];
+
+	while (i > 0) {
+		const int iParent = (i - 1) >> 1;
+		AG_Timer *toParent = agTimerHeap[iParent];
+
+		if (!TIMER_BEFORE(to, toParent)) {
+			break;
+		}
+		agTimerHeap[i] = toParent;
+		toParent->pvt.heapIdx = i;
+		i = iParent;
+	}
+	agTimerHeap[i] = to;
+	to->pvt.heapIdx = i;
+}
+
+static void
+TimerHeapDown(int i)
+{
+	AG_Timer *to = agTimerHeap[i];
+
+	for (;;) {
+		int iChild = (i << 1) + 1;
+
+		if (iChild >= agTimerHeapCount) {
+			break;
+		}
+		if (iChild+1 < agTimerHeapCount &&
+		    TIMER_BEFORE(agTimerHeap[iChild+1], agTimerHeap[iChild])) {
+			iChild++;
+		}
+		if (!TIMER_BEFORE(agTimerHeap[iChild], to)) {
+			break;
+		}
+		agTimerHeap[i] = agTimerHeap[iChild];
+		agTimerHeap[i]->pvt.heapIdx = i;
+		i = iChild;
+	}
+	agTimerHeap[i] = to;
+	to->pvt.heapIdx = i;
+}
+
+static __inline__ int
+TimerInHeap(const AG_Timer *_Nonnull to)
+{
+	return (to->pvt.heapIdx >= 0 &&
+	        to->pvt.heapIdx < agTimerHeapCount &&
+	        agTimerHeap[to->pvt.heapIdx] == to);
+}
+
+static int
+TimerHeapInsert(AG_Timer *_Nonnull to)
+{
+	if (agTimerHeapCount+1 > agTimerHeapMax) {
+		const int maxNew = (agTimerHeapMax > 0) ? agTimerHeapMax << 1 : 64;
+		AG_Timer **heapNew;
+
+		if ((heapNew = TryRealloc(agTimerHeap, maxNew*sizeof(AG_Timer *)))
+		    == NULL) {
+			return (-1);
+		}
+		agTimerHeap = heapNew;
+		agTimerHeapMax = maxNew;
+	}
+	agTimerHeap[agTimerHeapCount++] = to;
+	TimerHeapUp(agTimerHeapCount-1);
+	return (0);
+}
+
+/* Restore heap order after a change in the expiration time of a timer. */
+static void
+TimerHeapUpdate(AG_Timer *_Nonnull to)
+{
+	if (!TimerInHeap(to)) {
+		return;
+	}
+	TimerHeapUp(to->pvt.heapIdx);
+	TimerHeapDown(to->pvt.heapIdx);
+}
+
+static void
+TimerHeapRemove(AG_Timer *_Nonnull to)
+{
+	AG_Timer *toLast;
+	int i;
+
+	if (!TimerInHeap(to)) {
+		return;
+	}
+	i = to->pvt.heapIdx;
+	to->pvt.heapIdx = -1;
+	toLast = agTimerHeap[--agTimerHeapCount];
+	if (i < agTimerHeapCount) {
+		agTimerHeap[i] = toLast;
+		toLast->pvt.heapIdx = i;
+		TimerHeapUpdate(toLast);
+	}
+}
+
 void
 AG_InitTimers(void)
 {
@@ -49,6 +165,10 @@ void
 AG_DestroyTimers(void)
 {
 	AG_ObjectDestroy(&agTimerMgr);
+	Free(agTimerHeap);
+	agTimerHeap = NULL;
+	agTimerHeapCount = 0;
+	agTimerHeapMax = 0;
 	AG_MutexDestroy(&agTimerLock);
 }
 
@@ -63,7 +183,7 @@ AG_AddTimerAuto(void *p, Uint32 ival, AG_TimerFn fn, const char *fmt, ...)
 	AG_Timer *to;
 	AG_Event *ev;
 
-	if ((to = TryMalloc(sizeof(AG_Timer))) == NULL) {
+	if ((to = AG_ObjectTrySubAlloc(ob, &agTimerPool)) == NULL) {
 		return (NULL);
 	}
 	AG_InitTimer(to, "auto", AG_TIMER_AUTO_FREE);
@@ -84,7 +204,7 @@ AG_AddTimerAuto(void *p, Uint32 ival, AG_TimerFn fn, const char *fmt, ...)
 	return (to);
 fail:
 	AG_UnlockTimers(ob);
-	free(to);
+	AG_ObjectSubFree(ob, &agTimerPool, to);
 	return (NULL);
 }
 
@@ -102,52 +222,34 @@ AG_AddTimer(void *p, AG_Timer *to, Uint32 ival, AG_TimerFn fn,
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? OBJECT(p) : &agTimerMgr;
-	AG_Timer *toOther;
 	int newTimer = 0;
 	AG_Event *ev;
 	
 	AG_LockTimers(ob);
 
-	if (src->caps[AG_SINK_TIMER]) {		/* Unordered list */
-		if (to->obj == NULL) {
-			if (TAILQ_EMPTY(&ob->timers)) {
-				TAILQ_INSERT_TAIL(&agTimerObjQ, ob, tobjs);
-			}
-			TAILQ_INSERT_TAIL(&ob->timers, to, pvt.timers);
-			newTimer = 1;
-			to->obj = ob;
-			to->tSched = 0;
-		} else if (to->obj != ob) {
-			AG_FatalError("to->obj != ob");
-		}
-	} else {				/* Ordered timing wheel */
-		if (to->obj == NULL) {
-			newTimer = 1;
-			to->obj = ob;
-		} else if (to->obj != ob) {
-			AG_FatalError("to->obj != ob");
-		}
+	if (to->obj == NULL) {
 		if (TAILQ_EMPTY(&ob->timers)) {
 			TAILQ_INSERT_TAIL(&agTimerObjQ, ob, tobjs);
 		}
+		TAILQ_INSERT_TAIL(&ob->timers, to, pvt.timers);
+		newTimer = 1;
+		to->obj = ob;
+	} else if (to->obj != ob) {
+		AG_FatalError("to->obj != ob");
+	}
+	if (src->caps[AG_SINK_TIMER]) {		/* Kernel-based timer */
+		if (newTimer)
+			to->tSched = 0;
+	} else {				/* Soft timer heap */
 		to->tSched = AG_GetTicks()+ival;
-reinsert:
-		TAILQ_FOREACH(toOther, &ob->timers, pvt.timers) {
-			if (toOther == to) {
-				newTimer = 0;
-				TAILQ_REMOVE(&ob->timers, to, pvt.timers);
-				goto reinsert;
-			}
-			if (to->tSched < toOther->tSched) {
-				TAILQ_INSERT_BEFORE(toOther, to, pvt.timers);
-				break;
-			}
-		}
-		if (toOther == TAILQ_END(&ob->timers)) {
-			TAILQ_INSERT_TAIL(&ob->timers, to, pvt.timers);
-		}
 		to->ival = ival;
 		to->id = 0;				/* Not needed */
+		if (newTimer) {
+			if (TimerHeapInsert(to) == -1)
+				goto fail;
+		} else {
+			TimerHeapUpdate(to);
+		}
 	}
 
 	to->fn = fn;
@@ -170,6 +272,7 @@ reinsert:
 	AG_UnlockTimers(ob);
 	return (0);
 fail:
+	TimerHeapRemove(to);
 	to->obj = NULL;
 	TAILQ_REMOVE(&ob->timers, to, pvt.timers);
 	if (TAILQ_EMPTY(&ob->timers)) { TAILQ_REMOVE(&agTimerObjQ, ob, tobjs); }
@@ -193,6 +296,7 @@ AG_InitTimer(AG_Timer *to, const char *name, Uint flags)
 	}
 	to->id = -1;
 	to->obj = NULL;
+	to->pvt.heapIdx = -1;
 	to->flags = flags;
 	to->ival = 0;
 	to->tSched = 0;
@@ -208,7 +312,6 @@ AG_ResetTimer(void *p, AG_Timer *to, Uint32 ival)
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? OBJECT(p) : &agTimerMgr;
-	AG_Timer *toOther;
 	int rv = 0;
 	
 	AG_LockTimers(ob);
@@ -217,17 +320,9 @@ AG_ResetTimer(void *p, AG_Timer *to, Uint32 ival)
 		rv = -1;
 		goto out;
 	}
-	if (!src->caps[AG_SINK_TIMER]) {	/* Ordered timing wheel */
+	if (!src->caps[AG_SINK_TIMER]) {	/* Soft timer heap */
 		to->tSched = AG_GetTicks()+ival;
-		TAILQ_REMOVE(&ob->timers, to, pvt.timers);
-		TAILQ_FOREACH(toOther, &ob->timers, pvt.timers) {
-			if (to->tSched < toOther->tSched) {
-				TAILQ_INSERT_BEFORE(toOther, to, pvt.timers);
-				break;
-			}
-		}
-		if (toOther == TAILQ_END(&ob->timers))
-			TAILQ_INSERT_TAIL(&ob->timers, to, pvt.timers);
+		TimerHeapUpdate(to);
 	}
 	to->ival = ival;
 out:
@@ -241,20 +336,16 @@ AG_DelTimer(void *p, AG_Timer *to)
 {
 	AG_EventSource *src = AG_GetEventSource();
 	AG_Object *ob = (p != NULL) ? OBJECT(p) : &agTimerMgr;
-	AG_Timer *toOther;
 
 	AG_LockTimers(ob);
 	
-	TAILQ_FOREACH(toOther, &ob->timers, pvt.timers) {
-		if (toOther == to)
-			break;
-	}
-	if (toOther == NULL) 		/* Timer is not active */
+	if (to->obj != ob) 		/* Timer is not active */
 		goto out;
 
 	if (src->delTimerFn != NULL) {
 		src->delTimerFn(to);
 	}
+	TimerHeapRemove(to);
 	to->id = -1;
 	to->obj = NULL;
 
@@ -263,7 +354,7 @@ AG_DelTimer(void *p, AG_Timer *to)
 		TAILQ_REMOVE(&agTimerObjQ, ob, tobjs);
 
 	if (to->flags & AG_TIMER_AUTO_FREE)
-		free(to);
+		AG_ObjectSubFree(ob, &agTimerPool, to);
 out:
 	AG_UnlockTimers(ob);
 }
@@ -294,13 +385,8 @@ int
 AG_TimerIsRunning(void *p, AG_Timer *to)
 {
 	AG_Object *ob = (p != NULL) ? OBJECT(p) : &agTimerMgr;
-	AG_Timer *toRunning;
 
-	TAILQ_FOREACH(toRunning, &ob->timers, pvt.timers) {
-		if (toRunning == to)
-			break;
-	}
-	return (toRunning != NULL);
+	return (to->obj == ob);
 }
 
 /* Invoke a timer callback routine artificially. */
@@ -326,36 +412,45 @@ AG_ExecTimer(AG_Timer *to)
 void
 AG_ProcessTimeouts(Uint32 t)
 {
-	AG_Timer *to, *toNext;
-	AG_Object *ob, *obNext;
+	AG_Timer *to;
+	AG_Object *ob;
 	Uint32 rv;
 
 	AG_LockTiming();
-
-	for (ob = TAILQ_FIRST(&agTimerObjQ);
-	     ob != TAILQ_END(&agTimerObjQ);
-	     ob = obNext) {
-		obNext = TAILQ_NEXT(ob, tobjs);
+	while (agTimerHeapCount > 0) {
+		to = agTimerHeap[0];
+		if ((int)(to->tSched - t) > 0) {
+			break;
+		}
+		ob = to->obj;
 		AG_ObjectLock(ob);
-rescan:
-		for (to = TAILQ_FIRST(&ob->timers);
-		     to != TAILQ_END(&ob->timers);
-		     to = toNext) {
-			toNext = TAILQ_NEXT(to, pvt.timers);
-
-			if ((int)(to->tSched - t) > 0) {
-				continue;
-			}
-			rv = to->fn(to, &to->fnEvent);
-			if (rv > 0) {				/* Restart */
-				(void)AG_ResetTimer(ob, to, rv);
-				goto rescan;
-			} else {				/* Cancel */
-				AG_DelTimer(ob, to);
-			}
+		AG_TRACE_TIMER_BEGIN(to);
+		rv = to->fn(to, &to->fnEvent);
+		AG_TRACE_END();
+		if (rv > 0) {				/* Restart */
+			(void)AG_ResetTimer(ob, to, rv);
+		} else {				/* Cancel */
+			AG_DelTimer(ob, to);
 		}
 		AG_ObjectUnlock(ob);
 	}
 	AG_UnlockTiming();
 }
+
+/*
+ * Return the number of ticks (relative to t) until the soonest soft timer
+ * expires, 0 if a timer is already due, or 0xfffffffe if there are no timers.
+ * The caller should use AG_LockTiming().
+ */
+Uint32
+AG_GetNextTimeout(Uint32 t)
+{
+	int dt;
+
+	if (agTimerHeapCount == 0) {
+		return (0xfffffffe);
+	}
+	dt = (int)(agTimerHeap[0]->tSched - t);
+	return (dt > 0) ? (Uint32)dt : 0;
+}
 #endif /* AG_TIMERS */
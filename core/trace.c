@@ -0,0 +1,513 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Tracing spans and counters. Every thread records its events into its
+ * own ring buffer (without locking), timestamped with the TSC where it is
+ * available or a monotonic clock otherwise. AG_TraceDump() exports the
+ * buffers in the Chrome trace event format (JSON), which can be loaded
+ * into chrome://tracing or Perfetto.
+ */
+
+#include <agar/core/core.h>
+
+#if AG_MODEL != AG_SMALL && defined(AG_HAVE_64BIT)
+
+#include <agar/config/have_clock_gettime.h>
+
+#if defined(_WIN32) && !defined(_XBOX)
+# undef SLIST_ENTRY
+# include <windows.h>
+#elif defined(HAVE_CLOCK_GETTIME)
+# include <time.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+# define TRACE_HAVE_RDTSC
+#endif
+
+/* Per-thread event buffer. */
+typedef struct ag_trace_buffer {
+	AG_TraceEvent *_Nonnull ev;		/* Ring buffer of events */
+	Uint mask;				/* Ring buffer size - 1 */
+	Uint tid;				/* Thread number (for export) */
+	AG_Size n;				/* Events recorded */
+	int depth;				/* Open spans */
+	Uint flags;
+#define TRACE_BUFFER_EXITED 0x01		/* Thread has exited */
+	Uint epoch;				/* Epoch of open spans */
+	Uint32 _pad;
+	AG_Size stack[AG_TRACE_DEPTH_MAX];	/* Open spans (by sequence) */
+	struct ag_trace_buffer *_Nullable next;
+} AG_TraceBuffer;
+
+int agTraceEnabled = 0;				/* Tracing is enabled */
+
+static AG_TraceBuffer *_Nullable agTraceBuffers = NULL; /* All threads */
+static Uint   agTraceBufferSize = AG_TRACE_BUFFER_DEFAULT;
+static Uint   agTraceNextTid = 1;
+static int    agTraceTSC = 0;			/* Timestamps are TSC ticks */
+static int    agTraceInited = 0;
+static Uint64 agTraceTicks0 = 0;		/* Clock at AG_TraceEnable() */
+static Uint64 agTraceNsec0 = 0;
+static Uint   agTraceEpoch = 0;			/* Incremented on enable/disable */
+static Uint64 agTraceTicksOff = 0;		/* Clock at AG_TraceDisable() */
+#ifdef AG_THREADS
+static AG_Mutex     agTraceLock = AG_MUTEX_INITIALIZER;
+static AG_ThreadKey agTraceKey;
+#else
+static AG_TraceBuffer *_Nullable agTraceBuffer = NULL;
+#endif
+
+/* Return a monotonic time in nanoseconds. */
+static Uint64
+TraceNanoseconds(void)
+{
+#if defined(_WIN32) && !defined(_XBOX)
+	LARGE_INTEGER freq, count;
+
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (Uint64)((double)count.QuadPart * 1e9 / (double)freq.QuadPart);
+#elif defined(HAVE_CLOCK_GETTIME)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (Uint64)ts.tv_sec*1000000000ULL + (Uint64)ts.tv_nsec;
+#else
+	return (Uint64)AG_GetTicks() * 1000000ULL;
+#endif
+}
+
+/* Return the current time in trace clock ticks. */
+static __inline__ Uint64
+TraceTicks(void)
+{
+#ifdef TRACE_HAVE_RDTSC
+	if (agTraceTSC) {
+		Uint32 lo, hi;
+
+		__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+		return ((Uint64)hi << 32) | lo;
+	}
+#endif
+	return TraceNanoseconds();
+}
+
+#ifdef AG_THREADS
+static void
+TraceBufferExited(void *_Nullable p)
+{
+	AG_TraceBuffer *buf = p;
+
+	AG_MutexLock(&agTraceLock);
+	buf->flags |= TRACE_BUFFER_EXITED;
+	AG_MutexUnlock(&agTraceLock);
+}
+#endif
+
+/* Return the calling thread's buffer (allocating it on first use). */
+static AG_TraceBuffer *_Nullable
+GetTraceBuffer(void)
+{
+	AG_TraceBuffer *buf;
+	Uint size;
+
+#ifdef AG_THREADS
+	if ((buf = AG_ThreadKeyGet(agTraceKey)) != NULL)
+		return (buf);
+#else
+	if ((buf = agTraceBuffer) != NULL)
+		return (buf);
+#endif
+	if ((buf = TryMalloc(sizeof(AG_TraceBuffer))) == NULL) {
+		return (NULL);
+	}
+	size = agTraceBufferSize;
+	if ((buf->ev = TryMalloc(size*sizeof(AG_TraceEvent))) == NULL) {
+		free(buf);
+		return (NULL);
+	}
+	buf->mask = size - 1;
+	buf->n = 0;
+	buf->depth = 0;
+	buf->flags = 0;
+	buf->epoch = agTraceEpoch;
+
+	AG_MutexLock(&agTraceLock);
+	buf->tid = agTraceNextTid++;
+	buf->next = agTraceBuffers;
+	agTraceBuffers = buf;
+	AG_MutexUnlock(&agTraceLock);
+#ifdef AG_THREADS
+	AG_ThreadKeySet(agTraceKey, buf);
+#else
+	agTraceBuffer = buf;
+#endif
+	return (buf);
+}
+
+/*
+ * Start recording events into per-thread ring buffers of nEvents events
+ * (or AG_TRACE_BUFFER_DEFAULT if 0). The size applies to buffers of
+ * threads which have not yet recorded any event.
+ */
+void
+AG_TraceEnable(Uint nEvents)
+{
+	Uint size;
+
+	if (nEvents == 0) {
+		nEvents = AG_TRACE_BUFFER_DEFAULT;
+	}
+	for (size = 16; size < nEvents && size < 0x40000000; size <<= 1)
+		;;
+
+	AG_MutexLock(&agTraceLock);
+	if (!agTraceInited) {
+#ifdef AG_THREADS
+		if (AG_ThreadKeyTryCreate(&agTraceKey, TraceBufferExited) == -1) {
+			AG_MutexUnlock(&agTraceLock);
+			return;
+		}
+#endif
+#ifdef TRACE_HAVE_RDTSC
+		agTraceTSC = (agCPU.ext & AG_EXT_TSC) ? 1 : 0;
+#endif
+		agTraceNsec0 = TraceNanoseconds();
+		agTraceTicks0 = TraceTicks();
+		agTraceInited = 1;
+	}
+	agTraceBufferSize = size;
+	if (!agTraceEnabled) {
+		agTraceEpoch++;
+		agTraceEnabled = 1;
+	}
+	AG_MutexUnlock(&agTraceLock);
+}
+
+/*
+ * Stop recording events (the buffers are preserved). Spans left open are
+ * closed (as ending now) by their thread on its next AG_TraceBegin() or
+ * AG_TraceEnd() call, so that an AG_TRACE_END() skipped while tracing is
+ * disabled cannot unbalance the span stack.
+ */
+void
+AG_TraceDisable(void)
+{
+	AG_MutexLock(&agTraceLock);
+	if (agTraceEnabled) {
+		agTraceTicksOff = TraceTicks();
+		agTraceEpoch++;
+		agTraceEnabled = 0;
+	}
+	AG_MutexUnlock(&agTraceLock);
+}
+
+/*
+ * If tracing was enabled or disabled since the calling thread's spans
+ * were opened, close them as of the time tracing was disabled. Their
+ * AG_TraceEnd() calls may have been skipped, or may be unmatched (if the
+ * corresponding AG_TraceBegin() was skipped).
+ */
+static void
+TraceNewEpoch(AG_TraceBuffer *_Nonnull buf)
+{
+	AG_Size seq;
+	AG_TraceEvent *ev;
+	int i;
+
+	for (i = MIN(buf->depth, AG_TRACE_DEPTH_MAX) - 1; i >= 0; i--) {
+		seq = buf->stack[i];
+		if (buf->n - seq > (AG_Size)buf->mask) {
+			continue;				/* Overwritten */
+		}
+		ev = &buf->ev[seq & buf->mask];
+		ev->dur = (agTraceTicksOff > ev->ts) ?
+		          (agTraceTicksOff - ev->ts) : 0;
+	}
+	buf->depth = 0;
+	buf->epoch = agTraceEpoch;
+}
+
+/*
+ * Discard all recorded events, and release the buffers of threads which
+ * have exited. Tracing should be disabled.
+ */
+void
+AG_TraceClear(void)
+{
+	AG_TraceBuffer *buf, *bufNext, **pPrev;
+
+	AG_MutexLock(&agTraceLock);
+	for (pPrev = &agTraceBuffers, buf = agTraceBuffers;
+	     buf != NULL;
+	     buf = bufNext) {
+		bufNext = buf->next;
+		if (buf->flags & TRACE_BUFFER_EXITED) {
+			*pPrev = bufNext;
+			free(buf->ev);
+			free(buf);
+		} else {
+			buf->n = 0;
+			buf->depth = 0;
+			pPrev = &buf->next;
+		}
+	}
+	AG_MutexUnlock(&agTraceLock);
+}
+
+/* Release all resources (called by AG_Destroy()). */
+void
+AG_TraceDestroy(void)
+{
+	AG_TraceBuffer *buf, *bufNext;
+
+	agTraceEnabled = 0;
+
+	AG_MutexLock(&agTraceLock);
+	for (buf = agTraceBuffers; buf != NULL; buf = bufNext) {
+		bufNext = buf->next;
+		free(buf->ev);
+		free(buf);
+	}
+	agTraceBuffers = NULL;
+#ifdef AG_THREADS
+	if (agTraceInited) {
+		AG_ThreadKeySet(agTraceKey, NULL);
+		AG_ThreadKeyDelete(agTraceKey);
+	}
+#else
+	agTraceBuffer = NULL;
+#endif
+	agTraceInited = 0;
+	AG_MutexUnlock(&agTraceLock);
+}
+
+/*
+ * Open a span named name (copied), optionally associated with an object.
+ * Spans must be closed by AG_TraceEnd() in the same thread, in LIFO order.
+ */
+void
+AG_TraceBegin(const char *name, const void *p)
+{
+	const AG_Object *obj = p;
+	AG_TraceBuffer *buf;
+	AG_TraceEvent *ev;
+
+	if (!agTraceEnabled || (buf = GetTraceBuffer()) == NULL)
+		return;
+
+	if (buf->epoch != agTraceEpoch) {
+		TraceNewEpoch(buf);
+	}
+	if (buf->depth < AG_TRACE_DEPTH_MAX) {
+		buf->stack[buf->depth] = buf->n;
+	}
+	buf->depth++;
+
+	ev = &buf->ev[(buf->n++) & buf->mask];
+	ev->type = AG_TRACE_EVENT_SPAN;
+	Strlcpy(ev->name, name, sizeof(ev->name));
+	if (obj != NULL) {
+		Strlcpy(ev->obj, obj->name, sizeof(ev->obj));
+		ev->cls = obj->cls->name;
+	} else {
+		ev->obj[0] = '\0';
+		ev->cls = NULL;
+	}
+	ev->dur = AG_TRACE_UNFINISHED;
+	ev->ts = TraceTicks();
+}
+
+/* Close the most recently opened span of the calling thread. */
+void
+AG_TraceEnd(void)
+{
+	const Uint64 t = TraceTicks();
+	AG_TraceBuffer *buf;
+	AG_TraceEvent *ev;
+	AG_Size seq;
+
+	if (!agTraceInited || (buf = GetTraceBuffer()) == NULL)
+		return;
+
+	if (buf->epoch != agTraceEpoch) {
+		TraceNewEpoch(buf);
+		return;				/* Span opened in another epoch */
+	}
+	if (buf->depth == 0)
+		return;
+
+	if (--buf->depth >= AG_TRACE_DEPTH_MAX) {
+		return;
+	}
+	seq = buf->stack[buf->depth];
+	if (buf->n - seq > (AG_Size)buf->mask) {
+		return;					/* Overwritten */
+	}
+	ev = &buf->ev[seq & buf->mask];
+	ev->dur = t - ev->ts;
+}
+
+/* Record the value of a named counter. */
+void
+AG_TraceCounter(const char *name, Sint64 value)
+{
+	AG_TraceBuffer *buf;
+	AG_TraceEvent *ev;
+
+	if (!agTraceEnabled || (buf = GetTraceBuffer()) == NULL)
+		return;
+
+	ev = &buf->ev[(buf->n++) & buf->mask];
+	ev->type = AG_TRACE_EVENT_COUNTER;
+	Strlcpy(ev->name, name, sizeof(ev->name));
+	ev->obj[0] = '\0';
+	ev->cls = NULL;
+	ev->dur = (Uint64)value;
+	ev->ts = TraceTicks();
+}
+
+/* Write a string as a JSON string literal. */
+static void
+TraceWriteString(FILE *_Nonnull f, const char *_Nonnull s)
+{
+	const char *c;
+
+	fputc('"', f);
+	for (c = s; *c != '\0'; c++) {
+		switch (*c) {
+		case '"':
+			fputs("\\\"", f);
+			break;
+		case '\\':
+			fputs("\\\\", f);
+			break;
+		default:
+			if ((Uint8)*c < 0x20) {
+				fprintf(f, "\\u%04x", (Uint)(Uint8)*c);
+			} else {
+				fputc(*c, f);
+			}
+			break;
+		}
+	}
+	fputc('"', f);
+}
+
+/*
+ * Export the recorded events to a file in Chrome trace event format.
+ * Spans still open are reported as ending at the time of the dump.
+ * Return 0 on success or -1 on failure.
+ */
+int
+AG_TraceDump(const char *path)
+{
+	const AG_TraceBuffer *buf;
+	double ticksPerUsec = 1000.0;			/* Nanoseconds */
+	Uint64 tNow, nsNow;
+	FILE *f;
+	int first = 1;
+
+	if ((f = fopen(path, "w")) == NULL) {
+		AG_SetError(_("Unable to open %s (%s)"), path,
+		    AG_Strerror(errno));
+		return (-1);
+	}
+
+	AG_MutexLock(&agTraceLock);
+
+	nsNow = TraceNanoseconds();
+	tNow = TraceTicks();
+	if (agTraceTSC) {
+		/* Calibrate the TSC against the monotonic clock. */
+		while (nsNow - agTraceNsec0 < 10000000ULL) {
+			nsNow = TraceNanoseconds();
+			tNow = TraceTicks();
+		}
+		ticksPerUsec = (double)(tNow - agTraceTicks0) * 1000.0 /
+		               (double)(nsNow - agTraceNsec0);
+	}
+
+	fputs("{\"traceEvents\":[\n", f);
+	for (buf = agTraceBuffers; buf != NULL; buf = buf->next) {
+		AG_Size i = (buf->n > (AG_Size)buf->mask) ?
+		            buf->n - (AG_Size)buf->mask - 1 : 0;
+
+		fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\","
+		           "\"pid\":1,\"tid\":%u,\"args\":{\"name\":"
+			   "\"Thread %u\"}}",
+		    first ? "" : ",\n", buf->tid, buf->tid);
+		first = 0;
+
+		for (; i < buf->n; i++) {
+			const AG_TraceEvent *ev = &buf->ev[i & buf->mask];
+			const double ts = (double)(Sint64)(ev->ts -
+			                  agTraceTicks0) / ticksPerUsec;
+
+			fputs(",\n{\"name\":", f);
+			TraceWriteString(f, ev->name);
+			if (ev->type == AG_TRACE_EVENT_COUNTER) {
+				fprintf(f, ",\"ph\":\"C\",\"ts\":%.3f,"
+				           "\"pid\":1,\"tid\":%u,"
+					   "\"args\":{\"value\":%lld}}",
+				    ts, buf->tid, (long long)(Sint64)ev->dur);
+				continue;
+			}
+			fprintf(f, ",\"cat\":");
+			TraceWriteString(f, (ev->cls != NULL) ? ev->cls :
+			                                        "agar");
+			fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+			           "\"pid\":1,\"tid\":%u",
+			    ts,
+			    (double)((ev->dur != AG_TRACE_UNFINISHED) ?
+			             ev->dur : tNow - ev->ts) / ticksPerUsec,
+			    buf->tid);
+			if (ev->obj[0] != '\0') {
+				fputs(",\"args\":{\"object\":", f);
+				TraceWriteString(f, ev->obj);
+				fputc('}', f);
+			}
+			fputc('}', f);
+		}
+	}
+	fputs("\n],\"displayTimeUnit\":\"ms\"}\n", f);
+
+	AG_MutexUnlock(&agTraceLock);
+
+	if (fclose(f) != 0) {
+		AG_SetError(_("Unable to write %s (%s)"), path,
+		    AG_Strerror(errno));
+		return (-1);
+	}
+	return (0);
+}
+
+#endif /* AG_MODEL != AG_SMALL and AG_HAVE_64BIT */
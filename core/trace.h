@@ -0,0 +1,72 @@
+/*	Public domain	*/
+/*
+ * Tracing spans and counters (exportable to Chrome trace format).
+ */
+
+#ifndef _AGAR_CORE_TRACE_H_
+#define _AGAR_CORE_TRACE_H_
+
+#include <agar/core/begin.h>
+
+#if AG_MODEL != AG_SMALL && defined(AG_HAVE_64BIT)
+
+#ifndef AG_TRACE_NAME_MAX
+#define AG_TRACE_NAME_MAX 32		/* Span name and object name */
+#endif
+#ifndef AG_TRACE_DEPTH_MAX
+#define AG_TRACE_DEPTH_MAX 64		/* Maximum nesting of spans */
+#endif
+#ifndef AG_TRACE_BUFFER_DEFAULT
+#define AG_TRACE_BUFFER_DEFAULT 16384	/* Default events per thread */
+#endif
+
+/* Trace event. */
+typedef struct ag_trace_event {
+	Uint64 ts;				/* Start time (clock ticks) */
+	Uint64 dur;				/* Duration (or counter value) */
+	const char *_Nullable cls;		/* Object class (or NULL) */
+	Uint8 type;
+#define AG_TRACE_EVENT_SPAN    0		/* Span (AG_TraceBegin()) */
+#define AG_TRACE_EVENT_COUNTER 1		/* Counter (AG_TraceCounter()) */
+	Uint8 _pad[7];
+	char name[AG_TRACE_NAME_MAX];		/* Span or counter name */
+	char obj[AG_TRACE_NAME_MAX];		/* Object name (or "") */
+} AG_TraceEvent;
+
+#define AG_TRACE_UNFINISHED 0xffffffffffffffffULL /* dur of open span */
+
+__BEGIN_DECLS
+extern int agTraceEnabled;
+
+void AG_TraceEnable(Uint);
+void AG_TraceDisable(void);
+void AG_TraceClear(void);
+int  AG_TraceDump(const char *_Nonnull);
+void AG_TraceDestroy(void);
+
+void AG_TraceBegin(const char *_Nonnull, const void *_Nullable);
+void AG_TraceEnd(void);
+void AG_TraceCounter(const char *_Nonnull, Sint64);
+__END_DECLS
+
+/* Instrumentation macros (no function call while tracing is disabled). */
+#define AG_TRACE_BEGIN(name, obj) \
+	do { if (agTraceEnabled) AG_TraceBegin((name), (obj)); } while (0)
+#define AG_TRACE_END() \
+	do { if (agTraceEnabled) AG_TraceEnd(); } while (0)
+#define AG_TRACE_COUNTER(name, val) \
+	do { if (agTraceEnabled) AG_TraceCounter((name), (val)); } while (0)
+#define AG_TRACE_TIMER_BEGIN(to) \
+	AG_TRACE_BEGIN(((to)->name[0] != '\0') ? (to)->name : "timer", (to)->obj)
+
+#else /* AG_SMALL or !AG_HAVE_64BIT */
+
+#define AG_TRACE_BEGIN(name, obj)
+#define AG_TRACE_END()
+#define AG_TRACE_COUNTER(name, val)
+#define AG_TRACE_TIMER_BEGIN(to)
+
+#endif /* !AG_SMALL and AG_HAVE_64BIT */
+
+#include <agar/core/close.h>
+#endif /* _AGAR_CORE_TRACE_H_ */
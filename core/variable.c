@@ -213,6 +213,220 @@ AG_CompareVariables(const AG_Variable *a, const AG_Variable *b)
 	}
 }
 
+/*
+ * Objects with at least AG_VARIABLE_INDEX_MIN variables maintain an
+ * open-addressing (linear probing) index of their variables by name.
+ */
+#ifndef AG_VARIABLE_INDEX_MIN
+#define AG_VARIABLE_INDEX_MIN 8
+#endif
+
+/* Return the slot for the named variable (or the empty slot ending the probe). */
+static __inline__ AG_VariableIndexEnt *_Nonnull
+VarIndexProbe(const AG_VariableIndex *_Nonnull idx, const char *_Nonnull name,
+    Uint32 h)
+{
+	const Uint mask = idx->size - 1;
+	AG_VariableIndexEnt *ents = idx->ents;
+	Uint i;
+
+	for (i = h & mask; ents[i].V != NULL; i = (i+1) & mask) {
+		if (ents[i].hash == h && strcmp(ents[i].V->name, name) == 0)
+			break;
+	}
+	return (&ents[i]);
+}
+
+/* Rebuild the index from the object's list of variables. */
+static void
+VarIndexRebuild(AG_Object *_Nonnull ob, Uint sizeNew)
+{
+	AG_VariableIndex *idx = &ob->varIndex;
+	AG_VariableIndexEnt *entsNew, *ent;
+	AG_Variable *V;
+	Uint32 h;
+
+	if ((entsNew = TryMalloc(sizeNew * sizeof(AG_VariableIndexEnt))) == NULL) {
+		Free(idx->ents);		/* Fall back to linear search */
+		idx->ents = NULL;
+		idx->size = 0;
+		return;
+	}
+	memset(entsNew, 0, sizeNew * sizeof(AG_VariableIndexEnt));
+	Free(idx->ents);
+	idx->ents = entsNew;
+	idx->size = sizeNew;
+
+	TAILQ_FOREACH(V, &ob->vars, vars) {
+		h = AG_HashString(V->name);
+		ent = VarIndexProbe(idx, V->name, h);
+		if (ent->V == NULL) {			/* First one wins */
+			ent->hash = h;
+			ent->V = V;
+		}
+	}
+}
+
+/*
+ * Look up an object variable by name. Return NULL if undefined.
+ * The object must be locked.
+ */
+AG_Variable *
+AG_LookupVariable(void *pObj, const char *name)
+{
+	AG_Object *obj = pObj;
+	AG_Variable *V;
+
+	if (obj->varIndex.ents != NULL) {
+		return VarIndexProbe(&obj->varIndex, name,
+		    AG_HashString(name))->V;
+	}
+	TAILQ_FOREACH(V, &obj->vars, vars) {
+		if (strcmp(V->name, name) == 0)
+			break;
+	}
+	return (V);
+}
+
+/*
+ * Attach a newly initialized variable to an object. The name should be
+ * unique. The object must be locked.
+ */
+void
+AG_InsertVariable(void *pObj, AG_Variable *V)
+{
+	AG_Object *obj = pObj;
+	AG_VariableIndex *idx = &obj->varIndex;
+	AG_VariableIndexEnt *ent;
+	Uint32 h;
+
+	TAILQ_INSERT_TAIL(&obj->vars, V, vars);
+	idx->nVars++;
+
+	if (idx->ents == NULL) {
+		if (idx->nVars >= AG_VARIABLE_INDEX_MIN) {
+			VarIndexRebuild(obj, AG_VARIABLE_INDEX_MIN << 2);
+		}
+		return;
+	}
+	if ((idx->nVars << 1) > idx->size) {			/* Load <= .5 */
+		VarIndexRebuild(obj, idx->size << 1);
+		return;
+	}
+	h = AG_HashString(V->name);
+	ent = VarIndexProbe(idx, V->name, h);
+	if (ent->V == NULL) {
+		ent->hash = h;
+		ent->V = V;
+	}
+}
+
+/*
+ * Detach a variable from an object (without freeing it). Invalidates any
+ * AG_VariableHandle referencing the object. The object must be locked.
+ */
+void
+AG_RemoveVariable(void *pObj, AG_Variable *V)
+{
+	AG_Object *obj = pObj;
+	AG_VariableIndex *idx = &obj->varIndex;
+	AG_VariableIndexEnt *ents = idx->ents;
+	Uint i, j, k, mask;
+
+	TAILQ_REMOVE(&obj->vars, V, vars);
+	idx->nVars--;
+	idx->gen++;
+
+	if (ents == NULL) {
+		return;
+	}
+	i = (Uint)(VarIndexProbe(idx, V->name, AG_HashString(V->name)) - ents);
+	if (ents[i].V != V) {
+		return;
+	}
+
+	/* Backward-shift deletion. */
+	mask = idx->size - 1;
+	for (j = i; ; ) {
+		j = (j+1) & mask;
+		if (ents[j].V == NULL) {
+			break;
+		}
+		k = ents[j].hash & mask;
+		if ((i <= j) ? (i < k && k <= j) : (i < k || k <= j)) {
+			continue;
+		}
+		ents[i] = ents[j];
+		i = j;
+	}
+	ents[i].hash = 0;
+	ents[i].V = NULL;
+}
+
+/* Release a variable index (the variables themselves are not freed). */
+void
+AG_VariableIndexFree(AG_VariableIndex *idx)
+{
+	Free(idx->ents);
+	idx->ents = NULL;
+	idx->size = 0;
+	idx->nVars = 0;
+	idx->gen++;
+}
+
+/* Initialize a cached reference to the named variable. */
+void
+AG_InitVariableHandle(AG_VariableHandle *h, const char *name)
+{
+	h->name = name;
+	h->V = NULL;
+	h->gen = 0;
+}
+
+/*
+ * Return the variable referenced by a handle, looking it up again only if
+ * variables were removed from the object since it was last resolved.
+ * Returns NULL if the variable is undefined. The object must be locked.
+ */
+AG_Variable *
+AG_ResolveVariable(void *pObj, AG_VariableHandle *h)
+{
+	AG_Object *obj = pObj;
+
+	if (h->V == NULL || h->gen != obj->varIndex.gen) {
+		h->V = AG_LookupVariable(obj, h->name);
+		h->gen = obj->varIndex.gen;
+	}
+	return (h->V);
+}
+
+/*
+ * Variant of AG_GetVariable() which accepts a variable handle. The handle
+ * must only be used with one object.
+ */
+AG_Variable *
+AG_GetVariableCached(void *pObj, AG_VariableHandle *h, void **p)
+{
+	AG_Object *obj = pObj;
+	AG_Variable *V, *Vtgt;
+
+	AG_ObjectLock(obj);
+	if ((V = AG_ResolveVariable(obj, h)) == NULL) {
+		AG_FatalErrorV("E20", "No such variable");
+	}
+	AG_LockVariable(V);
+	if (V->type == AG_VARIABLE_P_VARIABLE) {
+		Vtgt = AG_AccessVariable(AGOBJECT(V->data.p), V->info.varName);
+		AG_UnlockVariable(V);
+		if ((V = Vtgt) == NULL)
+			AG_FatalErrorV("E20", "No such variable");
+	}
+	*p = (agVariableTypes[V->type].indirLvl > 0) ? V->data.p :
+	                                               (void *)&V->data;
+	AG_ObjectUnlock(obj);
+	return (V);
+}
+
 /*
  * Lookup a variable by name and return a generic pointer to its current value.
  * If the variable is a reference, the target is accessed.
@@ -308,13 +522,10 @@ AG_Unset(void *pObj, const char *name)
 #ifdef AG_DEBUG
 	Debug2(obj, "Unset \"" AGSI_YEL "%s" AGSI_RST "\"\n", name);
 #endif
-	TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0) {
-			TAILQ_REMOVE(&obj->vars, V, vars);
-			AG_FreeVariable(V);
-			free(V);
-			break;
-		}
+	if ((V = AG_LookupVariable(obj, name)) != NULL) {
+		AG_RemoveVariable(obj, V);
+		AG_FreeVariable(V);
+		AG_ObjectSubFree(obj, &agVariablePool, V);
 	}
 }
 
@@ -1340,14 +1551,10 @@ AG_SetString(void *pObj, const char *name, const char *s)
 	Debug2(obj, "Set \"" AGSI_YEL "%s" AGSI_RST "\" -> \""
 	    AGSI_BOLD "%s" AGSI_RST "\"\n", name, s);
 #endif
-	TAILQ_FOREACH(V, &obj->vars, vars) {
-		if (strcmp(V->name, name) == 0)
-			break;
-	}
-	if (V == NULL) {
-		V = Malloc(sizeof(AG_Variable));
+	if ((V = AG_LookupVariable(obj, name)) == NULL) {
+		V = AG_ObjectSubAlloc(obj, &agVariablePool);
 		AG_InitVariable(V, AG_VARIABLE_STRING, name);
-		TAILQ_INSERT_TAIL(&obj->vars, V, vars);
+		AG_InsertVariable(obj, V);
 
 		V->info.size = 0;				/* Allocated */
 		V->data.s = Strdup(s);
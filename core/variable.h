@@ -168,6 +168,32 @@ typedef struct ag_variable {
 	AG_TAILQ_ENTRY(ag_variable) vars;
 } AG_Variable;
 
+/* Per-object index of variables (by name). */
+typedef struct ag_variable_index_ent {
+	Uint32 hash;                          /* Hash of name */
+	Uint32 _pad;
+	AG_Variable *_Nullable V;             /* Variable (NULL = empty slot) */
+} AG_VariableIndexEnt;
+
+typedef struct ag_variable_index {
+	AG_VariableIndexEnt *_Nullable ents;  /* Slots (or NULL = no index) */
+	Uint size;                            /* Number of slots (2^n) */
+	Uint nVars;                           /* Total variables */
+	Uint gen;                             /* Incremented on removal */
+	Uint32 _pad;
+} AG_VariableIndex;
+
+/*
+ * Cached reference to a named variable of an object. The handle is
+ * invalidated whenever a variable is removed from the object.
+ */
+typedef struct ag_variable_handle {
+	const char *_Nonnull name;            /* Variable name */
+	AG_Variable *_Nullable V;             /* Resolved variable (or NULL) */
+	Uint gen;                             /* Object's index generation */
+	Uint32 _pad;
+} AG_VariableHandle;
+
 #define AG_VARIABLE_TYPE(V)      (agVariableTypes[(V)->type].typeTgt)
 #define AG_VARIABLE_TYPE_NAME(V) (agVariableTypes[(V)->type].name)
 
@@ -220,6 +246,21 @@ int  AG_CompareVariables(const AG_Variable *_Nonnull,
                         _Pure_Attribute;
 void AG_Unset(void *_Nonnull, const char *_Nonnull);
 
+AG_Variable *_Nullable AG_LookupVariable(void *_Nonnull, const char *_Nonnull)
+                                        _Pure_Attribute_If_Unthreaded;
+void                   AG_InsertVariable(void *_Nonnull, AG_Variable *_Nonnull);
+void                   AG_RemoveVariable(void *_Nonnull, AG_Variable *_Nonnull);
+void                   AG_VariableIndexFree(AG_VariableIndex *_Nonnull);
+
+void                   AG_InitVariableHandle(AG_VariableHandle *_Nonnull,
+                                             const char *_Nonnull);
+AG_Variable *_Nullable AG_ResolveVariable(void *_Nonnull,
+                                          AG_VariableHandle *_Nonnull);
+AG_Variable *_Nullable AG_GetVariableCached(void *_Nonnull,
+                                            AG_VariableHandle *_Nonnull,
+                                            void *_Nonnull *_Nonnull)
+                                           _Warn_Unused_Result;
+
 /*
  * UINT: Natural unsigned integer
  */
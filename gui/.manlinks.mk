@@ -115,6 +115,10 @@ MANLINKS+=AG_Driver.3:AG_ProcessEvent.3
 MANLINKS+=AG_Driver.3:AG_SDL_TranslateEvent.3
 MANLINKS+=AG_Driver.3:AG_WindowProcessQueued.3
 MANLINKS+=AG_Driver.3:AG_CustomEventLoop.3
+MANLINKS+=AG_DriverMemFB.3:AG_DriverMemFBGetSurface.3
+MANLINKS+=AG_DriverMemFB.3:AG_DriverMemFBGetDamage.3
+MANLINKS+=AG_DriverMemFB.3:AG_DriverMemFBClearDamage.3
+MANLINKS+=AG_DriverMemFB.3:AG_DriverMemFBExportPNG.3
 MANLINKS+=AG_Editable.3:AG_EditableNew.3
 MANLINKS+=AG_Editable.3:AG_EditableBindUTF8.3
 MANLINKS+=AG_Editable.3:AG_EditableBindASCII.3
@@ -556,6 +560,7 @@ MANLINKS+=AG_Surface.3:AG_SurfacePut32_At.3
 MANLINKS+=AG_Surface.3:AG_SurfacePut64_At.3
 MANLINKS+=AG_Surface.3:AG_SurfaceBlend.3
 MANLINKS+=AG_Surface.3:AG_SurfaceBlend_At.3
+MANLINKS+=AG_Surface.3:AG_SurfaceBlendRect.3
 MANLINKS+=AG_Surface.3:AG_SurfaceBlendRGB8.3
 MANLINKS+=AG_Surface.3:AG_SurfaceBlendRGB8_At.3
 MANLINKS+=AG_Surface.3:AG_SurfaceBlendRGB16.3
@@ -631,6 +636,10 @@ MANLINKS+=AG_Text.3:AG_TextRenderRTL.3
 MANLINKS+=AG_Text.3:AG_TextRenderCropped.3
 MANLINKS+=AG_Text.3:AG_TextRenderInternal.3
 MANLINKS+=AG_Text.3:AG_TextRenderGlyph.3
+MANLINKS+=AG_Text.3:AG_TextBlitGlyph.3
+MANLINKS+=AG_Text.3:AG_TextGlyphSurface.3
+MANLINKS+=AG_Text.3:AG_TextSetGlyphCacheBudget.3
+MANLINKS+=AG_Text.3:AG_TextClearGlyphCache.3
 MANLINKS+=AG_Text.3:AG_TextSize.3
 MANLINKS+=AG_Text.3:AG_TextSizeInternal.3
 MANLINKS+=AG_Text.3:AG_TextSizeMulti.3
@@ -69,7 +69,7 @@ AG_BoxNew(void *parent, enum ag_box_type type, Uint flags)
 {
 	AG_Box *box;
 
-	box = Malloc(sizeof(AG_Box));
+	box = AG_ObjectAlloc(&agBoxClass);
 	AG_ObjectInit(box, &agBoxClass);
 
 	box->type = type;
@@ -128,7 +128,7 @@ AG_ButtonNewS(void *parent, Uint flags, const char *label)
 {
 	AG_Button *bu;
 	
-	bu = Malloc(sizeof(AG_Button));
+	bu = AG_ObjectAlloc(&agButtonClass);
 	AG_ObjectInit(bu, &agButtonClass);
 
 	if (label != NULL) {
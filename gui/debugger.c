@@ -37,6 +37,8 @@
 #include <agar/gui/textbox.h>
 #include <agar/gui/tlist.h>
 #include <agar/gui/label.h>
+#include <agar/gui/progress_bar.h>
+#include <agar/gui/text_cache.h>
 #include <agar/gui/button.h>
 #include <agar/gui/numerical.h>
 #include <agar/gui/mspinbutton.h>
@@ -310,11 +312,30 @@ ExportSurfaceDlg(AG_Event *_Nonnull event)
 	AG_WindowShow(win);
 }
 
+/* Return the text cache used by a widget (or NULL). */
+static AG_TextCache *_Nullable
+GetTextCache(AG_Widget *_Nonnull wid)
+{
+	if (AG_WINDOW_ISA(wid)) {
+		return ((AG_Window *)wid)->tCache;
+	} else if (AG_LABEL_ISA(wid)) {
+		if (AGLABEL(wid)->type == AG_LABEL_POLLED &&
+		    wid->window != NULL) {
+			return (wid->window->tCache);	/* Shared */
+		}
+		return AGLABEL(wid)->tCache;
+	} else if (AG_PROGRESSBAR_ISA(wid)) {
+		return AGPROGRESSBAR(wid)->tCache;
+	}
+	return (NULL);
+}
+
 static void
 PollSurfaces(AG_Event *_Nonnull event)
 {
 	AG_Tlist *tl = AG_TLIST_SELF();
 	AG_Widget *wid = agDebuggerTgt;
+	AG_TextCache *tc;
 	AG_TlistItem *it;
 	Uint i;
 
@@ -325,6 +346,16 @@ PollSurfaces(AG_Event *_Nonnull event)
 
 	AG_ObjectLock(wid);
 	AG_TlistBegin(tl);
+	if ((tc = GetTextCache(wid)) != NULL) {
+		it = AG_TlistAdd(tl, NULL,
+		    "%sText cache: %u entries, %lu/%lu bytes, "
+		    "%lu hits, %lu misses, %lu evictions",
+		    (tc->flags & AG_TEXT_CACHE_SHARED) ? "Shared " : "",
+		    tc->curEnts, (Ulong)tc->size, (Ulong)tc->budget,
+		    (Ulong)tc->nHits, (Ulong)tc->nMisses,
+		    (Ulong)tc->nEvictions);
+		it->cat = "text-cache";
+	}
 	for (i = 0; i < wid->nSurfaces; i++) {
 		const AG_Surface *S = WSURFACE(wid,i);
 
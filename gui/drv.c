@@ -65,6 +65,7 @@ extern AG_DriverClass agDriverWGL;
 extern AG_DriverClass agDriverCocoa;
 #endif
 extern AG_DriverClass agDriverDUMMY;
+extern AG_DriverClass agDriverMemFB;
 
 AG_Object       agDrivers;			/* Drivers VFS */
 AG_DriverClass *agDriverOps = NULL;		/* Current driver class */
@@ -93,6 +94,7 @@ AG_DriverClass *agDriverList[] = {
 	&agDriverSDLFB,
 #endif
 	&agDriverDUMMY,
+	&agDriverMemFB,
 	NULL
 };
 
@@ -345,6 +347,7 @@ static void
 Init(void *_Nonnull obj)
 {
 	AG_Driver *drv = obj;
+	AG_GlyphCache *gc;
 	Uint i;
 
 	drv->id = 0;
@@ -364,9 +367,16 @@ Init(void *_Nonnull obj)
 	drv->mouse = NULL;
 	drv->joys = NULL;
 	drv->nJoys = 0;
-	drv->glyphCache = Malloc(AG_GLYPH_NBUCKETS*sizeof(AG_GlyphCache));
+	gc = drv->glyphCache = Malloc(sizeof(AG_GlyphCache));
+	gc->budget = AG_GLYPH_CACHE_BUDGET;
+	gc->size = 0;
+	gc->nPages = 0;
+	gc->nGlyphs = 0;
+	gc->nEvictions = 0;
+	TAILQ_INIT(&gc->pages);
+	gc->tint = NULL;
 	for (i = 0; i < AG_GLYPH_NBUCKETS; i++) {
-		SLIST_INIT(&drv->glyphCache[i].glyphs);
+		LIST_INIT(&gc->buckets[i]);
 	}
 	drv->gl = NULL;
 	drv->activeCursor = NULL;
@@ -96,9 +96,9 @@ DUMMY_DestroyGlobals(void)
 	if (nDrivers > 0)
 		return;
 #ifdef AG_EVENT_LOOP
-	AG_DelEventSink(dummyEventSink);         dummyEventSink = NULL;
-	AG_DelEventSpinner(dummyEventSpinner);   dummyEventSpinner = NULL;
-	AG_DelEventEpilogue(dummyEventEpilogue); dummyEventEpilogue = NULL;
+	if (dummyEventSink)     { AG_DelEventSink(dummyEventSink);         dummyEventSink = NULL; }
+	if (dummyEventSpinner)  { AG_DelEventSpinner(dummyEventSpinner);   dummyEventSpinner = NULL; }
+	if (dummyEventEpilogue) { AG_DelEventEpilogue(dummyEventEpilogue); dummyEventEpilogue = NULL; }
 #endif
 }
 
@@ -638,16 +638,16 @@ DUMMY_UpdateGlyph(void *_Nonnull obj, AG_Glyph *_Nonnull gl)
 	Debug(obj, "UpdateGlyph(%s, [%x:%x:%x:%x], '%c', %p)\n",
 	    OBJECT(gl->font)->name,
 	    gl->color.r, gl->color.g, gl->color.b, gl->color.a,
-	    (char)gl->ch, gl->su);
+	    (char)gl->ch, gl->page);
 }
 
 static void
 DUMMY_DrawGlyph(void *_Nonnull obj, const AG_Glyph *_Nonnull gl, int x, int y)
 {
-	Debug(obj, "DrawGlyph(%s, [%x:%x:%x:%x], '%c', [%dx%d %d-bpp], %d,%d)\n",
+	Debug(obj, "DrawGlyph(%s, [%x:%x:%x:%x], '%c', [%d,%d %dx%d], %d,%d)\n",
 	    OBJECT(gl->font)->name,
 	    gl->color.r, gl->color.g, gl->color.b, gl->color.a,
-	    (char)gl->ch, gl->su->w, gl->su->h, gl->su->format.BitsPerPixel,
+	    (char)gl->ch, gl->rs.x, gl->rs.y, gl->rs.w, gl->rs.h,
 	    x,y);
 }
 
@@ -175,8 +175,11 @@ AG_GL_DestroyContext(void *obj)
 {
 	AG_Driver *drv = obj;
 	AG_GL_Context *gl = drv->gl;
+	AG_GlyphPage *page;
 	AG_Glyph *glyph;
+#ifdef DEBUG_GL
 	int i;
+#endif
 
 #if defined(AG_DEBUG) && defined(GL_DEBUG_OUTPUT)
 	if (agGLdebugOutput)
@@ -187,17 +190,18 @@ AG_GL_DestroyContext(void *obj)
 	Debug(drv, "GL Context Destroy\n");
 #endif
 
-	/* Invalidate any cached glyph renderings. */
-	for (i = 0; i < AG_GLYPH_NBUCKETS; i++) {
-		SLIST_FOREACH(glyph, &drv->glyphCache[i].glyphs, glyphs) {
-			if (glyph->texture != 0) {
+	/* Invalidate the textures of the glyph atlas pages. */
+	TAILQ_FOREACH(page, &drv->glyphCache->pages, pages) {
+		if (page->texture == 0) {
+			continue;
+		}
 #ifdef DEBUG_GL
-				Debug(drv, "GL delete glyph #%d\n", glyph->texture);
+		Debug(drv, "GL delete glyph page #%d\n", page->texture);
 #endif
-				glDeleteTextures(1, (GLuint *)&glyph->texture);
-				glyph->texture = 0;
-			}
-		}
+		glDeleteTextures(1, (GLuint *)&page->texture);
+		page->texture = 0;
+		SLIST_FOREACH(glyph, &page->glyphs, pglyphs)
+			glyph->texture = 0;
 	}
 	
 	if (gl->nTextureGC > 0) {
@@ -1448,36 +1452,84 @@ AG_GL_DrawRectBlended(void *obj, const AG_Rect *r, const AG_Color *c,
 		AGDRIVER_CLASS(obj)->popBlendingMode(obj);
 }
 
-/* Prepare for rendering an AG_Text(3) glyph. */
+/*
+ * Prepare for rendering an AG_Text(3) glyph. If the texture of its atlas
+ * page already exists, update only the area of the glyph (and its padding).
+ */
 void
-AG_GL_UpdateGlyph(void *obj, AG_Glyph *gl)
+AG_GL_UpdateGlyph(void *obj, AG_Glyph *G)
 {
-	AG_Driver *drv = (AG_Driver *)obj;
-
-/*	AG_OBJECT_ISA(drv, "AG_Driver:*"); */
-
-	AGDRIVER_CLASS(drv)->uploadTexture(drv,
-	    &gl->texture, gl->su, &gl->texcoords);
+	AG_GlyphPage *page = G->page;
+	const AG_Surface *S = page->S;
+	const AG_Rect *r = &G->rs;
+
+	if (page->texture != 0 && r->w > 0 && r->h > 0) {
+		const int Bpp = S->format.BytesPerPixel;
+
+		glBindTexture(GL_TEXTURE_2D, (GLuint)page->texture);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, S->pitch / Bpp);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, r->x, r->y, r->w + 1, r->h + 1,
+		    GL_RGBA, AG_GL_SurfaceType(S),
+		    S->pixels + r->y*S->pitch + r->x*Bpp);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+	G->texture = page->texture;
+	G->texcoords.x = (float)r->x / (float)S->w;
+	G->texcoords.y = (float)r->y / (float)S->h;
+	G->texcoords.w = (float)(r->x + r->w) / (float)S->w;
+	G->texcoords.h = (float)(r->y + r->h) / (float)S->h;
 }
 
-/* Render an AG_Text(3) glyph at x,y. */
+/*
+ * Render an AG_Text(3) glyph at x,y. The glyph texture is modulated by
+ * the foreground color. Upload the atlas page on first use.
+ */
 void
 AG_GL_DrawGlyph(void *obj, const AG_Glyph *G, int x, int y)
 {
-	glBindTexture(GL_TEXTURE_2D, G->texture);
+	AG_Driver *drv = obj;
+	AG_GlyphPage *page = G->page;
+	const AG_Color *c = &G->color;
+	const AG_TexCoord tc = G->texcoords;
+	const int w = G->rs.w;
+	const int h = G->rs.h;
+	const int tint = !(G->flags & AG_GLYPH_NO_TINT);
+
+	if (G->colorBG.a != AG_TRANSPARENT) {
+		AG_Rect r;
+
+		r.x = x;
+		r.y = y;
+		r.w = w;
+		r.h = h;
+		AG_GL_DrawRectBlended(drv, &r, &G->colorBG,
+		    AG_ALPHA_SRC, AG_ALPHA_ONE_MINUS_SRC);
+	}
+	if (page->texture == 0) {
+		AGDRIVER_CLASS(drv)->uploadTexture(drv, &page->texture,
+		    page->S, NULL);
+	}
+	AGDRIVER_CLASS(drv)->pushBlendingMode(drv, AG_ALPHA_SRC,
+	    AG_ALPHA_ONE_MINUS_SRC);
+	glBindTexture(GL_TEXTURE_2D, (GLuint)page->texture);
+	if (tint) {
+		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+	}
 	glBegin(GL_POLYGON);
-	{
-		const AG_TexCoord tc = G->texcoords;
-		const int w = G->su->w;
-		const int h = G->su->h;
-
-		glTexCoord2f(tc.x, tc.y);  glVertex2i(x,   y);
-		glTexCoord2f(tc.w, tc.y);  glVertex2i(x+w, y);
-		glTexCoord2f(tc.w, tc.h);  glVertex2i(x+w, y+h);
-		glTexCoord2f(tc.x, tc.h);  glVertex2i(x,   y+h);
+	if (tint) {
+		GL_Color4uH(c->r, c->g, c->b, c->a);
 	}
+	glTexCoord2f(tc.x, tc.y);  glVertex2i(x,   y);
+	glTexCoord2f(tc.w, tc.y);  glVertex2i(x+w, y);
+	glTexCoord2f(tc.w, tc.h);  glVertex2i(x+w, y+h);
+	glTexCoord2f(tc.x, tc.h);  glVertex2i(x,   y+h);
 	glEnd();
+	if (tint) {
+		glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+	}
 	glBindTexture(GL_TEXTURE_2D, 0);
+	AGDRIVER_CLASS(drv)->popBlendingMode(drv);
 }
 
 /* Upload a texture. */
@@ -0,0 +1,1560 @@
+/*
+ * Copyright (c) 2026 Julien Nadeau Carriere <vedge@csoft.net>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE
+ * USE OF THIS SOFTWARE EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Single-window driver rendering to a 32-bit framebuffer in memory. It needs
+ * no windowing system and provides no input. Useful for measuring rendering
+ * costs and for comparing rendered frames against reference images.
+ */
+
+#include <agar/core/core.h>
+#include <agar/gui/gui.h>
+#include <agar/gui/drv.h>
+#include <agar/gui/text.h>
+#include <agar/gui/window.h>
+#include <agar/gui/cursors.h>
+#include <agar/gui/drv_memfb.h>
+
+#include <stdlib.h>
+
+/* Address of the 32-bit pixel at x,y. */
+#define PIXEL_AT(S,x,y) \
+	((Uint32 *)((S)->pixels + (y)*(S)->pitch + ((x) << 2)))
+
+static int nDrivers = 0;			/* Opened driver instances */
+static AG_DriverMemFB *_Nullable memfbDrv = NULL;
+#ifdef AG_EVENT_LOOP
+static AG_EventSink *_Nullable memfbEventSpinner = NULL;
+static AG_EventSink *_Nullable memfbEventEpilogue = NULL;
+#endif
+
+static void MEMFB_UpdateRegion(void *_Nonnull, const AG_Rect *_Nonnull);
+static void MEMFB_DrawRectFilled(void *_Nonnull, const AG_Rect *_Nonnull,
+                                 const AG_Color *_Nonnull);
+static int  CompareInts(const void *_Nonnull, const void *_Nonnull);
+#ifdef AG_EVENT_LOOP
+static int  MEMFB_EventSink(AG_EventSink *_Nonnull, AG_Event *_Nonnull);
+static int  MEMFB_EventEpilogue(AG_EventSink *_Nonnull, AG_Event *_Nonnull);
+#endif
+
+static void
+Init(void *_Nonnull obj)
+{
+	AG_DriverMemFB *mfb = obj;
+
+	mfb->S = NULL;
+	mfb->clipRects = NULL;
+	mfb->nClipRects = 0;
+	mfb->nDamage = 0;
+	mfb->nFrames = 0;
+	mfb->nFrameDamage = 0;
+	mfb->nPolyInts = 0;
+	mfb->polyInts = NULL;
+	mfb->dumpPath = NULL;
+	mfb->cursorVisible = 1;
+}
+
+static void
+Destroy(void *_Nonnull obj)
+{
+	AG_DriverMemFB *mfb = obj;
+
+	if (mfb->S != NULL) {
+		AG_SurfaceFree(mfb->S);
+	}
+	Free(mfb->clipRects);
+	Free(mfb->polyInts);
+	Free(mfb->dumpPath);
+}
+
+/*
+ * Pixel access (clipped against the active clipping rectangle).
+ */
+
+static __inline__ int
+ClippedPixel(const AG_Surface *_Nonnull S, int x, int y)
+{
+	return (x <  S->clipRect.x || x >= S->clipRect.x + S->clipRect.w ||
+	        y <  S->clipRect.y || y >= S->clipRect.y + S->clipRect.h);
+}
+
+static __inline__ Uint32
+MapColor(const AG_Surface *_Nonnull S, const AG_Color *_Nonnull c)
+{
+	return (Uint32)AG_MapPixel_RGB8(&S->format,
+	    AG_Hto8(c->r),
+	    AG_Hto8(c->g),
+	    AG_Hto8(c->b));
+}
+
+static __inline__ void
+Put32(AG_Surface *_Nonnull S, int x, int y, Uint32 px)
+{
+	if (!ClippedPixel(S, x,y))
+		*PIXEL_AT(S,x,y) = px;
+}
+
+/* Blend color c (by its alpha component) into the pixel at p. */
+static __inline__ void
+Blend32(AG_Surface *_Nonnull S, Uint32 *_Nonnull p, const AG_Color *_Nonnull c)
+{
+	Uint8 dR,dG,dB;
+	Uint a = AG_Hto8(c->a);
+
+	a += (a >> 7);				/* Scale 0..255 to 0..256 */
+	AG_GetColor_RGB8(*p, &S->format, &dR,&dG,&dB);
+	*p = (Uint32)AG_MapPixel_RGB8(&S->format,
+	    (AG_Hto8(c->r)*a + dR*(256 - a)) >> 8,
+	    (AG_Hto8(c->g)*a + dG*(256 - a)) >> 8,
+	    (AG_Hto8(c->b)*a + dB*(256 - a)) >> 8);
+}
+
+/* Clip a horizontal span against the clipping rectangle. */
+static __inline__ int
+ClipSpan(const AG_Surface *_Nonnull S, int *_Nonnull x1, int *_Nonnull x2,
+    int y)
+{
+	const AG_Rect *rc = &S->clipRect;
+	int t;
+
+	if (y < rc->y || y >= rc->y + rc->h) {
+		return (1);
+	}
+	if (*x1 > *x2) {
+		t = *x1;
+		*x1 = *x2;
+		*x2 = t;
+	}
+	if (*x1 < rc->x)          { *x1 = rc->x; }
+	if (*x2 >= rc->x + rc->w) { *x2 = rc->x + rc->w - 1; }
+	return (*x1 > *x2);
+}
+
+/* Fill the span [x1,x2] of row y with pixel px. */
+static void
+FillSpan(AG_Surface *_Nonnull S, int x1, int x2, int y, Uint32 px)
+{
+	Uint32 *p, *pEnd;
+
+	if (ClipSpan(S, &x1, &x2, y))
+		return;
+
+	p = PIXEL_AT(S, x1, y);
+	pEnd = p + (x2 - x1);
+	while (p <= pEnd)
+		*p++ = px;
+}
+
+/* Fill the span [x1,x2] of row y with a 32x32 polygon stipple pattern. */
+static void
+FillSpanStippled(AG_Surface *_Nonnull S, int x1, int x2, int y, Uint32 px,
+    const Uint8 *_Nonnull stipple)
+{
+	const Uint8 *row;
+	Uint32 *p;
+	int x;
+
+	if (ClipSpan(S, &x1, &x2, y))
+		return;
+
+	row = &stipple[(y & 31) << 2];
+	p = PIXEL_AT(S, x1, y);
+	for (x = x1; x <= x2; x++, p++) {
+		if (row[(x & 31) >> 3] & (0x80 >> (x & 7)))
+			*p = px;
+	}
+}
+
+/* Trivially reject a line whose endpoints lie on one side of the clip. */
+static __inline__ int
+RejectLine(const AG_Surface *_Nonnull S, int x1, int y1, int x2, int y2)
+{
+	const AG_Rect *rc = &S->clipRect;
+
+	return ((x1 <  rc->x         && x2 <  rc->x) ||
+	        (x1 >= rc->x + rc->w && x2 >= rc->x + rc->w) ||
+	        (y1 <  rc->y         && y2 <  rc->y) ||
+	        (y1 >= rc->y + rc->h && y2 >= rc->y + rc->h));
+}
+
+/*
+ * Bresenham line from (x1,y1) to (x2,y2) inclusive. Pixel i along the line
+ * is plotted if bit (i % 16) of the stipple mask is set.
+ */
+static void
+DrawLineStippled(AG_Surface *_Nonnull S, int x1, int y1, int x2, int y2,
+    Uint32 px, Uint16 mask)
+{
+	const int dx = abs(x2 - x1), sx = (x1 < x2) ? 1 : -1;
+	const int dy = -abs(y2 - y1), sy = (y1 < y2) ? 1 : -1;
+	int err = dx + dy, e2;
+	Uint i = 0;
+
+	if (RejectLine(S, x1,y1, x2,y2))
+		return;
+
+	for (;;) {
+		if (mask & (1 << (i++ & 15))) {
+			Put32(S, x1,y1, px);
+		}
+		if (x1 == x2 && y1 == y2) {
+			break;
+		}
+		e2 = err << 1;
+		if (e2 >= dy) { err += dy; x1 += sx; }
+		if (e2 <= dx) { err += dx; y1 += sy; }
+	}
+}
+
+/* Integer square root (for rounded corners). */
+static int
+ISqrt(int n)
+{
+	int x = n, y = (n + 1) >> 1;
+
+	if (n < 2) {
+		return (n);
+	}
+	while (y < x) {
+		x = y;
+		y = (x + n/x) >> 1;
+	}
+	return (x);
+}
+
+/*
+ * Generic driver operations
+ */
+
+static int
+MEMFB_Open(void *_Nonnull obj, const char *_Nullable spec)
+{
+	AG_Driver *drv = obj;
+	AG_DriverMemFB *mfb = obj;
+
+	if (nDrivers != 0) {
+		AG_SetErrorS(_("Multiple memfb driver instances are not supported"));
+		return (-1);
+	}
+	if ((drv->mouse = AG_MouseNew(mfb, "Memfb mouse")) == NULL ||
+	    (drv->kbd = AG_KeyboardNew(mfb, "Memfb keyboard")) == NULL)
+		goto fail;
+
+#ifdef AG_EVENT_LOOP
+	if ((memfbEventSpinner = AG_AddEventSpinner(MEMFB_EventSink, NULL)) == NULL ||
+	    (memfbEventEpilogue = AG_AddEventEpilogue(MEMFB_EventEpilogue, NULL)) == NULL)
+		goto fail;
+#endif
+	nDrivers = 1;
+	memfbDrv = mfb;
+	return (0);
+fail:
+#ifdef AG_EVENT_LOOP
+	if (memfbEventSpinner != NULL) { AG_DelEventSpinner(memfbEventSpinner); memfbEventSpinner = NULL; }
+	if (memfbEventEpilogue != NULL) { AG_DelEventEpilogue(memfbEventEpilogue); memfbEventEpilogue = NULL; }
+#endif
+	if (drv->kbd != NULL) { AG_ObjectDelete(drv->kbd); drv->kbd = NULL; }
+	if (drv->mouse != NULL) { AG_ObjectDelete(drv->mouse); drv->mouse = NULL; }
+	return (-1);
+}
+
+static void
+MEMFB_Close(void *_Nonnull obj)
+{
+	AG_Driver *drv = obj;
+
+#ifdef AG_DEBUG
+	if (nDrivers != 1) { AG_FatalError("Driver close without open"); }
+#endif
+#ifdef AG_EVENT_LOOP
+	AG_DelEventSpinner(memfbEventSpinner); memfbEventSpinner = NULL;
+	AG_DelEventEpilogue(memfbEventEpilogue); memfbEventEpilogue = NULL;
+#endif
+	AG_FreeCursors(drv);
+
+	AG_ObjectDelete(drv->kbd); drv->kbd = NULL;
+	AG_ObjectDelete(drv->mouse); drv->mouse = NULL;
+
+	memfbDrv = NULL;
+	nDrivers = 0;
+}
+
+static int
+MEMFB_GetDisplaySize(Uint *_Nonnull w, Uint *_Nonnull h)
+{
+	if (memfbDrv != NULL && memfbDrv->S != NULL) {
+		*w = memfbDrv->S->w;
+		*h = memfbDrv->S->h;
+	} else {
+		*w = 640;
+		*h = 480;
+	}
+	return (0);
+}
+
+static int
+MEMFB_PendingEvents(void *_Nonnull obj)
+{
+	return (0);
+}
+
+static int
+MEMFB_GetNextEvent(void *_Nullable obj, AG_DriverEvent *_Nonnull dev)
+{
+	return (0);
+}
+
+static int
+MEMFB_ProcessEvent(void *_Nullable obj, AG_DriverEvent *_Nonnull dev)
+{
+	AG_DriverSw *dsw = (obj != NULL) ? obj : (AG_DriverSw *)memfbDrv;
+
+	switch (dev->type) {
+	case AG_DRIVER_EXPOSE:
+		if (dsw != NULL) {
+			dsw->flags |= AG_DRIVER_SW_REDRAW;
+		}
+		return (1);
+	default:
+		return (0);
+	}
+}
+
+#ifdef AG_EVENT_LOOP
+static int
+MEMFB_EventSink(AG_EventSink *_Nonnull es, AG_Event *_Nonnull event)
+{
+	AG_Delay(1);
+	return (0);
+}
+
+static int
+MEMFB_EventEpilogue(AG_EventSink *_Nonnull es, AG_Event *_Nonnull event)
+{
+	AG_WindowDrawQueued();
+	AG_WindowProcessQueued();
+	return (0);
+}
+#endif /* AG_EVENT_LOOP */
+
+static void
+MEMFB_BeginRendering(void *_Nonnull obj)
+{
+	AGDRIVERMEMFB(obj)->nFrameDamage = 0;
+}
+
+static void
+MEMFB_RenderWindow(AG_Window *_Nonnull win)
+{
+	AG_Rect r;
+
+	AG_WidgetDraw(win);
+
+	r.x = WIDGET(win)->x;
+	r.y = WIDGET(win)->y;
+	r.w = WIDTH(win);
+	r.h = HEIGHT(win);
+	MEMFB_UpdateRegion(WIDGET(win)->drv, &r);
+}
+
+/* Write the framebuffer to the PNG file given by the "dump" option. */
+static void
+DumpFrame(AG_DriverMemFB *_Nonnull mfb)
+{
+	char path[AG_PATHNAME_MAX], num[16];
+	const char *s;
+
+	/* Substitute the frame number for a "%u" in the path. */
+	if ((s = strstr(mfb->dumpPath, "%u")) != NULL) {
+		Snprintf(num, sizeof(num), "%08u", mfb->nFrames);
+		Strlcpy(path, mfb->dumpPath, MIN(sizeof(path),
+		                                 (AG_Size)(s - mfb->dumpPath) + 1));
+		Strlcat(path, num, sizeof(path));
+		Strlcat(path, &s[2], sizeof(path));
+	} else {
+		Strlcpy(path, mfb->dumpPath, sizeof(path));
+	}
+	if (AG_SurfaceExportPNG(mfb->S, path, 0) == -1)
+		Verbose("%s: %s: %s\n", OBJECT(mfb)->name, path, AG_GetError());
+}
+
+static void
+MEMFB_EndRendering(void *_Nonnull obj)
+{
+	AG_DriverMemFB *mfb = obj;
+
+#ifdef AG_DEBUG
+	if (mfb->nClipRects != 1)
+		AG_FatalError("Inconsistent PushClipRect() / PopClipRect()");
+#endif
+	if (mfb->nFrameDamage > 0) {
+		mfb->nFrames++;
+		if (mfb->dumpPath != NULL)
+			DumpFrame(mfb);
+	}
+}
+
+static void
+MEMFB_FillRect(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c)
+{
+	MEMFB_DrawRectFilled(obj, r, c);
+}
+
+static void
+MEMFB_UpdateRegion(void *_Nonnull obj, const AG_Rect *_Nonnull rRegion)
+{
+	AG_DriverMemFB *mfb = obj;
+	AG_Rect r, rFB;
+	Uint i;
+
+	rFB.x = 0;
+	rFB.y = 0;
+	rFB.w = mfb->S->w;
+	rFB.h = mfb->S->h;
+	if (!AG_RectIntersect(&r, rRegion, &rFB))
+		return;
+
+	if (mfb->nDamage == AG_DRIVER_MEMFB_DAMAGE_MAX) {
+		AG_Rect2 u, d;
+
+		/* Collapse the list into its bounding rectangle. */
+		AG_RectToRect2(&u, &mfb->damage[0]);
+		for (i = 1; i < mfb->nDamage; i++) {
+			AG_RectToRect2(&d, &mfb->damage[i]);
+			if (d.x1 < u.x1) { u.x1 = d.x1; }
+			if (d.y1 < u.y1) { u.y1 = d.y1; }
+			if (d.x2 > u.x2) { u.x2 = d.x2; }
+			if (d.y2 > u.y2) { u.y2 = d.y2; }
+		}
+		u.w = u.x2 - u.x1;
+		u.h = u.y2 - u.y1;
+		AG_Rect2ToRect(&mfb->damage[0], &u);
+		mfb->nDamage = 1;
+	}
+	mfb->damage[mfb->nDamage++] = r;
+	mfb->nFrameDamage++;
+}
+
+static void
+MEMFB_UpdateTexture(void *_Nonnull obj, Uint texture, AG_Surface *_Nonnull S,
+    AG_TexCoord *_Nullable c)
+{
+	/* No-op */
+}
+
+static void
+MEMFB_DeleteTexture(void *_Nonnull obj, Uint texture)
+{
+	/* No-op */
+}
+
+static int
+MEMFB_SetRefreshRate(void *_Nonnull obj, int fps)
+{
+	AG_DriverSw *dsw = obj;
+
+	if (fps < 1) {
+		AG_SetErrorS(_("Invalid refresh rate"));
+		return (-1);
+	}
+	dsw->rNom = 1000/fps;
+	return (0);
+}
+
+/*
+ * Clipping and blending control (rendering context)
+ */
+
+static void
+MEMFB_PushClipRect(void *_Nonnull obj, const AG_Rect *_Nonnull r)
+{
+	AG_DriverMemFB *mfb = obj;
+	AG_ClipRect *cr, *crPrev;
+
+	mfb->clipRects = Realloc(mfb->clipRects, (mfb->nClipRects + 1) *
+	                                         sizeof(AG_ClipRect));
+	crPrev = &mfb->clipRects[mfb->nClipRects - 1];
+	cr = &mfb->clipRects[mfb->nClipRects++];
+
+	if (!AG_RectIntersect(&cr->r, &crPrev->r, r)) {
+		cr->r.w = 0;
+		cr->r.h = 0;
+	}
+	mfb->S->clipRect = cr->r;
+}
+
+static void
+MEMFB_PopClipRect(void *_Nonnull obj)
+{
+	AG_DriverMemFB *mfb = obj;
+
+#ifdef AG_DEBUG
+	if (mfb->nClipRects <= 1)
+		AG_FatalError("PopClipRect() without PushClipRect()");
+#endif
+	mfb->S->clipRect = mfb->clipRects[--mfb->nClipRects - 1].r;
+}
+
+static void
+MEMFB_PushBlendingMode(void *_Nonnull obj, AG_AlphaFn fnSrc, AG_AlphaFn fnDst)
+{
+	/* No-op (handle blending on a per-blit basis) */
+}
+
+static void
+MEMFB_PopBlendingMode(void *_Nonnull obj)
+{
+	/* No-op (handle blending on a per-blit basis) */
+}
+
+/*
+ * Cursor operations (cursors are not rendered)
+ */
+
+static AG_Cursor *
+MEMFB_CreateCursor(void *_Nonnull obj, Uint w, Uint h,
+    const Uint8 *_Nonnull data, const Uint8 *_Nonnull mask, int xHot, int yHot)
+{
+	AG_Cursor *ac;
+	const Uint size = w*h;
+
+	if ((ac = TryMalloc(sizeof(AG_Cursor))) == NULL) {
+		return (NULL);
+	}
+	AG_CursorInit(ac);
+	if ((ac->data = TryMalloc(size)) == NULL ||
+	    (ac->mask = TryMalloc(size)) == NULL) {
+		Free(ac->data);
+		free(ac);
+		return (NULL);
+	}
+	memcpy(ac->data, data, size);
+	memcpy(ac->mask, mask, size);
+	ac->w = w;
+	ac->h = h;
+	ac->xHot = xHot;
+	ac->yHot = yHot;
+	return (ac);
+}
+
+static void
+MEMFB_FreeCursor(void *_Nonnull obj, AG_Cursor *_Nonnull ac)
+{
+	AG_Driver *drv = obj;
+
+	if (ac == drv->activeCursor) {
+		drv->activeCursor = NULL;
+	}
+	Free(ac->data);
+	Free(ac->mask);
+	free(ac);
+}
+
+static int
+MEMFB_SetCursor(void *_Nonnull obj, AG_Cursor *_Nonnull ac)
+{
+	AGDRIVER(obj)->activeCursor = ac;
+	return (0);
+}
+
+static void
+MEMFB_UnsetCursor(void *_Nonnull obj)
+{
+	AG_Driver *drv = obj;
+
+	drv->activeCursor = TAILQ_FIRST(&drv->cursors);
+}
+
+static int
+MEMFB_GetCursorVisibility(void *_Nonnull obj)
+{
+	return AGDRIVERMEMFB(obj)->cursorVisible;
+}
+
+static void
+MEMFB_SetCursorVisibility(void *_Nonnull obj, int flag)
+{
+	AGDRIVERMEMFB(obj)->cursorVisible = flag;
+}
+
+/*
+ * Surface operations (rendering context)
+ */
+
+static void
+MEMFB_BlitSurface(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    AG_Surface *_Nonnull S, int x, int y)
+{
+	AG_SurfaceBlit(S, NULL, AGDRIVERMEMFB(obj)->S, x,y);
+}
+
+static void
+MEMFB_BlitSurfaceFrom(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    int s, const AG_Rect *_Nullable rSrc, int x, int y)
+{
+	AG_SurfaceBlit(wid->surfaces[s], rSrc, AGDRIVERMEMFB(obj)->S, x,y);
+}
+
+#ifdef HAVE_OPENGL
+static void
+MEMFB_BlitSurfaceGL(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    AG_Surface *_Nonnull S, float w, float h)
+{
+	/* Not applicable */
+}
+
+static void
+MEMFB_BlitSurfaceFromGL(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    int s, float w, float h)
+{
+	/* Not applicable */
+}
+
+static void
+MEMFB_BlitSurfaceFlippedGL(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    int s, float w, float h)
+{
+	/* Not applicable */
+}
+#endif /* HAVE_OPENGL */
+
+static int
+MEMFB_RenderToSurface(void *_Nonnull obj, AG_Widget *_Nonnull wid,
+    AG_Surface *_Nonnull *_Nullable pS)
+{
+	AG_DriverMemFB *mfb = obj;
+	AG_Surface *S;
+	AG_Rect r;
+	int visiblePrev;
+
+	AG_BeginRendering(mfb);
+	visiblePrev = wid->window->visible;
+	wid->window->visible = 1;
+	AG_WindowDraw(wid->window);
+	wid->window->visible = visiblePrev;
+	AG_EndRendering(mfb);
+
+	S = AG_SurfaceNew(&mfb->S->format, wid->w, wid->h, 0);
+	r.x = wid->rView.x1;
+	r.y = wid->rView.y1;
+	r.w = wid->w;
+	r.h = wid->h;
+	AG_SurfaceBlit(mfb->S, &r, S, 0,0);
+	*pS = S;
+	return (0);
+}
+
+/*
+ * Rendering operations (rendering context)
+ */
+
+static void
+MEMFB_PutPixel(void *_Nonnull obj, int x, int y, const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+
+	Put32(S, x,y, MapColor(S,c));
+}
+
+static void
+MEMFB_PutPixel32(void *_Nonnull obj, int x, int y, Uint32 px)
+{
+	Put32(AGDRIVERMEMFB(obj)->S, x,y, px);
+}
+
+static void
+MEMFB_PutPixelRGB8(void *_Nonnull obj, int x, int y, Uint8 r, Uint8 g, Uint8 b)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+
+	Put32(S, x,y, (Uint32)AG_MapPixel_RGB8(&S->format, r,g,b));
+}
+
+#if AG_MODEL == AG_LARGE
+static void
+MEMFB_PutPixel64(void *_Nonnull obj, int x, int y, Uint64 px)
+{
+	/* The video format is that of the framebuffer surface. */
+	Put32(AGDRIVERMEMFB(obj)->S, x,y, (Uint32)px);
+}
+
+static void
+MEMFB_PutPixelRGB16(void *_Nonnull obj, int x, int y, Uint16 r, Uint16 g,
+    Uint16 b)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+
+	Put32(S, x,y, (Uint32)AG_MapPixel_RGB16(&S->format, r,g,b));
+}
+#endif /* AG_LARGE */
+
+/*
+ * The framebuffer has no alpha channel so the alpha functions are not
+ * needed; the source color is blended by its alpha component.
+ */
+static void
+MEMFB_BlendPixel(void *_Nonnull obj, int x, int y, const AG_Color *_Nonnull c,
+    AG_AlphaFn fnSrc, AG_AlphaFn fnDst)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+
+	if (!ClippedPixel(S, x,y))
+		Blend32(S, PIXEL_AT(S,x,y), c);
+}
+
+static void
+MEMFB_DrawLine(void *_Nonnull obj, int x1, int y1, int x2, int y2,
+    const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+
+	DrawLineStippled(S, x1,y1, x2,y2, MapColor(S,c), 0xffff);
+}
+
+static void
+MEMFB_DrawLineH(void *_Nonnull obj, int x1, int x2, int y,
+    const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+
+	FillSpan(S, x1, x2, y, MapColor(S,c));
+}
+
+static void
+MEMFB_DrawLineV(void *_Nonnull obj, int x, int y1, int y2,
+    const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+	const AG_Rect *rc = &S->clipRect;
+	Uint8 *p, *pEnd;
+	Uint32 px;
+	int t;
+
+	if (x < rc->x || x >= rc->x + rc->w) {
+		return;
+	}
+	if (y1 > y2) {
+		t = y1;
+		y1 = y2;
+		y2 = t;
+	}
+	if (y1 < rc->y)          { y1 = rc->y; }
+	if (y2 >= rc->y + rc->h) { y2 = rc->y + rc->h - 1; }
+	if (y1 > y2)
+		return;
+
+	px = MapColor(S,c);
+	p = (Uint8 *)PIXEL_AT(S, x, y1);
+	pEnd = p + (y2 - y1)*S->pitch;
+	for (; p <= pEnd; p += S->pitch)
+		*(Uint32 *)p = px;
+}
+
+static void
+MEMFB_DrawLineBlended(void *_Nonnull obj, int x1, int y1, int x2, int y2,
+    const AG_Color *_Nonnull c, AG_AlphaFn fnSrc, AG_AlphaFn fnDst)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+	const int dx = abs(x2 - x1), sx = (x1 < x2) ? 1 : -1;
+	const int dy = -abs(y2 - y1), sy = (y1 < y2) ? 1 : -1;
+	int err = dx + dy, e2;
+
+	if (RejectLine(S, x1,y1, x2,y2))
+		return;
+
+	for (;;) {
+		if (!ClippedPixel(S, x1,y1)) {
+			Blend32(S, PIXEL_AT(S,x1,y1), c);
+		}
+		if (x1 == x2 && y1 == y2) {
+			break;
+		}
+		e2 = err << 1;
+		if (e2 >= dy) { err += dy; x1 += sx; }
+		if (e2 <= dx) { err += dx; y1 += sy; }
+	}
+}
+
+/* Draw parallel lines offset along the minor axis to approximate width. */
+static void
+MEMFB_DrawLineW_Sti16(void *_Nonnull obj, int x1, int y1, int x2, int y2,
+    const AG_Color *_Nonnull c, float width, Uint16 mask)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+	const Uint32 px = MapColor(S,c);
+	const int n = (width > 1.0f) ? (int)(width + 0.5f) : 1;
+	const int horiz = (abs(x2 - x1) >= abs(y2 - y1));
+	int i, o;
+
+	for (i = 0; i < n; i++) {
+		o = i - ((n - 1) >> 1);
+		if (horiz) {
+			DrawLineStippled(S, x1, y1+o, x2, y2+o, px, mask);
+		} else {
+			DrawLineStippled(S, x1+o, y1, x2+o, y2, px, mask);
+		}
+	}
+}
+
+static void
+MEMFB_DrawLineW(void *_Nonnull obj, int x1, int y1, int x2, int y2,
+    const AG_Color *_Nonnull c, float width)
+{
+	MEMFB_DrawLineW_Sti16(obj, x1,y1, x2,y2, c, width, 0xffff);
+}
+
+/* X coordinate of the edge (xa,ya)-(xb,yb) at row y. */
+static __inline__ int
+EdgeX(int xa, int ya, int xb, int yb, int y)
+{
+	if (yb == ya) {
+		return (xb);
+	}
+	return xa + (xb - xa)*(y - ya) / (yb - ya);
+}
+
+static void
+MEMFB_DrawTriangle(void *_Nonnull obj, const AG_Pt *_Nonnull v1,
+    const AG_Pt *_Nonnull v2, const AG_Pt *_Nonnull v3,
+    const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+	const AG_Pt *a = v1, *b = v2, *t;
+	const AG_Pt *d = v3;
+	Uint32 px;
+	int y, yEnd;
+
+	/* Sort the vertices by y coordinate ascending. */
+	if (a->y > b->y) { t = a; a = b; b = t; }
+	if (b->y > d->y) { t = b; b = d; d = t; }
+	if (a->y > b->y) { t = a; a = b; b = t; }
+
+	px = MapColor(S,c);
+	y = MAX(a->y, S->clipRect.y);
+	yEnd = MIN(d->y, S->clipRect.y + S->clipRect.h - 1);
+	for (; y <= yEnd; y++) {
+		int xa, xb;
+
+		xa = EdgeX(a->x, a->y, d->x, d->y, y);
+		if (y < b->y) {
+			xb = EdgeX(a->x, a->y, b->x, b->y, y);
+		} else {
+			xb = EdgeX(b->x, b->y, d->x, d->y, y);
+		}
+		FillSpan(S, xa, xb, y, px);
+	}
+}
+
+/* Scanline polygon fill (with optional 32x32 stipple pattern). */
+static void
+FillPolygon(AG_DriverMemFB *_Nonnull mfb, const AG_Pt *_Nonnull pts, Uint nPts,
+    Uint32 px, const Uint8 *_Nullable stipple)
+{
+	AG_Surface *S = mfb->S;
+	int y, x1, y1, x2, y2;
+	int yMin, yMax;
+	Uint i, i1, i2, nPolyInts;
+
+	if (nPts < 3)
+		return;
+
+	/* Allocate/resize the array of intersections. */
+	if (nPts > mfb->nPolyInts) {
+		mfb->polyInts = Realloc(mfb->polyInts, nPts*sizeof(int));
+		mfb->nPolyInts = nPts;
+	}
+
+	/* Find Y extrema */
+	yMin = pts[0].y;
+	yMax = yMin;
+	for (i = 1; i < nPts; i++) {
+		if (pts[i].y < yMin) {
+			yMin = pts[i].y;
+		} else if (pts[i].y > yMax) {
+			yMax = pts[i].y;
+		}
+	}
+	if (yMin < S->clipRect.y) {
+		yMin = S->clipRect.y;
+	}
+	if (yMax >= S->clipRect.y + S->clipRect.h)
+		yMax = S->clipRect.y + S->clipRect.h - 1;
+
+	/* Find the intersections. */
+	for (y = yMin; y <= yMax; y++) {
+		nPolyInts = 0;
+		for (i = 0; i < nPts; i++) {
+			if (i == 0) {
+				i1 = nPts - 1;
+				i2 = 0;
+			} else {
+				i1 = i - 1;
+				i2 = i;
+			}
+			y1 = pts[i1].y;
+			y2 = pts[i2].y;
+			if (y1 < y2) {
+				x1 = pts[i1].x;
+				x2 = pts[i2].x;
+			} else if (y1 > y2) {
+				x2 = pts[i1].x;
+				y2 = pts[i1].y;
+				x1 = pts[i2].x;
+				y1 = pts[i2].y;
+			} else {
+				continue;
+			}
+			if (((y >= y1) && (y < y2)) ||
+			    ((y == yMax) && (y > y1) && (y <= y2))) {
+				mfb->polyInts[nPolyInts++] =
+				    (((y - y1) << 16) / (y2 - y1)) *
+				     (x2 - x1) + (x1 << 16);
+			}
+		}
+		qsort(mfb->polyInts, nPolyInts, sizeof(int), CompareInts);
+
+		for (i = 0; i+1 < nPolyInts; i += 2) {
+			int xa, xb;
+
+			xa = mfb->polyInts[i] + 1;
+			xa = (xa >> 16) + ((xa & 0x8000) >> 15);
+			xb = mfb->polyInts[i+1] - 1;
+			xb = (xb >> 16) + ((xb & 0x8000) >> 15);
+			if (stipple != NULL) {
+				FillSpanStippled(S, xa, xb, y, px, stipple);
+			} else {
+				FillSpan(S, xa, xb, y, px);
+			}
+		}
+	}
+}
+
+static int
+CompareInts(const void *_Nonnull p1, const void *_Nonnull p2)
+{
+	return (*(const int *)p1 - *(const int *)p2);
+}
+
+static void
+MEMFB_DrawPolygon(void *_Nonnull obj, const AG_Pt *_Nonnull pts, Uint nPts,
+    const AG_Color *_Nonnull c)
+{
+	AG_DriverMemFB *mfb = obj;
+
+	FillPolygon(mfb, pts, nPts, MapColor(mfb->S, c), NULL);
+}
+
+static void
+MEMFB_DrawPolygon_Sti32(void *_Nonnull obj, const AG_Pt *_Nonnull pts,
+    Uint nPts, const AG_Color *_Nonnull c, const Uint8 *_Nonnull stipple)
+{
+	AG_DriverMemFB *mfb = obj;
+
+	FillPolygon(mfb, pts, nPts, MapColor(mfb->S, c), stipple);
+}
+
+static void
+MEMFB_DrawArrow(void *_Nonnull obj, Uint8 angle, int x0, int y0, int h,
+    const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+	const Uint32 px = MapColor(S,c);
+	const int p1 = y0 - (h >> 1) + 1;
+	const int p2 = p1 + h-2;
+	int i, s, e;
+
+#ifdef AG_DEBUG
+	if (angle >= 4) { AG_FatalError("Bad angle"); }
+#endif
+	switch (angle) {
+	case 0:						/* Up */
+		for (i = p1, s = x0, e = x0; i < p2; i++, s--, e++) {
+			FillSpan(S, s, e, i, px);
+		}
+		break;
+	case 2:						/* Down */
+		for (i = p2, s = x0, e = x0; i > p1; i--, s--, e++) {
+			FillSpan(S, s, e, i, px);
+		}
+		break;
+	case 1:						/* Right */
+		{
+			const int q1 = x0 - (h >> 1) + 1, q2 = q1 + h-2;
+			int x;
+
+			for (x = q2, s = y0, e = y0; x > q1; x--, s--, e++) {
+				for (i = s; i <= e; i++)
+					Put32(S, x,i, px);
+			}
+		}
+		break;
+	case 3:						/* Left */
+		{
+			const int q1 = x0 - (h >> 1) + 1, q2 = q1 + h-2;
+			int x;
+
+			for (x = q1, s = y0, e = y0; x < q2; x++, s--, e++) {
+				for (i = s; i <= e; i++)
+					Put32(S, x,i, px);
+			}
+		}
+		break;
+	}
+}
+
+/* Horizontal inset of row k of a box of height h with corner radius rad. */
+static __inline__ int
+RowInset(int rad, int k, int h, int roundBottom)
+{
+	int d;
+
+	if (k < rad) {
+		d = rad - k;
+	} else if (roundBottom && k >= h - rad) {
+		d = k - (h - rad - 1);
+	} else {
+		return (0);
+	}
+	return (rad - ISqrt(rad*rad - d*d));
+}
+
+/*
+ * Draw a box with rounded corners, filled with c1. The top and left edges
+ * are outlined with c2, the right (and bottom) edges with c3.
+ */
+static void
+DrawBoxRounded(AG_Surface *_Nonnull S, const AG_Rect *_Nonnull r, int rad,
+    const AG_Color *_Nonnull c1, const AG_Color *_Nonnull c2,
+    const AG_Color *_Nonnull c3, int roundBottom)
+{
+	const int rx = r->x, ry = r->y, rw = r->w, rh = r->h;
+	const Uint32 px1 = MapColor(S,c1);
+	const Uint32 px2 = MapColor(S,c2);
+	const Uint32 px3 = MapColor(S,c3);
+	int k, kEnd, inset, insetEdge, xl, xr;
+
+	if (rw < 4 || rh < 4) {
+		return;
+	}
+	if (rad < 0) {
+		rad = 0;
+	}
+	if ((rad << 1) > rw) { rad = rw >> 1; }
+	if ((rad << 1) > rh) { rad = rh >> 1; }
+
+	k = MAX(0, S->clipRect.y - ry);
+	kEnd = MIN(rh, S->clipRect.y + S->clipRect.h - ry);
+	for (; k < kEnd; k++) {
+		inset = RowInset(rad, k, rh, roundBottom);
+		xl = rx + inset;
+		xr = rx + rw - 1 - inset;
+
+		if (k == 0) {
+			FillSpan(S, xl, xr, ry, px2);
+			continue;
+		}
+		if (roundBottom && k == rh-1) {
+			FillSpan(S, xl, xr, ry+k, px3);
+			continue;
+		}
+		FillSpan(S, xl+1, xr-1, ry+k, px1);
+
+		/* Outline, covering the gap to the row nearer the edge. */
+		if (k < (rh >> 1) || !roundBottom) {
+			insetEdge = RowInset(rad, k-1, rh, roundBottom);
+		} else {
+			insetEdge = RowInset(rad, k+1, rh, roundBottom);
+		}
+		FillSpan(S, xl, MAX(xl, rx + insetEdge - 1), ry+k, px2);
+		FillSpan(S, MIN(xr, rx + rw - insetEdge), xr, ry+k, px3);
+	}
+}
+
+static void
+MEMFB_DrawBoxRounded(void *_Nonnull obj, const AG_Rect *_Nonnull r, int z,
+    int rad, const AG_Color *_Nonnull c1, const AG_Color *_Nonnull c2,
+    const AG_Color *_Nonnull c3)
+{
+	DrawBoxRounded(AGDRIVERMEMFB(obj)->S, r, rad, c1, c2, c3, 1);
+}
+
+static void
+MEMFB_DrawBoxRoundedTop(void *_Nonnull obj, const AG_Rect *_Nonnull r, int z,
+    int rad, const AG_Color *_Nonnull c1, const AG_Color *_Nonnull c2,
+    const AG_Color *_Nonnull c3)
+{
+	DrawBoxRounded(AGDRIVERMEMFB(obj)->S, r, rad, c1, c2, c3, 0);
+}
+
+static void
+MEMFB_DrawCircle(void *_Nonnull obj, int x1, int y1, int radius,
+    const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+	const Uint32 px = MapColor(S,c);
+	int v = (radius << 1) - 1;
+	int e = 0, u = 1;
+	int x = 0, y = radius;
+
+	while (x < y) {
+		Put32(S, x1+x, y1+y, px);
+		Put32(S, x1+x, y1-y, px);
+		Put32(S, x1-x, y1+y, px);
+		Put32(S, x1-x, y1-y, px);
+		e += u;
+		u += 2;
+		if (v < (e << 1)) {
+			y--;
+			e -= v;
+			v -= 2;
+		}
+		x++;
+		Put32(S, x1+y, y1+x, px);
+		Put32(S, x1+y, y1-x, px);
+		Put32(S, x1-y, y1+x, px);
+		Put32(S, x1-y, y1-x, px);
+	}
+	Put32(S, x1-radius, y1, px);
+	Put32(S, x1+radius, y1, px);
+}
+
+static void
+MEMFB_DrawCircleFilled(void *_Nonnull obj, int x1, int y1, int radius,
+    const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+	const Uint32 px = MapColor(S,c);
+	int v = (radius << 1) - 1;
+	int e = 0, u = 1;
+	int x = 0, y = radius;
+
+	FillSpan(S, x1-radius, x1+radius, y1, px);
+	while (x < y) {
+		FillSpan(S, x1-x, x1+x, y1+y, px);
+		FillSpan(S, x1-x, x1+x, y1-y, px);
+		e += u;
+		u += 2;
+		if (v < (e << 1)) {
+			y--;
+			e -= v;
+			v -= 2;
+		}
+		x++;
+		FillSpan(S, x1-y, x1+y, y1+x, px);
+		FillSpan(S, x1-y, x1+y, y1-x, px);
+	}
+}
+
+static void
+MEMFB_DrawRectFilled(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c)
+{
+	AG_FillRect(AGDRIVERMEMFB(obj)->S, r, c);
+}
+
+static void
+MEMFB_DrawRectBlended(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c, AG_AlphaFn fnSrc, AG_AlphaFn fnDst)
+{
+	AG_SurfaceBlendRect(AGDRIVERMEMFB(obj)->S, r, c);
+}
+
+static void
+MEMFB_DrawRectDithered(void *_Nonnull obj, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c)
+{
+	AG_Surface *S = AGDRIVERMEMFB(obj)->S;
+	const Uint32 px = MapColor(S,c);
+	const int x2 = r->x + r->w - 2;
+	const int y2 = r->y + r->h - 2;
+	int x, y, flag = 0;
+
+	for (y = r->y; y < y2; y++) {
+		flag = !flag;
+		for (x = r->x+1+flag; x < x2; x+=2)
+			Put32(S, x,y, px);
+	}
+}
+
+static void
+MEMFB_UpdateGlyph(void *_Nonnull obj, AG_Glyph *_Nonnull G)
+{
+	/* Nothing to do */
+}
+
+static void
+MEMFB_DrawGlyph(void *_Nonnull obj, const AG_Glyph *_Nonnull G, int x, int y)
+{
+	AG_TextBlitGlyph(AGDRIVERMEMFB(obj)->S, G, x,y);
+}
+
+/*
+ * Single-display specific operations.
+ */
+
+/* Apply the "width", "height", "fpsMax", "bgColor" and "dump" options. */
+static void
+GetPrefDisplaySettings(AG_DriverMemFB *_Nonnull mfb, Uint *_Nonnull w,
+    Uint *_Nonnull h)
+{
+	AG_Driver *drv = AGDRIVER(mfb);
+	AG_DriverSw *dsw = AGDRIVERSW(mfb);
+	char buf[AG_PATHNAME_MAX];
+
+	if (*w == 0) {
+		if (AG_Defined(drv, "width")) {
+			AG_GetString(drv, "width", buf, sizeof(buf));
+			*w = (Uint)strtoul(buf, NULL, 10);
+		}
+		if (*w == 0)
+			*w = 640;
+	}
+	if (*h == 0) {
+		if (AG_Defined(drv, "height")) {
+			AG_GetString(drv, "height", buf, sizeof(buf));
+			*h = (Uint)strtoul(buf, NULL, 10);
+		}
+		if (*h == 0)
+			*h = 480;
+	}
+	if (AG_Defined(drv, "fpsMax")) {
+		char *ep;
+		float v;
+
+		AG_GetString(drv, "fpsMax", buf, sizeof(buf));
+		v = (float)strtod(buf, &ep);
+		if (*ep == '\0') {
+			dsw->rNom = (v > 0.0f) ? (Uint)(1000.0f/v) : 0;
+		}
+	}
+	if (AG_Defined(drv, "bgColor")) {
+		AG_ColorFromString(&dsw->bgColor,
+		    AG_GetStringP(drv,"bgColor"),
+		    NULL);
+	}
+	if (AG_Defined(drv, "dump")) {
+		AG_GetString(drv, "dump", buf, sizeof(buf));
+		Free(mfb->dumpPath);
+		mfb->dumpPath = Strdup(buf);
+	}
+	if (!AG_Defined(drv, "!bgPopup"))
+		dsw->flags |= AG_DRIVER_SW_BGPOPUP;
+}
+
+/* Initialize the clipping rectangle stack. */
+static int
+InitClipRects(AG_DriverMemFB *_Nonnull mfb, int wView, int hView)
+{
+	AG_ClipRect *cr;
+
+	/* Rectangle 0 always covers the whole view. */
+	if ((mfb->clipRects = TryMalloc(sizeof(AG_ClipRect))) == NULL) {
+		return (-1);
+	}
+	cr = &mfb->clipRects[0];
+	cr->r.x = 0;
+	cr->r.y = 0;
+	cr->r.w = wView;
+	cr->r.h = hView;
+	mfb->nClipRects = 1;
+	return (0);
+}
+
+static void
+InitDefaultCursor(AG_Driver *_Nonnull drv)
+{
+	AG_Cursor *ac;
+
+	ac = Malloc(sizeof(AG_Cursor));
+	AG_CursorInit(ac);
+	TAILQ_INSERT_HEAD(&drv->cursors, ac, cursors);
+	drv->nCursors++;
+	drv->activeCursor = ac;
+}
+
+static int
+MEMFB_OpenVideo(void *_Nonnull obj, Uint w, Uint h, int depth, Uint flags)
+{
+	AG_Driver *drv = obj;
+	AG_DriverSw *dsw = obj;
+	AG_DriverMemFB *mfb = obj;
+	AG_PixelFormat *pf;
+
+	if (flags & AG_VIDEO_OVERLAY)     { dsw->flags |= AG_DRIVER_SW_OVERLAY; }
+	if (flags & AG_VIDEO_BGPOPUPMENU) { dsw->flags |= AG_DRIVER_SW_BGPOPUP; }
+
+	GetPrefDisplaySettings(mfb, &w, &h);
+
+	if ((pf = drv->videoFmt = TryMalloc(sizeof(AG_PixelFormat))) == NULL) {
+		return (-1);
+	}
+	AG_PixelFormatRGB(pf, 32,
+#if AG_BYTEORDER == AG_BIG_ENDIAN
+	    0xff000000,
+	    0x00ff0000,
+	    0x0000ff00
+#else
+	    0x000000ff,
+	    0x0000ff00,
+	    0x00ff0000
+#endif
+	);
+	mfb->S = AG_SurfaceNew(pf, w, h, 0);
+
+	dsw->w = w;
+	dsw->h = h;
+	dsw->depth = 32;
+
+	if (InitClipRects(mfb, w, h) == -1)
+		goto fail;
+
+	InitDefaultCursor(drv);
+	AG_InitStockCursors(drv);
+
+	MEMFB_DrawRectFilled(mfb, &mfb->clipRects[0].r, &dsw->bgColor);
+	return (0);
+fail:
+	AG_SurfaceFree(mfb->S);
+	mfb->S = NULL;
+	AG_PixelFormatFree(drv->videoFmt);
+	free(drv->videoFmt);
+	drv->videoFmt = NULL;
+	return (-1);
+}
+
+static int
+MEMFB_OpenVideoContext(void *_Nonnull obj, void *_Nonnull ctx, Uint flags)
+{
+	AG_SetErrorS("openVideoContext() not supported");
+	return (-1);
+}
+
+static int
+MEMFB_SetVideoContext(void *_Nonnull obj, void *_Nonnull ctx)
+{
+	AG_SetErrorS("setVideoContext() not supported");
+	return (-1);
+}
+
+static void
+MEMFB_CloseVideo(void *_Nonnull obj)
+{
+	AG_DriverMemFB *mfb = obj;
+
+	if (mfb->S != NULL) {
+		AG_SurfaceFree(mfb->S);
+		mfb->S = NULL;
+	}
+	mfb->nDamage = 0;
+}
+
+static int
+MEMFB_VideoResize(void *_Nonnull obj, Uint w, Uint h)
+{
+	AG_DriverSw *dsw = obj;
+	AG_DriverMemFB *mfb = obj;
+	AG_ClipRect *cr0;
+
+	if (AG_SurfaceResize(mfb->S, w,h) == -1) {
+		return (-1);
+	}
+	dsw->w = w;
+	dsw->h = h;
+
+	/* Update clipping rectangle 0. */
+	cr0 = &mfb->clipRects[0];
+	cr0->r.w = w;
+	cr0->r.h = h;
+	mfb->S->clipRect = cr0->r;
+
+	mfb->nDamage = 0;
+	return (0);
+}
+
+static AG_Surface *
+MEMFB_VideoCapture(void *_Nonnull obj)
+{
+	return AG_SurfaceDup(AGDRIVERMEMFB(obj)->S);
+}
+
+static void
+MEMFB_VideoClear(void *_Nonnull obj, const AG_Color *_Nonnull c)
+{
+	AG_DriverMemFB *mfb = obj;
+	const AG_Rect *r0 = &mfb->clipRects[0].r;
+	AG_Rect rSave = mfb->S->clipRect;
+
+	mfb->S->clipRect = *r0;
+	MEMFB_DrawRectFilled(mfb, r0, c);
+	mfb->S->clipRect = rSave;
+	MEMFB_UpdateRegion(mfb, r0);
+}
+
+/*
+ * Public interface.
+ */
+
+/*
+ * Return the framebuffer surface. It remains valid until the display is
+ * resized or closed.
+ */
+AG_Surface *
+AG_DriverMemFBGetSurface(void *obj)
+{
+	AG_OBJECT_ISA(obj, "AG_Driver:AG_DriverSw:AG_DriverMemFB:*");
+	return AGDRIVERMEMFB(obj)->S;
+}
+
+/* Return the regions updated since the last AG_DriverMemFBClearDamage(). */
+const AG_Rect *
+AG_DriverMemFBGetDamage(void *obj, Uint *nRects)
+{
+	AG_DriverMemFB *mfb = obj;
+
+	AG_OBJECT_ISA(mfb, "AG_Driver:AG_DriverSw:AG_DriverMemFB:*");
+	*nRects = mfb->nDamage;
+	return (mfb->damage);
+}
+
+/* Clear the list of updated regions. */
+void
+AG_DriverMemFBClearDamage(void *obj)
+{
+	AG_OBJECT_ISA(obj, "AG_Driver:AG_DriverSw:AG_DriverMemFB:*");
+	AGDRIVERMEMFB(obj)->nDamage = 0;
+}
+
+/* Write the current framebuffer contents to a PNG file. */
+int
+AG_DriverMemFBExportPNG(void *obj, const char *path)
+{
+	AG_DriverMemFB *mfb = obj;
+
+	AG_OBJECT_ISA(mfb, "AG_Driver:AG_DriverSw:AG_DriverMemFB:*");
+	if (mfb->S == NULL) {
+		AG_SetErrorS(_("Display is not open"));
+		return (-1);
+	}
+	return AG_SurfaceExportPNG(mfb->S, path, 0);
+}
+
+AG_DriverSwClass agDriverMemFB = {
+	{
+		{
+			"AG_Driver:AG_DriverSw:AG_DriverMemFB",
+			sizeof(AG_DriverMemFB),
+			{ 1,7, AGC_DRIVER_MEMFB, 0xE097 },
+			Init,
+			NULL,		/* reset */
+			Destroy,
+			NULL,		/* load */
+			NULL,		/* save */
+			NULL,		/* edit */
+		},
+		"memfb",
+		AG_FRAMEBUFFER,
+		AG_WM_SINGLE,
+		0,
+		MEMFB_Open,
+		MEMFB_Close,
+		MEMFB_GetDisplaySize,
+		NULL,				/* beginEventProcessing */
+		MEMFB_PendingEvents,
+		MEMFB_GetNextEvent,
+		MEMFB_ProcessEvent,
+		NULL,				/* genericEventLoop */
+		NULL,				/* endEventProcessing */
+		NULL,				/* terminate */
+		MEMFB_BeginRendering,
+		MEMFB_RenderWindow,
+		MEMFB_EndRendering,
+		MEMFB_FillRect,
+		MEMFB_UpdateRegion,
+		NULL,				/* uploadTexture */
+		MEMFB_UpdateTexture,
+		MEMFB_DeleteTexture,
+		MEMFB_SetRefreshRate,
+		MEMFB_PushClipRect,
+		MEMFB_PopClipRect,
+		MEMFB_PushBlendingMode,
+		MEMFB_PopBlendingMode,
+		MEMFB_CreateCursor,
+		MEMFB_FreeCursor,
+		MEMFB_SetCursor,
+		MEMFB_UnsetCursor,
+		MEMFB_GetCursorVisibility,
+		MEMFB_SetCursorVisibility,
+		MEMFB_BlitSurface,
+		MEMFB_BlitSurfaceFrom,
+#ifdef HAVE_OPENGL
+		MEMFB_BlitSurfaceGL,
+		MEMFB_BlitSurfaceFromGL,
+		MEMFB_BlitSurfaceFlippedGL,
+#endif
+		NULL,				/* backupSurfaces */
+		NULL,				/* restoreSurfaces */
+		MEMFB_RenderToSurface,
+		MEMFB_PutPixel,
+		MEMFB_PutPixel32,
+		MEMFB_PutPixelRGB8,
+#if AG_MODEL == AG_LARGE
+		MEMFB_PutPixel64,
+		MEMFB_PutPixelRGB16,
+#endif
+		MEMFB_BlendPixel,
+		MEMFB_DrawLine,
+		MEMFB_DrawLineH,
+		MEMFB_DrawLineV,
+		MEMFB_DrawLineBlended,
+		MEMFB_DrawLineW,
+		MEMFB_DrawLineW_Sti16,
+		MEMFB_DrawTriangle,
+		MEMFB_DrawPolygon,
+		MEMFB_DrawPolygon_Sti32,
+		MEMFB_DrawArrow,
+		MEMFB_DrawBoxRounded,
+		MEMFB_DrawBoxRoundedTop,
+		MEMFB_DrawCircle,
+		MEMFB_DrawCircleFilled,
+		MEMFB_DrawRectFilled,
+		MEMFB_DrawRectBlended,
+		MEMFB_DrawRectDithered,
+		MEMFB_UpdateGlyph,
+		MEMFB_DrawGlyph,
+		NULL,				/* deleteList */
+		NULL,				/* getClipboardText */
+		NULL,				/* setClipboardText */
+		NULL				/* setMouseAutoCapture */
+	},
+	0,
+	MEMFB_OpenVideo,
+	MEMFB_OpenVideoContext,
+	MEMFB_SetVideoContext,
+	MEMFB_CloseVideo,
+	MEMFB_VideoResize,
+	MEMFB_VideoCapture,
+	MEMFB_VideoClear
+};
@@ -0,0 +1,52 @@
+/*	Public domain	*/
+
+/*
+ * Single-window driver rendering to an in-memory framebuffer surface.
+ */
+
+#ifndef _AGAR_GUI_DRV_MEMFB_H_
+#define _AGAR_GUI_DRV_MEMFB_H_
+
+#include <agar/gui/drv.h>
+
+#include <agar/gui/begin.h>
+
+#ifndef AG_DRIVER_MEMFB_DAMAGE_MAX
+#define AG_DRIVER_MEMFB_DAMAGE_MAX 64	/* Maximum damage list length */
+#endif
+
+typedef struct ag_driver_memfb {
+	struct ag_driver_sw _inherit;	/* AG_Driver -> AG_DriverSw */
+
+	AG_Surface *_Nullable S;	/* Framebuffer surface */
+
+	AG_ClipRect *_Nullable clipRects;  /* Clipping rectangle stack */
+	Uint                  nClipRects;
+
+	Uint nDamage;			/* Regions updated since last clear */
+	AG_Rect damage[AG_DRIVER_MEMFB_DAMAGE_MAX];
+
+	Uint nFrames;			/* Frames rendered (with updates) */
+	Uint nFrameDamage;		/* Regions updated in this frame */
+
+	Uint           nPolyInts;
+	int  *_Nullable polyInts;	/* Sorted intersections for drawPolygon */
+
+	char *_Nullable dumpPath;	/* Dump frames to PNG ("dump" option) */
+	int cursorVisible;		/* Cursor visibility flag */
+	Uint32 _pad;
+} AG_DriverMemFB;
+
+#define AGDRIVERMEMFB(o) ((AG_DriverMemFB *)(o))
+
+__BEGIN_DECLS
+extern AG_DriverSwClass agDriverMemFB;
+
+AG_Surface *_Nullable AG_DriverMemFBGetSurface(void *_Nonnull);
+const AG_Rect *_Nonnull AG_DriverMemFBGetDamage(void *_Nonnull, Uint *_Nonnull);
+void AG_DriverMemFBClearDamage(void *_Nonnull);
+int  AG_DriverMemFBExportPNG(void *_Nonnull, const char *_Nonnull);
+__END_DECLS
+
+#include <agar/gui/close.h>
+#endif /* _AGAR_GUI_DRV_MEMFB_H_ */
@@ -1539,8 +1539,13 @@ SDL2FB_DrawGlyph(void *_Nonnull drv, const AG_Glyph *_Nonnull G, int x, int y)
 {
 	AG_DriverSDL2FB *sfb = drv;
 	SDL_Surface *Swin = SDL_GetWindowSurface(sfb->window);
-	
-	AG_SDL2_BlitSurface(G->su, NULL, Swin, x,y);
+	AG_Rect r;
+
+	r.x = 0;
+	r.y = 0;
+	r.w = G->rs.w;
+	r.h = G->rs.h;
+	AG_SDL2_BlitSurface(AG_TextGlyphSurface(drv, G), &r, Swin, x,y);
 }
 
 /* Initialize the clipping rectangle stack. */
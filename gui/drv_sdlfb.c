@@ -1519,8 +1519,13 @@ static void
 SDLFB_DrawGlyph(void *_Nonnull drv, const AG_Glyph *_Nonnull G, int x, int y)
 {
 	AG_DriverSDLFB *sfb = drv;
-	
-	AG_SDL_BlitSurface(G->su, NULL, sfb->s, x,y);
+	AG_Rect r;
+
+	r.x = 0;
+	r.y = 0;
+	r.w = G->rs.w;
+	r.h = G->rs.h;
+	AG_SDL_BlitSurface(AG_TextGlyphSurface(drv, G), &r, sfb->s, x,y);
 }
 
 /* Initialize the clipping rectangle stack. */
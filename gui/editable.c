@@ -871,7 +871,7 @@ AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
 
 				if (ON_LINE(yMouse,y) &&
 				    mx >= x &&
-				    mx <= x + G->su->w) {
+				    mx <= x + G->rs.w) {
 					*pos = i;
 					if (buf->s[*pos]   == 0x1b &&
 					    buf->s[*pos+1] >= 0x40 &&
@@ -883,7 +883,7 @@ AG_EditableMapPosition(AG_Editable *ed, AG_EditableBuffer *buf, int mx, int my,
 					}
 					goto out;
 				}
-				x += G->su->w;
+				x += G->rs.w;
 			}
 			break;
 		case AG_FONT_DUMMY:
@@ -1151,7 +1151,7 @@ Draw(void *_Nonnull obj)
 		if (selected) {
 			r.x = x - ed->x;
 			r.y = y + 1;
-			r.w = G->su->w + 1;
+			r.w = G->rs.w + 1;
 			r.h = lineSkip + 1;
 			/* TODO queue and combine rectangles */
 			AG_DrawRectFilled(ed, &r, cSel);
@@ -1062,7 +1062,7 @@ AG_FileDlgSelectType(AG_FileDlg *fd, AG_FileType *ft)
 	}
 	AG_SetFontSize(fd->optsCtr, "90%");
 
-	WIDGET(fd)->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(fd);
 	AG_Redraw(fd);
 }
 
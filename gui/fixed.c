@@ -149,7 +149,7 @@ static __inline__ void
 UpdateWindow(AG_Fixed *_Nonnull fx)
 {
 	if (!(fx->flags & AG_FIXED_NO_UPDATE))
-		WIDGET(fx)->flags |= AG_WIDGET_UPDATE_WINDOW;
+		AG_WidgetUpdate(fx);
 }
 
 /*
@@ -1291,7 +1291,7 @@ static void
 GetGlyphMetrics(void *_Nonnull obj, AG_Glyph *G)
 {
 	/* Populate the advance field (for AG_TextRenderGlyph()). */
-	G->advance = G->su->w;
+	G->advance = G->rs.w;
 }
 
 static void
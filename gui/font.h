@@ -31,6 +31,12 @@ enum ag_font_spec_source {
 #ifndef AG_GLYPH_NBUCKETS             /* Bucket count for glyph cache */
 #define AG_GLYPH_NBUCKETS (AG_MODEL * 8)
 #endif
+#ifndef AG_GLYPH_PAGE_SIZE            /* Glyph atlas page size (px, power of 2) */
+#define AG_GLYPH_PAGE_SIZE (AG_MODEL * 8)
+#endif
+#ifndef AG_GLYPH_CACHE_BUDGET         /* Default glyph cache budget (bytes) */
+#define AG_GLYPH_CACHE_BUDGET (AG_MODEL * AG_MODEL * 2048)
+#endif
 
 /* Generic font specification. */
 typedef struct ag_font_spec {
@@ -79,27 +85,62 @@ typedef struct ag_font_style_sort {
 } AG_FontStyleSort;
 
 /*
- * Cached rendering of a glyph of a given font and BG/FG color. This cache is
- * used by widgets which require per-glyph metrics such as AG_Editable(3).
- * For drivers which support hardware textures, the rendered glyph may be
- * associated with a generated texture and texture coordinates.
+ * Cached rendering of a glyph of a given font. This cache is used by widgets
+ * which require per-glyph metrics such as AG_Editable(3). Glyphs are packed
+ * into shared atlas pages and rendered in white over a transparent
+ * background, so a single rendering serves all colors: the colors of the
+ * last AG_TextRenderGlyph() request are applied by the driver at draw time.
+ * For drivers which support hardware textures, each page may be associated
+ * with a texture and the glyph with texture coordinates into it.
  */
 typedef struct ag_glyph {
 	struct ag_font *_Nonnull font;       /* Font face */
-	AG_Color colorBG;                    /* Background color */
-	AG_Color color;                      /* Foreground color */
-	AG_Surface *_Nonnull su;             /* Rendered surface */
+	AG_Color colorBG;                    /* Background color (to draw) */
+	AG_Color color;                      /* Foreground color (to draw) */
+	AG_Surface *_Nonnull su;             /* Atlas page surface */
+	struct ag_glyph_page *_Nonnull page; /* Atlas page */
+	AG_Rect rs;                          /* Glyph rectangle in page */
 	AG_Char ch;                          /* Native character */
 	int advance;                         /* Advance (px) */
 	Uint texture;                        /* Driver-specific texture ID */
+	Uint flags;
+#define AG_GLYPH_NO_TINT 0x01                /* Draw pixels as rendered */
 	AG_TexCoord texcoords;               /* Mapped texture coordinates */
-	Uint32 _pad1;
-	AG_SLIST_ENTRY(ag_glyph) glyphs;     /* Entry in glyph cache */
+	AG_LIST_ENTRY(ag_glyph) glyphs;      /* Entry in glyph cache bucket */
+	AG_SLIST_ENTRY(ag_glyph) pglyphs;    /* Entry in atlas page */
 } AG_Glyph;
 
+/* Row of glyphs in an atlas page. */
+typedef struct ag_glyph_shelf {
+	Uint16 x;                            /* Next free column */
+	Uint16 y;                            /* Top of shelf */
+	Uint16 h;                            /* Height of shelf */
+	Uint16 _pad;
+} AG_GlyphShelf;
+
+/* Glyph atlas page (a surface shared by many glyphs). */
+typedef struct ag_glyph_page {
+	AG_Surface *_Nonnull S;              /* Page surface */
+	AG_GlyphShelf *_Nullable shelves;    /* Allocated shelves */
+	Uint nShelves;
+	int yFree;                           /* Top of unallocated area */
+	Uint nGlyphs;                        /* Number of glyphs in page */
+	Uint texture;                        /* Driver-specific texture ID */
+	AG_SLIST_HEAD_(ag_glyph) glyphs;     /* Glyphs in this page */
+	AG_TAILQ_ENTRY(ag_glyph_page) pages; /* Entry in glyph cache */
+} AG_GlyphPage;
+
 /* Cache of rendered glyphs (usually driver-managed). */
 typedef struct ag_glyph_cache {
-	AG_SLIST_HEAD_(ag_glyph) glyphs;      /* Cached glyph list */
+	AG_Size budget;                      /* Page memory limit (0 = none) */
+	AG_Size size;                        /* Page memory in use (bytes) */
+	Uint nPages;                         /* Number of atlas pages */
+	Uint nGlyphs;                        /* Number of cached glyphs */
+	Uint nEvictions;                     /* Pages evicted so far */
+	Uint32 _pad;
+	AG_TAILQ_HEAD(ag_glyph_pageq, ag_glyph_page) pages; /* MRU first */
+	AG_Surface *_Nullable tint;          /* For AG_TextGlyphSurface() */
+	AG_LIST_HEAD_(ag_glyph) buckets[AG_GLYPH_NBUCKETS];
 } AG_GlyphCache;
 
 /* Font object instance */
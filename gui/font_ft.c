@@ -269,16 +269,39 @@ fail:
 	return (-1);
 }
 
+/* Free the renderings of a glyph (keeping its metrics). */
 static void
-FlushGlyph(AG_GlyphFt *_Nonnull G)
+FlushGlyphRenderings(AG_FontFt *_Nonnull fontFt, AG_GlyphFt *_Nonnull G)
 {
-	G->stored = 0;
-	G->index = 0;
+	if (!(G->stored & (AG_GLYPH_FT_BITMAP | AG_GLYPH_FT_PIXMAP))) {
+		return;
+	}
+	TAILQ_REMOVE(&fontFt->rendered, G, rendered);
 	Free(G->bitmap.buffer);
 	G->bitmap.buffer = NULL;
 	Free(G->pixmap.buffer);
 	G->pixmap.buffer = NULL;
-	G->cached = 0;
+	fontFt->bitmapSize -= G->size;
+	G->size = 0;
+	G->stored &= ~(AG_GLYPH_FT_BITMAP | AG_GLYPH_FT_PIXMAP);
+}
+
+/* Remove a glyph from the cache and free it. */
+static void
+FlushGlyph(AG_FontFt *_Nonnull fontFt, AG_GlyphFt *_Nonnull G)
+{
+	AG_GlyphFt **pG;
+
+	FlushGlyphRenderings(fontFt, G);
+
+	for (pG = &fontFt->buckets[G->cached & (fontFt->nBuckets - 1)];
+	     *pG != G;
+	     pG = &(*pG)->next)
+		;;
+	*pG = G->next;
+	TAILQ_REMOVE(&fontFt->glyphs, G, glyphs);
+	fontFt->nGlyphs--;
+	Free(G);
 }
 
 /* Flush the entire glyph cache. */
@@ -286,17 +309,90 @@ static void
 FlushCache(void *_Nonnull obj)
 {
 	AG_FontFt *fontFt = obj;
-	const int size = sizeof(fontFt->cache) / sizeof(fontFt->cache[0]);
-	int i;
+	AG_GlyphFt *G;
 
-	for (i = 0; i < size; i++) {
-		AG_GlyphFt *G = &fontFt->cache[i];
+	while ((G = TAILQ_FIRST(&fontFt->glyphs)) != NULL) {
+		FlushGlyph(fontFt, G);
+	}
+	Free(fontFt->buckets);
+	fontFt->buckets = NULL;
+	fontFt->nBuckets = 0;
+}
 
-		if (G->cached)
-			FlushGlyph(G);
+/* Double the size of the glyph hash table. */
+static void
+GrowCache(AG_FontFt *_Nonnull fontFt)
+{
+	const Uint nBucketsNew = (fontFt->nBuckets != 0) ?
+	                         (fontFt->nBuckets << 1) : 256;
+	AG_GlyphFt **bucketsNew;
+	AG_GlyphFt *G;
+	Uint i;
+
+	bucketsNew = Malloc(nBucketsNew * sizeof(AG_GlyphFt *));
+	for (i = 0; i < nBucketsNew; i++) {
+		bucketsNew[i] = NULL;
+	}
+	TAILQ_FOREACH(G, &fontFt->glyphs, glyphs) {
+		const Uint h = G->cached & (nBucketsNew - 1);
+
+		G->next = bucketsNew[h];
+		bucketsNew[h] = G;
+	}
+	Free(fontFt->buckets);
+	fontFt->buckets = bucketsNew;
+	fontFt->nBuckets = nBucketsNew;
+}
+
+/*
+ * Return a new, empty cache entry for character ch. Evict the least
+ * recently used glyph if the cache is full.
+ */
+static AG_GlyphFt *_Nonnull
+InsertGlyph(AG_FontFt *_Nonnull fontFt, AG_Char ch)
+{
+	AG_GlyphFt *G;
+	Uint h;
+
+	if (fontFt->nGlyphs >= AG_FONTFT_GLYPHS_MAX) {
+		FlushGlyph(fontFt, TAILQ_LAST(&fontFt->glyphs, ag_glyph_ftq));
+		fontFt->nEvictions++;
+	} else if (fontFt->nGlyphs >= fontFt->nBuckets) {
+		GrowCache(fontFt);
+	}
+	G = Malloc(sizeof(AG_GlyphFt));
+	memset(G, 0, sizeof(AG_GlyphFt));
+	G->cached = ch;
+
+	h = ch & (fontFt->nBuckets - 1);
+	G->next = fontFt->buckets[h];
+	fontFt->buckets[h] = G;
+	TAILQ_INSERT_HEAD(&fontFt->glyphs, G, glyphs);
+	fontFt->nGlyphs++;
+	return (G);
+}
+
+/*
+ * Account for the renderings of G (which were just added) and free the
+ * renderings of least recently used glyphs as needed.
+ */
+static void
+AddGlyphRenderings(AG_FontFt *_Nonnull fontFt, AG_GlyphFt *_Nonnull G,
+    Uint size, int wasRendered)
+{
+	AG_GlyphFt *Glru;
+
+	if (!wasRendered) {
+		TAILQ_INSERT_HEAD(&fontFt->rendered, G, rendered);
+	}
+	G->size += size;
+	fontFt->bitmapSize += size;
+
+	while (fontFt->bitmapSize > AG_FONTFT_BITMAPS_MAX &&
+	       (Glru = TAILQ_LAST(&fontFt->rendered, ag_glyph_ft_rq)) != G) {
+		FlushGlyphRenderings(fontFt, Glru);
+		fontFt->nEvictions++;
 	}
-	if (fontFt->scratch.cached)
-		FlushGlyph(&fontFt->scratch);
 }
 
 static void
@@ -364,22 +460,34 @@ GetGlyph(void *_Nonnull obj, AG_Char ch, Uint want)
 	FT_Glyph_Metrics *Gmetrics;
 	FT_Error rv;
 
-#ifdef AG_UNICODE
-	if (ch < 256) {
-#else
-	if (1) {
-#endif
-		fontFt->current = &fontFt->cache[ch];
+	if (fontFt->buckets != NULL) {
+		for (G = fontFt->buckets[ch & (fontFt->nBuckets - 1)];
+		     G != NULL;
+		     G = G->next) {
+			if (G->cached == ch)
+				break;
+		}
 	} else {
-		if (fontFt->scratch.cached != ch) {
-			FlushGlyph(&fontFt->scratch);
+		G = NULL;
+	}
+	if (G != NULL) {
+		if (G != TAILQ_FIRST(&fontFt->glyphs)) {
+			TAILQ_REMOVE(&fontFt->glyphs, G, glyphs);
+			TAILQ_INSERT_HEAD(&fontFt->glyphs, G, glyphs);
+		}
+		if ((G->stored & (AG_GLYPH_FT_BITMAP | AG_GLYPH_FT_PIXMAP)) &&
+		    G != TAILQ_FIRST(&fontFt->rendered)) {
+			TAILQ_REMOVE(&fontFt->rendered, G, rendered);
+			TAILQ_INSERT_HEAD(&fontFt->rendered, G, rendered);
+		}
+		if ((G->stored & want) == want) {
+			fontFt->nHits++;
+			return (void *)(G);
 		}
-		fontFt->current = &fontFt->scratch;
+	} else {
+		G = InsertGlyph(fontFt, ch);
 	}
-	G = fontFt->current;
-
-	if ((G->stored & want) == want) 
-		return (void *)(G);
+	fontFt->nMisses++;
 
 	if (G->index == 0) {
 		G->index = FT_Get_Char_Index(face, ch);
@@ -428,6 +536,9 @@ GetGlyph(void *_Nonnull obj, AG_Char ch, Uint want)
 	    ((want & AG_GLYPH_FT_PIXMAP) && !(G->stored & AG_GLYPH_FT_PIXMAP))) {
 		FT_Bitmap *src, *dst;
 	    	const int wantMono = (want & AG_GLYPH_FT_BITMAP);
+		const int wasRendered = (G->stored & (AG_GLYPH_FT_BITMAP |
+		                                      AG_GLYPH_FT_PIXMAP));
+		Uint size = 0;
 
 		/* Render the glyph. */
 		if (FT_Render_Glyph(Gslot, wantMono ? FT_RENDER_MODE_MONO :
@@ -451,6 +562,7 @@ GetGlyph(void *_Nonnull obj, AG_Char ch, Uint want)
 		if (wantMono || !FT_IS_SCALABLE(face))
 			dst->pitch <<= 3;
 
+		dst->buffer = NULL;
 		if (dst->rows != 0) {
 			const AG_Size bufferSize = (dst->pitch * dst->rows);
 			int i;
@@ -458,6 +570,7 @@ GetGlyph(void *_Nonnull obj, AG_Char ch, Uint want)
 			if ((dst->buffer = TryMalloc(bufferSize)) == NULL) {
 				return (NULL);
 			}
+			size = (Uint)bufferSize;
 			memset(dst->buffer, 0, bufferSize);
 
 			for (i = 0; i < src->rows; i++) {
@@ -498,8 +611,8 @@ GetGlyph(void *_Nonnull obj, AG_Char ch, Uint want)
 		} else {
 			G->stored |= AG_GLYPH_FT_PIXMAP;     /* Gray levels */
 		}
+		AddGlyphRenderings(fontFt, G, size, wasRendered);
 	}
-	G->cached = ch;                           /* Mark this glyph cached */
 	return (G);
 }
 
@@ -512,7 +625,7 @@ GetGlyphMetrics(void *_Nonnull obj, AG_Glyph *G)
 	if ((Gft = GetGlyph(font, G->ch, AG_GLYPH_FT_METRICS)) != NULL) {
 		G->advance = Gft->advance;
 	} else {
-		G->advance = G->su->w;                          /* Fallback */
+		G->advance = G->rs.w;                           /* Fallback */
 	}
 }
 
@@ -919,10 +1032,17 @@ Init(void *_Nonnull obj)
 {
 	AG_FontFt *font = obj;
 
-	memset(&font->current, 0, sizeof(AG_GlyphFt *) +   /* current */
-	                          sizeof(AG_GlyphFt)*256 + /* cache */
-	                          sizeof(AG_GlyphFt) +     /* scratch */
-	                          sizeof(int));            /* fixedSize */
+	font->buckets = NULL;
+	font->nBuckets = 0;
+	font->nGlyphs = 0;
+	font->bitmapSize = 0;
+	font->nHits = 0;
+	font->nMisses = 0;
+	font->nEvictions = 0;
+	font->fixedSize = 0;
+	font->_pad = 0;
+	TAILQ_INIT(&font->glyphs);
+	TAILQ_INIT(&font->rendered);
 }
 
 AG_FontClass agFontFtClass = {
@@ -12,6 +12,13 @@
 
 #include <agar/gui/begin.h>
 
+#ifndef AG_FONTFT_GLYPHS_MAX          /* Maximum number of cached glyphs */
+#define AG_FONTFT_GLYPHS_MAX (AG_MODEL * 128)
+#endif
+#ifndef AG_FONTFT_BITMAPS_MAX         /* Maximum memory for cached bitmaps */
+#define AG_FONTFT_BITMAPS_MAX (AG_MODEL * 16384)
+#endif
+
 /* Cached glyph */
 typedef struct ag_glyph_ft {
 	Uint stored;                   /* Which resources are stored */
@@ -25,19 +32,33 @@ typedef struct ag_glyph_ft {
 	int yMin, yMax;                /* Bounding box Y */
 	int yOffset;                   /* (ascent - yMax) */
 	int advance;                   /* Horizontal advance */
+	Uint size;                     /* Bitmap + pixmap size (bytes) */
 	AG_Char cached;                /* Cached character */
-	AG_CHAR_PADDING(_pad);
+	struct ag_glyph_ft *_Nullable next;    /* Next in hash bucket */
+	AG_TAILQ_ENTRY(ag_glyph_ft) glyphs;    /* Entry in glyph LRU */
+	AG_TAILQ_ENTRY(ag_glyph_ft) rendered;  /* Entry in bitmap LRU */
 } AG_GlyphFt;
 
-/* FreeType font */
+/*
+ * FreeType font. Glyphs are cached in a hash table keyed by character.
+ * Metrics are kept for up to AG_FONTFT_GLYPHS_MAX glyphs, and renderings
+ * (bitmaps and pixmaps) for as many of them as fit in AG_FONTFT_BITMAPS_MAX
+ * bytes. Both are evicted in least recently used order.
+ */
 typedef struct ag_font_ft {
 	AG_Font _inherit;              /* AG_Font -> AG_FontFt */
 	_Nonnull FT_Face face;         /* Typographical font face handle */
-	AG_GlyphFt *_Nonnull current;
-	AG_GlyphFt cache[256];         /* Transform cache */
-	AG_GlyphFt scratch;
+	AG_GlyphFt *_Nullable *_Nullable buckets;  /* Glyph hash table */
+	Uint nBuckets;                 /* Hash table size (power of 2) */
+	Uint nGlyphs;                  /* Number of cached glyphs */
+	AG_Size bitmapSize;            /* Memory used by renderings (bytes) */
+	Uint64 nHits;                  /* Requests served from the cache */
+	Uint64 nMisses;                /* Requests which loaded the glyph */
+	Uint64 nEvictions;             /* Glyphs or renderings evicted */
 	int fixedSize;                 /* For non-scalable formats */
 	Uint32 _pad;
+	AG_TAILQ_HEAD(ag_glyph_ftq, ag_glyph_ft) glyphs;    /* MRU first */
+	AG_TAILQ_HEAD(ag_glyph_ft_rq, ag_glyph_ft) rendered; /* MRU first */
 } AG_FontFt;
 
 #define   AGFONTFT(o)      ((AG_FontFt *)(o))
@@ -224,6 +224,8 @@ ag_widget_update(void *obj)
 	AG_ObjectLock(wid);
 
 	wid->flags |= AG_WIDGET_UPDATE_WINDOW;
+	if (wid->window != NULL)
+		((AG_Widget *)wid->window)->flags |= AG_WIDGET_UPDATE_WINDOW;
 
 	AG_ObjectUnlock(wid);
 }
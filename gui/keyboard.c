@@ -332,6 +332,10 @@ static const struct {
 static const Uint agKeyNameTblSize = sizeof(agKeyNameTbl) /
                                      sizeof(agKeyNameTbl[0]);
 
+/* Interned event names (see AG_PostEventByAtom(3)) */
+static AG_EventAtom atomKeyUp = 0;
+static AG_EventAtom atomKeyDown = 0;
+
 AG_Keyboard *
 AG_KeyboardNew(void *drv, const char *desc)
 {
@@ -344,6 +348,10 @@ AG_KeyboardNew(void *drv, const char *desc)
 	}
 	AG_ObjectInit(kbd, &agKeyboardClass);
 	AGINPUTDEVICE(kbd)->drv = drv;
+
+	atomKeyUp = AG_GetEventAtom("key-up");
+	atomKeyDown = AG_GetEventAtom("key-down");
+
 	if ((AGINPUTDEVICE(kbd)->desc = TryStrdup(desc)) == NULL) {
 		goto fail;
 	}
@@ -458,10 +466,12 @@ PostUnfocusedKeyUp(AG_Widget *_Nonnull wid, AG_KeySym ks, AG_KeyMod kmod,
 			WIDGET_OPS(wid)->key_up(wid, ks, kmod, ch);
 		} else {
 #ifdef AG_UNICODE
-			AG_PostEvent(wid,  "key-up", "%i(key),%i(mod),%lu(ch)",
+			AG_PostEventByAtom(wid, atomKeyUp,
+			    "%i(key),%i(mod),%lu(ch)",
 			    (int)ks, (int)kmod, (Ulong)ch);
 #else
-			AG_PostEvent(wid,  "key-up", "%i(key),%i(mod),%u(ch)",
+			AG_PostEventByAtom(wid, atomKeyUp,
+			    "%i(key),%i(mod),%u(ch)",
 			    (int)ks, (int)kmod, (Uint)ch);
 #endif
 		}
@@ -487,10 +497,12 @@ PostUnfocusedKeyDown(AG_Widget *_Nonnull wid, AG_KeySym ks, AG_KeyMod kmod,
 			WIDGET_OPS(wid)->key_down(wid, ks, kmod, ch);
 		} else {
 #ifdef AG_UNICODE
-			AG_PostEvent(wid,  "key-down", "%i(key),%i(mod),%lu(ch)",
+			AG_PostEventByAtom(wid, atomKeyDown,
+			    "%i(key),%i(mod),%lu(ch)",
 			    (int)ks, (int)kmod, (Ulong)ch);
 #else
-			AG_PostEvent(wid,  "key-down", "%i(key),%i(mod),%u(ch)",
+			AG_PostEventByAtom(wid, atomKeyDown,
+			    "%i(key),%i(mod),%u(ch)",
 			    (int)ks, (int)kmod, (Uint)ch);
 #endif
 		}
@@ -554,11 +566,11 @@ AG_ProcessKey(AG_Keyboard *kbd, AG_Window *win, AG_KeyboardAction action,
 					    modState, ch);
 				} else {
 #ifdef AG_UNICODE
-					AG_PostEvent(wFoc, "key-up",
+					AG_PostEventByAtom(wFoc, atomKeyUp,
 					    "%i(key),%i(mod),%lu(ch)",
 					    (int)ks, (int)modState, (Ulong)ch);
 #else
-					AG_PostEvent(wFoc, "key-up",
+					AG_PostEventByAtom(wFoc, atomKeyUp,
 					    "%i(key),%i(mod),%u(ch)",
 					    (int)ks, (int)modState, (Uint)ch);
 #endif
@@ -569,11 +581,11 @@ AG_ProcessKey(AG_Keyboard *kbd, AG_Window *win, AG_KeyboardAction action,
 					    ks, modState, ch);
 				} else {
 #ifdef AG_UNICODE
-					AG_PostEvent(wFoc, "key-down",
+					AG_PostEventByAtom(wFoc, atomKeyDown,
 					    "%i(key),%i(mod),%lu(ch)",
 					    (int)ks, (int)modState, (Ulong)ch);
 #else
-					AG_PostEvent(wFoc, "key-down",
+					AG_PostEventByAtom(wFoc, atomKeyDown,
 					    "%i(key),%i(mod),%u(ch)",
 					    (int)ks, (int)modState, (Uint)ch);
 #endif
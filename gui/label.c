@@ -48,6 +48,16 @@
 static void DrawStatic(AG_Label *_Nonnull);
 static void DrawPolled(AG_Label *_Nonnull);
 
+/*
+ * Return the text cache of a polled label. Polled labels share the text
+ * cache of their window (or have none if not attached to a window).
+ */
+static __inline__ AG_TextCache *_Nullable
+PolledTextCache(AG_Label *_Nonnull lbl)
+{
+	return (WIDGET(lbl)->window != NULL) ? AG_TextCacheGetShared(lbl) : NULL;
+}
+
 /* Create a new polled (dynamically updated) label. */
 AG_Label *
 AG_LabelNewPolled(void *parent, Uint flags, const char *fmt, ...)
@@ -57,11 +67,10 @@ AG_LabelNewPolled(void *parent, Uint flags, const char *fmt, ...)
 	va_list ap;
 	const char *p;
 	
-	lbl = Malloc(sizeof(AG_Label));
+	lbl = AG_ObjectAlloc(&agLabelClass);
 	AG_ObjectInit(lbl, &agLabelClass);
 
 	lbl->type = AG_LABEL_POLLED;
-	lbl->tCache = AG_TextCacheNew(lbl, 32, 4);
 	lbl->pollBufSize = AG_FMTSTRING_BUFFER_INIT;
 	lbl->pollBuf = Malloc(lbl->pollBufSize);
 
@@ -72,6 +81,7 @@ AG_LabelNewPolled(void *parent, Uint flags, const char *fmt, ...)
 	/* Build the format string */
 	fs = lbl->fmt = Malloc(sizeof(AG_FmtString));
 	fs->s = Strdup(fmt);
+	fs->prog = NULL;
 	fs->n = 0;
 	va_start(ap, fmt);
 	for (p = fmt; *p != '\0'; p++) {
@@ -111,11 +121,10 @@ AG_LabelNewPolledMT(void *parent, Uint flags, AG_Mutex *mu, const char *fmt, ...
 	va_list ap;
 	const char *p;
 	
-	lbl = Malloc(sizeof(AG_Label));
+	lbl = AG_ObjectAlloc(&agLabelClass);
 	AG_ObjectInit(lbl, &agLabelClass);
 
 	lbl->type = AG_LABEL_POLLED;
-	lbl->tCache = AG_TextCacheNew(lbl, 32, 4);
 	lbl->pollBufSize = AG_FMTSTRING_BUFFER_INIT;
 	lbl->pollBuf = Malloc(lbl->pollBufSize);
 
@@ -128,6 +137,7 @@ AG_LabelNewPolledMT(void *parent, Uint flags, AG_Mutex *mu, const char *fmt, ...
 		AG_FatalError(NULL);
 	}
 	fs->s = Strdup(fmt);
+	fs->prog = NULL;
 	fs->n = 0;
 	va_start(ap, fmt);
 	for (p = fmt; *p != '\0'; p++) {
@@ -165,7 +175,7 @@ AG_LabelNew(void *parent, Uint flags, const char *fmt, ...)
 	AG_Label *lbl;
 	va_list ap;
 
-	lbl = Malloc(sizeof(AG_Label));
+	lbl = AG_ObjectAlloc(&agLabelClass);
 	AG_ObjectInit(lbl, &agLabelClass);
 
 	lbl->type = AG_LABEL_STATIC;
@@ -192,7 +202,7 @@ AG_LabelNewS(void *parent, Uint flags, const char *text)
 {
 	AG_Label *lbl;
 	
-	lbl = Malloc(sizeof(AG_Label));
+	lbl = AG_ObjectAlloc(&agLabelClass);
 	AG_ObjectInit(lbl, &agLabelClass);
 
 	lbl->type = AG_LABEL_STATIC;
@@ -218,6 +228,7 @@ SizeRequest(void *_Nonnull obj, AG_SizeReq *_Nonnull r)
 		break;
 	case AG_LABEL_POLLED:
 		if (lbl->fmt->s && lbl->fmt->s[0] != '\0') {     /* Auto-size */
+			AG_TextCache *tc;
 			int sCached;
 
 			for (;;) {
@@ -240,8 +251,9 @@ SizeRequest(void *_Nonnull obj, AG_SizeReq *_Nonnull r)
 					break;
 				}
 			}
-			if ((sCached = AG_TextCacheGet(lbl->tCache, lbl->pollBuf)) != -1) {
-				const AG_Surface *S = WSURFACE(lbl,sCached);
+			if ((tc = PolledTextCache(lbl)) != NULL &&
+			    (sCached = AG_TextCacheGet(tc, lbl->pollBuf)) != -1) {
+				const AG_Surface *S = WSURFACE(tc->widget,sCached);
 
 				r->w = S->w;
 				r->h = S->h;
@@ -262,6 +274,7 @@ static int
 SizeAllocate(void *_Nonnull obj, const AG_SizeAlloc *_Nonnull a)
 {
 	AG_Label *lbl = obj;
+	AG_TextCache *tc;
 	int wLbl, hLbl, sCached;
 	
 	if (a->w < WIDGET(lbl)->paddingLeft + 1 + WIDGET(lbl)->paddingRight ||
@@ -304,8 +317,9 @@ SizeAllocate(void *_Nonnull obj, const AG_SizeAlloc *_Nonnull a)
 				break;
 			}
 		}
-		if ((sCached = AG_TextCacheGet(lbl->tCache, lbl->pollBuf)) != -1) {
-			const AG_Surface *S = WSURFACE(lbl,sCached);
+		if ((tc = PolledTextCache(lbl)) != NULL &&
+		    (sCached = AG_TextCacheGet(tc, lbl->pollBuf)) != -1) {
+			const AG_Surface *S = WSURFACE(tc->widget,sCached);
 
 			if (S->w > a->w || S->h > a->h) {
 				lbl->flags |=   AG_LABEL_PARTIAL;
@@ -559,6 +573,7 @@ DrawStatic(AG_Label *_Nonnull lbl)
 static void
 DrawPolled(AG_Label *_Nonnull lbl)
 {
+	AG_TextCache *tc;
 	char *pollBufNew;
 	AG_Size rv;
 	int sCached;
@@ -581,12 +596,13 @@ DrawPolled(AG_Label *_Nonnull lbl)
 		}
 	}
 
-	if ((sCached = AG_TextCacheGet(lbl->tCache,lbl->pollBuf)) != -1) {
-		const AG_Surface *S = WSURFACE(lbl,sCached);
+	if ((tc = PolledTextCache(lbl)) != NULL &&
+	    (sCached = AG_TextCacheGet(tc, lbl->pollBuf)) != -1) {
+		const AG_Surface *S = WSURFACE(tc->widget,sCached);
 		const int x = JustifyOffset(lbl, WIDTH(lbl), S->w);
 		const int y = ValignOffset(lbl, HEIGHT(lbl), S->h);
 
-		AG_WidgetBlitSurface(lbl, sCached, x,y);
+		AG_TextCacheBlit(tc, lbl, sCached, x,y);
 	}
 }
 
@@ -46,7 +46,7 @@ typedef struct ag_label {
 	enum ag_text_justify justify;   /* Justification mode */
 	enum ag_text_valign valign;     /* Vertical alignment */
 
-	struct ag_text_cache *_Nonnull tCache; /* Rendered text cache (POLLED) */
+	struct ag_text_cache *_Nullable tCache; /* Private text cache (or NULL) */
 	AG_FmtString *_Nullable fmt;           /* Polled label data */
 	char *_Nullable pollBuf;               /* Polled label buffer */
 	AG_Size         pollBufSize;
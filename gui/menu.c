@@ -52,7 +52,7 @@ AG_MenuNew(void *parent, Uint flags)
 {
 	AG_Menu *m;
 
-	m = Malloc(sizeof(AG_Menu));
+	m = AG_ObjectAlloc(&agMenuClass);
 	AG_ObjectInit(m, &agMenuClass);
 
 	if (flags & AG_MENU_HFILL) { WIDGET(m)->flags |= AG_WIDGET_HFILL; }
@@ -360,7 +360,7 @@ AG_MenuExpand(void *parent, AG_MenuItem *mi, int x1, int y1)
 	AG_AddEvent(win, "window-shown", OnWindowShown, "%p", m);
 	AG_AddEvent(win, "window-hidden", OnWindowHidden, "%p", m);
 	
-	mi->view = mv = Malloc(sizeof(AG_MenuView));
+	mi->view = mv = AG_ObjectAlloc(&agMenuViewClass);
 	AG_ObjectInit(mv, &agMenuViewClass);
 	mv->pmenu = m;
 	mv->pitem = mi;
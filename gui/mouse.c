@@ -40,6 +40,11 @@ static void PostMouseMotion(AG_Window *_Nonnull, AG_Widget *_Nonnull, int,int, i
 static void PostMouseButtonUp(AG_Window *_Nonnull, AG_Widget *_Nonnull, int,int, AG_MouseButton);
 static void PostMouseButtonDown(AG_Window *_Nonnull, AG_Widget *_Nonnull, int,int, AG_MouseButton);
 
+/* Interned event names (see AG_PostEventByAtom(3)) */
+static AG_EventAtom atomMouseMotion = 0;
+static AG_EventAtom atomMouseButtonUp = 0;
+static AG_EventAtom atomMouseButtonDown = 0;
+
 AG_Mouse *
 AG_MouseNew(void *drv, const char *desc)
 {
@@ -52,6 +57,11 @@ AG_MouseNew(void *drv, const char *desc)
 	}
 	AG_ObjectInit(ms, &agMouseClass);
 	AGINPUTDEVICE(ms)->drv = drv;
+
+	atomMouseMotion = AG_GetEventAtom("mouse-motion");
+	atomMouseButtonUp = AG_GetEventAtom("mouse-button-up");
+	atomMouseButtonDown = AG_GetEventAtom("mouse-button-down");
+
 	if ((AGINPUTDEVICE(ms)->desc = TryStrdup(desc)) == NULL) {
 		goto fail;
 	}
@@ -172,7 +182,7 @@ PostMouseMotion(AG_Window *_Nonnull win, AG_Widget *_Nonnull wid, int x, int y,
 		            y - wid->rView.y1,
 			    xRel, yRel);
 		}
-		AG_PostEvent(wid, "mouse-motion",
+		AG_PostEventByAtom(wid, atomMouseMotion,
 		    "%i(x),%i(y),%i(xRel),%i(yRel),%i(buttons)",
 		    x - wid->rView.x1,
 		    y - wid->rView.y1,
@@ -232,7 +242,7 @@ PostMouseButtonUp(AG_Window *_Nonnull win, AG_Widget *_Nonnull wid,
 		            x - wid->rView.x1,
 		            y - wid->rView.y1);
 		} else {
-			AG_PostEvent(wid, "mouse-button-up",
+			AG_PostEventByAtom(wid, atomMouseButtonUp,
 			    "%i(button),%i(x),%i(y)",
 			    (int)button,
 			    x - wid->rView.x1,
@@ -293,7 +303,6 @@ PostMouseButtonDown(AG_Window *_Nonnull win, AG_Widget *_Nonnull wid,
     int x, int y, AG_MouseButton button)
 {
 	AG_Widget *chld;
-	AG_Event *ev;
 	
 	AG_ObjectLock(wid);
 
@@ -314,16 +323,11 @@ PostMouseButtonDown(AG_Window *_Nonnull win, AG_Widget *_Nonnull wid,
 	            x - wid->rView.x1,
 	            y - wid->rView.y1);
 	} else {
-		TAILQ_FOREACH(ev, &OBJECT(wid)->events, events) {
-			if (strcmp(ev->name, "mouse-button-down") == 0)
-				break;
-		}
-		if (ev != NULL)
-			AG_PostEvent(wid, "mouse-button-down",
-			    "%i(button),%i(x),%i(y)",
-			    (int)button,
-			    x - wid->rView.x1,
-			    y - wid->rView.y1);
+		AG_PostEventByAtom(wid, atomMouseButtonDown,
+		    "%i(button),%i(x),%i(y)",
+		    (int)button,
+		    x - wid->rView.x1,
+		    y - wid->rView.y1);
 	}
 out:
 	AG_ObjectUnlock(wid);
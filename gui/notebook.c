@@ -515,7 +515,7 @@ AG_NotebookSelect(AG_Notebook *nb, AG_NotebookTab *tab)
 	AG_WidgetSizeAlloc(tab, &aTab);
 	AG_WidgetShowAll(tab);
 
-	WIDGET(nb)->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(nb);
 /* 	AG_WidgetFocus(tab); */
 out:
 	AG_Redraw(nb);
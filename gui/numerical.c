@@ -357,9 +357,9 @@ UpdateFromText(AG_Event *_Nonnull event)
 	void *value, *min, *max;
 	const char *inTxt = num->inTxt;
 
-	valueb = AG_GetVariable(num, "value", &value);
-	minb = AG_GetVariable(num, "min", &min);
-	maxb = AG_GetVariable(num, "max", &max);
+	valueb = AG_GetVariableCached(num, &num->hValue, &value);
+	minb = AG_GetVariableCached(num, &num->hMin, &min);
+	maxb = AG_GetVariableCached(num, &num->hMax, &max);
 
 	switch (AG_VARIABLE_TYPE(valueb)) {
 	case AG_VARIABLE_FLOAT:
@@ -493,7 +493,7 @@ AG_NumericalSetUnitSystem(AG_Numerical *num, const char *unitKey)
 
 	UpdateUnitSelector(num);
 
-	WIDGET(num)->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(num);
 	AG_ObjectUnlock(num);
 
 	return (0);
@@ -515,7 +515,7 @@ AG_NumericalUpdate(AG_Numerical *num)
 	if (!AG_Defined(num,"value")) {
 		return;
 	}
-	valueb = AG_GetVariable(num, "value", &value);
+	valueb = AG_GetVariableCached(num, &num->hValue, &value);
 	switch (AG_VARIABLE_TYPE(valueb)) {
 	case AG_VARIABLE_DOUBLE:
 		{
@@ -610,6 +610,10 @@ Init(void *_Nonnull obj)
 	num->wUnitSel = 0;
 	num->hUnitSel = 0;
 	num->wPreUnit = 0;
+	AG_InitVariableHandle(&num->hValue, "value");
+	AG_InitVariableHandle(&num->hMin, "min");
+	AG_InitVariableHandle(&num->hMax, "max");
+	AG_InitVariableHandle(&num->hInc, "inc");
 
 	/* Input textbox */
 	tb = num->input = AG_TextboxNewS(num, AG_TEXTBOX_EXCL, NULL);
@@ -759,10 +763,10 @@ AG_NumericalIncrement(AG_Numerical *num)
 	AG_OBJECT_ISA(num, "AG_Widget:AG_Numerical:*");
 	AG_ObjectLock(num);
 
-	valueb = AG_GetVariable(num, "value", &value);
-	minb = AG_GetVariable(num, "min", &min);
-	maxb = AG_GetVariable(num, "max", &max);
-	incb = AG_GetVariable(num, "inc", &inc);
+	valueb = AG_GetVariableCached(num, &num->hValue, &value);
+	minb = AG_GetVariableCached(num, &num->hMin, &min);
+	maxb = AG_GetVariableCached(num, &num->hMax, &max);
+	incb = AG_GetVariableCached(num, &num->hInc, &inc);
 
 	switch (AG_VARIABLE_TYPE(valueb)) {
 	case AG_VARIABLE_FLOAT:   ADD_REAL(float);   break;
@@ -823,10 +827,10 @@ AG_NumericalDecrement(AG_Numerical *num)
 	AG_OBJECT_ISA(num, "AG_Widget:AG_Numerical:*");
 	AG_ObjectLock(num);
 
-	valueb = AG_GetVariable(num, "value", &value);
-	minb = AG_GetVariable(num, "min", &min);
-	maxb = AG_GetVariable(num, "max", &max);
-	incb = AG_GetVariable(num, "inc", &inc);
+	valueb = AG_GetVariableCached(num, &num->hValue, &value);
+	minb = AG_GetVariableCached(num, &num->hMin, &min);
+	maxb = AG_GetVariableCached(num, &num->hMax, &max);
+	incb = AG_GetVariableCached(num, &num->hInc, &inc);
 
 	switch (AG_VARIABLE_TYPE(valueb)) {
 	case AG_VARIABLE_FLOAT:  SUB_REAL(float);  break;
@@ -931,7 +935,7 @@ AG_NumericalGetFlt(AG_Numerical *num)
 	AG_Variable *bValue;
 	void *value;
 
-	bValue = AG_GetVariable(num, "value", &value);
+	bValue = AG_GetVariableCached(num, &num->hValue, &value);
 
 	switch (AG_VARIABLE_TYPE(bValue)) {
 	case AG_VARIABLE_FLOAT:   return *(float *)value;
@@ -959,7 +963,7 @@ AG_NumericalGetDbl(AG_Numerical *num)
 	AG_Variable *bValue;
 	void *value;
 
-	bValue = AG_GetVariable(num, "value", &value);
+	bValue = AG_GetVariableCached(num, &num->hValue, &value);
 
 	switch (AG_VARIABLE_TYPE(bValue)) {
 	case AG_VARIABLE_FLOAT:   return (double)(*(float *)value);
@@ -987,7 +991,7 @@ AG_NumericalGetInt(AG_Numerical *num)
 	AG_Variable *bValue;
 	void *value;
 
-	bValue = AG_GetVariable(num, "value", &value);
+	bValue = AG_GetVariableCached(num, &num->hValue, &value);
 	switch (AG_VARIABLE_TYPE(bValue)) {
 	case AG_VARIABLE_FLOAT:   return (int)(*(float *)value);
 	case AG_VARIABLE_DOUBLE:  return (int)(*(double *)value);
@@ -1014,7 +1018,7 @@ AG_NumericalGetUint32(AG_Numerical *num)
 	AG_Variable *bValue;
 	void *value;
 
-	bValue = AG_GetVariable(num, "value", &value);
+	bValue = AG_GetVariableCached(num, &num->hValue, &value);
 
 	switch (AG_VARIABLE_TYPE(bValue)) {
 	case AG_VARIABLE_FLOAT:   return (Uint32)(*(float *)value);
@@ -1043,7 +1047,7 @@ AG_NumericalGetUint64(AG_Numerical *num)
 	AG_Variable *bValue;
 	void *value;
 
-	bValue = AG_GetVariable(num, "value", &value);
+	bValue = AG_GetVariableCached(num, &num->hValue, &value);
 
 	switch (AG_VARIABLE_TYPE(bValue)) {
 	case AG_VARIABLE_FLOAT:   return (Uint64)(*(float *)value);
@@ -44,6 +44,9 @@ typedef struct ag_numerical {
 	Uint32 _pad;
 	AG_Timer toUpdate;                   /* For refresh (not in EXCL mode) */
 	AG_Timer toInc, toDec;               /* For keyboard increment/decrement */
+	AG_VariableHandle hValue;            /* Cached "value" binding */
+	AG_VariableHandle hMin, hMax;        /* Cached range bindings */
+	AG_VariableHandle hInc;              /* Cached "inc" binding */
 } AG_Numerical;
 
 #define   AGNUMERICAL(obj)      ((AG_Numerical *)(obj))
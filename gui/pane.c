@@ -136,7 +136,7 @@ AG_PaneMoveDivider(AG_Pane *pa, int dx)
 		a.h = HEIGHT(pa);
 		AG_WidgetSizeAlloc(pa, &a);
 		rv = pa->dx;
-		WIDGET(pa)->flags |= AG_WIDGET_UPDATE_WINDOW;
+		AG_WidgetUpdate(pa);
 		pa->rx = rv;
 	}
 
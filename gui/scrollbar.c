@@ -87,7 +87,7 @@ AG_ScrollbarNew(void *parent, enum ag_scrollbar_type type, Uint flags)
 {
 	AG_Scrollbar *sb;
 
-	sb = Malloc(sizeof(AG_Scrollbar));
+	sb = AG_ObjectAlloc(&agScrollbarClass);
 	AG_ObjectInit(sb, &agScrollbarClass);
 
 	sb->type = type;
@@ -131,7 +131,7 @@ ScrollbarChanged(AG_Event *_Nonnull event)
 	AG_Scrollview *sv = AG_SCROLLVIEW_PTR(1);
 
 	PlaceWidgets(sv, NULL, NULL);                    /* Update clipping */
-	WIDGET(sv)->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(sv);
 	AG_Redraw(sv);
 }
 
@@ -158,7 +158,7 @@ MouseMotion(void *obj, int x, int y, int dx, int dy)
 	}
 
 	PlaceWidgets(sv, NULL, NULL);                    /* Update clipping */
-	WIDGET(sv)->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(sv);
 	AG_Redraw(sv);
 }
 
@@ -243,7 +243,7 @@ MouseButtonDown(void *obj, AG_MouseButton button, int x, int y)
 	}
 
 	PlaceWidgets(sv, NULL, NULL);                    /* Update clipping */
-	WIDGET(sv)->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(sv);
 	AG_Redraw(sv);
 }
 
@@ -186,9 +186,9 @@ GetPosition(AG_Slider *_Nonnull sl, int *_Nonnull x)
 	AG_Variable *bMin, *bMax, *bVal;
 	void *pMin, *pMax, *pVal;
 
-	bVal = AG_GetVariable(sl, "value", &pVal);
-	bMin = AG_GetVariable(sl, "min", &pMin);
-	bMax = AG_GetVariable(sl, "max", &pMax);
+	bVal = AG_GetVariableCached(sl, &sl->hValue, &pVal);
+	bMin = AG_GetVariableCached(sl, &sl->hMin, &pMin);
+	bMax = AG_GetVariableCached(sl, &sl->hMax, &pMax);
 
 	switch (AG_VARIABLE_TYPE(bVal)) {
 	case AG_VARIABLE_FLOAT:		GET_POSITION(float);		break;
@@ -239,9 +239,9 @@ SeekToPosition(AG_Slider *_Nonnull sl, int x)
 	AG_Variable *bMin, *bMax, *bVal;
 	void *pMin, *pMax, *pVal;
 
-	bVal = AG_GetVariable(sl, "value", &pVal);
-	bMin = AG_GetVariable(sl, "min", &pMin);
-	bMax = AG_GetVariable(sl, "max", &pMax);
+	bVal = AG_GetVariableCached(sl, &sl->hValue, &pVal);
+	bMin = AG_GetVariableCached(sl, &sl->hMin, &pMin);
+	bMax = AG_GetVariableCached(sl, &sl->hMax, &pMax);
 
 	switch (AG_VARIABLE_TYPE(bVal)) {
 	case AG_VARIABLE_FLOAT:		SEEK_TO_POSITION(float);	break;
@@ -291,10 +291,10 @@ Increment(AG_Slider *_Nonnull sl)
 	AG_Variable *bVal, *bMin, *bMax, *bInc;
 	void *pVal, *pMin, *pMax, *pInc;
 
-	bVal = AG_GetVariable(sl, "value", &pVal);
-	bMin = AG_GetVariable(sl, "min", &pMin);
-	bMax = AG_GetVariable(sl, "max", &pMax);
-	bInc = AG_GetVariable(sl, "inc", &pInc);
+	bVal = AG_GetVariableCached(sl, &sl->hValue, &pVal);
+	bMin = AG_GetVariableCached(sl, &sl->hMin, &pMin);
+	bMax = AG_GetVariableCached(sl, &sl->hMax, &pMax);
+	bInc = AG_GetVariableCached(sl, &sl->hInc, &pInc);
 
 	switch (AG_VARIABLE_TYPE(bVal)) {
 	case AG_VARIABLE_FLOAT:		INCREMENT(float);	break;
@@ -328,10 +328,10 @@ Decrement(AG_Slider *_Nonnull sl)
 	AG_Variable *bVal, *bMin, *bMax, *bInc;
 	void *pVal, *pMin, *pMax, *pInc;
 
-	bVal = AG_GetVariable(sl, "value", &pVal);
-	bMin = AG_GetVariable(sl, "min", &pMin);
-	bMax = AG_GetVariable(sl, "max", &pMax);
-	bInc = AG_GetVariable(sl, "inc", &pInc);
+	bVal = AG_GetVariableCached(sl, &sl->hValue, &pVal);
+	bMin = AG_GetVariableCached(sl, &sl->hMin, &pMin);
+	bMax = AG_GetVariableCached(sl, &sl->hMax, &pMax);
+	bInc = AG_GetVariableCached(sl, &sl->hInc, &pInc);
 
 	switch (AG_VARIABLE_TYPE(bVal)) {
 	case AG_VARIABLE_FLOAT:		DECREMENT(float);	break;
@@ -497,7 +497,7 @@ OnShow(AG_Event *_Nonnull event)
 	AG_Variable *V;
 	void *dummy;
 	
-	if ((V = AG_GetVariable(sl, "value", &dummy)) == NULL) {
+	if ((V = AG_GetVariableCached(sl, &sl->hValue, &dummy)) == NULL) {
 		V = AG_SetInt(sl, "value", 0);
 		AG_LockVariable(V);
 	}
@@ -549,6 +549,11 @@ Init(void *_Nonnull obj)
 	AG_SetEvent(sl, "widget-lostfocus", OnFocusLoss, NULL);
 
 	AG_InitTimer(&sl->moveTo, "move", 0);
+
+	AG_InitVariableHandle(&sl->hValue, "value");
+	AG_InitVariableHandle(&sl->hMin, "min");
+	AG_InitVariableHandle(&sl->hMax, "max");
+	AG_InitVariableHandle(&sl->hInc, "inc");
 }
 
 static void
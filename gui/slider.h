@@ -36,6 +36,9 @@ typedef struct ag_slider {
 	int xOffs;			/* Cursor offset for scrolling */
 	int extent;			/* Available area for scrolling */
 	AG_Timer moveTo;		/* Timer for keyboard motion */
+	AG_VariableHandle hValue;	/* Cached "value" binding */
+	AG_VariableHandle hMin, hMax;	/* Cached range bindings */
+	AG_VariableHandle hInc;		/* Cached "inc" binding */
 } AG_Slider;
 
 #define   AGSLIDER(o)        ((AG_Slider *)(o))
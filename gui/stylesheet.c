@@ -427,14 +427,14 @@ int
 AG_LookupStyleSheet(AG_StyleSheet *_Nonnull css, void *_Nonnull obj,
     const char *_Nonnull key, char *_Nonnull *_Nonnull rv)
 {
-	AG_ObjectClass **hier;
+	AG_ObjectClass *const *hier;
 	AG_StyleBlock *blk;
 	AG_StyleEntry *ent;
 	const char *clName;
 	const AG_Object *parent = OBJECT(obj)->parent;
 	int nHier;
 
-	if (AG_ObjectGetInheritHier(obj, &hier, &nHier) != 0) {
+	if (AG_ObjectGetInheritHierCached(obj, &hier, &nHier) != 0) {
 		return (0);
 	}
 	clName = hier[nHier - 1]->name;
@@ -564,9 +564,7 @@ match_uncond_E:
 	if (ent == NULL)
 		goto fail;
 out:
-	free(hier);
 	return (1);
 fail:
-	free(hier);
 	return (0);
 }
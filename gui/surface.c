@@ -43,6 +43,11 @@
 
 #include <string.h>
 
+#ifdef __SSE2__
+# include <emmintrin.h>
+# define BLIT32_SSE2
+#endif
+
 /* Check for incorrect blitter maps / invocations. */
 /* #define DEBUG_BLITTER_MAP */
 
@@ -325,7 +330,8 @@ Get_Aligned_Pitch_Padding(const AG_Surface *_Nonnull S, Uint w,
 			return (-1);
 		}
 #endif /* AG_DEBUG */
-		len = (w >> pf->PixelsPerByteShift);
+		len = (w + (1 << pf->PixelsPerByteShift) - 1) >>
+		      pf->PixelsPerByteShift;		/* Round up to bytes */
 	} else {
 		len = (w * pf->BytesPerPixel);
 	}
@@ -761,24 +767,15 @@ AG_SurfaceCopy(AG_Surface *D, const AG_Surface *S)
 		}
 #endif
 		if (D->format.BitsPerPixel < 8) {         /* <8bpp block copy */
-			const Uint8 *pSrc = S->pixels;
-			Uint8 *pDst = D->pixels;
-			Uint Spadding = S->padding, Dpadding = D->padding;
-			const Uint pitch = (w >> D->format.PixelsPerByteShift);
+			const int shift = D->format.PixelsPerByteShift;
+			const Uint len = (w >> shift);          /* Whole bytes */
 
-			if (D->w > S->w) {
-				Dpadding += (D->w - S->w) >> D->format.PixelsPerByteShift;
-			} else if (D->w < S->w) {
-				Spadding += (S->w - D->w) >> S->format.PixelsPerByteShift;
-			}
 			for (y = 0; y < h; y++) {
-				pSrc += S->Lpadding;
-				pDst += D->Lpadding;
-
-				memcpy(pDst, pSrc, pitch);
-
-				pSrc += pitch + Spadding;
-				pDst += pitch + Dpadding;
+				memcpy(D->pixels + y*D->pitch + D->Lpadding,
+				       S->pixels + y*S->pitch + S->Lpadding, len);
+				for (x = (len << shift); x < w; x++)
+					AG_SurfacePut8(D, x,y,
+					    AG_SurfaceGet8(S, x,y));
 			}
 		} else {                                 /* >=8bpp block copy */
 			const Uint8 *pSrc = S->pixels;
@@ -940,10 +937,12 @@ AG_LowerBlit_Sub8_to_Any(AG_Surface *D, const AG_Rect *rd, const AG_Surface *S,
 			if (c.a == AG_TRANSPARENT) {
 				continue;
 			}
-			AG_SurfaceBlend(D,
-			    (xd + x),
-			    (yd + y),
-			    &c);
+			if (c.a == AG_OPAQUE) {
+				AG_SurfacePut(D, (xd + x), (yd + y),
+				    AG_MapPixel(&D->format, &c));
+			} else {
+				AG_SurfaceBlend(D, (xd + x), (yd + y), &c);
+			}
 		}
 	}
 }
@@ -1099,7 +1098,10 @@ AG_LowerBlit_Any_to_Any(AG_Surface *D, const AG_Rect *rd, const AG_Surface *S,
 
 			px = AG_SurfaceGet_At(S, pSrc);
 			AG_GetColor(&c, px, &S->format);
-			if (c.a != AG_TRANSPARENT) {
+			if (c.a == AG_OPAQUE) {
+				AG_SurfacePut_At(D, pDst,
+				    AG_MapPixel(&D->format, &c));
+			} else if (c.a != AG_TRANSPARENT) {
 				AG_SurfaceBlend_At(D, pDst, &c);
 			}
 			pSrc += S->format.BytesPerPixel;
@@ -1226,13 +1228,495 @@ AG_LowerBlit_Co(AG_Surface *D, const AG_Rect *rd, const AG_Surface *S,
 			}
 next_pixel:
 			pSrc += S->format.BytesPerPixel;
-			pDst += S->format.BytesPerPixel;
+			pDst += D->format.BytesPerPixel;
 		}
 		pSrc += S->padding;
 		pDst += D->padding;
 	}
 }
 
+/*
+ * Fast lower blits between 32-bit packed surfaces with 8-bit components
+ * at byte boundaries (in any order, with or without alpha). Components are
+ * extracted with shifts instead of AG_GetColor() and AG_MapPixel() and
+ * rows are processed in SIMD where possible. The results are identical to
+ * those of the general blitters above.
+ */
+typedef struct blit32 {
+	Uint flags;
+#define BLIT32_ALPHA    0x01		/* Honor per-surface alpha */
+#define BLIT32_COLORKEY 0x02		/* Honor source colorkey */
+#define BLIT32_SWAP_RB  0x04		/* Exchange R and B (SSE2 layouts) */
+	AG_Component alpha;		/* Per-surface alpha */
+	Uint32 colorkey;		/* Source colorkey */
+	Uint32 dAmask;			/* Destination alpha mask (or 0) */
+	int sR, sG, sB, sA;		/* Source shifts (sA = -1 if no alpha) */
+	int dR, dG, dB, dA;		/* Destination shifts (dA = -1 if none) */
+} Blit32;
+
+typedef void (*Blit32RowFn)(const Blit32 *_Nonnull, Uint32 *_Nonnull,
+                            const Uint32 *_Nonnull, int);
+
+/* Expand an 8-bit component to AG_Component and back. */
+#if AG_MODEL == AG_LARGE
+# define BLIT32_EXPAND(c) ((c) * 257)
+# define BLIT32_REDUCE(c) ((c) >> 8)
+#else
+# define BLIT32_EXPAND(c) (c)
+# define BLIT32_REDUCE(c) (c)
+#endif
+
+/* Return the shift of an 8-bit component mask, or -1 if it is unaligned. */
+static int
+Blit32_Shift(AG_Pixel mask)
+{
+	int shift;
+
+	for (shift = 0; shift < 32; shift += 8) {
+		if (mask == ((AG_Pixel)0xff << shift))
+			return (shift);
+	}
+	return (-1);
+}
+
+/*
+ * Return the component shifts of a 32-bit packed format with 8-bit
+ * components (A = -1 if there is no alpha). Return -1 if unsupported.
+ */
+static int
+Blit32_Format(const AG_PixelFormat *_Nonnull pf, int *_Nonnull R,
+    int *_Nonnull G, int *_Nonnull B, int *_Nonnull A)
+{
+	if (pf->mode != AG_SURFACE_PACKED || pf->BytesPerPixel != 4 ||
+	    (*R = Blit32_Shift(pf->Rmask)) == -1 ||
+	    (*G = Blit32_Shift(pf->Gmask)) == -1 ||
+	    (*B = Blit32_Shift(pf->Bmask)) == -1)
+		return (-1);
+
+	*A = -1;
+	if (pf->Amask != 0 && (*A = Blit32_Shift(pf->Amask)) == -1)
+		return (-1);
+
+	return (0);
+}
+
+/*
+ * Check whether S and D are in formats supported by the fast blitters and
+ * initialize the blit context. Return -1 if they are not.
+ */
+static int
+Blit32_Init(Blit32 *_Nonnull b, const AG_Surface *_Nonnull D,
+    const AG_Surface *_Nonnull S, Uint flags)
+{
+	if (Blit32_Format(&S->format, &b->sR, &b->sG, &b->sB, &b->sA) == -1 ||
+	    Blit32_Format(&D->format, &b->dR, &b->dG, &b->dB, &b->dA) == -1)
+		return (-1);
+
+	b->dAmask = (Uint32)D->format.Amask;
+	b->alpha = S->alpha;
+	b->colorkey = (Uint32)S->colorkey;
+	if ((flags & BLIT32_COLORKEY) && S->colorkey != (AG_Pixel)b->colorkey)
+		flags &= ~(BLIT32_COLORKEY);       /* Can never match a pixel */
+
+	b->flags = flags;
+	return (0);
+}
+
+/*
+ * Blend component s (an AG_Component value) into the 8-bit component d by
+ * alpha a, as AG_SurfaceBlend_At() does (rounding towards -infinity).
+ */
+static __inline__ Uint32
+Blit32_MixComponent(Uint32 s, Uint32 d, Uint32 a)
+{
+	d = BLIT32_EXPAND(d);
+	if (s >= d) {
+		return BLIT32_REDUCE(d + (((s - d) * a) >> AG_COMPONENT_BITS));
+	} else {
+		return BLIT32_REDUCE(d - (((d - s) * a + AG_COLOR_LAST) >>
+		                          AG_COMPONENT_BITS));
+	}
+}
+
+/* Blend the 8-bit component s into d by alpha a. */
+#define Blit32_Mix(s, d, a) Blit32_MixComponent(BLIT32_EXPAND(s), (d), (a))
+
+/* Blit a row of pixels (generic C version). */
+static void
+Blit32_Row(const Blit32 *_Nonnull b, Uint32 *_Nonnull pDst,
+    const Uint32 *_Nonnull pSrc, int w)
+{
+	const Uint32 dOpaque = b->dAmask;
+	int x;
+
+	for (x = 0; x < w; x++) {
+		const Uint32 px = pSrc[x];
+		Uint32 sr, sg, sb, dpx, da;
+		Uint a;
+
+		if ((b->flags & BLIT32_COLORKEY) && px == b->colorkey) {
+			continue;
+		}
+		a = (b->sA != -1) ? BLIT32_EXPAND((px >> b->sA) & 0xff) :
+		                    AG_OPAQUE;
+		if ((b->flags & BLIT32_ALPHA) && a > b->alpha) {
+			a = b->alpha;
+		}
+		if (a == AG_TRANSPARENT) {
+			continue;
+		}
+		sr = (px >> b->sR) & 0xff;
+		sg = (px >> b->sG) & 0xff;
+		sb = (px >> b->sB) & 0xff;
+		if (a == AG_OPAQUE) {
+			pDst[x] = (sr << b->dR) | (sg << b->dG) | (sb << b->dB) |
+			          dOpaque;
+			continue;
+		}
+		dpx = pDst[x];
+		pDst[x] = (Blit32_Mix(sr, (dpx >> b->dR) & 0xff, a) << b->dR) |
+		          (Blit32_Mix(sg, (dpx >> b->dG) & 0xff, a) << b->dG) |
+		          (Blit32_Mix(sb, (dpx >> b->dB) & 0xff, a) << b->dB);
+		if (b->dA != -1) {
+			da = BLIT32_EXPAND((dpx >> b->dA) & 0xff) + a;
+			if (da > AG_COLOR_LAST) {
+				da = AG_COLOR_LAST;
+			}
+			pDst[x] |= BLIT32_REDUCE(da) << b->dA;
+		}
+	}
+}
+
+#ifdef BLIT32_SSE2
+/*
+ * Blend the 16-bit lanes of s into d by alpha a and write the result to r
+ * as 8-bit values. The alpha lanes (per aLane) receive the sum of the alphas
+ * (clamped). Expects zero, aLane and one (LARGE) or c255 (MEDIUM) in scope.
+ */
+#if AG_MODEL == AG_LARGE
+# define BLIT32_SSE2_MIX(r, s, d, a) {					\
+	const __m128i dp = _mm_subs_epu16((s), (d));			\
+	const __m128i dn = _mm_subs_epu16((d), (s));			\
+	__m128i neg = _mm_mulhi_epu16(dn, (a));				\
+									\
+	neg = _mm_add_epi16(neg, _mm_andnot_si128(			\
+	    _mm_cmpeq_epi16(_mm_mullo_epi16(dn, (a)), zero), one));	\
+	(r) = _mm_sub_epi16(_mm_add_epi16((d),				\
+	    _mm_mulhi_epu16(dp, (a))), neg);				\
+	(r) = _mm_or_si128(						\
+	    _mm_and_si128(aLane, _mm_adds_epu16((d), (a))),		\
+	    _mm_andnot_si128(aLane, (r)));				\
+	(r) = _mm_srli_epi16((r), 8);					\
+	}
+#else
+# define BLIT32_SSE2_MIX(r, s, d, a) {					\
+	const __m128i dp = _mm_subs_epu16((s), (d));			\
+	const __m128i dn = _mm_subs_epu16((d), (s));			\
+									\
+	(r) = _mm_sub_epi16(_mm_add_epi16((d),				\
+	    _mm_srli_epi16(_mm_mullo_epi16(dp, (a)), 8)),		\
+	    _mm_srli_epi16(_mm_adds_epu16(				\
+	        _mm_mullo_epi16(dn, (a)), c255), 8));			\
+	(r) = _mm_or_si128(						\
+	    _mm_and_si128(aLane, _mm_adds_epu16((d), (a))),		\
+	    _mm_andnot_si128(aLane, (r)));				\
+	}
+#endif
+
+/*
+ * Blit a row of pixels (SSE2 version). Four pixels are processed at a
+ * time, with components unpacked into 16-bit lanes. Only the layouts with
+ * RGB in the low 24 bits are handled (see Blit32_InitSSE2()).
+ */
+static void
+Blit32_Row_SSE2(const Blit32 *_Nonnull b, Uint32 *_Nonnull pDst,
+    const Uint32 *_Nonnull pSrc, int w)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+	const __m128i aMask = _mm_set1_epi32((int)0xff000000);
+	const __m128i aLane = _mm_set_epi16(-1,0,0,0, -1,0,0,0);
+	const __m128i dOpaque = _mm_set1_epi32((int)b->dAmask);
+	const __m128i dMask = _mm_set1_epi32((int)(b->dAmask | 0x00ffffff));
+	const __m128i rbMask = _mm_set1_epi32(0x000000ff);
+	const __m128i gaMask = _mm_set1_epi32((int)0xff00ff00);
+	const __m128i ckV = _mm_set1_epi32((int)b->colorkey);
+	const __m128i alphaV = _mm_set1_epi16((short)b->alpha);
+	const __m128i aMax = _mm_set1_epi16((short)AG_OPAQUE);
+#if AG_MODEL == AG_LARGE
+	const __m128i one = _mm_set1_epi16(1);
+#else
+	const __m128i c255 = _mm_set1_epi16(0xff);
+#endif
+	const int sHasA = (b->sA != -1);
+	int x;
+
+	for (x = 0; x+4 <= w; x += 4) {
+		const __m128i sRaw = _mm_loadu_si128((const __m128i *)&pSrc[x]);
+		const __m128i d = _mm_loadu_si128((const __m128i *)&pDst[x]);
+		__m128i s = sRaw, keep, opaque, out;
+		__m128i sl, sh, dl, dh, al, ah, rl, rh;
+
+		if (b->flags & BLIT32_SWAP_RB) {
+			s = _mm_or_si128(_mm_and_si128(s, gaMask),
+			    _mm_or_si128(
+			        _mm_and_si128(_mm_srli_epi32(s, 16), rbMask),
+			        _mm_slli_epi32(_mm_and_si128(s, rbMask), 16)));
+		}
+		if (!sHasA) {
+			s = _mm_or_si128(s, aMask);
+		}
+		keep = (b->flags & BLIT32_COLORKEY) ?
+		       _mm_cmpeq_epi32(sRaw, ckV) : zero;
+
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(
+		    _mm_and_si128(s, aMask), zero)) == 0xffff) {
+			continue;			/* All transparent */
+		}
+		if (!(b->flags & BLIT32_ALPHA)) {
+			const int m = _mm_movemask_epi8(_mm_cmpeq_epi32(
+			              _mm_and_si128(s, aMask), aMask));
+
+			if (m == 0xffff && _mm_movemask_epi8(keep) == 0) {
+				_mm_storeu_si128((__m128i *)&pDst[x],
+				    _mm_or_si128(_mm_and_si128(s, rgbMask),
+				                 dOpaque));
+				continue;
+			}
+		}
+#if AG_MODEL == AG_LARGE
+		sl = _mm_unpacklo_epi8(s, s);		/* Expand by 257 */
+		sh = _mm_unpackhi_epi8(s, s);
+		dl = _mm_unpacklo_epi8(d, d);
+		dh = _mm_unpackhi_epi8(d, d);
+#else
+		sl = _mm_unpacklo_epi8(s, zero);
+		sh = _mm_unpackhi_epi8(s, zero);
+		dl = _mm_unpacklo_epi8(d, zero);
+		dh = _mm_unpackhi_epi8(d, zero);
+#endif
+		/* Broadcast the alpha of each pixel to all of its lanes. */
+		al = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sl, 0xff), 0xff);
+		ah = _mm_shufflehi_epi16(_mm_shufflelo_epi16(sh, 0xff), 0xff);
+		if (b->flags & BLIT32_ALPHA) {
+			al = _mm_subs_epu16(al, _mm_subs_epu16(al, alphaV));
+			ah = _mm_subs_epu16(ah, _mm_subs_epu16(ah, alphaV));
+		}
+		BLIT32_SSE2_MIX(rl, sl, dl, al);
+		BLIT32_SSE2_MIX(rh, sh, dh, ah);
+		out = _mm_and_si128(_mm_packus_epi16(rl, rh), dMask);
+
+		/* Copy opaque pixels and leave transparent pixels untouched. */
+		opaque = _mm_packs_epi16(_mm_cmpeq_epi16(al, aMax),
+		                         _mm_cmpeq_epi16(ah, aMax));
+		out = _mm_or_si128(_mm_andnot_si128(opaque, out),
+		    _mm_and_si128(opaque,
+		        _mm_or_si128(_mm_and_si128(s, rgbMask), dOpaque)));
+		keep = _mm_or_si128(keep,
+		    _mm_packs_epi16(_mm_cmpeq_epi16(al, zero),
+		                    _mm_cmpeq_epi16(ah, zero)));
+		out = _mm_or_si128(_mm_andnot_si128(keep, out),
+		                   _mm_and_si128(keep, d));
+
+		_mm_storeu_si128((__m128i *)&pDst[x], out);
+	}
+	if (x < w)
+		Blit32_Row(b, &pDst[x], &pSrc[x], w - x);
+}
+
+/*
+ * Select the SSE2 row function if the RGB components of both surfaces
+ * occupy the low 24 bits (in RGB or BGR order).
+ */
+static Blit32RowFn _Nonnull
+Blit32_InitSSE2(Blit32 *_Nonnull b)
+{
+	if (b->sG != 8 || b->dG != 8 ||
+	    (b->sR != 0 && b->sR != 16) || (b->dR != 0 && b->dR != 16) ||
+	    (b->sA != -1 && b->sA != 24) || (b->dA != -1 && b->dA != 24)) {
+		return (Blit32_Row);
+	}
+	if (b->sR != b->dR) {
+		b->flags |= BLIT32_SWAP_RB;
+	}
+	return (Blit32_Row_SSE2);
+}
+#endif /* BLIT32_SSE2 */
+
+static void
+Blit32_Rows(AG_Surface *_Nonnull D, const AG_Rect *_Nonnull rd,
+    const AG_Surface *_Nonnull S, const AG_Rect *_Nonnull rs,
+    const Blit32 *_Nonnull b, Blit32RowFn _Nonnull rowFn)
+{
+	const Uint8 *pSrc = S->pixels + (rs->y * S->pitch) + S->Lpadding +
+	                    (rs->x << 2);
+	Uint8 *pDst = D->pixels + (rd->y * D->pitch) + D->Lpadding +
+	              (rd->x << 2);
+	int y;
+
+	for (y = 0; y < rd->h; y++) {
+		rowFn(b, (Uint32 *)pDst, (const Uint32 *)pSrc, rd->w);
+		pSrc += S->pitch;
+		pDst += D->pitch;
+	}
+}
+
+/*
+ * Lower blits for 32-bit packed to 32-bit packed (generic C versions).
+ * Fall back to the general blitters for unsupported formats.
+ */
+static void
+AG_LowerBlit_Packed32_AlCo(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	Blit32 b;
+
+	if (Blit32_Init(&b, D, S, BLIT32_ALPHA | BLIT32_COLORKEY) == -1) {
+		AG_LowerBlit_AlCo(D, rd, S, rs);
+		return;
+	}
+	Blit32_Rows(D, rd, S, rs, &b, Blit32_Row);
+}
+static void
+AG_LowerBlit_Packed32_Al(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	Blit32 b;
+
+	if (Blit32_Init(&b, D, S, BLIT32_ALPHA) == -1) {
+		AG_LowerBlit_Al(D, rd, S, rs);
+		return;
+	}
+	Blit32_Rows(D, rd, S, rs, &b, Blit32_Row);
+}
+static void
+AG_LowerBlit_Packed32_Co(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	Blit32 b;
+
+	if (Blit32_Init(&b, D, S, BLIT32_COLORKEY) == -1) {
+		AG_LowerBlit_Co(D, rd, S, rs);
+		return;
+	}
+	Blit32_Rows(D, rd, S, rs, &b, Blit32_Row);
+}
+static void
+AG_LowerBlit_Packed32(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	Blit32 b;
+
+	if (Blit32_Init(&b, D, S, 0) == -1) {
+		AG_LowerBlit_Any_to_Any(D, rd, S, rs);
+		return;
+	}
+	Blit32_Rows(D, rd, S, rs, &b, Blit32_Row);
+}
+
+#ifdef BLIT32_SSE2
+/*
+ * Lower blits for 32-bit packed to 32-bit packed (SSE2 versions).
+ */
+static void
+AG_LowerBlit_Packed32_AlCo_SSE2(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	Blit32 b;
+
+	if (Blit32_Init(&b, D, S, BLIT32_ALPHA | BLIT32_COLORKEY) == -1) {
+		AG_LowerBlit_AlCo(D, rd, S, rs);
+		return;
+	}
+	Blit32_Rows(D, rd, S, rs, &b, Blit32_InitSSE2(&b));
+}
+static void
+AG_LowerBlit_Packed32_Al_SSE2(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	Blit32 b;
+
+	if (Blit32_Init(&b, D, S, BLIT32_ALPHA) == -1) {
+		AG_LowerBlit_Al(D, rd, S, rs);
+		return;
+	}
+	Blit32_Rows(D, rd, S, rs, &b, Blit32_InitSSE2(&b));
+}
+static void
+AG_LowerBlit_Packed32_Co_SSE2(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	Blit32 b;
+
+	if (Blit32_Init(&b, D, S, BLIT32_COLORKEY) == -1) {
+		AG_LowerBlit_Co(D, rd, S, rs);
+		return;
+	}
+	Blit32_Rows(D, rd, S, rs, &b, Blit32_InitSSE2(&b));
+}
+static void
+AG_LowerBlit_Packed32_SSE2(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	Blit32 b;
+
+	if (Blit32_Init(&b, D, S, 0) == -1) {
+		AG_LowerBlit_Any_to_Any(D, rd, S, rs);
+		return;
+	}
+	Blit32_Rows(D, rd, S, rs, &b, Blit32_InitSSE2(&b));
+}
+#endif /* BLIT32_SSE2 */
+
+/*
+ * Lower blit for 8-bit indexed source to 32-bit packed destination.
+ * Opaque palette entries are mapped once through a lookup table.
+ */
+static void
+AG_LowerBlit_Indexed8_to_Packed32(AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *S, const AG_Rect *rs)
+{
+	const AG_Palette *pal = S->format.palette;
+	const AG_Color *colors = pal->colors;
+	const Uint nColors = pal->nColors;
+	Uint32 map[256];
+	Uint8 mapped[256];
+	int x, y;
+
+#ifdef DEBUG_BLITTER_MAP
+	if (S->format.mode != AG_SURFACE_INDEXED ||
+	    S->format.BitsPerPixel != 8 ||
+	    D->format.mode != AG_SURFACE_PACKED ||
+	    D->format.BytesPerPixel != 4)
+		AG_FatalError("Bad blitter map");
+#endif
+	memset(mapped, 0, sizeof(mapped));
+
+	for (y = 0; y < rd->h; y++) {
+		const Uint8 *pSrc = S->pixels + ((rs->y + y) * S->pitch) +
+		                    S->Lpadding + rs->x;
+		Uint32 *pDst = (Uint32 *)(D->pixels +
+		                          ((rd->y + y) * D->pitch) +
+		                          D->Lpadding + (rd->x << 2));
+
+		for (x = 0; x < rd->w; x++) {
+			const Uint8 px = pSrc[x];
+			const AG_Color *c = &colors[px % nColors];
+
+			if (c->a == AG_OPAQUE) {
+				if (!mapped[px]) {
+					map[px] = (Uint32)AG_MapPixel(
+					    &D->format, c);
+					mapped[px] = 1;
+				}
+				pDst[x] = map[px];
+			} else if (c->a != AG_TRANSPARENT) {
+				AG_SurfaceBlend_At(D, (Uint8 *)&pDst[x], c);
+			}
+		}
+	}
+}
+
 /*
  * Copy/blend a region of pixels (per srcRect) from a source surface S to a
  * destination surface D, at coordinates xDst,yDst of D.
@@ -1436,17 +1920,545 @@ AG_SurfaceFree(AG_Surface *S)
 		free(S);
 }
 
+/*
+ * Taps of the resampling filter for one destination column or row: the
+ * weights (sum 1<<SCALE_WBITS) of n source pixels starting at first.
+ */
+typedef struct scale_taps {
+	int first;			/* First source pixel */
+	int n;				/* Number of source pixels */
+	Uint offs;			/* Offset into the weights array */
+} ScaleTaps;
+
+#define SCALE_WBITS 14			/* Fractional bits of weights */
+#define SCALE_TBITS 6			/* Fractional bits of intermediate */
+
+/* Context of an AG_SurfaceScale() operation. */
+typedef struct scale_ctx {
+	const AG_Surface *_Nonnull S;	/* Source surface */
+	AG_Surface *_Nonnull D;		/* Target surface */
+	int *_Nullable xMap;		/* Nearest: source column of x */
+	int *_Nullable yMap;		/* Nearest: source row of y */
+	ScaleTaps *_Nullable xTaps;	/* Filtered: taps of column x */
+	ScaleTaps *_Nullable yTaps;	/* Filtered: taps of row y */
+	Sint16 *_Nullable xW;		/* Filtered: weights of xTaps */
+	Sint16 *_Nullable yW;		/* Filtered: weights of yTaps */
+	Sint16 *_Nullable tmp;		/* Filtered: horizontal pass output */
+	int aIdx;			/* Index of alpha byte (or -1) */
+	Uint32 _pad;
+	Uint32 recip[256];		/* Un-premultiply factors by alpha */
+} ScaleCtx;
+
+/* Lanczos (a=3) kernel. */
+static double
+Scale_Lanczos3(double t)
+{
+	if (t < 0.0) {
+		t = -t;
+	}
+	if (t < 1e-8) {
+		return (1.0);
+	}
+	if (t >= 3.0) {
+		return (0.0);
+	}
+	return (3.0 * Sin(AG_PI*t) * Sin(AG_PI*t/3.0)) / (AG_PI*AG_PI * t*t);
+}
+
+/*
+ * Compute the filter taps for scaling nSrc pixels to nDst pixels. This is
+ * the only floating-point part of the filtered scalers. Clamp to edges.
+ */
+static ScaleTaps *_Nullable
+Scale_InitTaps(int nSrc, int nDst, Uint filter, Sint16 *_Nullable *_Nonnull pW)
+{
+	const double scale = (double)nDst / (double)nSrc;
+	const double kScale = (scale < 1.0) ? scale : 1.0;
+	ScaleTaps *taps;
+	Sint16 *W;
+	double *fw, support;
+	int maxTaps, i;
+	Uint offs = 0;
+
+	switch (filter) {
+	case AG_SCALE_BILINEAR:
+		support = 1.0;
+		break;
+	case AG_SCALE_BOX:
+		support = 0.5 / kScale + 0.5;
+		break;
+	default:
+		support = 3.0 / kScale;
+		break;
+	}
+	maxTaps = (int)Ceil(support*2.0) + 2;
+
+	if ((taps = TryMalloc(nDst*sizeof(ScaleTaps))) == NULL) {
+		return (NULL);
+	}
+	if ((W = TryMalloc(nDst*maxTaps*sizeof(Sint16))) == NULL) {
+		free(taps);
+		return (NULL);
+	}
+	if ((fw = TryMalloc(maxTaps*sizeof(double))) == NULL) {
+		free(W);
+		free(taps);
+		return (NULL);
+	}
+	for (i = 0; i < nDst; i++) {
+		const double c = ((double)i + 0.5) / scale - 0.5;
+		const int lo = (int)Floor(c - support);
+		const int hi = (int)Ceil(c + support);
+		const int first = AG_MAX(lo, 0);
+		const int last = AG_MIN(hi, nSrc-1);
+		const int n = last - first + 1;
+		double sum = 0.0;
+		int j, k, total = 0, kMax = 0;
+		ScaleTaps *t = &taps[i];
+
+		for (k = 0; k < n; k++) {
+			fw[k] = 0.0;
+		}
+		for (j = lo; j <= hi; j++) {
+			double wt;
+
+			switch (filter) {
+			case AG_SCALE_BILINEAR:
+				wt = 1.0 - Fabs((double)j - c);
+				break;
+			case AG_SCALE_BOX:
+				wt = AG_MIN((double)(i+1) / scale, (double)(j+1)) -
+				     AG_MAX((double)i / scale, (double)j);
+				break;
+			default:
+				wt = Scale_Lanczos3(((double)j - c) * kScale);
+				break;
+			}
+			if (wt == 0.0 || (filter != AG_SCALE_LANCZOS && wt < 0.0))
+				continue;
+
+			k = AG_MIN(AG_MAX(j, first), last) - first;
+			fw[k] += wt;
+			sum += wt;
+		}
+		for (k = 0; k < n; k++) {
+			const double v = (sum != 0.0) ? fw[k] / sum *
+			                 (double)(1 << SCALE_WBITS) : 0.0;
+
+			W[offs+k] = (Sint16)Floor(v + 0.5);
+			total += W[offs+k];
+			if (W[offs+k] > W[offs+kMax])
+				kMax = k;
+		}
+		W[offs+kMax] += (1 << SCALE_WBITS) - total;  /* Rounding error */
+
+		t->first = first;
+		t->n = n;
+		t->offs = offs;
+		while (t->n > 1 && W[t->offs] == 0) {	/* Trim zero taps */
+			t->first++;
+			t->offs++;
+			t->n--;
+		}
+		while (t->n > 1 && W[t->offs + t->n - 1] == 0) {
+			t->n--;
+		}
+		offs += n;
+	}
+	free(fw);
+	*pW = W;
+	return (taps);
+}
+
+/* Scale rows [y1,y2) of the target (nearest neighbor). */
+static void
+Scale_Nearest(void *_Nullable p, int y1, int y2)
+{
+	const ScaleCtx *sc = p;
+	const AG_Surface *S = sc->S;
+	AG_Surface *D = sc->D;
+	const int *xMap = sc->xMap;
+	const int BytesPerPixel = D->format.BytesPerPixel;
+	int x, y;
+
+	if (D->format.BitsPerPixel < 8) {
+		for (y = y1; y < y2; y++) {
+			for (x = 0; x < D->w; x++) {
+				AG_SurfacePut8(D, x,y,
+				    AG_SurfaceGet8(S, xMap[x], sc->yMap[y]));
+			}
+		}
+		return;
+	}
+	for (y = y1; y < y2; y++) {
+		const Uint8 *pSrc = S->pixels + sc->yMap[y]*S->pitch +
+		                    S->Lpadding;
+		Uint8 *pDst = D->pixels + y*D->pitch + D->Lpadding;
+
+		if (y > y1 && sc->yMap[y] == sc->yMap[y-1]) {
+			memcpy(pDst, pDst - D->pitch, D->w*BytesPerPixel);
+			continue;
+		}
+		switch (BytesPerPixel) {
+		case 4:
+			for (x = 0; x < D->w; x++) {
+				((Uint32 *)pDst)[x] = ((const Uint32 *)pSrc)[xMap[x]];
+			}
+			break;
+		case 2:
+			for (x = 0; x < D->w; x++) {
+				((Uint16 *)pDst)[x] = ((const Uint16 *)pSrc)[xMap[x]];
+			}
+			break;
+		case 1:
+			for (x = 0; x < D->w; x++) {
+				pDst[x] = pSrc[xMap[x]];
+			}
+			break;
+		default:
+			for (x = 0; x < D->w; x++) {
+				memcpy(&pDst[x*BytesPerPixel],
+				       &pSrc[xMap[x]*BytesPerPixel], BytesPerPixel);
+			}
+			break;
+		}
+	}
+}
+
+/*
+ * Horizontal pass of the filtered scalers: filter source rows [y1,y2) to
+ * the target width. The bytes of each pixel are processed as 4 channels
+ * (premultiplied by alpha) in SCALE_TBITS fixed-point.
+ */
+static void
+Scale_FilterH(void *_Nullable p, int y1, int y2)
+{
+	const ScaleCtx *sc = p;
+	const AG_Surface *S = sc->S;
+	const int wDst = sc->D->w;
+	const int aIdx = sc->aIdx;
+	Sint16 *row;
+	int x, y, i, k;
+
+	row = Malloc(S->w * 4 * sizeof(Sint16));
+
+	for (y = y1; y < y2; y++) {
+		const Uint8 *pSrc = S->pixels + y*S->pitch + S->Lpadding;
+		Sint16 *pTmp = &sc->tmp[y * wDst * 4];
+
+		x = 0;
+#ifdef BLIT32_SSE2
+		if (agCPU.ext & AG_EXT_SSE2) {
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i k = _mm_set1_epi16(257 << SCALE_TBITS);
+			const __m128i aLane = (aIdx != -1) ?
+			    _mm_slli_epi64(_mm_set1_epi64x(0xffff), aIdx << 4) :
+			    zero;
+			const __m128i a255 = _mm_set1_epi16(0xff);
+
+			for (; x+2 <= S->w; x += 2) {		/* Premultiply */
+				const __m128i c = _mm_unpacklo_epi8(
+				    _mm_loadl_epi64((const __m128i *)
+				                    &pSrc[x << 2]), zero);
+				__m128i a, r, keep;
+
+				if (aIdx == -1) {
+					_mm_storeu_si128((__m128i *)&row[x << 2],
+					    _mm_slli_epi16(c, SCALE_TBITS));
+					continue;
+				}
+				a = _mm_and_si128(c, aLane);	/* Broadcast alpha */
+				a = _mm_or_si128(a, _mm_or_si128(
+				    _mm_slli_epi64(a, 16), _mm_srli_epi64(a, 16)));
+				a = _mm_or_si128(a, _mm_or_si128(
+				    _mm_slli_epi64(a, 32), _mm_srli_epi64(a, 32)));
+				r = _mm_mulhi_epu16(_mm_mullo_epi16(c, a), k);
+				keep = _mm_or_si128(aLane, _mm_cmpeq_epi16(a, a255));
+				r = _mm_or_si128(_mm_andnot_si128(keep, r),
+				    _mm_and_si128(keep, _mm_slli_epi16(c, SCALE_TBITS)));
+				_mm_storeu_si128((__m128i *)&row[x << 2], r);
+			}
+		}
+#endif /* BLIT32_SSE2 */
+		for (; x < S->w; x++) {			/* Premultiply */
+			const Uint8 *px = &pSrc[x << 2];
+			const Uint a = (aIdx != -1) ? px[aIdx] : 0xff;
+
+			for (i = 0; i < 4; i++) {
+				row[(x << 2) + i] = (i == aIdx || a == 0xff) ?
+				    (Sint16)(px[i] << SCALE_TBITS) :
+				    (Sint16)((px[i]*a*257) >> (16 - SCALE_TBITS));
+			}
+		}
+		x = 0;
+#ifdef BLIT32_SSE2
+		if (agCPU.ext & AG_EXT_SSE2) {
+			const __m128i rndV = _mm_set1_epi32(1 << (SCALE_WBITS-1));
+
+			for (; x < wDst; x++) {
+				const ScaleTaps *t = &sc->xTaps[x];
+				const Sint16 *W = &sc->xW[t->offs];
+				const Sint16 *pRow = &row[t->first << 2];
+				__m128i acc = rndV;
+
+				/* Interleave pairs of pixels; madd by the weights. */
+				for (k = 0; k < t->n; k += 2) {
+					const int kb = (k+1 < t->n) ? k+1 : k;
+					const Sint16 wb = (k+1 < t->n) ? W[k+1] : 0;
+					const __m128i wV = _mm_set1_epi32((int)
+					    ((Uint16)W[k] | ((Uint32)(Uint16)wb << 16)));
+					const __m128i a = _mm_loadl_epi64(
+					    (const __m128i *)&pRow[k << 2]);
+					const __m128i b = _mm_loadl_epi64(
+					    (const __m128i *)&pRow[kb << 2]);
+
+					acc = _mm_add_epi32(acc, _mm_madd_epi16(
+					    _mm_unpacklo_epi16(a, b), wV));
+				}
+				acc = _mm_srai_epi32(acc, SCALE_WBITS);
+				_mm_storel_epi64((__m128i *)&pTmp[x << 2],
+				    _mm_packs_epi32(acc, acc));
+			}
+		}
+#endif /* BLIT32_SSE2 */
+		for (; x < wDst; x++) {
+			const ScaleTaps *t = &sc->xTaps[x];
+			const Sint16 *W = &sc->xW[t->offs];
+			const Sint16 *pRow = &row[t->first << 2];
+			Sint32 acc[4] = { 0,0,0,0 };
+
+			for (k = 0; k < t->n; k++) {
+				for (i = 0; i < 4; i++)
+					acc[i] += W[k] * pRow[(k << 2) + i];
+			}
+			for (i = 0; i < 4; i++) {
+				const Sint32 v = (acc[i] + (1 << (SCALE_WBITS-1))) >>
+				                 SCALE_WBITS;
+
+				pTmp[(x << 2) + i] = (Sint16)AG_MIN(AG_MAX(v,-32768),
+				                                    32767);
+			}
+		}
+	}
+	free(row);
+}
+
+/* Convert the premultiplied channels pv of a pixel to straight alpha. */
+static __inline__ void
+Scale_StorePixel(const ScaleCtx *_Nonnull sc, Uint8 *_Nonnull px,
+    const Sint16 *_Nonnull pv)
+{
+	const int rnd = (1 << (SCALE_TBITS-1));
+	const int aIdx = sc->aIdx;
+	int a, c, i;
+
+	a = (pv[aIdx] + rnd) >> SCALE_TBITS;
+	a = AG_MIN(AG_MAX(a, 0), 255);
+
+	for (i = 0; i < 4; i++) {
+		if (i == aIdx) {
+			px[i] = (Uint8)a;
+			continue;
+		}
+		if (a == 255) {
+			c = (pv[i] + rnd) >> SCALE_TBITS;
+			c = AG_MIN(AG_MAX(c, 0), 255);
+		} else {
+			c = AG_MIN(AG_MAX(pv[i], 0), a << SCALE_TBITS);
+			c = (int)(((Uint32)c * sc->recip[a] + (1 << 20)) >> 21);
+		}
+		px[i] = (Uint8)c;
+	}
+}
+
+/*
+ * Convert a row of vertically filtered, premultiplied channels (in
+ * SCALE_TBITS fixed-point) to target pixels with straight alpha.
+ */
+static void
+Scale_StoreRow(const ScaleCtx *_Nonnull sc, Uint8 *_Nonnull pDst,
+    const Sint16 *_Nonnull v, int w)
+{
+	const int rnd = (1 << (SCALE_TBITS-1));
+	int x = 0, i;
+
+#ifdef BLIT32_SSE2
+	if (agCPU.ext & AG_EXT_SSE2) {
+		const __m128i rndV = _mm_set1_epi16(rnd);
+		const __m128i ones = _mm_set1_epi8(-1);
+		const int aBits = (sc->aIdx != -1) ? (0x1111 << sc->aIdx) : 0;
+
+		/* Convert 4 pixels at a time (scalar if some are translucent). */
+		for (; x+4 <= w; x += 4) {
+			const __m128i lo = _mm_loadu_si128((const __m128i *)
+			                                   &v[x << 2]);
+			const __m128i hi = _mm_loadu_si128((const __m128i *)
+			                                   &v[(x << 2) + 8]);
+			const __m128i px = _mm_packus_epi16(
+			    _mm_srai_epi16(_mm_adds_epi16(lo, rndV), SCALE_TBITS),
+			    _mm_srai_epi16(_mm_adds_epi16(hi, rndV), SCALE_TBITS));
+
+			if ((_mm_movemask_epi8(_mm_cmpeq_epi8(px, ones)) &
+			    aBits) == aBits) {
+				_mm_storeu_si128((__m128i *)&pDst[x << 2], px);
+			} else {
+				for (i = 0; i < 4; i++)
+					Scale_StorePixel(sc, &pDst[(x+i) << 2],
+					    &v[(x+i) << 2]);
+			}
+		}
+	}
+#endif /* BLIT32_SSE2 */
+	if (sc->aIdx == -1) {
+		for (i = (x << 2); i < (w << 2); i++) {
+			const int c = (v[i] + rnd) >> SCALE_TBITS;
+
+			pDst[i] = (Uint8)AG_MIN(AG_MAX(c, 0), 255);
+		}
+		return;
+	}
+	for (; x < w; x++)
+		Scale_StorePixel(sc, &pDst[x << 2], &v[x << 2]);
+}
+
+/* Vertical pass of the filtered scalers: produce target rows [y1,y2). */
+static void
+Scale_FilterV(void *_Nullable p, int y1, int y2)
+{
+	const ScaleCtx *sc = p;
+	AG_Surface *D = sc->D;
+	const int n = D->w << 2;			/* Channels per row */
+	const Sint32 rnd = 1 << (SCALE_WBITS-1);
+	Sint16 *row;
+	int y, i, k;
+
+	row = Malloc(n * sizeof(Sint16));
+
+	for (y = y1; y < y2; y++) {
+		const ScaleTaps *t = &sc->yTaps[y];
+		const Sint16 *W = &sc->yW[t->offs];
+		const Sint16 *pTmp = &sc->tmp[t->first * n];
+
+		i = 0;
+#ifdef BLIT32_SSE2
+		if (agCPU.ext & AG_EXT_SSE2) {
+			const __m128i rndV = _mm_set1_epi32(rnd);
+
+			for (; i+8 <= n; i += 8) {
+				__m128i accLo = rndV, accHi = rndV;
+
+				/* Interleave pairs of rows; madd by the weights. */
+				for (k = 0; k < t->n; k += 2) {
+					const int kb = (k+1 < t->n) ? k+1 : k;
+					const Sint16 wb = (k+1 < t->n) ? W[k+1] : 0;
+					const __m128i wV = _mm_set1_epi32((int)
+					    ((Uint16)W[k] | ((Uint32)(Uint16)wb << 16)));
+					const __m128i a = _mm_loadu_si128(
+					    (const __m128i *)&pTmp[k*n + i]);
+					const __m128i b = _mm_loadu_si128(
+					    (const __m128i *)&pTmp[kb*n + i]);
+
+					accLo = _mm_add_epi32(accLo, _mm_madd_epi16(
+					    _mm_unpacklo_epi16(a, b), wV));
+					accHi = _mm_add_epi32(accHi, _mm_madd_epi16(
+					    _mm_unpackhi_epi16(a, b), wV));
+				}
+				_mm_storeu_si128((__m128i *)&row[i], _mm_packs_epi32(
+				    _mm_srai_epi32(accLo, SCALE_WBITS),
+				    _mm_srai_epi32(accHi, SCALE_WBITS)));
+			}
+		}
+#endif /* BLIT32_SSE2 */
+		for (; i < n; i++) {
+			Sint32 acc = rnd;
+
+			for (k = 0; k < t->n; k++) {
+				acc += W[k] * pTmp[k*n + i];
+			}
+			acc >>= SCALE_WBITS;
+			row[i] = (Sint16)AG_MIN(AG_MAX(acc, -32768), 32767);
+		}
+		Scale_StoreRow(sc, D->pixels + y*D->pitch + D->Lpadding, row,
+		    D->w);
+	}
+	free(row);
+}
+
+/* Execute fn over [0,n), in parallel row bands if requested. */
+static void
+Scale_Run(ScaleCtx *_Nonnull sc, int n, Uint flags,
+    void (*_Nonnull fn)(void *_Nullable, int, int))
+{
+#if AG_MODEL != AG_SMALL
+	if (flags & AG_SCALE_PARALLEL) {
+		AG_TaskParallelFor(AG_TaskPoolDefault(), 0, n, 0, fn, sc);
+		return;
+	}
+#endif
+	fn(sc, 0, n);
+}
+
+/*
+ * Scale a 32-bit packed surface S with 8-bit components to D with a
+ * separable filter. Return -1 if there is insufficient memory.
+ */
+static int
+Scale_Filtered(const AG_Surface *_Nonnull S, AG_Surface *_Nonnull D,
+    Uint flags)
+{
+	ScaleCtx sc;
+	int R,G,B,A, i, rv = -1;
+
+	memset(&sc, 0, sizeof(sc));
+	sc.S = S;
+	sc.D = D;
+	if (Blit32_Format(&S->format, &R,&G,&B,&A) == -1) {
+		AG_SetErrorS("Bad format");
+		return (-1);
+	}
+#if AG_BYTEORDER == AG_BIG_ENDIAN
+	sc.aIdx = (A != -1) ? 3 - (A >> 3) : -1;
+#else
+	sc.aIdx = (A != -1) ? (A >> 3) : -1;
+#endif
+	for (i = 1; i < 256; i++) {		/* 255/a in 15-bit fixed-point */
+		sc.recip[i] = (255 << 15) / i;
+	}
+	if ((sc.xTaps = Scale_InitTaps(S->w, D->w, flags & AG_SCALE_FILTER,
+	                               &sc.xW)) == NULL ||
+	    (sc.yTaps = Scale_InitTaps(S->h, D->h, flags & AG_SCALE_FILTER,
+	                               &sc.yW)) == NULL ||
+	    (sc.tmp = TryMalloc(S->h * D->w * 4 * sizeof(Sint16))) == NULL)
+		goto out;
+
+	Scale_Run(&sc, S->h, flags, Scale_FilterH);
+	Scale_Run(&sc, D->h, flags, Scale_FilterV);
+	rv = 0;
+out:
+	Free(sc.tmp);
+	Free(sc.xTaps);
+	Free(sc.xW);
+	Free(sc.yTaps);
+	Free(sc.yW);
+	return (rv);
+}
+
 /*
  * Scale a surface to size w x h.
- * TODO optimized cases; filtering
- * TODO integer-only version
+ *
+ * The filter is selected by flags (AG_SCALE_NEAREST by default). Filtering
+ * is done in 32-bit RGBA with 8-bit components (other packed and grayscale
+ * formats are converted). Indexed surfaces are always scaled with nearest
+ * neighbor. With AG_SCALE_PARALLEL, process bands of rows in parallel on
+ * the default task pool.
  */
 AG_Surface *
 AG_SurfaceScale(const AG_Surface *S, Uint w, Uint h, Uint flags)
 {
 	AG_Surface *D;
-	float xf,yf;
-	int x,y;
+	ScaleCtx sc;
+	Uint filter = (flags & AG_SCALE_FILTER);
+	int R,G,B,A, x,y;
 
 	if (S->format.mode == AG_SURFACE_INDEXED &&
 	    S->format.BitsPerPixel < 8 &&
@@ -1462,46 +2474,315 @@ AG_SurfaceScale(const AG_Surface *S, Uint w, Uint h, Uint flags)
 		AG_SurfaceCopy(D, S);
 		return (D);
 	}
+	if (S->w == 0 || S->h == 0 || w == 0 || h == 0)
+		return (D);
+
+	if (S->format.mode == AG_SURFACE_INDEXED)
+		filter = AG_SCALE_NEAREST;
 
-	xf = (float)(S->w - 1) / (float)(D->w - 1);
-	yf = (float)(S->h - 1) / (float)(D->h - 1);
+	if (filter != AG_SCALE_NEAREST) {
+		if (Blit32_Format(&S->format, &R,&G,&B,&A) == 0) {
+			if (Scale_Filtered(S, D, flags) == 0)
+				return (D);
+		} else {
+			AG_Surface *Srgba, *Drgba;
 
-	for (y = 0; y < D->h; y++) {
-		for (x = 0; x < D->w; x++) {
-			AG_SurfacePut(D, x,y, AG_SurfaceGet(S, 
-			    (int)((float)x * xf),
-			    (int)((float)y * yf)));
+			Srgba = AG_SurfaceRGBA(S->w, S->h, 32, 0,
+#if AG_BYTEORDER == AG_BIG_ENDIAN
+			    0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff);
+#else
+			    0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+#endif
+			AG_SurfaceCopy(Srgba, S);
+			Drgba = AG_SurfaceNew(&Srgba->format, w,h, 0);
+			if (Scale_Filtered(Srgba, Drgba, flags) == 0) {
+				AG_SurfaceCopy(D, Drgba);
+				AG_SurfaceFree(Drgba);
+				AG_SurfaceFree(Srgba);
+				return (D);
+			}
+			AG_SurfaceFree(Drgba);
+			AG_SurfaceFree(Srgba);
 		}
+		/* Fallback to nearest neighbor. */
 	}
+
+	memset(&sc, 0, sizeof(sc));
+	sc.S = S;
+	sc.D = D;
+	sc.xMap = Malloc(w * sizeof(int));
+	sc.yMap = Malloc(h * sizeof(int));
+	for (x = 0; x < w; x++) {
+		sc.xMap[x] = (w > 1) ?
+		    (int)(((Uint64)x * (S->w - 1)) / (w - 1)) : 0;
+	}
+	for (y = 0; y < h; y++) {
+		sc.yMap[y] = (h > 1) ?
+		    (int)(((Uint64)y * (S->h - 1)) / (h - 1)) : 0;
+	}
+	Scale_Run(&sc, h, flags, Scale_Nearest);
+
+	free(sc.xMap);
+	free(sc.yMap);
 	return (D);
 }
 
-/* Fill a rectangle with pixels of a given color. */
+/*
+ * Fill the spans of a clipped rectangle r in a 1-, 2- or 4-bpp surface.
+ * Whole bytes are filled with a repeating pattern and the partial bytes at
+ * either end are written pixel by pixel.
+ */
+static void
+FillRect_Sub8(AG_Surface *_Nonnull S, const AG_Rect *_Nonnull r, Uint8 px)
+{
+	const int shift = S->format.PixelsPerByteShift;
+	const int ppb = (1 << shift);
+	const int x2 = r->x + r->w;
+	int xa = (r->x + ppb-1) & ~(ppb-1);	/* First whole byte */
+	int xb = x2 & ~(ppb-1);			/* End of whole bytes */
+	Uint8 pattern;
+	int x, y;
+
+	switch (S->format.BitsPerPixel) {
+	case 4:  pattern = px | (px << 4);	break;
+	case 2:  pattern = px * 0x55;		break;
+	default: pattern = px ? 0xff : 0x00;	break;
+	}
+	if (xa > xb) {					/* Within one byte */
+		xa = xb = x2;
+	}
+	for (y = r->y; y < r->y + r->h; y++) {
+		for (x = r->x; x < xa; x++) {
+			AG_SurfacePut8(S, x,y, px);
+		}
+		if (xb > xa) {
+			memset(S->pixels + y*S->pitch + S->Lpadding +
+			       (xa >> shift), pattern, (xb - xa) >> shift);
+		}
+		for (x = xb; x < x2; x++)
+			AG_SurfacePut8(S, x,y, px);
+	}
+}
+
+/*
+ * Fill a clipped rectangle r in an 8- to 64-bpp surface. The first span is
+ * filled by writing one pixel and doubling the filled area, and copied to
+ * the remaining rows. Fill with memset() if all bytes of px are the same.
+ */
+static void
+FillRect_Spans(AG_Surface *_Nonnull S, const AG_Rect *_Nonnull r,
+    AG_Pixel px)
+{
+	const int BytesPerPixel = S->format.BytesPerPixel;
+	const AG_Size len = (AG_Size)r->w * BytesPerPixel;
+	Uint8 *pRow = S->pixels + r->y*S->pitch + S->Lpadding +
+	              r->x*BytesPerPixel;
+	AG_Size n;
+	int i, y;
+
+	AG_SurfacePut_At(S, pRow, px);
+	for (i = 1; i < BytesPerPixel; i++) {
+		if (pRow[i] != pRow[0])
+			break;
+	}
+	if (i == BytesPerPixel) {
+		const Uint8 v = pRow[0];
+
+		for (y = 0; y < r->h; y++) {
+			memset(pRow, v, len);
+			pRow += S->pitch;
+		}
+		return;
+	}
+	for (n = BytesPerPixel; n < len; n <<= 1) {
+		memcpy(&pRow[n], pRow, AG_MIN(n, len - n));
+	}
+	for (y = 1; y < r->h; y++)
+		memcpy(pRow + y*S->pitch, pRow, len);
+}
+
+/*
+ * Fill a rectangle with pixels of a given color. If rd is NULL, fill the
+ * clipping rectangle of the surface. The alpha component of the target
+ * pixels is replaced by that of c (there is no blending).
+ */
 void
 AG_FillRect(AG_Surface *S, const AG_Rect *rd, const AG_Color *c)
 {
 	AG_Rect r;
 	AG_Pixel px;
-	int x,y;
 
-	if (rd != NULL) {
-		const int cx = S->clipRect.x, cx2 = S->clipRect.x+S->clipRect.w;
-		const int cy = S->clipRect.y, cy2 = S->clipRect.y+S->clipRect.h;
+	if (!AG_RectIntersect(&r, (rd != NULL) ? rd : &S->clipRect,
+	    &S->clipRect)) {
+		return;
+	}
+	px = AG_MapPixel(&S->format, c);
 
-		r = *rd;
-		if (r.x < cx)       { r.x = cx; }
-		if (r.y < cy)       { r.y = cy; }
-		if (r.x+r.w >= cx2) { r.w = cx2-r.x; }
-		if (r.y+r.h >= cy2) { r.h = cy2-r.y; }
+	if (S->format.BitsPerPixel < 8) {
+		FillRect_Sub8(S, &r, (Uint8)px);
 	} else {
-		r = S->clipRect;
+		FillRect_Spans(S, &r, px);
 	}
-	px = AG_MapPixel(&S->format, c);
+}
+
+/*
+ * Blend the color c into a clipped rectangle r in a 32-bit packed surface
+ * with 8-bit components (generic C version).
+ */
+static void
+BlendRect32(AG_Surface *_Nonnull S, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c, const Blit32 *_Nonnull b)
+{
+	const Uint32 a = c->a;
+	int x, y;
 
-	/* XXX TODO optimized cases */
-	for (y = r.y; y < r.h; y++)
-		for (x = r.x; x < r.w; x++)
-			AG_SurfacePut(S, x, y, px);
+	for (y = r->y; y < r->y + r->h; y++) {
+		Uint32 *p = (Uint32 *)(S->pixels + y*S->pitch + S->Lpadding) +
+		            r->x;
+
+		for (x = 0; x < r->w; x++) {
+			const Uint32 dpx = p[x];
+			Uint32 da;
+
+			p[x] = (Blit32_MixComponent(c->r, (dpx >> b->dR) & 0xff,
+			          a) << b->dR) |
+			       (Blit32_MixComponent(c->g, (dpx >> b->dG) & 0xff,
+			          a) << b->dG) |
+			       (Blit32_MixComponent(c->b, (dpx >> b->dB) & 0xff,
+			          a) << b->dB);
+			if (b->dA != -1) {
+				da = BLIT32_EXPAND((dpx >> b->dA) & 0xff) + a;
+				if (da > AG_COLOR_LAST) {
+					da = AG_COLOR_LAST;
+				}
+				p[x] |= BLIT32_REDUCE(da) << b->dA;
+			}
+		}
+	}
+}
+
+#ifdef BLIT32_SSE2
+/*
+ * Blend the color c into a clipped rectangle r in a 32-bit packed surface
+ * with 8-bit components (SSE2 version). Four pixels are processed at a time,
+ * with components unpacked into 16-bit lanes.
+ */
+static void
+BlendRect32_SSE2(AG_Surface *_Nonnull S, const AG_Rect *_Nonnull r,
+    const AG_Color *_Nonnull c, const Blit32 *_Nonnull b)
+{
+	const AG_PixelFormat *pf = &S->format;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i dMask = _mm_set1_epi32((int)(Uint32)(pf->Rmask |
+	                      pf->Gmask | pf->Bmask | pf->Amask));
+	const __m128i aV = _mm_set1_epi16((short)c->a);
+#if AG_MODEL == AG_LARGE
+	const __m128i one = _mm_set1_epi16(1);
+#else
+	const __m128i c255 = _mm_set1_epi16(0xff);
+#endif
+	Uint16 sLanes[4] = { 0,0,0,0 }, aLanes[4] = { 0,0,0,0 };
+	__m128i sV, aLane;
+	int x, y;
+
+	sLanes[b->dR >> 3] = c->r;
+	sLanes[b->dG >> 3] = c->g;
+	sLanes[b->dB >> 3] = c->b;
+	if (b->dA != -1) {
+		aLanes[b->dA >> 3] = 0xffff;
+	}
+	sV = _mm_set_epi16(sLanes[3], sLanes[2], sLanes[1], sLanes[0],
+	                   sLanes[3], sLanes[2], sLanes[1], sLanes[0]);
+	aLane = _mm_set_epi16(aLanes[3], aLanes[2], aLanes[1], aLanes[0],
+	                      aLanes[3], aLanes[2], aLanes[1], aLanes[0]);
+
+	for (y = r->y; y < r->y + r->h; y++) {
+		Uint32 *p = (Uint32 *)(S->pixels + y*S->pitch + S->Lpadding) +
+		            r->x;
+		AG_Rect rTail;
+
+		for (x = 0; x+4 <= r->w; x += 4) {
+			const __m128i d = _mm_loadu_si128((const __m128i *)&p[x]);
+			__m128i dl, dh, rl, rh;
+#if AG_MODEL == AG_LARGE
+			dl = _mm_unpacklo_epi8(d, d);	/* Expand by 257 */
+			dh = _mm_unpackhi_epi8(d, d);
+#else
+			dl = _mm_unpacklo_epi8(d, zero);
+			dh = _mm_unpackhi_epi8(d, zero);
+#endif
+			BLIT32_SSE2_MIX(rl, sV, dl, aV);
+			BLIT32_SSE2_MIX(rh, sV, dh, aV);
+			_mm_storeu_si128((__m128i *)&p[x],
+			    _mm_and_si128(_mm_packus_epi16(rl, rh), dMask));
+		}
+		if (x < r->w) {
+			rTail.x = r->x + x;
+			rTail.y = y;
+			rTail.w = r->w - x;
+			rTail.h = 1;
+			BlendRect32(S, &rTail, c, b);
+		}
+	}
+}
+#endif /* BLIT32_SSE2 */
+
+/*
+ * Blend a rectangle of the given color into a surface, as AG_SurfaceBlend()
+ * would for each pixel. If rd is NULL, blend into the clipping rectangle of
+ * the surface. An opaque c is equivalent to AG_FillRect().
+ */
+void
+AG_SurfaceBlendRect(AG_Surface *S, const AG_Rect *rd, const AG_Color *c)
+{
+	AG_Rect r;
+	Blit32 b;
+	int x, y;
+
+	if (c->a == AG_OPAQUE) {
+		AG_FillRect(S, rd, c);
+		return;
+	}
+	if (c->a == AG_TRANSPARENT ||
+	    !AG_RectIntersect(&r, (rd != NULL) ? rd : &S->clipRect,
+	    &S->clipRect)) {
+		return;
+	}
+	if (Blit32_Format(&S->format, &b.dR, &b.dG, &b.dB, &b.dA) == 0) {
+#ifdef BLIT32_SSE2
+		if (agCPU.ext & AG_EXT_SSE2) {
+			BlendRect32_SSE2(S, &r, c, &b);
+			return;
+		}
+#endif
+		BlendRect32(S, &r, c, &b);
+		return;
+	}
+	if (S->format.BitsPerPixel < 8) {
+		for (y = r.y; y < r.y + r.h; y++) {
+			for (x = r.x; x < r.x + r.w; x++) {
+				AG_Color pc;
+
+				AG_GetColor(&pc, AG_SurfaceGet8(S, x,y),
+				    &S->format);
+				pc.r += ((c->r - pc.r) * c->a) >> AG_COMPONENT_BITS;
+				pc.g += ((c->g - pc.g) * c->a) >> AG_COMPONENT_BITS;
+				pc.b += ((c->b - pc.b) * c->a) >> AG_COMPONENT_BITS;
+				AG_SurfacePut8(S, x,y,
+				    (Uint8)AG_MapPixel(&S->format, &pc));
+			}
+		}
+		return;
+	}
+	for (y = r.y; y < r.y + r.h; y++) {
+		Uint8 *p = S->pixels + y*S->pitch + S->Lpadding +
+		           r.x*S->format.BytesPerPixel;
+
+		for (x = 0; x < r.w; x++) {
+			AG_SurfaceBlend_At(S, p, c);
+			p += S->format.BytesPerPixel;
+		}
+	}
 }
 
 /* Return the pixel at x,y in a 1- to 8-bpp surface S. */
@@ -2444,6 +3725,50 @@ const AG_LowerBlit agLowerBlits_Std_Packed[] = {
 	{ AG_SURFACE_INDEXED, 0,  2,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Packed_to_Sub8 },
 	{ AG_SURFACE_INDEXED, 0,  4,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Packed_to_Sub8 },
 	{ AG_SURFACE_INDEXED, 0,  8,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Packed_to_8 },
+#ifdef BLIT32_SSE2
+	{
+		AG_SURFACE_PACKED, 32, 32,
+		AG_LOWERBLIT_PSALPHA_SRC | AG_LOWERBLIT_COLORKEY_SRC, AG_EXT_SSE2,
+		0,0,0,0, 0,0,0,0,
+		AG_LowerBlit_Packed32_AlCo_SSE2
+	},{
+		AG_SURFACE_PACKED, 32, 32,
+		AG_LOWERBLIT_PSALPHA_SRC, AG_EXT_SSE2,
+		0,0,0,0, 0,0,0,0,
+		AG_LowerBlit_Packed32_Al_SSE2
+	},{
+		AG_SURFACE_PACKED, 32, 32,
+		AG_LOWERBLIT_COLORKEY_SRC, AG_EXT_SSE2,
+		0,0,0,0, 0,0,0,0,
+		AG_LowerBlit_Packed32_Co_SSE2
+	},{
+		AG_SURFACE_PACKED, 32, 32,
+		0, AG_EXT_SSE2,
+		0,0,0,0, 0,0,0,0,
+		AG_LowerBlit_Packed32_SSE2
+	},
+#endif
+	{
+		AG_SURFACE_PACKED, 32, 32,
+		AG_LOWERBLIT_PSALPHA_SRC | AG_LOWERBLIT_COLORKEY_SRC, 0,
+		0,0,0,0, 0,0,0,0,
+		AG_LowerBlit_Packed32_AlCo
+	},{
+		AG_SURFACE_PACKED, 32, 32,
+		AG_LOWERBLIT_PSALPHA_SRC, 0,
+		0,0,0,0, 0,0,0,0,
+		AG_LowerBlit_Packed32_Al
+	},{
+		AG_SURFACE_PACKED, 32, 32,
+		AG_LOWERBLIT_COLORKEY_SRC, 0,
+		0,0,0,0, 0,0,0,0,
+		AG_LowerBlit_Packed32_Co
+	},{
+		AG_SURFACE_PACKED, 32, 32,
+		0, 0,
+		0,0,0,0, 0,0,0,0,
+		AG_LowerBlit_Packed32
+	},
 	{
 		AG_SURFACE_PACKED, 0, 0,
 		AG_LOWERBLIT_PSALPHA_SRC | AG_LOWERBLIT_COLORKEY_SRC, 0,
@@ -2482,6 +3807,7 @@ const AG_LowerBlit agLowerBlits_Std_Indexed[] = {
 	{ AG_SURFACE_ANY,    1,  0,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Sub8_to_Any },
 	{ AG_SURFACE_ANY,    2,  0,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Sub8_to_Any },
 	{ AG_SURFACE_ANY,    4,  0,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Sub8_to_Any },
+	{ AG_SURFACE_PACKED, 8, 32,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Indexed8_to_Packed32 },
 	{ AG_SURFACE_ANY,    8,  0,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Sub8_to_Any },
 	{ AG_SURFACE_ANY,    0,  0,   0,  0,  0,0,0,0, 0,0,0,0, AG_LowerBlit_Sub8_to_Any }
 };
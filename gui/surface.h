@@ -237,6 +237,15 @@ typedef enum ag_alpha_func {
 	AG_ALPHA_LAST
 } AG_AlphaFn;
 
+/* Flags for AG_SurfaceScale() */
+#define AG_SCALE_NEAREST  0x00          /* Nearest neighbor (default) */
+#define AG_SCALE_BILINEAR 0x01          /* Bilinear interpolation */
+#define AG_SCALE_BOX      0x02          /* Box filter (area averaging) */
+#define AG_SCALE_LANCZOS  0x03          /* Lanczos filter (a=3) */
+#define AG_SCALE_FILTER   0x0f          /* Mask of filter selection */
+#define AG_SCALE_PARALLEL 0x10          /* Process bands of rows in parallel
+                                           on the default task pool */
+
 /* Flags for AG_SurfaceExportBMP () */
 #define AG_EXPORT_BMP_NO_32BIT 0x01     /* Don't export a 32-bit BMP even when
                                            surface has an alpha channel */
@@ -399,6 +408,8 @@ void AG_SurfaceBlendRGB8_At(AG_Surface *_Nonnull, Uint8 *_Nonnull,
 
 void  AG_FillRect(AG_Surface *_Nonnull, const AG_Rect *_Nullable,
                   const AG_Color *_Nonnull);
+void  AG_SurfaceBlendRect(AG_Surface *_Nonnull, const AG_Rect *_Nullable,
+                          const AG_Color *_Nonnull);
 
 Uint8 AG_SurfaceGet8(const AG_Surface *_Nonnull, int,int)
                     _Pure_Attribute;
@@ -61,7 +61,7 @@ AG_TableNew(void *parent, Uint flags)
 {
 	AG_Table *t;
 
-	t = Malloc(sizeof(AG_Table));
+	t = AG_ObjectAlloc(&agTableClass);
 	AG_ObjectInit(t, &agTableClass);
 
 	if (flags & AG_TABLE_HFILL) { WIDGET(t)->flags |= AG_WIDGET_HFILL; }
@@ -951,14 +951,35 @@ static __inline__ Uint
 HashPrevCell(AG_Table *_Nonnull t, const AG_TableCell *_Nonnull c)
 {
 	char buf[AG_TABLE_HASHBUF_MAX];
-	Uchar *p;
-	Uint h;
 
 	AG_TablePrintCell(c, buf, sizeof(buf));
-	for (h = 0, p = (Uchar *)buf; *p != '\0'; p++) {
-		h = 31*h + *p;
+	return (Uint)(AG_HashString(buf) & (t->nPrevBuckets - 1));
+}
+
+/*
+ * Grow the backing store hash (which must be empty) such that it averages
+ * no more than 4 cells per bucket.
+ */
+static void
+SizePrevBuckets(AG_Table *_Nonnull t)
+{
+	const Uint nCells = (Uint)t->m * (Uint)t->n;
+	AG_TableBucket *cPrevNew;
+	Uint i, nBuckets;
+
+	for (nBuckets = t->nPrevBuckets;
+	     nBuckets < (nCells >> 2);
+	     nBuckets <<= 1)
+		;
+	if (nBuckets == t->nPrevBuckets ||
+	    (cPrevNew = TryRealloc(t->cPrev,
+	     nBuckets*sizeof(AG_TableBucket))) == NULL) {
+		return;
 	}
-	return (h % t->nPrevBuckets);
+	t->cPrev = cPrevNew;
+	t->nPrevBuckets = nBuckets;
+	for (i = 0; i < nBuckets; i++)
+		TAILQ_INIT(&t->cPrev[i].cells);
 }
 
 void
@@ -979,6 +1000,9 @@ AG_TableBegin(AG_Table *t)
 	AG_OBJECT_ISA(t, "AG_Widget:AG_Table:*");
 	AG_ObjectLock(t);		/* Lock across TableBegin/End */
 
+	if (TAILQ_EMPTY(&t->cPrevList))
+		SizePrevBuckets(t);
+
 	/* Copy the existing cells to the backing store and free the table. */
 	for (m = 0; m < t->m; m++) {
 		for (n = 0; n < t->n; n++) {
@@ -2469,7 +2493,7 @@ Init(void *_Nonnull obj)
 	AG_BindInt(sb, "visible", &t->mVis);
 	AG_WidgetSetFocusable(sb, 0);
 
-	t->nPrevBuckets = 256;
+	t->nPrevBuckets = 256;				/* Power of 2 */
 	t->cPrev = Malloc(t->nPrevBuckets*sizeof(AG_TableBucket));
 	for (i = 0; i < t->nPrevBuckets; i++) {
 		AG_TableBucket *tb = &t->cPrev[i];
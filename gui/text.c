@@ -338,25 +338,6 @@ AG_PopTextState(void)
 	--agTextStateCur;
 }
 
-/* Clear the glyph cache. */
-void
-AG_TextClearGlyphCache(AG_Driver *drv)
-{
-	int i;
-	AG_Glyph *G, *Gnext;
-
-	for (i = 0; i < AG_GLYPH_NBUCKETS; i++) {
-		for (G = SLIST_FIRST(&drv->glyphCache[i].glyphs);
-		     G != SLIST_END(&drv->glyphCache[i].glyphs);
-		     G = Gnext) {
-			Gnext = SLIST_NEXT(G, glyphs);
-			AG_SurfaceFree(G->su);
-			free(G);
-		}
-		SLIST_INIT(&drv->glyphCache[i].glyphs);
-	}
-}
-
 static __inline__ void
 InitMetrics(AG_TextMetrics *_Nonnull Tm)
 {
@@ -1353,21 +1334,298 @@ AG_TextExportUnicode_StripANSI(const char *encoding, char *dst, const AG_Char *u
 	}
 }
 
+/*
+ * Glyph cache. Glyphs are rendered once per (font, character) in white over
+ * a transparent background and packed into shared atlas pages by a simple
+ * shelf allocator. Pages are kept in most-recently-used order; when the
+ * memory budget would be exceeded, the least recently used page is evicted
+ * (its glyphs are forgotten) and reused.
+ */
+
+static __inline__ Uint
+GlyphHash(const AG_Font *_Nonnull font, AG_Char ch)
+{
+	return (Uint)((ch + (AG_Char)font->height * 31) % AG_GLYPH_NBUCKETS);
+}
+
+static __inline__ AG_Size
+GlyphPageSize(const AG_GlyphPage *_Nonnull page)
+{
+	const AG_Surface *S = page->S;
+
+	return (AG_Size)S->h * (AG_Size)S->pitch;
+}
+
+/* Forget about all glyphs allocated in an atlas page. */
+static void
+GlyphPageReset(AG_GlyphCache *_Nonnull gc, AG_GlyphPage *_Nonnull page)
+{
+	AG_Glyph *G, *Gnext;
+
+	for (G = SLIST_FIRST(&page->glyphs);
+	     G != SLIST_END(&page->glyphs);
+	     G = Gnext) {
+		Gnext = SLIST_NEXT(G, pglyphs);
+		LIST_REMOVE(G, glyphs);
+		free(G);
+		gc->nGlyphs--;
+	}
+	SLIST_INIT(&page->glyphs);
+	page->nGlyphs = 0;
+	page->nShelves = 0;
+	page->yFree = 0;
+}
+
+static void
+GlyphPageFree(AG_Driver *_Nonnull drv, AG_GlyphPage *_Nonnull page)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+
+	GlyphPageReset(gc, page);
+	TAILQ_REMOVE(&gc->pages, page, pages);
+	gc->size -= GlyphPageSize(page);
+	gc->nPages--;
+
+	if (page->texture != 0) {
+		AGDRIVER_CLASS(drv)->deleteTexture(drv, page->texture);
+	}
+	AG_SurfaceFree(page->S);
+	Free(page->shelves);
+	free(page);
+}
+
+/*
+ * Compute the dimensions of a new atlas page able to hold a w x h glyph.
+ * Shrink the default page size so that a page fits within the budget, but
+ * never below the size of the glyph itself.
+ */
+static void
+GlyphPageDims(const AG_GlyphCache *_Nonnull gc, int w, int h,
+    int *_Nonnull wPage, int *_Nonnull hPage)
+{
+	const AG_Size Bpp = agSurfaceFmt->BytesPerPixel;
+	int wp = AG_GLYPH_PAGE_SIZE, hp = AG_GLYPH_PAGE_SIZE;
+
+	while (gc->budget != 0 &&
+	       (AG_Size)wp * (AG_Size)hp * Bpp > gc->budget) {
+		if ((wp >> 1) >= w && wp >= hp) {
+			wp >>= 1;
+		} else if ((hp >> 1) >= h) {
+			hp >>= 1;
+		} else if ((wp >> 1) >= w) {
+			wp >>= 1;
+		} else {
+			break;
+		}
+	}
+	while (wp < w) { wp <<= 1; }           /* Oversized glyph */
+	while (hp < h) { hp <<= 1; }
+
+	*wPage = wp;
+	*hPage = hp;
+}
+
+static AG_GlyphPage *_Nonnull
+GlyphPageNew(AG_Driver *_Nonnull drv, int wPage, int hPage)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_GlyphPage *page;
+
+	page = Malloc(sizeof(AG_GlyphPage));
+	page->S = AG_SurfaceNew(agSurfaceFmt, wPage, hPage,
+	    AG_SURFACE_GL_TEXTURE);
+	page->shelves = NULL;
+	page->nShelves = 0;
+	page->yFree = 0;
+	page->nGlyphs = 0;
+	page->texture = 0;
+	SLIST_INIT(&page->glyphs);
+	TAILQ_INSERT_HEAD(&gc->pages, page, pages);
+	gc->size += GlyphPageSize(page);
+	gc->nPages++;
+	return (page);
+}
+
+/*
+ * Allocate a w x h area in an atlas page (best-fitting shelf first, then a
+ * new shelf). Return 0 on success or -1 if the page is full.
+ */
+static int
+GlyphPageAlloc(AG_GlyphPage *_Nonnull page, int w, int h, AG_Rect *_Nonnull r)
+{
+	const int wPage = page->S->w;
+	const int hPage = page->S->h;
+	AG_GlyphShelf *sh, *shBest = NULL;
+	Uint i;
+
+	if (w > wPage || h > hPage)
+		return (-1);
+
+	for (i = 0; i < page->nShelves; i++) {
+		sh = &page->shelves[i];
+		if (sh->h >= h && sh->h <= h + (h >> 1) + 1 &&
+		    wPage - sh->x >= w &&
+		    (shBest == NULL || sh->h < shBest->h))
+			shBest = sh;
+	}
+	if (shBest == NULL) {
+		if (page->yFree + h > hPage) {
+			return (-1);
+		}
+		page->shelves = Realloc(page->shelves,
+		    (page->nShelves + 1) * sizeof(AG_GlyphShelf));
+		shBest = &page->shelves[page->nShelves++];
+		shBest->x = 0;
+		shBest->y = (Uint16)page->yFree;
+		shBest->h = (Uint16)h;
+		shBest->_pad = 0;
+		page->yFree += h;
+	}
+	r->x = shBest->x;
+	r->y = shBest->y;
+	r->w = w;
+	r->h = h;
+	shBest->x += (Uint16)w;
+	return (0);
+}
+
+/*
+ * Find room for a w x h glyph (1 pixel padding included), creating or
+ * evicting pages as needed. The page is moved to the head of the list.
+ */
+static AG_GlyphPage *_Nonnull
+GlyphCacheAlloc(AG_Driver *_Nonnull drv, int w, int h, AG_Rect *_Nonnull r)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_GlyphPage *page;
+	AG_Size sizeNew;
+	int wPage, hPage;
+
+	TAILQ_FOREACH(page, &gc->pages, pages) {
+		if (GlyphPageAlloc(page, w,h, r) == 0)
+			goto out;
+	}
+
+	GlyphPageDims(gc, w,h, &wPage, &hPage);
+	sizeNew = (AG_Size)wPage * (AG_Size)hPage *
+	          agSurfaceFmt->BytesPerPixel;
+
+	if (gc->budget != 0 && gc->size + sizeNew > gc->budget &&
+	    (page = TAILQ_LAST(&gc->pages, ag_glyph_pageq)) != NULL &&
+	    page->S->w == wPage && page->S->h == hPage) {
+		/* Over budget: recycle the least recently used page. */
+		GlyphPageReset(gc, page);
+		gc->nEvictions++;
+		if (GlyphPageAlloc(page, w,h, r) == 0)
+			goto out;
+	}
+	while (gc->budget != 0 && gc->size + sizeNew > gc->budget &&
+	       (page = TAILQ_LAST(&gc->pages, ag_glyph_pageq)) != NULL) {
+		GlyphPageFree(drv, page);
+		gc->nEvictions++;
+	}
+	page = GlyphPageNew(drv, wPage, hPage);
+	if (GlyphPageAlloc(page, w,h, r) == -1) {
+		AG_FatalError("GlyphPageAlloc");
+	}
+	return (page);
+out:
+	if (page != TAILQ_FIRST(&gc->pages)) {
+		TAILQ_REMOVE(&gc->pages, page, pages);
+		TAILQ_INSERT_HEAD(&gc->pages, page, pages);
+	}
+	return (page);
+}
+
+/* Clear the glyph cache. */
+void
+AG_TextClearGlyphCache(AG_Driver *drv)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_GlyphPage *page;
+
+	while ((page = TAILQ_FIRST(&gc->pages)) != NULL) {
+		GlyphPageFree(drv, page);
+	}
+	if (gc->tint != NULL) {
+		AG_SurfaceFree(gc->tint);
+		gc->tint = NULL;
+	}
+}
+
+/*
+ * Set the maximum amount of memory (in bytes) used by the glyph cache
+ * of a driver. Evict pages as needed. A budget of 0 means no limit.
+ * New pages are made smaller than AG_GLYPH_PAGE_SIZE if needed to fit
+ * the budget. The budget may only be exceeded by the single page holding
+ * the last rendered glyph, if that glyph alone does not fit.
+ */
+void
+AG_TextSetGlyphCacheBudget(AG_Driver *drv, AG_Size budget)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_GlyphPage *page;
+
+	gc->budget = budget;
+	while (budget != 0 && gc->size > budget &&
+	       (page = TAILQ_LAST(&gc->pages, ag_glyph_pageq)) != NULL) {
+		GlyphPageFree(drv, page);
+		gc->nEvictions++;
+	}
+}
+
 static AG_Glyph *_Nonnull
 TextRenderGlyph_Miss(AG_Driver *_Nonnull drv, AG_Font *_Nonnull font,
-    const AG_Color *_Nonnull cBg, const AG_Color *_Nonnull cFg, AG_Char ch)
+    AG_Char ch)
 {
+	AG_Color cBg, cFg;
 	AG_Glyph *G;
+	AG_GlyphPage *page;
+	AG_Surface *S, *Sg;
+	AG_Rect r;
 	AG_Char s[2];
+	int y;
 
-	G = Malloc(sizeof(AG_Glyph));
-	G->font = (AG_Font *)font;
-	G->colorBG = *cBg;
-	G->color = *cFg;
-	G->ch = ch;
 	s[0] = ch;
 	s[1] = '\0';
-	G->su = AG_TextRenderInternal(s, font, cBg,cFg);    /* Render glyph */
+	AG_ColorNone(&cBg);
+	AG_ColorWhite(&cFg);
+	Sg = AG_TextRenderInternal(s, font, &cBg, &cFg);    /* Render glyph */
+
+	page = GlyphCacheAlloc(drv, Sg->w + 1, Sg->h + 1, &r);
+	S = page->S;
+	AG_FillRect(S, &r, &cBg);                      /* Clear with padding */
+	r.w--;
+	r.h--;
+	if (AG_PixelFormatCompare(&Sg->format, &S->format) == 0) {
+		const int len = r.w * S->format.BytesPerPixel;
+
+		for (y = 0; y < r.h; y++) {
+			memcpy(S->pixels + (r.y + y)*S->pitch +
+			                   r.x*S->format.BytesPerPixel,
+			       Sg->pixels + y*Sg->pitch, len);
+		}
+	} else {
+		AG_SurfaceBlit(Sg, NULL, S, r.x, r.y);
+	}
+	AG_SurfaceFree(Sg);
+
+	G = Malloc(sizeof(AG_Glyph));
+	G->font = font;
+	G->su = S;
+	G->page = page;
+	G->rs = r;
+	G->ch = ch;
+	G->texture = 0;
+	G->flags = (font->spec.type == AG_FONT_BITMAP) ? AG_GLYPH_NO_TINT : 0;
+	G->texcoords.x = 0.0f;
+	G->texcoords.y = 0.0f;
+	G->texcoords.w = 0.0f;
+	G->texcoords.h = 0.0f;
+	SLIST_INSERT_HEAD(&page->glyphs, G, pglyphs);
+	page->nGlyphs++;
+	drv->glyphCache->nGlyphs++;
+
 	AGFONT_OPS(font)->get_glyph_metrics(font, G);    /* Get the advance */
 	AGDRIVER_CLASS(drv)->updateGlyph(drv, G);   /* Prepare GPU transfer */
 	return (G);
@@ -1379,29 +1637,242 @@ TextRenderGlyph_Miss(AG_Driver *_Nonnull drv, AG_Font *_Nonnull font,
  * AG_Driver(3) instances because glyph renderings may be associated with
  * driver-specific hardware textures.
  *
+ * The returned glyph is shared by all colors and remains valid until the
+ * next call to AG_TextRenderGlyph() (which may evict it from the cache).
+ *
  * Must be called from GUI rendering context.
  */
 AG_Glyph *
 AG_TextRenderGlyph(AG_Driver *drv, AG_Font *font,
     const AG_Color *cBg, const AG_Color *cFg, AG_Char ch)
 {
+	AG_GlyphCache *gc = drv->glyphCache;
 	AG_Glyph *G;
-	const Uint h = (Uint)(ch % AG_GLYPH_NBUCKETS);
+	const Uint h = GlyphHash(font, ch);
 
-	SLIST_FOREACH(G, &drv->glyphCache[h].glyphs, glyphs) {
-		if (ch == G->ch &&
-		    font == G->font &&
-		    AG_ColorCompare(cBg, &G->colorBG) == 0 &&
-		    AG_ColorCompare(cFg, &G->color) == 0)
+	LIST_FOREACH(G, &gc->buckets[h], glyphs) {
+		if (ch == G->ch && font == G->font)
 			break;
 	}
 	if (G == NULL) {
-		G = TextRenderGlyph_Miss(drv, font, cBg, cFg, ch);
-		SLIST_INSERT_HEAD(&drv->glyphCache[h].glyphs, G, glyphs);
+		G = TextRenderGlyph_Miss(drv, font, ch);
+		LIST_INSERT_HEAD(&gc->buckets[h], G, glyphs);
+	} else if (G->page != TAILQ_FIRST(&gc->pages)) {
+		TAILQ_REMOVE(&gc->pages, G->page, pages);
+		TAILQ_INSERT_HEAD(&gc->pages, G->page, pages);
 	}
+	G->colorBG = *cBg;
+	G->color = *cFg;
 	return (G);
 }
 
+/* Whether pf is a 32-bit format with 8-bit components. */
+static __inline__ int
+GlyphFormat32(const AG_PixelFormat *_Nonnull pf)
+{
+	return (pf->mode == AG_SURFACE_PACKED && pf->BitsPerPixel == 32 &&
+	        (pf->Rmask >> pf->Rshift) == 0xff &&
+	        (pf->Gmask >> pf->Gshift) == 0xff &&
+	        (pf->Bmask >> pf->Bshift) == 0xff &&
+	        (pf->Amask == 0 || (pf->Amask >> pf->Ashift) == 0xff));
+}
+
+/* Divide an 8-bit by 8-bit product by 255 (rounded). */
+#define GLYPH_DIV255(x) (((x) + 128 + (((x) + 128) >> 8)) >> 8)
+
+/* TextBlitGlyphPixels() between 32-bit surfaces. */
+static void
+TextBlitGlyphPixels32(AG_Surface *_Nonnull D, const AG_Glyph *_Nonnull G,
+    const AG_Rect *_Nonnull r, int sx, int sy, int put)
+{
+	const AG_Surface *S = G->su;
+	const int sR = S->format.Rshift, sG = S->format.Gshift;
+	const int sB = S->format.Bshift, sA = S->format.Ashift;
+	const int dR = D->format.Rshift, dG = D->format.Gshift;
+	const int dB = D->format.Bshift, dA = D->format.Ashift;
+	const Uint32 dAmask = (Uint32)D->format.Amask;
+	const Uint32 sRGB = (Uint32)(S->format.Rmask | S->format.Gmask |
+	                             S->format.Bmask);
+	const int tint = !(G->flags & AG_GLYPH_NO_TINT);
+	const Uint32 fR = AG_Hto8(G->color.r), fG = AG_Hto8(G->color.g);
+	const Uint32 fB = AG_Hto8(G->color.b), fA = AG_Hto8(G->color.a);
+	int i, j;
+
+	for (j = 0; j < r->h; j++) {
+		const Uint32 *pSrc = (const Uint32 *)(S->pixels +
+		    (sy + j)*S->pitch + (sx << 2));
+		Uint32 *pDst = (Uint32 *)(D->pixels + (r->y + j)*D->pitch +
+		    D->Lpadding + (r->x << 2));
+
+		for (i = 0; i < r->w; i++, pSrc++, pDst++) {
+			const Uint32 sp = *pSrc;
+			Uint32 cR, cG, cB, a, ia, dp, da;
+
+			if ((a = (sp >> sA) & 0xff) == 0) {
+				continue;
+			}
+			if (tint && (sp & sRGB) == sRGB) {    /* White (usual) */
+				cR = fR;
+				cG = fG;
+				cB = fB;
+			} else {
+				cR = (sp >> sR) & 0xff;
+				cG = (sp >> sG) & 0xff;
+				cB = (sp >> sB) & 0xff;
+				if (tint) {
+					cR = GLYPH_DIV255(cR * fR);
+					cG = GLYPH_DIV255(cG * fG);
+					cB = GLYPH_DIV255(cB * fB);
+				}
+			}
+			if (tint && fA != 0xff) {
+				a = GLYPH_DIV255(a * fA);
+			}
+			if (!put && a < 0xff) {
+				if (a == 0) {
+					continue;
+				}
+				ia = 0xff - a;
+				dp = *pDst;
+				cR = GLYPH_DIV255(cR*a + ((dp >> dR) & 0xff)*ia);
+				cG = GLYPH_DIV255(cG*a + ((dp >> dG) & 0xff)*ia);
+				cB = GLYPH_DIV255(cB*a + ((dp >> dB) & 0xff)*ia);
+				da = ((dp & dAmask) >> dA) + a;
+				a = (da > 0xff) ? 0xff : da;
+			}
+			*pDst = (cR << dR) | (cG << dG) | (cB << dB) |
+			        ((a << dA) & dAmask);
+		}
+	}
+}
+
+/*
+ * Write the pixels of glyph G (tinted in its foreground color) at x,y in
+ * packed surface D. Clip to the clipping rectangle of D. If put is 1,
+ * overwrite the destination pixels, otherwise blend.
+ */
+static void
+TextBlitGlyphPixels(AG_Surface *_Nonnull D, const AG_Glyph *_Nonnull G,
+    int x, int y, int put)
+{
+	const AG_Surface *S = G->su;
+	const AG_Color *cFg = &G->color;
+	const int tint = !(G->flags & AG_GLYPH_NO_TINT);
+	const int SBpp = S->format.BytesPerPixel;
+	const int DBpp = D->format.BytesPerPixel;
+	AG_Rect r;
+	int sx, sy, i, j;
+
+	r.x = x;
+	r.y = y;
+	r.w = G->rs.w;
+	r.h = G->rs.h;
+	if (!AG_RectIntersect(&r, &r, &D->clipRect)) {
+		return;
+	}
+	sx = G->rs.x + (r.x - x);
+	sy = G->rs.y + (r.y - y);
+
+	if (GlyphFormat32(&S->format) && S->format.Amask != 0 &&
+	    GlyphFormat32(&D->format)) {
+		TextBlitGlyphPixels32(D, G, &r, sx,sy, put);
+		return;
+	}
+
+	for (j = 0; j < r.h; j++) {
+		const Uint8 *pSrc = S->pixels + (sy + j)*S->pitch + sx*SBpp;
+		Uint8 *pDst = D->pixels + (r.y + j)*D->pitch + D->Lpadding +
+		              r.x*DBpp;
+
+		for (i = 0; i < r.w; i++, pSrc += SBpp, pDst += DBpp) {
+			AG_Color c, dc;
+			Uint32 a, ia;
+
+			AG_GetColor(&c, AG_SurfaceGet_At(S, pSrc), &S->format);
+			if (c.a == AG_TRANSPARENT) {
+				continue;
+			}
+			if (tint) {
+				c.r = (AG_Component)(((Uint32)c.r * cFg->r) /
+				                     AG_COLOR_LAST);
+				c.g = (AG_Component)(((Uint32)c.g * cFg->g) /
+				                     AG_COLOR_LAST);
+				c.b = (AG_Component)(((Uint32)c.b * cFg->b) /
+				                     AG_COLOR_LAST);
+				c.a = (AG_Component)(((Uint32)c.a * cFg->a) /
+				                     AG_COLOR_LAST);
+			}
+			if (put || c.a == AG_OPAQUE) {
+				AG_SurfacePut_At(D, pDst,
+				    AG_MapPixel(&D->format, &c));
+				continue;
+			}
+			a = c.a;
+			ia = AG_COLOR_LAST - a;
+			AG_GetColor(&dc, AG_SurfaceGet_At(D, pDst), &D->format);
+			dc.r = (AG_Component)(((Uint32)c.r*a + dc.r*ia) /
+			                      AG_COLOR_LAST);
+			dc.g = (AG_Component)(((Uint32)c.g*a + dc.g*ia) /
+			                      AG_COLOR_LAST);
+			dc.b = (AG_Component)(((Uint32)c.b*a + dc.b*ia) /
+			                      AG_COLOR_LAST);
+			dc.a = (dc.a + a > AG_COLOR_LAST) ? AG_COLOR_LAST :
+			       (AG_Component)(dc.a + a);
+			AG_SurfacePut_At(D, pDst, AG_MapPixel(&D->format, &dc));
+		}
+	}
+}
+
+/*
+ * Draw glyph G at x,y in surface D using the colors of the last
+ * AG_TextRenderGlyph() request (for software rendering drivers).
+ * D must be a packed surface of 8 bits per pixel or more.
+ */
+void
+AG_TextBlitGlyph(AG_Surface *D, const AG_Glyph *G, int x, int y)
+{
+	if (G->colorBG.a != AG_TRANSPARENT) {
+		AG_Rect r;
+
+		r.x = x;
+		r.y = y;
+		r.w = G->rs.w;
+		r.h = G->rs.h;
+		AG_SurfaceBlendRect(D, &r, &G->colorBG);
+	}
+	TextBlitGlyphPixels(D, G, x,y, 0);
+}
+
+/*
+ * Return a surface whose upper-left G->rs.w x G->rs.h area contains glyph G
+ * in the colors of the last AG_TextRenderGlyph() request. The surface is
+ * owned by the driver and valid until the next call.
+ */
+AG_Surface *
+AG_TextGlyphSurface(AG_Driver *drv, const AG_Glyph *G)
+{
+	AG_GlyphCache *gc = drv->glyphCache;
+	AG_Surface *S = gc->tint;
+	AG_Rect r;
+
+	if (S == NULL || S->w < G->rs.w || S->h < G->rs.h) {
+		const int w = (S != NULL) ? AG_MAX(S->w, G->rs.w) : G->rs.w;
+		const int h = (S != NULL) ? AG_MAX(S->h, G->rs.h) : G->rs.h;
+
+		if (S != NULL) {
+			AG_SurfaceFree(S);
+		}
+		S = gc->tint = AG_SurfaceNew(agSurfaceFmt, w,h, 0);
+	}
+	r.x = 0;
+	r.y = 0;
+	r.w = G->rs.w;
+	r.h = G->rs.h;
+	AG_FillRect(S, &r, &G->colorBG);
+	TextBlitGlyphPixels(S, G, 0,0, (G->colorBG.a == AG_TRANSPARENT));
+	return (S);
+}
+
 /*
  * Set foreground text color from the given AG_Color(3).
  * Applies to the current text rendering state.
@@ -269,6 +269,7 @@ AG_Font *_Nullable AG_TextFontPct(int);
 AG_Font *_Nullable AG_TextFontPctFlags(int, Uint);
 void               AG_PopTextState(void);
 void               AG_TextClearGlyphCache(AG_Driver *_Nonnull);
+void               AG_TextSetGlyphCacheBudget(AG_Driver *_Nonnull, AG_Size);
 
 void AG_TextSize(const char *_Nullable, int *_Nullable, int *_Nullable);
 void AG_TextSizeMulti(const char *_Nonnull, int *_Nonnull, int *_Nonnull,
@@ -323,6 +324,9 @@ AG_Glyph *_Nonnull AG_TextRenderGlyph(AG_Driver *_Nonnull, AG_Font *_Nonnull,
                                       const AG_Color *_Nonnull, const AG_Color *_Nonnull,
 				      AG_Char)
                                      _Warn_Unused_Result;
+void AG_TextBlitGlyph(AG_Surface *_Nonnull, const AG_Glyph *_Nonnull, int,int);
+AG_Surface *_Nonnull AG_TextGlyphSurface(AG_Driver *_Nonnull,
+                                         const AG_Glyph *_Nonnull);
 
 int  AG_TextParseANSI(const AG_TextState *_Nonnull, AG_TextANSI *_Nonnull,
                       const AG_Char *_Nonnull);
@@ -1,5 +1,5 @@
 /*
- * Copyright (c) 2008-2019 Julien Nadeau Carriere <vedge@csoft.net>
+ * Copyright (c) 2008-2023 Julien Nadeau Carriere <vedge@csoft.net>
  * All rights reserved.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -25,119 +25,223 @@
 
 /*
  * A cache of rendered text surfaces tagged with rendering attributes.
+ *
+ * Entries are hashed on the text and its rendering state and kept in a
+ * single LRU list. The least recently used entries are expired when the
+ * memory budget (or the optional entry limit) is exceeded.
  */
 
 #include <agar/core/core.h>
 #include <agar/gui/gui.h>
 #include <agar/gui/text_cache.h>
 #include <agar/gui/widget.h>
+#include <agar/gui/window.h>
 
 /* #define TEXTCACHE_DEBUG */
 
+#define TEXTCACHE_NBUCKETS_INIT 32	/* Initial hash table size */
+
 static void FreeCachedText(AG_TextCache *_Nonnull, AG_CachedText *_Nonnull);
 
-static __inline__ Uint _Pure_Attribute
-Hash_Text(AG_TextCache *_Nonnull tc, const char *_Nonnull s)
+/*
+ * Hash a string (32-bit FNV-1a) along with the attributes of a text state,
+ * with a final avalanche step so that the low bits are usable as an index.
+ */
+static __inline__ Uint32 _Pure_Attribute
+Hash_Text(const char *_Nonnull s, const AG_TextState *_Nonnull ts)
 {
-	Uint h;
-	Uchar *p;
+	Uint32 h = AG_HashString(s);
+
+	h ^= ((Uint32)ts->color.r << 24) ^ ((Uint32)ts->color.g << 16) ^
+	     ((Uint32)ts->color.b << 8)  ^  (Uint32)ts->color.a;
+	h *= 16777619U;
+	h ^= ((Uint32)ts->colorBG.r << 24) ^ ((Uint32)ts->colorBG.g << 16) ^
+	     ((Uint32)ts->colorBG.b << 8)  ^  (Uint32)ts->colorBG.a;
+	h *= 16777619U;
+	h ^= (Uint32)ts->font->height ^ ((Uint32)ts->justify << 8) ^
+	     ((Uint32)ts->valign << 12) ^ ((Uint32)ts->tabWd << 16);
+
+	h ^= h >> 16;
+	h *= 0x85ebca6bU;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35U;
+	h ^= h >> 16;
+	return (h);
+}
 
-	for (h = 0, p = (Uchar *)s; *p != '\0'; p++) {
-		h = 31*h + *p;
+static AG_TextCache *_Nonnull
+CreateCache(void *_Nonnull widget, Uint nBuckets, Uint maxEnts, AG_Size budget)
+{
+	AG_TextCache *tc;
+	Uint i;
+
+	tc = Malloc(sizeof(AG_TextCache));
+	tc->widget = widget;
+	tc->buckets = Malloc(nBuckets * sizeof(AG_CachedText *));
+	for (i = 0; i < nBuckets; i++) {
+		tc->buckets[i] = NULL;
 	}
-	return (h % tc->nBuckets);
+	tc->nBuckets = nBuckets;
+	tc->curEnts = 0;
+	tc->maxEnts = maxEnts;
+	tc->flags = 0;
+	tc->size = 0;
+	tc->budget = budget;
+	tc->nHits = 0;
+	tc->nMisses = 0;
+	tc->nEvictions = 0;
+	TAILQ_INIT(&tc->ents);
+	return (tc);
 }
 
+/*
+ * Create a text cache for the given widget, limited to a total of
+ * nBuckets*nBucketEnts entries as well as the default memory budget.
+ */
 AG_TextCache *
 AG_TextCacheNew(void *widget, Uint nBuckets, Uint nBucketEnts)
 {
-	AG_TextCache *tc;
-	Uint i;
+	Uint n;
 
 #ifdef TEXTCACHE_DEBUG
 	Debug(widget, "TextCacheNew(): %d buckets\n", nBuckets);
 #endif
-	tc = Malloc(sizeof(AG_TextCache));
-	tc->widget = widget;
-	tc->curEnts = 0;
-	tc->buckets = Malloc(nBuckets*sizeof(AG_TextCacheBucket));
-	tc->nBuckets = nBuckets;
-	tc->nBucketEnts = nBucketEnts;
+	for (n = 1; n < nBuckets; n <<= 1)
+		;;
+	return CreateCache(widget, n, nBuckets*nBucketEnts,
+	    AG_TEXT_CACHE_BUDGET);
+}
 
-	for (i = 0; i < nBuckets; i++) {
-		AG_TextCacheBucket *buck = &tc->buckets[i];
+/*
+ * Create a text cache for the given widget, limited only by a memory
+ * budget in bytes (0 = unlimited).
+ */
+AG_TextCache *
+AG_TextCacheNewBudget(void *widget, AG_Size budget)
+{
+	return CreateCache(widget, TEXTCACHE_NBUCKETS_INIT, 0, budget);
+}
+
+/*
+ * Return the text cache shared by all widgets of the window that the
+ * given widget is attached to (creating it if needed). Surfaces in a
+ * shared cache are mapped in the window and must be drawn with
+ * AG_TextCacheBlit().
+ */
+AG_TextCache *
+AG_TextCacheGetShared(void *obj)
+{
+	AG_Widget *wid = obj;
+	AG_Window *win;
 
-		TAILQ_INIT(&buck->ents);
-		buck->nEnts = 0;
+	if (AG_WINDOW_ISA(wid)) {
+		win = (AG_Window *)wid;
+	} else if ((win = wid->window) == NULL) {
+		AG_FatalError("Widget is not attached to a window");
 	}
-	return (tc);
+	if (win->tCache == NULL) {
+		win->tCache = AG_TextCacheNewBudget(win,
+		    AG_TEXT_CACHE_SHARED_BUDGET);
+		win->tCache->flags |= AG_TEXT_CACHE_SHARED;
+	}
+	return (win->tCache);
 }
 
-void
-AG_TextCacheClear(AG_TextCache *tc)
+/* Expire least recently used entries until the cache fits its limits. */
+static void
+ExpireEntries(AG_TextCache *_Nonnull tc)
 {
-	Uint i;
-	AG_CachedText *ct, *ctNext;
+	AG_CachedText *ct;
 
+	while ((tc->budget != 0 && tc->size > tc->budget) ||
+	       (tc->maxEnts != 0 && tc->curEnts > tc->maxEnts)) {
+		ct = TAILQ_LAST(&tc->ents, ag_cached_textq);
+		if (ct == NULL || ct == TAILQ_FIRST(&tc->ents)) {
+			break;				/* Keep the latest entry */
+		}
 #ifdef TEXTCACHE_DEBUG
-	Debug(NULL, "TextCacheDestroy: freeing %d buckets\n", tc->nBuckets);
+		Debug(NULL, "TextCache: expiring \"%s\" (%lu bytes, %u ents)\n",
+		    ct->text, (Ulong)ct->size, tc->curEnts);
 #endif
-	for (i = 0; i < tc->nBuckets; i++) {
-		AG_TextCacheBucket *buck = &tc->buckets[i];
-
-		for (ct = TAILQ_FIRST(&buck->ents);
-		     ct != TAILQ_END(&buck->ents);
-		     ct = ctNext) {
-			ctNext = TAILQ_NEXT(ct, ents);
-			FreeCachedText(tc, ct);
-		}
-		TAILQ_INIT(&buck->ents);
-		buck->nEnts = 0;
+		FreeCachedText(tc, ct);
+		tc->nEvictions++;
 	}
-	tc->curEnts = 0;
 }
 
+/* Set the memory budget in bytes (0 = unlimited). */
 void
-AG_TextCacheDestroy(AG_TextCache *tc)
+AG_TextCacheSetBudget(AG_TextCache *tc, AG_Size budget)
 {
-	AG_TextCacheClear(tc);
-	Free(tc->buckets);
-	free(tc);
+	tc->budget = budget;
+	ExpireEntries(tc);
 }
 
-/* Expire some of the oldest entries from the cache. */
-static void
-ExpireEntries(AG_TextCache *_Nonnull tc)
+void
+AG_TextCacheClear(AG_TextCache *tc)
 {
 	AG_CachedText *ct;
-	Uint i;
-
-	for (i = 0; i < tc->nBuckets; i++) {
-		AG_TextCacheBucket *buck = &tc->buckets[i];
 
-		if (buck->nEnts > tc->nBucketEnts) {
-			ct = TAILQ_LAST(&buck->ents, ag_cached_textq);
 #ifdef TEXTCACHE_DEBUG
-			Debug(NULL,
-			    "TextCache: expiring entry #%u (\"%s\"), %u ents\n",
-			    i, ct->text, buck->nEnts);
+	Debug(NULL, "TextCacheClear: freeing %u entries\n", tc->curEnts);
 #endif
-			TAILQ_REMOVE(&buck->ents, ct, ents);
-			FreeCachedText(tc, ct);
-			buck->nEnts--;
-			tc->curEnts--;
-		}
-	}
+	while ((ct = TAILQ_FIRST(&tc->ents)) != NULL)
+		FreeCachedText(tc, ct);
+}
+
+void
+AG_TextCacheDestroy(AG_TextCache *tc)
+{
+	AG_TextCacheClear(tc);
+	Free(tc->buckets);
+	free(tc);
 }
 
+/* Remove an entry from the cache and free it. */
 static void
 FreeCachedText(AG_TextCache *_Nonnull tc, AG_CachedText *_Nonnull ct)
 {
+	AG_CachedText **pct;
+
+	for (pct = &tc->buckets[ct->hash & (tc->nBuckets - 1)];
+	     *pct != ct;
+	     pct = &(*pct)->next)
+		;;
+	*pct = ct->next;
+	TAILQ_REMOVE(&tc->ents, ct, ents);
+	tc->curEnts--;
+	tc->size -= ct->size;
+
 	AG_WidgetUnmapSurface(tc->widget, ct->surface);
 	Free(ct->text);
 	free(ct);
 }
 
+/* Double the size of the hash table. */
+static void
+GrowBuckets(AG_TextCache *_Nonnull tc)
+{
+	const Uint nBucketsNew = (tc->nBuckets << 1);
+	AG_CachedText **bucketsNew, *ct;
+	Uint i;
+
+	if ((bucketsNew = TryMalloc(nBucketsNew * sizeof(AG_CachedText *)))
+	    == NULL) {
+		return;				/* Keep the current table */
+	}
+	for (i = 0; i < nBucketsNew; i++) {
+		bucketsNew[i] = NULL;
+	}
+	TAILQ_FOREACH(ct, &tc->ents, ents) {
+		const Uint h = ct->hash & (nBucketsNew - 1);
+
+		ct->next = bucketsNew[h];
+		bucketsNew[h] = ct;
+	}
+	Free(tc->buckets);
+	tc->buckets = bucketsNew;
+	tc->nBuckets = nBucketsNew;
+}
+
 /* Compare two text states. */
 static __inline__ int
 CompareTextStates(const AG_TextState *_Nonnull a, const AG_TextState *_Nonnull b)
@@ -153,62 +257,109 @@ CompareTextStates(const AG_TextState *_Nonnull a, const AG_TextState *_Nonnull b
 	return (1);
 }
 
+/*
+ * Return the surface mapping of the given text rendered with the current
+ * text state, rendering and inserting it in the cache if needed.
+ * Return -1 on failure.
+ */
 int
 AG_TextCacheGet(AG_TextCache *tc, const char *text)
 {
 	const AG_TextState *ts = AG_TEXT_STATE_CUR();
-	AG_TextCacheBucket *buck;
+	const Uint32 hash = Hash_Text(text, ts);
 	AG_CachedText *ct;
 	AG_Surface *S;
+	AG_Size len;
 	Uint h;
 
-	h = Hash_Text(tc, text);
-#ifdef TEXTCACHE_DEBUG
-	Debug(NULL, "TextCacheLookup: string \"%s\" = %u...", text, h);
-#endif
-	buck = &tc->buckets[h];
-	TAILQ_FOREACH(ct, &buck->ents, ents) {
-		if (strcmp(ct->text, text) == 0 &&
+	if (tc->flags & AG_TEXT_CACHE_SHARED)
+		AG_ObjectLock(tc->widget);
+
+	for (ct = tc->buckets[hash & (tc->nBuckets - 1)];
+	     ct != NULL;
+	     ct = ct->next) {
+		if (ct->hash == hash &&
+		    strcmp(ct->text, text) == 0 &&
 		    CompareTextStates(&ct->state, ts) == 0)
 			break;
 	}
-	if (ct == NULL) {
-#ifdef TEXTCACHE_DEBUG
-		Debug(NULL, "MISS (ent %u)\n", tc->curEnts+1);
-#endif
-		if ((S = AG_TextRender(text)) == NULL) {
-			return (-1);
-		}
-		if ((ct = TryMalloc(sizeof(AG_CachedText))) == NULL) {
-			goto fail;
-		}
-		if ((ct->text = strdup(text)) == NULL) {
-			free(ct);
-			goto fail;
-		}
-		ct->surface = AG_WidgetMapSurface(tc->widget, S);
-		memcpy(&ct->state, ts, sizeof(AG_TextState));
-		tc->curEnts++;
-		TAILQ_INSERT_HEAD(&buck->ents, ct, ents);
-		buck->nEnts++;
-
-		if (tc->curEnts > tc->nBuckets*tc->nBucketEnts) {
+	if (ct != NULL) {
 #ifdef TEXTCACHE_DEBUG
-			Debug(NULL, "TextCache: Expiring entries "
-			    "(%u > %u)...\n", tc->curEnts,
-			    tc->nBuckets*tc->nBucketEnts);
+		Debug(NULL, "TextCache: \"%s\" = %08x HIT\n", text, hash);
 #endif
-			ExpireEntries(tc);
+		if (ct != TAILQ_FIRST(&tc->ents)) {
+			TAILQ_REMOVE(&tc->ents, ct, ents);
+			TAILQ_INSERT_HEAD(&tc->ents, ct, ents);
 		}
-	} else {
-		TAILQ_REMOVE(&buck->ents, ct, ents);
-		TAILQ_INSERT_HEAD(&buck->ents, ct, ents);
+		tc->nHits++;
+		goto out;
+	}
 #ifdef TEXTCACHE_DEBUG
-		Debug(NULL, "HIT\n");
+	Debug(NULL, "TextCache: \"%s\" = %08x MISS (ent %u)\n", text, hash,
+	    tc->curEnts+1);
 #endif
+	tc->nMisses++;
+
+	if ((S = AG_TextRender(text)) == NULL) {
+		goto fail;
+	}
+	if ((ct = TryMalloc(sizeof(AG_CachedText))) == NULL) {
+		goto fail_surface;
+	}
+	len = strlen(text) + 1;
+	if ((ct->text = TryMalloc(len)) == NULL) {
+		free(ct);
+		goto fail_surface;
+	}
+	memcpy(ct->text, text, len);
+	ct->hash = hash;
+	ct->size = sizeof(AG_CachedText) + len + S->pitch*S->h;
+	ct->surface = AG_WidgetMapSurface(tc->widget, S);
+	memcpy(&ct->state, ts, sizeof(AG_TextState));
+
+	if (tc->curEnts >= tc->nBuckets) {
+		GrowBuckets(tc);
+	}
+	h = hash & (tc->nBuckets - 1);
+	ct->next = tc->buckets[h];
+	tc->buckets[h] = ct;
+	TAILQ_INSERT_HEAD(&tc->ents, ct, ents);
+	tc->curEnts++;
+	tc->size += ct->size;
+
+	ExpireEntries(tc);
+out:
+	if (tc->flags & AG_TEXT_CACHE_SHARED) {
+		AG_ObjectUnlock(tc->widget);
 	}
 	return (ct->surface);
-fail:
+fail_surface:
 	AG_SurfaceFree(S);
+fail:
+	if (tc->flags & AG_TEXT_CACHE_SHARED) {
+		AG_ObjectUnlock(tc->widget);
+	}
 	return (-1);
 }
+
+/*
+ * Draw a surface returned by AG_TextCacheGet() at coordinates x,y relative
+ * to widget wid. Unlike AG_WidgetBlitSurface(), this works with surfaces
+ * of shared caches (which are mapped in the window instead of wid).
+ *
+ * This must be called from rendering context (the Widget draw() operation).
+ */
+void
+AG_TextCacheBlit(AG_TextCache *tc, void *obj, int surface, int x, int y)
+{
+	AG_Widget *wid = obj;
+
+	AG_OBJECT_ISA(wid, "AG_Widget:*");
+#ifdef AG_DEBUG
+	if (surface == -1 || tc->widget->surfaces[surface] == NULL)
+		AG_FatalError("Bad surface handle");
+#endif
+	wid->drvOps->blitSurfaceFrom(wid->drv, tc->widget, surface, NULL,
+	    wid->rView.x1 + x,
+	    wid->rView.y1 + y);
+}
@@ -6,37 +6,57 @@
 #include <agar/gui/text.h>
 #include <agar/gui/begin.h>
 
+#ifndef AG_TEXT_CACHE_BUDGET		/* Default memory budget (bytes) */
+#define AG_TEXT_CACHE_BUDGET (AG_MODEL * 8192)
+#endif
+#ifndef AG_TEXT_CACHE_SHARED_BUDGET	/* Default budget of shared caches */
+#define AG_TEXT_CACHE_SHARED_BUDGET (AG_MODEL * 65536)
+#endif
+
 typedef struct ag_cached_text {
 	char *_Nonnull text;			/* Text string */
 	int surface;				/* Surface mapping */
-	Uint32 _pad;
+	Uint32 hash;				/* Hash of text and state */
+	AG_Size size;				/* Memory used (bytes) */
 	AG_TextState state;			/* Text rendering state */
-	AG_TAILQ_ENTRY(ag_cached_text) ents;
+	struct ag_cached_text *_Nullable next;	/* Next in hash bucket */
+	AG_TAILQ_ENTRY(ag_cached_text) ents;	/* Entry in LRU list */
 } AG_CachedText;
 
-typedef struct ag_text_cache_bucket {
-	AG_TAILQ_HEAD(ag_cached_textq,ag_cached_text) ents;
-	Uint nEnts;
-	Uint32 _pad;
-} AG_TextCacheBucket;
-
 struct ag_widget;
 
+/*
+ * Cache of rendered text surfaces, mapped in (and owned by) a widget.
+ * Entries are looked up in a hash table and expired in least recently
+ * used order whenever the total size of the entries exceeds the memory
+ * budget, or the number of entries exceeds maxEnts (if nonzero).
+ */
 typedef struct ag_text_cache {
 	struct ag_widget *_Nonnull widget;	/* Widget managing surfaces */
-	AG_TextCacheBucket *_Nonnull buckets;	/* Hash table */
-	Uint                        nBuckets;
+	AG_CachedText *_Nullable *_Nonnull buckets; /* Hash table */
+	Uint nBuckets;
 	Uint curEnts;				/* Current entries */
-	Uint nBucketEnts;			/* Target bucket utilization */
-	Uint32 _pad;
+	Uint maxEnts;				/* Entry limit (or 0) */
+	Uint flags;
+#define AG_TEXT_CACHE_SHARED 0x01		/* Shared by a window's widgets */
+	AG_Size size;				/* Memory used (bytes) */
+	AG_Size budget;				/* Memory budget (or 0) */
+	Uint64 nHits;				/* Cache hits */
+	Uint64 nMisses;				/* Cache misses */
+	Uint64 nEvictions;			/* Expired entries */
+	AG_TAILQ_HEAD(ag_cached_textq, ag_cached_text) ents; /* MRU first */
 } AG_TextCache;
 
 __BEGIN_DECLS
 AG_TextCache *_Nonnull AG_TextCacheNew(void *_Nonnull, Uint, Uint);
+AG_TextCache *_Nonnull AG_TextCacheNewBudget(void *_Nonnull, AG_Size);
+AG_TextCache *_Nonnull AG_TextCacheGetShared(void *_Nonnull);
 
+void AG_TextCacheSetBudget(AG_TextCache *_Nonnull, AG_Size);
 void AG_TextCacheClear(AG_TextCache *_Nonnull);
 void AG_TextCacheDestroy(AG_TextCache *_Nonnull);
 int  AG_TextCacheGet(AG_TextCache *_Nonnull, const char *_Nonnull);
+void AG_TextCacheBlit(AG_TextCache *_Nonnull, void *_Nonnull, int, int,int);
 __END_DECLS
 
 #include <agar/gui/close.h>
@@ -47,7 +47,7 @@ AG_TlistNew(void *parent, Uint flags)
 {
 	AG_Tlist *tl;
 
-	tl = Malloc(sizeof(AG_Tlist));
+	tl = AG_ObjectAlloc(&agTlistClass);
 	AG_ObjectInit(tl, &agTlistClass);
 
 	if (flags & AG_TLIST_HFILL) { WIDGET(tl)->flags |= AG_WIDGET_HFILL; }
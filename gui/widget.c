@@ -217,6 +217,8 @@ SetParentWindow(AG_Widget *_Nonnull wid, AG_Window *_Nullable win)
 
 		if (wid->flags & AG_WIDGET_USE_TEXT)
 			win->flags |= AG_WINDOW_USE_TEXT;
+		if (wid->flags & AG_WIDGET_UPDATE_WINDOW)
+			WIDGET(win)->flags |= AG_WIDGET_UPDATE_WINDOW;
 
 		/*
 		 * Commit any previously deferred AG_MapStockCursor()
@@ -286,6 +288,7 @@ OnAttach(AG_Event *_Nonnull event)
 
 		if (AGWINDOW(wParent)->visible) {
 			wid->flags |= AG_WIDGET_UPDATE_WINDOW;
+			wParent->flags |= AG_WIDGET_UPDATE_WINDOW;
 			AG_PostEvent(wid, "widget-shown", NULL);
 		}
 		if (wParent->flags & AG_WIDGET_DISABLE_ON_ATTACH) {
@@ -1953,6 +1956,7 @@ void
 AG_WidgetDraw(void *p)
 {
 	AG_Widget *wid = p;
+	AG_Rect2 rDamage;
 	Uint flags;
 	int useText;
 
@@ -1964,6 +1968,13 @@ AG_WidgetDraw(void *p)
 	    (flags & (AG_WIDGET_HIDE | AG_WIDGET_UNDERSIZE)))
 		goto out;
 
+	/* Skip widgets outside of the damaged area being redrawn. */
+	if (wid->window != NULL && wid->window->pvt.drawClipped &&
+	    !AG_RectIntersect2(&rDamage, &wid->rView, &wid->window->pvt.rDraw))
+		goto out;
+
+	AG_TRACE_BEGIN("draw", wid);
+
 	if (flags & AG_WIDGET_DISABLED)       { wid->state = AG_DISABLED_STATE; }
 	else if (flags & AG_WIDGET_MOUSEOVER) { wid->state = AG_HOVER_STATE;    }
 	else if (flags & AG_WIDGET_FOCUSED)   { wid->state = AG_FOCUSED_STATE;  }
@@ -2000,6 +2011,7 @@ AG_WidgetDraw(void *p)
 	if (useText) {
 		AG_PopTextState();
 	}
+	AG_TRACE_END();
 out:
 	AG_ObjectUnlock(wid);
 }
@@ -33,6 +33,7 @@
 
 #include <agar/gui/gui.h>
 #include <agar/gui/window.h>
+#include <agar/gui/text_cache.h>
 #include <agar/gui/titlebar.h>
 #include <agar/gui/icon.h>
 #include <agar/gui/primitive.h>
@@ -111,6 +112,8 @@ const char *agWindowAlignmentNames[] = {
 
 static int agWindowIconCounter = 0;
 
+static void DamageClear(AG_Window *_Nonnull);
+
 /*
  * Lookup a window by name.
  * The agDrivers VFS must be locked.
@@ -182,7 +185,7 @@ AG_WindowNewUnder(void *pDrv, Uint flags)
 		AG_SetErrorS("drv is not a Driver");
 		return (NULL);
 	}
-	if ((win = TryMalloc(sizeof(AG_Window))) == NULL) {
+	if ((win = AG_ObjectTryAlloc(&agWindowClass)) == NULL) {
 		return (NULL);
 	}
 	WindowNew_Common(win, flags);
@@ -209,7 +212,7 @@ AG_WindowNew(Uint flags)
 	AG_Driver *drv;
 	AG_Window *win;
 
-	if ((win = TryMalloc(sizeof(AG_Window))) == NULL) {
+	if ((win = AG_ObjectTryAlloc(&agWindowClass)) == NULL) {
 		return (NULL);
 	}
 	WindowNew_Common(win, flags);
@@ -627,25 +630,6 @@ AG_WindowMovePinned(AG_Window *winParent, int xRel, int yRel)
 	AG_UnlockVFS(&agDrivers);
 }
 
-/*
- * Test whether a widget (or one of its children) is requesting a
- * geometry update.
- */
-static int _Pure_Attribute
-UpdateNeeded(AG_Widget *_Nonnull wid)
-{
-	AG_Widget *chld;
-
-	if (wid->flags & AG_WIDGET_UPDATE_WINDOW) {
-		return (1);
-	}
-	OBJECT_FOREACH_CHILD(chld, wid, ag_widget) {
-		if (UpdateNeeded(chld))
-			return (1);
-	}
-	return (0);
-}
-
 /*
  * Test whether a window is currently selected for a given WM operation.
  * The agDrivers VFS must be locked.
@@ -680,7 +664,8 @@ Draw(void *_Nonnull obj)
 	const int wBorderBot = win->wBorderBot;
 	int wBorderSide;
 
-	if (UpdateNeeded(WIDGET(win)))
+	/* AG_WidgetUpdate() flags the parent window as well. */
+	if (WIDGET(win)->flags & AG_WIDGET_UPDATE_WINDOW)
 		AG_WindowUpdate(win);
 
 	/* Render window background. */
@@ -859,7 +844,7 @@ OnHide(AG_Event *_Nonnull event)
 	win->visible = 0;
 	WIDGET(win)->flags &= ~(AG_WIDGET_VISIBLE);
 
-	win->dirty = 0;                       /* Cancel any display updates */
+	DamageClear(win);                     /* Cancel any display updates */
 	win->flags |= AG_WINDOW_NOCURSORCHG;     /* Disallow cursor changes */
 	if (win == agWindowToFocus)            /* Cancel any focus requests */
 		agWindowToFocus = NULL;
@@ -1122,15 +1107,131 @@ out:
 	AG_UnlockVFS(&agDrivers);
 }
 
+/* Extend r to include the rectangle b. */
+static __inline__ void
+DamageUnion(AG_Rect2 *_Nonnull r, const AG_Rect2 *_Nonnull b)
+{
+	if (b->x1 < r->x1) { r->x1 = b->x1; }
+	if (b->y1 < r->y1) { r->y1 = b->y1; }
+	if (b->x2 > r->x2) { r->x2 = b->x2; }
+	if (b->y2 > r->y2) { r->y2 = b->y2; }
+	r->w = r->x2 - r->x1;
+	r->h = r->y2 - r->y1;
+}
+
+/*
+ * Add a rectangle to a list of damaged areas, merging it with any area it
+ * overlaps or touches. If the list is full, merge it with the area which
+ * it enlarges the least.
+ */
+static void
+DamageAdd(AG_Rect2 *_Nonnull D, int *_Nonnull nD, const AG_Rect2 *_Nonnull pr)
+{
+	AG_Rect2 r = *pr, u;
+	Uint grow, growMin;
+	int i, iMin;
+
+	if (r.w <= 0 || r.h <= 0)
+		return;
+scan:
+	for (i = 0; i < *nD; i++) {
+		if (r.x1 <= D[i].x2 && r.x2 >= D[i].x1 &&
+		    r.y1 <= D[i].y2 && r.y2 >= D[i].y1) {
+			DamageUnion(&r, &D[i]);
+			D[i] = D[--(*nD)];
+			goto scan;
+		}
+	}
+	if (*nD < AG_WINDOW_DAMAGE_MAX) {
+		D[(*nD)++] = r;
+		return;
+	}
+	for (i = 0, iMin = 0, growMin = ~0U; i < *nD; i++) {
+		u = r;
+		DamageUnion(&u, &D[i]);
+		grow = (Uint)(u.w*u.h - D[i].w*D[i].h);
+		if (grow < growMin) {
+			growMin = grow;
+			iMin = i;
+		}
+	}
+	DamageUnion(&r, &D[iMin]);
+	D[iMin] = D[--(*nD)];
+	goto scan;
+}
+
+/*
+ * Copy the damaged areas of a window into D and reset them. Return the
+ * number of areas, or -1 if the entire window needs to be redrawn.
+ * The Window must be locked.
+ */
+static int
+DamageTake(AG_Window *_Nonnull win, AG_Rect2 *_Nonnull D)
+{
+	int n;
+
+	AG_MutexLock(&win->pvt.damageLock);
+	n = win->pvt.nDamage;
+	memcpy(D, win->pvt.damage, n*sizeof(AG_Rect2));
+	win->pvt.nDamage = 0;
+	AG_MutexUnlock(&win->pvt.damageLock);
+
+	if (win->dirty || (WIDGET(win)->flags & AG_WIDGET_UPDATE_WINDOW)) {
+		return (-1);
+	}
+	return (n);
+}
+
+/* Mark a window as fully redrawn. The Window must be locked. */
+static void
+DamageClear(AG_Window *_Nonnull win)
+{
+	AG_MutexLock(&win->pvt.damageLock);
+	win->pvt.nDamage = 0;
+	AG_MutexUnlock(&win->pvt.damageLock);
+	win->dirty = 0;
+}
+
+/*
+ * Redraw the given area of a window (in view coordinates) with clipping.
+ * AG_WidgetDraw() skips the widgets which lie outside of the area.
+ * The Window must be locked.
+ */
+static void
+DrawArea(AG_Window *_Nonnull win, const AG_Rect2 *_Nonnull rArea)
+{
+	AG_Driver *drv = WIDGET(win)->drv;
+	AG_Rect r;
+
+	AG_Rect2ToRect(&r, rArea);
+	win->pvt.rDraw = *rArea;
+	win->pvt.drawClipped = 1;
+	AGDRIVER_CLASS(drv)->pushClipRect(drv, &r);
+
+	AG_TRACE_BEGIN("render", win);
+	AG_WidgetDraw(win);
+	AG_TRACE_END();
+
+	AGDRIVER_CLASS(drv)->popClipRect(drv);
+	win->pvt.drawClipped = 0;
+}
+
 /*
  * Render all windows that need to be redrawn. This is typically invoked
  * by the main event loop after all events have been processed.
+ *
+ * If the driver implements updateRegion(), only the areas damaged by
+ * AG_Redraw() are redrawn and presented. Otherwise, damaged windows are
+ * redrawn entirely.
  */ 
 void
 AG_WindowDrawQueued(void)
 {
+	AG_Rect2 D[AG_WINDOW_DAMAGE_MAX], Dwin[AG_WINDOW_DAMAGE_MAX];
 	AG_Driver *drv;
 	AG_Window *win;
+	AG_Rect r;
+	int nD, i;
 
 	AG_LockVFS(&agDrivers);
 
@@ -1138,14 +1239,27 @@ AG_WindowDrawQueued(void)
 		switch (AGDRIVER_CLASS(drv)->wm) {
 		case AG_WM_MULTIPLE:
 			if ((win = AGDRIVERMW(drv)->win) != NULL) {
-				if (!win->visible || !win->dirty) {
+				if (!win->visible) {
 					continue;
 				}
 				AG_ObjectLock(win);
+				if ((nD = DamageTake(win, D)) == 0) {
+					AG_ObjectUnlock(win);
+					continue;
+				}
 				AG_BeginRendering(drv);
-				AGDRIVER_CLASS(drv)->renderWindow(win);
+				if (nD > 0 &&
+				    AGDRIVER_CLASS(drv)->updateRegion != NULL) {
+					for (i = 0; i < nD; i++) {
+						DrawArea(win, &D[i]);
+						AG_Rect2ToRect(&r, &D[i]);
+						AGDRIVER_CLASS(drv)->updateRegion(drv, &r);
+					}
+				} else {
+					AGDRIVER_CLASS(drv)->renderWindow(win);
+				}
 				AG_EndRendering(drv);
-				win->dirty = 0;
+				DamageClear(win);
 				AG_ObjectUnlock(win);
 			}
 			break;
@@ -1153,7 +1267,7 @@ AG_WindowDrawQueued(void)
 			{
 				AG_DriverSw *dsw = (AG_DriverSw *)drv;
 				Uint32 t;
-				int doRedraw;
+				int doRedraw, n;
 
 				t = AG_GetTicks();
 				if ((t - dsw->rLast) < dsw->rNom) {
@@ -1161,28 +1275,72 @@ AG_WindowDrawQueued(void)
 					goto out;
 				}
 				dsw->rLast = t;
-				
+
 				doRedraw = (dsw->flags & AG_DRIVER_SW_REDRAW);
-				if (doRedraw) {
-					dsw->flags &= ~(AG_DRIVER_SW_REDRAW);
-				} else {
-					AG_FOREACH_WINDOW(win, drv)
-						if (win->visible && win->dirty)
-							break;
+				dsw->flags &= ~(AG_DRIVER_SW_REDRAW);
+
+				/*
+				 * Merge the damaged areas of all windows, since
+				 * redrawing an area may overwrite the contents
+				 * of overlapping windows above.
+				 */
+				nD = 0;
+				AG_FOREACH_WINDOW(win, drv) {
+					if (!win->visible) {
+						continue;
+					}
+					AG_ObjectLock(win);
+					if ((n = DamageTake(win, Dwin)) == -1) {
+						DamageAdd(D, &nD, &WIDGET(win)->rView);
+					} else {
+						for (i = 0; i < n; i++)
+							DamageAdd(D, &nD, &Dwin[i]);
+					}
+					AG_ObjectUnlock(win);
+				}
+				if (nD == 0 && !doRedraw) {
+					break;
 				}
-				if (doRedraw || win != NULL) {
-					AG_BeginRendering(drv);
+				if (AGDRIVER_CLASS(drv)->updateRegion == NULL)
+					doRedraw = 1;
+
+				AG_BeginRendering(drv);
+				if (doRedraw) {
 					AG_FOREACH_WINDOW(win, drv) {
 						if (!win->visible) {
 							continue;
 						}
 						AG_ObjectLock(win);
 						AGDRIVER_CLASS(drv)->renderWindow(win);
-						win->dirty = 0;
+						DamageClear(win);
 						AG_ObjectUnlock(win);
 					}
-					AG_EndRendering(drv);
+				} else {
+					for (i = 0; i < nD; i++) {
+						AG_FOREACH_WINDOW(win, drv) {
+							AG_Rect2 rWin;
+
+							if (!win->visible ||
+							    !AG_RectIntersect2(&rWin,
+							    &D[i], &WIDGET(win)->rView)) {
+								continue;
+							}
+							AG_ObjectLock(win);
+							DrawArea(win, &rWin);
+							AG_ObjectUnlock(win);
+						}
+						AG_Rect2ToRect(&r, &D[i]);
+						AGDRIVER_CLASS(drv)->updateRegion(drv, &r);
+					}
+					AG_FOREACH_WINDOW(win, drv) {
+						if (win->visible) {
+							AG_ObjectLock(win);
+							DamageClear(win);
+							AG_ObjectUnlock(win);
+						}
+					}
 				}
+				AG_EndRendering(drv);
 			}
 			break;
 		}
@@ -2796,9 +2954,11 @@ AG_WindowDraw(AG_Window *_Nonnull win)
 		return;
 
 	AG_OBJECT_ISA(drv, "AG_Driver:*");
+	AG_TRACE_BEGIN("render", win);
 	AGDRIVER_CLASS(drv)->renderWindow(win);
+	AG_TRACE_END();
 
-	win->dirty = 0;
+	DamageClear(win);
 }
 
 /*
@@ -2860,7 +3020,7 @@ AG_WidgetSetPosition(void *_Nonnull obj, int x, int y)
 	AG_ObjectLock(wid);
 	wid->x = x;
 	wid->y = y;
-	wid->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(wid);
 	AG_ObjectUnlock(wid);
 }
 
@@ -2874,7 +3034,7 @@ AG_WidgetSetSize(void *_Nonnull obj, int w, int h)
 	AG_ObjectLock(wid);
 	wid->w = w;
 	wid->h = h;
-	wid->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(wid);
 	AG_ObjectUnlock(wid);
 }
 
@@ -2890,7 +3050,7 @@ AG_WidgetSetGeometry(void *obj, const AG_Rect *r)
 	wid->y = r->y;
 	wid->w = r->w;
 	wid->h = r->h;
-	wid->flags |= AG_WIDGET_UPDATE_WINDOW;
+	AG_WidgetUpdate(wid);
 	AG_ObjectUnlock(wid);
 }
 
@@ -2917,10 +3077,21 @@ AG_Redraw(void *_Nonnull obj)
 	    WIDGET(obj)->window ? OBJECT(WIDGET(obj)->window)->name : "(null)",
 	    AG_GetTicks());
 #endif
-	if ((win = WIDGET(obj)->window) != NULL) {
-		AG_OBJECT_ISA(win, "AG_Widget:AG_Window:*");
+	if ((win = WIDGET(obj)->window) == NULL) {
+		return;
+	}
+	AG_OBJECT_ISA(win, "AG_Widget:AG_Window:*");
+
+	if (win->dirty) {
+		return;
+	}
+	if (obj == win) {
 		win->dirty = 1;
+		return;
 	}
+	AG_MutexLock(&win->pvt.damageLock);
+	DamageAdd(win->pvt.damage, &win->pvt.nDamage, &WIDGET(obj)->rView);
+	AG_MutexUnlock(&win->pvt.damageLock);
 }
 
 /*
@@ -3043,6 +3214,7 @@ Init(void *_Nonnull obj)
 	win->alignment = AG_WINDOW_ALIGNMENT_NONE;
 	win->tbar = NULL;
 	win->icon = NULL;
+	win->tCache = NULL;
 	win->wMin = 0;
 	win->hMin = 0;
 	win->wBorderBot = agWindowBotBorderDefault;
@@ -3072,6 +3244,10 @@ Init(void *_Nonnull obj)
 	for (i = 0; i < 5; i++)
 		win->pvt.caResize[i] = NULL;
 
+	AG_MutexInit(&win->pvt.damageLock);
+	win->pvt.nDamage = 0;
+	win->pvt.drawClipped = 0;
+
 	AG_SetEvent(win, "window-gainfocus", OnGainFocus, NULL);
 	AG_SetEvent(win, "window-lostfocus", OnLostFocus, NULL);
 
@@ -3101,6 +3277,18 @@ Init(void *_Nonnull obj)
 	WIDGET(win)->pal = agDefaultPalette;
 }
 
+static void
+Destroy(void *_Nonnull obj)
+{
+	AG_Window *win = obj;
+
+	if (win->tCache != NULL) {
+		AG_TextCacheDestroy(win->tCache);
+		win->tCache = NULL;
+	}
+	AG_MutexDestroy(&win->pvt.damageLock);
+}
+
 #if defined(AG_WIDGETS) && defined(AG_DEBUG)
 static void
 WindowCaptionChanged(AG_Event *event)
@@ -3271,7 +3459,7 @@ AG_WidgetClass agWindowClass = {
 		{ 1,0, AGC_WINDOW, 0xE024 },
 		Init,
 		NULL,		/* reset */
-		NULL,		/* destroy */
+		Destroy,
 		NULL,		/* load */
 		NULL,		/* save */
 #if defined(AG_WIDGETS) && defined(AG_DEBUG)
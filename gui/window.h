@@ -14,6 +14,7 @@
 struct ag_titlebar;
 struct ag_font;
 struct ag_icon;
+struct ag_text_cache;
 struct ag_widget;
 struct ag_cursor;
 
@@ -58,6 +59,10 @@ enum ag_window_wm_type {
 
 typedef AG_TAILQ_HEAD(ag_cursor_areaq, ag_cursor_area) AG_CursorAreaQ;
 
+#ifndef AG_WINDOW_DAMAGE_MAX
+#define AG_WINDOW_DAMAGE_MAX 8		/* Damage rectangles per window */
+#endif
+
 typedef struct ag_window_fade_ctx {
 	float inTime, outTime;                /* Total fade time (in s) */
 	float inIncr, outIncr;                /* Delta (in opacity units) */
@@ -74,6 +79,11 @@ typedef struct ag_window_pvt {
 	AG_WindowFadeCtx *fade;               /* Fadein/fadeout context */
 	AG_CursorAreaQ cursorAreas;           /* Cursor-change areas */
 	AG_CursorArea *_Nullable caResize[5]; /* Window-resize areas */
+	_Nonnull_Mutex AG_Mutex damageLock;   /* Lock on damage[] */
+	int nDamage;                          /* Damaged areas (or 0) */
+	int drawClipped;                      /* Drawing only rDraw */
+	AG_Rect2 damage[AG_WINDOW_DAMAGE_MAX]; /* Areas to redraw (view coords) */
+	AG_Rect2 rDraw;                       /* Area being redrawn */
 } AG_WindowPvt;
 
 /* Window instance */
@@ -122,6 +132,7 @@ typedef struct ag_window {
 
 	struct ag_titlebar *_Nullable tbar;	/* Titlebar (or NULL) */
 	struct ag_icon *_Nullable     icon;	/* Window icon (internal WM) */
+	struct ag_text_cache *_Nullable tCache;	/* Shared text cache (or NULL) */
 
 	Uint32 _pad;
 	int wMin, hMin;				/* Minimum geometry (px) */
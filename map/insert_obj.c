@@ -69,7 +69,7 @@ EditPane(void *_Nonnull p, void *_Nonnull box)
 	MAP_View *mv = TOOL(tool)->mv;
 	AG_TlistItem *it;
 	MAP_Object *mo;
-	AG_ObjectClass **hier;
+	AG_ObjectClass *const *hier;
 	int          i, nHier;
 
 	if ((it = AG_TlistSelectedItem(mv->lib_tl)) == NULL ||
@@ -89,7 +89,7 @@ EditPane(void *_Nonnull p, void *_Nonnull box)
 
 	AG_SeparatorNewHoriz(box);
 
-	if (AG_ObjectGetInheritHier(mo, &hier, &nHier) != 0) {
+	if (AG_ObjectGetInheritHierCached(mo, &hier, &nHier) != 0) {
 		AG_FatalError(NULL);
 	}
 	for (i = nHier-1; i >= 0; i--) {
@@ -106,7 +106,6 @@ EditPane(void *_Nonnull p, void *_Nonnull box)
 		clsMo->edit(mo, box, TOOL(tool));
 		AG_SeparatorNewHoriz(box);
 	}
-	free(hier);
 }
 
 static int
@@ -55,7 +55,9 @@ extern const AG_TestCase scrollviewTest;
 extern const AG_TestCase socketsTest;
 extern const AG_TestCase surfaceTest;
 extern const AG_TestCase tableTest;
+extern const AG_TestCase tblTest;
 extern const AG_TestCase textboxTest;
+extern const AG_TestCase textcacheTest;
 extern const AG_TestCase textdlgTest;
 extern const AG_TestCase threadsTest;
 extern const AG_TestCase unitconvTest;
@@ -80,6 +82,9 @@ extern const AG_TestCase timeoutsTest;
 #ifdef AG_USER
 extern const AG_TestCase userTest;
 #endif
+#ifdef AG_SERIALIZATION
+extern const AG_TestCase datasourceTest;
+#endif
 #ifdef HAVE_AGAR_MATH
 extern const AG_TestCase bezierTest;
 extern const AG_TestCase mathTest;
@@ -114,7 +119,9 @@ const AG_TestCase *testCases[] = {
 	&socketsTest,
 	&surfaceTest,
 	&tableTest,
+	&tblTest,
 	&textboxTest,
+	&textcacheTest,
 	&textdlgTest,
 	&threadsTest,
 	&unitconvTest,
@@ -139,6 +146,9 @@ const AG_TestCase *testCases[] = {
 #ifdef AG_USER
 	&userTest,
 #endif
+#ifdef AG_SERIALIZATION
+	&datasourceTest,
+#endif
 #ifdef HAVE_AGAR_MATH
 	&bezierTest,
 	&mathTest,
@@ -479,7 +489,7 @@ TestMsg(void *obj, const char *fmt, ...)
 
 	va_start(args, fmt);
 	AG_Vasprintf(&s, fmt, args);
-	ln = AG_ConsoleMsgS(ti->console, s);
+	ln = TestMsgS(ti, s);
 	va_end(args);
 	free(s);
 	return (ln);
@@ -491,23 +501,13 @@ TestMsgS(void *obj, const char *s)
 {
 	AG_TestInstance *ti = obj;
 
+	if (ti->console == NULL) {			/* agartest -b */
+		fprintf(stderr, "%s: %s\n", ti->name, s);
+		return (NULL);
+	}
 	return AG_ConsoleMsgS(ti->console, s);
 }
 
-#if (defined(i386) || defined(__i386__) || defined(__x86_64__))
-# define HAVE_RDTSC
-static __inline__ Uint64
-rdtsc(void)
-{
-	Uint64 rv;
-
-	__asm __volatile(".byte 0x0f, 0x31" : "=A" (rv));
-	return (rv);
-}
-#else
-# undef HAVE_RDTSC
-#endif
-
 /* Execute a benchmark module (called from bench() op) */
 void
 TestExecBenchmark(void *obj, AG_Benchmark *bm)
@@ -523,6 +523,10 @@ TestExecBenchmark(void *obj, AG_Benchmark *bm)
 	Uint32 tTot, tRun;
 #endif
 
+	if (cons == NULL) {				/* agartest -b */
+		BenchExecHeadless(ti, bm);
+		return;
+	}
 	for (fIdx = 0; fIdx < bm->nFuncs; fIdx++) {
 		char pbuf[64];
 		AG_BenchmarkFn *bfn = &bm->funcs[fIdx];
@@ -684,6 +688,14 @@ ConsoleWrite(const char *msg)
 	return (1);
 }
 
+/* Write verbose and debug messages to stderr (in benchmark mode). */
+static int
+StderrWrite(const char *msg)
+{
+	fputs(msg, stderr);
+	return (1);
+}
+
 static void
 ConsoleWindowDetached(AG_Event *event)
 {
@@ -824,11 +836,12 @@ main(int argc, char *argv[])
 	AG_Box *hBox;
 	int c, i, optInd;
 	Uint initFlags = AG_VERBOSE;
-	int noConsoleRedir=0;
+	int noConsoleRedir=0, benchMode=0;
 
 	TAILQ_INIT(&tests);
 
-	while ((c = AG_Getopt(argc, argv, "CDWqd:s:t:v?hp:", &optArg, &optInd)) != -1) {
+	while ((c = AG_Getopt(argc, argv, "CDWbqd:s:t:v?hp:n:w:P:o:f:B:T:",
+	    &optArg, &optInd)) != -1) {
 		switch (c) {
 		case 'C':
 			noConsoleRedir = 1;
@@ -836,6 +849,38 @@ main(int argc, char *argv[])
 		case 'D':
 			agDebugLvl = 2;
 			break;
+		case 'b':
+			benchMode = 1;
+			break;
+		case 'n':
+			benchCfg.runs = atoi(optArg);
+			break;
+		case 'w':
+			benchCfg.warmup = atoi(optArg);
+			break;
+		case 'P':
+			benchCfg.cpu = atoi(optArg);
+			break;
+		case 'o':
+			benchCfg.outFile = optArg;
+			break;
+		case 'f':
+			if (AG_Strcasecmp(optArg, "csv") == 0) {
+				benchCfg.format = BENCH_FORMAT_CSV;
+			} else if (AG_Strcasecmp(optArg, "json") == 0) {
+				benchCfg.format = BENCH_FORMAT_JSON;
+			} else {
+				printf("Bad output format: %s (json or csv)\n",
+				    optArg);
+				return (1);
+			}
+			break;
+		case 'B':
+			benchCfg.baselineFile = optArg;
+			break;
+		case 'T':
+			benchCfg.threshold = atof(optArg);
+			break;
 		case 'W':
 			initFlags |= AG_SOFT_TIMERS;
 			break;
@@ -874,10 +919,21 @@ main(int argc, char *argv[])
 		case '?':
 		case 'h':
 		default:
-			printf("Usage: agartest [-bCWqv] [-d driver] [-s stylesheet] [-t font] [test1 test2 ...]\n");
+			printf("Usage: agartest [-bCWqv] [-d driver] [-s stylesheet] [-t font]\n"
+			       "                [-n runs] [-w warmup] [-P cpu] [-o file] [-f json|csv]\n"
+			       "                [-B baseline] [-T threshold] [test1 test2 ...]\n");
 			return (1);
 		}
 	}
+#ifdef _WIN32
+	optInd++;                                 /* Skip pathname argument */
+#endif
+	if (benchMode) {
+		AG_SetVerboseCallback(StderrWrite);
+		AG_SetDebugCallback(StderrWrite);
+		if (driverSpec == NULL)
+			driverSpec = "dummy";
+	}
 	if (AG_InitCore("agartest", initFlags) == -1) {
 		goto fail;
 	}
@@ -897,7 +953,7 @@ main(int argc, char *argv[])
 
 	/* Redirect AG_Verbose() and AG_Debug() output to the AG_Console. */
 	consoleBuf[0] = '\0';
-	if (!noConsoleRedir) {
+	if (!noConsoleRedir && !benchMode) {
 		AG_SetVerboseCallback(ConsoleWrite);
 		AG_SetDebugCallback(ConsoleWrite);
 	}
@@ -925,6 +981,15 @@ main(int argc, char *argv[])
 	(void)AG_ConfigLoad();
 	AG_SetDefaultFont(NULL);
 
+	if (benchMode) {				/* Headless benchmarks */
+		int rv;
+
+		rv = BenchRunHeadless(testCases, &argv[optInd], argc-optInd);
+		AG_DestroyGraphics();
+		AG_Destroy();
+		return (rv);
+	}
+
 	if ((win = winMain = AG_WindowNew(AG_WINDOW_MAIN)) == NULL) {
 		return (1);
 	}
@@ -1134,9 +1199,6 @@ main(int argc, char *argv[])
 	AG_WindowSetGeometryAligned(win, AG_WINDOW_MC, 980, 540);
 	AG_WindowShow(win);
 
-#ifdef _WIN32
-	optInd++;                                 /* Skip pathname argument */
-#endif
 	if (optInd == argc &&
 	    AG_GetBool(agConfig,"initial-run") == 1) {
 #ifdef AUTORUN_WIDGETS
@@ -66,12 +66,46 @@ typedef struct ag_benchmark {
 					   preemption and retry (0=disable) */
 } AG_Benchmark;
 
-AG_ConsoleLine *_Nonnull TestMsg(void *_Nonnull, const char *_Nonnull, ...);
-AG_ConsoleLine *_Nonnull TestMsgS(void *_Nonnull, const char *_Nonnull);
+/* Settings for headless benchmark mode (agartest -b). */
+typedef struct bench_settings {
+	int warmup;			/* Discarded runs before sampling */
+	int runs;			/* Samples per function (0 = default) */
+	int cpu;			/* Pin to this CPU (-1 = no pinning) */
+	enum bench_format {
+		BENCH_FORMAT_JSON,
+		BENCH_FORMAT_CSV
+	} format;			/* Output format */
+	const char *_Nullable outFile;	  /* Output file (NULL = stdout) */
+	const char *_Nullable baselineFile; /* Results to compare against */
+	double threshold;		/* Regression threshold (%) */
+} BenchSettings;
+
+#if defined(HAVE_64BIT) && \
+    (defined(i386) || defined(__i386__) || defined(__x86_64__))
+# define HAVE_RDTSC
+static __inline__ Uint64
+rdtsc(void)
+{
+	Uint32 lo, hi;
+
+	__asm __volatile("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((Uint64)hi << 32) | lo;
+}
+#else
+# undef HAVE_RDTSC
+#endif
+
+extern BenchSettings benchCfg;
+
+AG_ConsoleLine *_Nullable TestMsg(void *_Nonnull, const char *_Nonnull, ...);
+AG_ConsoleLine *_Nullable TestMsgS(void *_Nonnull, const char *_Nonnull);
 
 void TestExecBenchmark(void *_Nonnull, AG_Benchmark *_Nonnull);
 void TestWindowClose(AG_Event *_Nonnull);
 
+void BenchExecHeadless(void *_Nonnull, AG_Benchmark *_Nonnull);
+int  BenchRunHeadless(const AG_TestCase *_Nonnull *_Nonnull, char *_Nonnull *_Nullable, int);
+
 #include "config/enable_nls.h"
 #ifdef ENABLE_NLS
 # include <libintl.h>
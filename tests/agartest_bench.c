@@ -0,0 +1,580 @@
+/*	Public domain	*/
+
+/*
+ * Headless benchmark runner (agartest -b). Runs the benchmarks of the
+ * given test modules without a GUI console, computes statistics over the
+ * per-iteration timings and writes them out as JSON or CSV. Optionally
+ * compares the medians against a baseline file produced by an earlier run.
+ */
+
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+# define _GNU_SOURCE				/* For sched_setaffinity() */
+#endif
+
+#include "agartest.h"
+
+#include <agar/config/have_clock_gettime.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# if defined(__linux__)
+#  include <sched.h>
+# endif
+# if defined(HAVE_CLOCK_GETTIME)
+#  include <time.h>
+# endif
+#endif
+
+/* Statistics over the samples of one benchmark function. */
+typedef struct bench_result {
+	char suite[32];			/* Test module name */
+	char group[64];			/* AG_Benchmark name */
+	char name[96];			/* AG_BenchmarkFn name */
+	Uint runs;			/* Samples collected */
+	Uint iterations;		/* Iterations per sample */
+	double min, max;		/* Per-iteration time */
+	double mean, median, p95, stddev;
+	double baseline;		/* Baseline median (or < 0) */
+} BenchResult;
+
+BenchSettings benchCfg = {
+	0,				/* warmup */
+	0,				/* runs */
+	-1,				/* cpu */
+	BENCH_FORMAT_JSON,		/* format */
+	NULL,				/* outFile */
+	NULL,				/* baselineFile */
+	10.0				/* threshold */
+};
+
+static BenchResult *benchResults = NULL;
+static Uint         benchResultCount = 0;
+static const char  *benchUnit = "ticks";
+
+/* Return the current time in the units reported by benchUnit. */
+static Uint64
+BenchClock(void)
+{
+#ifdef HAVE_RDTSC
+	if (agCPU.ext & AG_EXT_TSC) {
+		benchUnit = "clks";
+		return rdtsc();
+	}
+#endif
+#if defined(_WIN32)
+	{
+		LARGE_INTEGER freq, count;
+
+		QueryPerformanceFrequency(&freq);
+		QueryPerformanceCounter(&count);
+		benchUnit = "ns";
+		return (Uint64)((double)count.QuadPart * 1e9 /
+		                (double)freq.QuadPart);
+	}
+#elif defined(HAVE_CLOCK_GETTIME)
+	{
+		struct timespec ts;
+
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		benchUnit = "ns";
+		return (Uint64)ts.tv_sec*1000000000ULL + (Uint64)ts.tv_nsec;
+	}
+#else
+	benchUnit = "ticks";
+	return (Uint64)AG_GetTicks();
+#endif
+}
+
+static int
+CompareDoubles(const void *p1, const void *p2)
+{
+	const double a = *(const double *)p1;
+	const double b = *(const double *)p2;
+
+	return (a < b) ? -1 : (a > b) ? 1 : 0;
+}
+
+/* Compute the summary statistics of n samples (sorted in place). */
+static void
+BenchStats(BenchResult *r, double *samples, Uint n)
+{
+	double sum = 0.0, var = 0.0;
+	Uint i, rank;
+
+	qsort(samples, n, sizeof(double), CompareDoubles);
+
+	for (i = 0; i < n; i++) {
+		sum += samples[i];
+	}
+	r->runs = n;
+	r->min = samples[0];
+	r->max = samples[n-1];
+	r->mean = sum / (double)n;
+	r->median = (n & 1) ? samples[n/2] :
+	            (samples[n/2 - 1] + samples[n/2]) / 2.0;
+
+	rank = (Uint)ceil(0.95 * (double)n);		/* Nearest rank */
+	r->p95 = samples[(rank > 0) ? rank-1 : 0];
+
+	for (i = 0; i < n; i++) {
+		var += (samples[i] - r->mean) * (samples[i] - r->mean);
+	}
+	r->stddev = (n > 1) ? sqrt(var / (double)(n - 1)) : 0.0;
+	r->baseline = -1.0;
+}
+
+/*
+ * Execute a benchmark module headlessly (called by TestExecBenchmark()
+ * when the instance has no console) and record the results.
+ */
+void
+BenchExecHeadless(void *obj, AG_Benchmark *bm)
+{
+	AG_TestInstance *ti = obj;
+	const Uint runs = (benchCfg.runs > 0) ? (Uint)benchCfg.runs : bm->runs;
+	const Uint iterations = (bm->iterations > 0) ? bm->iterations : 1;
+	double *samples;
+	Uint fIdx;
+
+	if (runs == 0 ||
+	    (samples = TryMalloc(runs*sizeof(double))) == NULL)
+		return;
+
+	for (fIdx = 0; fIdx < bm->nFuncs; fIdx++) {
+		AG_BenchmarkFn *bfn = &bm->funcs[fIdx];
+		BenchResult *r, *resultsNew;
+		Uint i, j, nRetries = 0;
+		Uint64 t1, t2;
+
+		for (i = 0; i < (Uint)benchCfg.warmup; i++) {
+			for (j = 0; j < iterations; j++)
+				bfn->run(ti, bfn->arg);
+		}
+		for (i = 0; i < runs; ) {
+			t1 = BenchClock();
+			for (j = 0; j < iterations; j++) {
+				bfn->run(ti, bfn->arg);
+			}
+			t2 = BenchClock();
+			samples[i] = (double)(t2 - t1) / (double)iterations;
+
+			if (bm->maximum > 0 && samples[i] > bm->maximum &&
+			    ++nRetries < runs) {
+				continue;		/* Assume preemption */
+			}
+			i++;
+		}
+
+		if ((resultsNew = TryRealloc(benchResults,
+		    (benchResultCount+1)*sizeof(BenchResult))) == NULL) {
+			break;
+		}
+		benchResults = resultsNew;
+		r = &benchResults[benchResultCount++];
+		Strlcpy(r->suite, ti->name, sizeof(r->suite));
+		Strlcpy(r->group, bm->name, sizeof(r->group));
+		Strlcpy(r->name, bfn->name, sizeof(r->name));
+		r->iterations = iterations;
+		BenchStats(r, samples, runs);
+
+		fprintf(stderr, "%s: %s: median %.1f %s (p95 %.1f, "
+		                "stddev %.1f, %u runs)\n",
+		    r->suite, r->name, r->median, benchUnit, r->p95,
+		    r->stddev, r->runs);
+	}
+	free(samples);
+}
+
+/* Pin the calling thread to the given CPU. */
+static int
+BenchPinCPU(int cpu)
+{
+#if defined(__linux__)
+	cpu_set_t set;
+
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set) == -1) {
+		AG_SetError("sched_setaffinity(%d): %s", cpu,
+		    AG_Strerror(errno));
+		return (-1);
+	}
+	return (0);
+#elif defined(_WIN32)
+	if (SetThreadAffinityMask(GetCurrentThread(),
+	    (DWORD_PTR)1 << cpu) == 0) {
+		AG_SetError("SetThreadAffinityMask(%d) failed", cpu);
+		return (-1);
+	}
+	return (0);
+#else
+	AG_SetErrorS("CPU pinning is not supported on this platform");
+	return (-1);
+#endif
+}
+
+/* Write a string as a JSON string literal. */
+static void
+WriteJSONString(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for (; *s != '\0'; s++) {
+		if (*s == '"' || *s == '\\') {
+			fputc('\\', f);
+			fputc(*s, f);
+		} else if ((Uint8)*s < 0x20) {
+			fprintf(f, "\\u%04x", (Uint)(Uint8)*s);
+		} else {
+			fputc(*s, f);
+		}
+	}
+	fputc('"', f);
+}
+
+/* Write a string as a CSV field (quoted if needed). */
+static void
+WriteCSVString(FILE *f, const char *s)
+{
+	if (strpbrk(s, ",\"\n") == NULL) {
+		fputs(s, f);
+		return;
+	}
+	fputc('"', f);
+	for (; *s != '\0'; s++) {
+		if (*s == '"') {
+			fputc('"', f);
+		}
+		fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static int
+BenchWriteResults(void)
+{
+	FILE *f = stdout;
+	Uint i;
+
+	if (benchCfg.outFile != NULL &&
+	    (f = fopen(benchCfg.outFile, "w")) == NULL) {
+		AG_SetError("%s: %s", benchCfg.outFile, AG_Strerror(errno));
+		return (-1);
+	}
+	if (benchCfg.format == BENCH_FORMAT_CSV) {
+		fputs("suite,group,name,unit,runs,iterations,min,median,"
+		      "mean,p95,max,stddev\n", f);
+		for (i = 0; i < benchResultCount; i++) {
+			const BenchResult *r = &benchResults[i];
+
+			WriteCSVString(f, r->suite);
+			fputc(',', f);
+			WriteCSVString(f, r->group);
+			fputc(',', f);
+			WriteCSVString(f, r->name);
+			fprintf(f, ",%s,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n",
+			    benchUnit, r->runs, r->iterations, r->min,
+			    r->median, r->mean, r->p95, r->max, r->stddev);
+		}
+	} else {
+		AG_AgarVersion av;
+
+		AG_GetVersion(&av);
+		fprintf(f, "{\"agar\":\"%d.%d.%d\",\"arch\":",
+		    av.major, av.minor, av.patch);
+		WriteJSONString(f, agCPU.arch);
+		fprintf(f, ",\"unit\":\"%s\",\"warmup\":%d,\"benchmarks\":[\n",
+		    benchUnit, benchCfg.warmup);
+		for (i = 0; i < benchResultCount; i++) {
+			const BenchResult *r = &benchResults[i];
+
+			/* One benchmark per line (see BenchLoadBaseline()). */
+			fputs("{\"suite\":", f);
+			WriteJSONString(f, r->suite);
+			fputs(",\"group\":", f);
+			WriteJSONString(f, r->group);
+			fputs(",\"name\":", f);
+			WriteJSONString(f, r->name);
+			fprintf(f, ",\"runs\":%u,\"iterations\":%u,"
+			           "\"min\":%.3f,\"median\":%.3f,\"mean\":%.3f,"
+				   "\"p95\":%.3f,\"max\":%.3f,\"stddev\":%.3f}%s\n",
+			    r->runs, r->iterations, r->min, r->median, r->mean,
+			    r->p95, r->max, r->stddev,
+			    (i < benchResultCount-1) ? "," : "");
+		}
+		fputs("]}\n", f);
+	}
+	if (f != stdout) {
+		fclose(f);
+	}
+	return (0);
+}
+
+/*
+ * Extract the JSON string value of key from a line written by
+ * BenchWriteResults() (with escapes removed).
+ */
+static int
+GetJSONString(const char *ln, const char *key, char *dst, AG_Size size)
+{
+	char pat[32];
+	const char *s;
+	AG_Size n = 0;
+
+	Snprintf(pat, sizeof(pat), "\"%s\":\"", key);
+	if ((s = strstr(ln, pat)) == NULL) {
+		return (-1);
+	}
+	for (s += strlen(pat); *s != '\0' && *s != '"'; s++) {
+		if (*s == '\\' && s[1] != '\0') {
+			s++;
+		}
+		if (n+1 < size)
+			dst[n++] = *s;
+	}
+	dst[n] = '\0';
+	return (0);
+}
+
+/* Split the next CSV field off *s (quoted fields are unescaped). */
+static void
+GetCSVField(const char **s, char *dst, AG_Size size)
+{
+	const char *c = *s;
+	AG_Size n = 0;
+	int quoted = 0;
+
+	if (*c == '"') {
+		quoted = 1;
+		c++;
+	}
+	for (; *c != '\0' && *c != '\n'; c++) {
+		if (quoted && *c == '"') {
+			if (c[1] != '"') {
+				quoted = 0;
+				continue;
+			}
+			c++;
+		} else if (!quoted && *c == ',') {
+			break;
+		}
+		if (n+1 < size)
+			dst[n++] = *c;
+	}
+	dst[n] = '\0';
+	*s = (*c == ',') ? c+1 : c;
+}
+
+/* Look up the result for suite/group/name. */
+static BenchResult *
+FindResult(const char *suite, const char *group, const char *name)
+{
+	Uint i;
+
+	for (i = 0; i < benchResultCount; i++) {
+		BenchResult *r = &benchResults[i];
+
+		if (strcmp(r->suite, suite) == 0 &&
+		    strcmp(r->group, group) == 0 &&
+		    strcmp(r->name, name) == 0)
+			return (r);
+	}
+	return (NULL);
+}
+
+/*
+ * Load the medians from a baseline file (in either output format) into
+ * the baseline field of the matching results.
+ */
+static int
+BenchLoadBaseline(const char *path)
+{
+	char ln[1024], suite[32], group[64], name[96], field[64];
+	FILE *f;
+	int isCSV = -1;
+
+	if ((f = fopen(path, "r")) == NULL) {
+		AG_SetError("%s: %s", path, AG_Strerror(errno));
+		return (-1);
+	}
+	while (fgets(ln, sizeof(ln), f) != NULL) {
+		BenchResult *r;
+		double median;
+
+		if (isCSV == -1) {
+			isCSV = (strncmp(ln, "suite,", 6) == 0);
+			if (isCSV)
+				continue;
+		}
+		if (isCSV) {
+			const char *s = ln;
+			int i;
+
+			GetCSVField(&s, suite, sizeof(suite));
+			GetCSVField(&s, group, sizeof(group));
+			GetCSVField(&s, name, sizeof(name));
+			for (i = 0; i < 5; i++) {	/* Up to median */
+				GetCSVField(&s, field, sizeof(field));
+			}
+			median = strtod(field, NULL);
+		} else {
+			const char *s;
+
+			if (GetJSONString(ln, "suite", suite, sizeof(suite)) == -1 ||
+			    GetJSONString(ln, "group", group, sizeof(group)) == -1 ||
+			    GetJSONString(ln, "name", name, sizeof(name)) == -1 ||
+			    (s = strstr(ln, "\"median\":")) == NULL) {
+				continue;
+			}
+			median = strtod(&s[9], NULL);
+		}
+		if ((r = FindResult(suite, group, name)) != NULL)
+			r->baseline = median;
+	}
+	fclose(f);
+	return (0);
+}
+
+/*
+ * Compare the medians against the baseline. Return the number of
+ * benchmarks which regressed by more than the threshold.
+ */
+static int
+BenchCompareBaseline(void)
+{
+	int nRegressions = 0;
+	Uint i;
+
+	for (i = 0; i < benchResultCount; i++) {
+		const BenchResult *r = &benchResults[i];
+		double pct;
+
+		if (r->baseline < 0.0) {
+			fprintf(stderr, "%s: %s: not in baseline\n",
+			    r->suite, r->name);
+			continue;
+		}
+		pct = (r->baseline > 0.0) ?
+		      (r->median - r->baseline) * 100.0 / r->baseline : 0.0;
+		if (pct > benchCfg.threshold) {
+			fprintf(stderr, "%s: %s: REGRESSION %+.1f%% "
+			                "(%.1f -> %.1f %s)\n",
+			    r->suite, r->name, pct, r->baseline, r->median,
+			    benchUnit);
+			nRegressions++;
+		} else {
+			fprintf(stderr, "%s: %s: %+.1f%%\n",
+			    r->suite, r->name, pct);
+		}
+	}
+	return (nRegressions);
+}
+
+/* Run the benchmarks of one test module. */
+static int
+BenchRunTest(const AG_TestCase *tc)
+{
+	AG_TestInstance *ti;
+	int rv;
+
+	if ((ti = TryMalloc(tc->size)) == NULL) {
+		return (-1);
+	}
+	memset(ti, 0, tc->size);
+	ti->name = tc->name;
+	ti->tc = tc;
+	ti->score = 1.0;
+	ti->console = NULL;			/* Headless */
+
+	if (tc->init != NULL && tc->init(ti) == -1) {
+		free(ti);
+		return (-1);
+	}
+	rv = tc->bench(ti);
+	if (tc->destroy != NULL) {
+		tc->destroy(ti);
+	}
+	free(ti);
+	return (rv);
+}
+
+/*
+ * Run the benchmarks of the named test modules (or of all modules if
+ * nNames is 0). Return 0 on success, 1 on failure or 2 if the results
+ * regressed against the baseline.
+ */
+int
+BenchRunHeadless(const AG_TestCase **testCases, char **names, int nNames)
+{
+	const AG_TestCase **pTest;
+	int i, nFailed = 0, nRegressions = 0;
+
+	if (benchCfg.cpu >= 0 && BenchPinCPU(benchCfg.cpu) == -1)
+		fprintf(stderr, "agartest: %s\n", AG_GetError());
+
+	for (pTest = &testCases[0]; *pTest != NULL; pTest++) {
+		const AG_TestCase *tc = *pTest;
+
+		if (tc->bench == NULL) {
+			continue;
+		}
+		if (nNames > 0) {
+			for (i = 0; i < nNames; i++) {
+				if (AG_Strcasecmp(tc->name, names[i]) == 0)
+					break;
+			}
+			if (i == nNames)
+				continue;
+		}
+		if (tc->flags & (AG_TEST_OPENGL | AG_TEST_SDL)) {
+			fprintf(stderr, "%s: skipped (requires %s)\n",
+			    tc->name, (tc->flags & AG_TEST_OPENGL) ?
+			    "OpenGL" : "SDL");
+			continue;
+		}
+		if (BenchRunTest(tc) == -1) {
+			fprintf(stderr, "%s: Failed (%s)\n", tc->name,
+			    AG_GetError());
+			nFailed++;
+		}
+	}
+	for (i = 0; i < nNames; i++) {
+		for (pTest = &testCases[0]; *pTest != NULL; pTest++) {
+			if (AG_Strcasecmp((*pTest)->name, names[i]) == 0)
+				break;
+		}
+		if (*pTest == NULL || (*pTest)->bench == NULL) {
+			fprintf(stderr, "%s: No such benchmark\n", names[i]);
+			nFailed++;
+		}
+	}
+
+	if (BenchWriteResults() == -1) {
+		fprintf(stderr, "agartest: %s\n", AG_GetError());
+		nFailed++;
+	}
+	if (benchCfg.baselineFile != NULL) {
+		if (BenchLoadBaseline(benchCfg.baselineFile) == -1) {
+			fprintf(stderr, "agartest: %s\n", AG_GetError());
+			nFailed++;
+		} else if ((nRegressions = BenchCompareBaseline()) > 0) {
+			fprintf(stderr, "agartest: %d benchmark(s) regressed "
+			                "by more than %.1f%%\n",
+			    nRegressions, benchCfg.threshold);
+		}
+	}
+	free(benchResults);
+	benchResults = NULL;
+	benchResultCount = 0;
+
+	if (nFailed > 0) {
+		return (1);
+	}
+	return (nRegressions > 0) ? 2 : 0;
+}
@@ -0,0 +1,533 @@
+/*	Public domain	*/
+/*
+ * Test the AG_DataSource(3) buffered and zlib stream filters.
+ */
+
+#include "agartest.h"
+
+#ifdef AG_SERIALIZATION
+
+#include <agar/config/have_zlib.h>
+
+#define NVALUES 4096			/* Integers written per test */
+
+/*
+ * Write NVALUES integers and a string, then fill in the integers at
+ * offset 0 (the count) and at offset 8 (the offset of the string).
+ */
+static void
+WriteValues(AG_DataSource *ds)
+{
+	AG_Offset strOffs;
+	Uint32 i;
+
+	AG_WriteUint32(ds, 0);				/* Count */
+	AG_WriteUint32(ds, 0xdeadbeef);
+	AG_WriteUint32(ds, 0);				/* String offset */
+	for (i = 0; i < NVALUES; i++) {
+		AG_WriteUint32(ds, i*7);
+	}
+	strOffs = AG_Tell(ds);
+	AG_WriteString(ds, "The End");
+	AG_WriteUint32At(ds, NVALUES, 0);
+	AG_WriteUint32At(ds, (Uint32)strOffs, 8);
+}
+
+/* Read back and verify the data written by WriteValues(). */
+static int
+ReadValues(AG_TestInstance *ti, AG_DataSource *ds)
+{
+	char s[16];
+	Uint32 i, n, strOffs;
+
+	if ((n = AG_ReadUint32(ds)) != NVALUES ||
+	    AG_ReadUint32(ds) != 0xdeadbeef) {
+		TestMsg(ti, "Bad header (count=%u)", (Uint)n);
+		return (-1);
+	}
+	strOffs = AG_ReadUint32(ds);
+	for (i = 0; i < n; i++) {
+		if (AG_ReadUint32(ds) != i*7) {
+			TestMsg(ti, "Bad value #%u", (Uint)i);
+			return (-1);
+		}
+	}
+	if (AG_Tell(ds) != (AG_Offset)strOffs) {
+		TestMsg(ti, "String at %ld, expected %u", (long)AG_Tell(ds),
+		    (Uint)strOffs);
+		return (-1);
+	}
+	AG_CopyString(s, ds, sizeof(s));
+	if (strcmp(s, "The End") != 0) {
+		TestMsg(ti, "Bad string \"%s\"", s);
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ * Read past the end of the data. The first read must return the bytes
+ * remaining and the next one must return 0.
+ */
+static int
+ShortRead(AG_TestInstance *ti, AG_DataSource *ds, AG_Size nRemain)
+{
+	Uint8 buf[64];
+	AG_Size nRead;
+
+	if (AG_ReadP(ds, buf, sizeof(buf), &nRead) == -1 || nRead != nRemain) {
+		TestMsg(ti, "Short read returned %lu (expected %lu)",
+		    (unsigned long)nRead, (unsigned long)nRemain);
+		return (-1);
+	}
+	if (AG_ReadP(ds, buf, sizeof(buf), &nRead) == 0 && nRead != 0) {
+		TestMsg(ti, "Read %lu bytes past the end", (unsigned long)nRead);
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+TestBuffered(AG_TestInstance *ti)
+{
+	AG_DataSource *core, *ds;
+	AG_Size len;
+	int rv = -1;
+
+	if ((core = AG_OpenAutoCore()) == NULL) {
+		return (-1);
+	}
+	/* A small buffer, so most AG_WriteAt() reach the underlying source. */
+	if ((ds = AG_OpenBuffered(core, 64, 0)) == NULL) {
+		TestMsg(ti, "AG_OpenBuffered: %s", AG_GetError());
+		AG_CloseDataSource(core);
+		return (-1);
+	}
+	WriteValues(ds);
+	if (AG_Flush(ds) == -1) {
+		goto out;
+	}
+	len = AG_CORE_SOURCE(core)->size;
+	if (len != 12 + NVALUES*4 + 4 + 7) {
+		TestMsg(ti, "Buffered: wrote %lu bytes", (unsigned long)len);
+		goto out;
+	}
+
+	/* Read back from the start. */
+	if (AG_Seek(ds, 0, AG_SEEK_SET) == -1 || ReadValues(ti, ds) == -1)
+		goto out;
+
+	/* Seek within the read-ahead buffer and outside of it. */
+	if (AG_Seek(ds, 12 + 100*4, AG_SEEK_SET) == -1 ||
+	    AG_ReadUint32(ds) != 100*7 ||
+	    AG_Seek(ds, -8, AG_SEEK_CUR) == -1 ||
+	    AG_ReadUint32(ds) != 99*7 ||
+	    AG_Seek(ds, 12 + 4000*4, AG_SEEK_SET) == -1 ||
+	    AG_ReadUint32(ds) != 4000*7) {
+		TestMsgS(ti, "Buffered: seek failed");
+		goto out;
+	}
+
+	/* Short read at the end. */
+	if (AG_Seek(ds, (AG_Offset)len - 5, AG_SEEK_SET) == -1 ||
+	    ShortRead(ti, ds, 5) == -1)
+		goto out;
+
+	rv = 0;
+out:
+	AG_CloseBuffered(ds);
+	AG_CloseDataSource(core);
+	return (rv);
+}
+
+/* A data source over another, whose seek operation can be made to fail. */
+typedef struct {
+	AG_DataSource ds;
+	AG_DataSource *sub;
+	int failSeek;
+} FailSeekSource;
+
+static int
+FailSeekRead(AG_DataSource *ds, void *buf, AG_Size size, AG_Size *rv)
+{
+	return AG_ReadP(((FailSeekSource *)ds)->sub, buf, size, rv);
+}
+
+static int
+FailSeekWrite(AG_DataSource *ds, const void *buf, AG_Size size, AG_Size *rv)
+{
+	return AG_WriteP(((FailSeekSource *)ds)->sub, buf, size, rv);
+}
+
+static AG_Offset
+FailSeekTell(AG_DataSource *ds)
+{
+	return AG_Tell(((FailSeekSource *)ds)->sub);
+}
+
+static int
+FailSeekSeek(AG_DataSource *ds, AG_Offset offs, enum ag_seek_mode mode)
+{
+	FailSeekSource *fs = (FailSeekSource *)ds;
+
+	if (fs->failSeek) {
+		AG_SetErrorS("Seek failed");
+		return (-1);
+	}
+	return AG_Seek(fs->sub, offs, mode);
+}
+
+/*
+ * A write following a read must land at the logical position. If the
+ * underlying source fails to seek back over the read-ahead data, the
+ * write must fail (rather than land past the read-ahead data).
+ */
+static int
+TestBufferedSeekFail(AG_TestInstance *ti)
+{
+	AG_DataSource *core, *ds = NULL;
+	FailSeekSource *fs;
+	const Uint8 *data;
+	Uint8 c = 0xaa;
+	int i, rv = -1;
+
+	if ((core = AG_OpenAutoCore()) == NULL) {
+		return (-1);
+	}
+	if ((fs = TryMalloc(sizeof(FailSeekSource))) == NULL) {
+		AG_CloseDataSource(core);
+		return (-1);
+	}
+	AG_DataSourceInit(&fs->ds);
+	fs->sub = core;
+	fs->failSeek = 0;
+	fs->ds.read = FailSeekRead;
+	fs->ds.write = FailSeekWrite;
+	fs->ds.tell = FailSeekTell;
+	fs->ds.seek = FailSeekSeek;
+
+	for (i = 0; i < 256; i++) {
+		AG_WriteUint8(core, (Uint8)i);
+	}
+	if (AG_Seek(core, 0, AG_SEEK_SET) == -1 ||
+	    (ds = AG_OpenBuffered(&fs->ds, 64, 0)) == NULL) {
+		goto out;
+	}
+	if (AG_ReadUint8(ds) != 0 ||
+	    AG_WriteP(ds, &c, 1, NULL) == -1 ||
+	    AG_Flush(ds) == -1) {
+		TestMsgS(ti, "Buffered: write after read failed");
+		goto out;
+	}
+	if (AG_ReadUint8(ds) != 2) {
+		TestMsgS(ti, "Buffered: read after write failed");
+		goto out;
+	}
+	fs->failSeek = 1;
+	if (AG_WriteP(ds, &c, 1, NULL) == 0) {
+		TestMsgS(ti, "Buffered: write succeeded after a failed seek");
+		goto out;
+	}
+	fs->failSeek = 0;
+	if (AG_Flush(ds) == -1) {
+		goto out;
+	}
+	data = AG_CORE_SOURCE(core)->data;
+	for (i = 0; i < 256; i++) {
+		if (data[i] != ((i == 1) ? 0xaa : i)) {
+			TestMsg(ti, "Buffered: byte %d is 0x%x", i, data[i]);
+			goto out;
+		}
+	}
+	rv = 0;
+out:
+	if (ds != NULL) {
+		AG_CloseBuffered(ds);
+	}
+	AG_DataSourceDestroy(&fs->ds);
+	AG_CloseDataSource(core);
+	return (rv);
+}
+
+#ifdef HAVE_ZLIB
+static int
+TestZlib(AG_TestInstance *ti)
+{
+	AG_DataSource *core, *ds, *dsIn;
+	const AG_Size len = 12 + NVALUES*4 + 4 + 7;
+	Uint32 v = 0;
+	int rv = -1;
+
+	if ((core = AG_OpenAutoCore()) == NULL) {
+		return (-1);
+	}
+	if ((ds = AG_OpenZlibCompress(core, 6, 0)) == NULL) {
+		TestMsg(ti, "AG_OpenZlibCompress: %s", AG_GetError());
+		AG_CloseDataSource(core);
+		return (-1);
+	}
+	WriteValues(ds);
+
+	/* Data already compressed cannot be patched. */
+	if (AG_Flush(ds) == -1) {
+		TestMsg(ti, "AG_Flush: %s", AG_GetError());
+		AG_CloseZlib(ds);
+		goto out;
+	}
+	if (AG_WriteAtP(ds, &v, sizeof(v), 0, NULL) == 0) {
+		TestMsgS(ti, "zlib: AG_WriteAt() succeeded after a flush");
+		AG_CloseZlib(ds);
+		goto out;
+	}
+	AG_CloseZlib(ds);
+	if (AG_CORE_SOURCE(core)->size >= len) {
+		TestMsg(ti, "zlib: %lu bytes compressed to %lu",
+		    (unsigned long)len,
+		    (unsigned long)AG_CORE_SOURCE(core)->size);
+		goto out;
+	}
+
+	/* Decompress. */
+	dsIn = AG_OpenConstCore(AG_CORE_SOURCE(core)->data,
+	    AG_CORE_SOURCE(core)->size);
+	if (dsIn == NULL ||
+	    (ds = AG_OpenZlibDecompress(dsIn, AG_DATA_SOURCE_CLOSE_SUB)) == NULL) {
+		TestMsg(ti, "AG_OpenZlibDecompress: %s", AG_GetError());
+		goto out;
+	}
+	if (ReadValues(ti, ds) == -1 || ShortRead(ti, ds, 0) == -1) {
+		AG_CloseZlib(ds);
+		goto out;
+	}
+	AG_CloseZlib(ds);
+
+	/* Forward seek (and short read) over decompressed data. */
+	dsIn = AG_OpenConstCore(AG_CORE_SOURCE(core)->data,
+	    AG_CORE_SOURCE(core)->size);
+	if (dsIn == NULL ||
+	    (ds = AG_OpenZlibDecompress(dsIn, AG_DATA_SOURCE_CLOSE_SUB)) == NULL) {
+		TestMsg(ti, "AG_OpenZlibDecompress: %s", AG_GetError());
+		goto out;
+	}
+	if (AG_Seek(ds, 12 + 2000*4, AG_SEEK_SET) == -1 ||
+	    AG_ReadUint32(ds) != 2000*7 ||
+	    AG_Seek(ds, 4, AG_SEEK_CUR) == -1 ||
+	    AG_ReadUint32(ds) != 2002*7) {
+		TestMsgS(ti, "zlib: forward seek failed");
+		AG_CloseZlib(ds);
+		goto out;
+	}
+	if (AG_Seek(ds, 0, AG_SEEK_SET) == 0) {
+		TestMsgS(ti, "zlib: backward seek succeeded");
+		AG_CloseZlib(ds);
+		goto out;
+	}
+	if (AG_Seek(ds, (AG_Offset)len - 5, AG_SEEK_SET) == -1 ||
+	    ShortRead(ti, ds, 5) == -1) {
+		AG_CloseZlib(ds);
+		goto out;
+	}
+	AG_CloseZlib(ds);
+	rv = 0;
+out:
+	AG_CloseDataSource(core);
+	return (rv);
+}
+
+/*
+ * Write a stream much larger than AG_ZLIB_WINDOW, with small writes and a
+ * single large one. Only the last AG_ZLIB_WINDOW bytes may be patched, and
+ * the memory held by the stream must stay bounded.
+ */
+static int
+TestZlibWindow(AG_TestInstance *ti)
+{
+	AG_DataSource *core, *ds = NULL, *dsIn;
+	const AG_Size nValues = AG_ZLIB_WINDOW;		/* 4*AG_ZLIB_WINDOW bytes */
+	const AG_Size blkSize = 3*AG_ZLIB_WINDOW;
+	Uint8 *blk, *blkIn = NULL;
+	AG_Offset blkOffs;
+	Uint32 v = 0xcafe;
+	AG_Size i;
+	int rv = -1;
+
+	if ((blk = TryMalloc(blkSize)) == NULL ||
+	    (blkIn = TryMalloc(blkSize)) == NULL ||
+	    (core = AG_OpenAutoCore()) == NULL) {
+		Free(blk);
+		Free(blkIn);
+		return (-1);
+	}
+	for (i = 0; i < blkSize; i++) {
+		blk[i] = (Uint8)((i * 31) ^ (i >> 9));
+	}
+	if ((ds = AG_OpenZlibCompress(core, 1, 0)) == NULL) {
+		TestMsg(ti, "AG_OpenZlibCompress: %s", AG_GetError());
+		goto out;
+	}
+	AG_WriteUint32(ds, 0);
+	for (i = 0; i < nValues; i++) {
+		AG_WriteUint32(ds, (Uint32)i);
+	}
+	blkOffs = AG_Tell(ds);
+	if (AG_Write(ds, blk, blkSize) == -1) {
+		TestMsg(ti, "zlib: AG_Write(): %s", AG_GetError());
+		goto out;
+	}
+
+	if (AG_ZLIB_SOURCE(ds)->holdSize > 2*AG_ZLIB_WINDOW) {
+		TestMsg(ti, "zlib: holding %lu bytes",
+		    (unsigned long)AG_ZLIB_SOURCE(ds)->holdSize);
+		goto out;
+	}
+	if (AG_WriteAtP(ds, &v, sizeof(v), 0, NULL) == 0 ||
+	    AG_WriteAtP(ds, &v, sizeof(v), blkOffs - 4, NULL) == 0) {
+		TestMsgS(ti, "zlib: patched data older than AG_ZLIB_WINDOW");
+		goto out;
+	}
+	if (AG_WriteAtP(ds, &v, sizeof(v),
+	    blkOffs + (AG_Offset)(blkSize - AG_ZLIB_WINDOW), NULL) == -1) {
+		TestMsg(ti, "zlib: AG_WriteAt(): %s", AG_GetError());
+		goto out;
+	}
+	memcpy(&blk[blkSize - AG_ZLIB_WINDOW], &v, sizeof(v));
+	AG_CloseZlib(ds);
+	ds = NULL;
+
+	dsIn = AG_OpenConstCore(AG_CORE_SOURCE(core)->data,
+	    AG_CORE_SOURCE(core)->size);
+	if (dsIn == NULL ||
+	    (ds = AG_OpenZlibDecompress(dsIn, AG_DATA_SOURCE_CLOSE_SUB)) == NULL) {
+		TestMsg(ti, "AG_OpenZlibDecompress: %s", AG_GetError());
+		goto out;
+	}
+	if (AG_ReadUint32(ds) != 0) {
+		TestMsgS(ti, "zlib: bad header");
+		goto out;
+	}
+	for (i = 0; i < nValues; i++) {
+		if (AG_ReadUint32(ds) != (Uint32)i) {
+			TestMsg(ti, "zlib: bad value #%lu", (unsigned long)i);
+			goto out;
+		}
+	}
+	if (AG_Read(ds, blkIn, blkSize) == -1 ||
+	    memcmp(blk, blkIn, blkSize) != 0 ||
+	    ShortRead(ti, ds, 0) == -1) {
+		TestMsgS(ti, "zlib: large write differs");
+		goto out;
+	}
+	rv = 0;
+out:
+	if (ds != NULL) {
+		AG_CloseZlib(ds);
+	}
+	AG_CloseDataSource(core);
+	Free(blkIn);
+	Free(blk);
+	return (rv);
+}
+
+/*
+ * Save an object through zlib over a buffered source (which requires
+ * AG_WriteAt() to fill in offsets), then load it back.
+ */
+static int
+TestZlibObject(AG_TestInstance *ti)
+{
+	AG_Object *ob, *obLoaded;
+	AG_DataSource *core, *bs, *ds, *dsIn;
+	char s[64];
+	int rv = -1;
+
+	ob = AG_ObjectNew(NULL, "saved", &agObjectClass);
+	obLoaded = AG_ObjectNew(NULL, "loaded", &agObjectClass);
+	AG_SetInt(ob, "int", -1234);
+	AG_SetUint32(ob, "uint32", 0xfeedface);
+	AG_SetString(ob, "string", "Compressed object");
+
+	if ((core = AG_OpenAutoCore()) == NULL) {
+		goto out_obj;
+	}
+	if ((bs = AG_OpenBuffered(core, 0, AG_DATA_SOURCE_CLOSE_SUB)) == NULL ||
+	    (ds = AG_OpenZlibCompress(bs, -1, 0)) == NULL) {
+		TestMsg(ti, "Open: %s", AG_GetError());
+		goto out_obj;
+	}
+	if (AG_ObjectSerialize(ob, ds) == -1) {
+		TestMsg(ti, "AG_ObjectSerialize: %s", AG_GetError());
+		AG_CloseZlib(ds);
+		AG_CloseBuffered(bs);
+		goto out_obj;
+	}
+	AG_CloseZlib(ds);
+	if (AG_Flush(bs) == -1) {
+		AG_CloseBuffered(bs);
+		goto out_obj;
+	}
+
+	dsIn = AG_OpenConstCore(AG_CORE_SOURCE(core)->data,
+	    AG_CORE_SOURCE(core)->size);
+	if (dsIn == NULL ||
+	    (ds = AG_OpenZlibDecompress(dsIn, AG_DATA_SOURCE_CLOSE_SUB)) == NULL) {
+		TestMsg(ti, "AG_OpenZlibDecompress: %s", AG_GetError());
+		AG_CloseBuffered(bs);
+		goto out_obj;
+	}
+	if (AG_ObjectUnserialize(obLoaded, ds) == -1) {
+		TestMsg(ti, "AG_ObjectUnserialize: %s", AG_GetError());
+		goto out_ds;
+	}
+	AG_GetString(obLoaded, "string", s, sizeof(s));
+	if (AG_GetInt(obLoaded, "int") != -1234 ||
+	    AG_GetUint32(obLoaded, "uint32") != 0xfeedface ||
+	    strcmp(s, "Compressed object") != 0) {
+		TestMsgS(ti, "Loaded object differs");
+		goto out_ds;
+	}
+	rv = 0;
+out_ds:
+	AG_CloseZlib(ds);
+	AG_CloseBuffered(bs);
+out_obj:
+	AG_ObjectDestroy(obLoaded);
+	AG_ObjectDestroy(ob);
+	return (rv);
+}
+#endif /* HAVE_ZLIB */
+
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+
+	if (TestBuffered(ti) == -1 ||
+	    TestBufferedSeekFail(ti) == -1) {
+		return (-1);
+	}
+#ifdef HAVE_ZLIB
+	if (TestZlib(ti) == -1 ||
+	    TestZlibWindow(ti) == -1 ||
+	    TestZlibObject(ti) == -1)
+		return (-1);
+#else
+	TestMsgS(ti, "zlib support not compiled in; skipping zlib tests");
+#endif
+	return (0);
+}
+
+const AG_TestCase datasourceTest = {
+	AGSI_IDEOGRAM AGSI_FILESYSTEM AGSI_RST,
+	"datasource",
+	N_("Test the AG_DataSource(3) buffered and zlib filters"),
+	"1.7.1",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
+
+#endif /* AG_SERIALIZATION */
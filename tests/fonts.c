@@ -19,6 +19,144 @@ SelectedFont(AG_Event *event)
 	}
 }
 
+/*
+ * Render the glyphs of a range of characters. Return the number of glyphs
+ * whose rectangle is not contained in their atlas page.
+ */
+static int
+RenderGlyphs(AG_Driver *drv, AG_Font *font, AG_Char c1, AG_Char c2)
+{
+	AG_Color cBg, cFg;
+	AG_Glyph *G;
+	AG_Char ch;
+	int nBad = 0;
+
+	AG_ColorNone(&cBg);
+	AG_ColorWhite(&cFg);
+	for (ch = c1; ch <= c2; ch++) {
+		G = AG_TextRenderGlyph(drv, font, &cBg, &cFg, ch);
+		if (G->rs.x < 0 || G->rs.y < 0 ||
+		    G->rs.x + G->rs.w > G->su->w ||
+		    G->rs.y + G->rs.h > G->su->h)
+			nBad++;
+	}
+	return (nBad);
+}
+
+/* Test the glyph atlas of the driver glyph cache. */
+static int
+Test(void *obj)
+{
+	AG_Driver *drv;
+	AG_GlyphCache *gc;
+	AG_Font *font = agDefaultFont;
+	AG_Glyph *G, *G2;
+	AG_Surface *S;
+	AG_Color cBg, cFg, c;
+	AG_Size budgetSaved;
+	int x, y, nLit = 0, rv = -1;
+
+	if (agDriverSw == NULL) {
+		TestMsgS(obj, "Skipping glyph cache test (not a single-window driver)");
+		return (0);
+	}
+	drv = AGDRIVER(agDriverSw);
+	gc = drv->glyphCache;
+	budgetSaved = gc->budget;
+	AG_TextClearGlyphCache(drv);
+
+	/* Cache hit: one rendering per (font, character), for all colors. */
+	AG_ColorBlack(&cBg);
+	AG_ColorWhite(&cFg);
+	G = AG_TextRenderGlyph(drv, font, &cBg, &cFg, 'A');
+	AG_ColorRGB_8(&cFg, 255,0,0);
+	G2 = AG_TextRenderGlyph(drv, font, &cBg, &cFg, 'A');
+	if (G2 != G || gc->nGlyphs != 1 || gc->nPages != 1) {
+		TestMsg(obj, "Cache miss on same glyph (%u glyphs, %u pages)",
+		    gc->nGlyphs, gc->nPages);
+		goto out;
+	}
+	if (G->color.r != cFg.r || G->color.g != cFg.g ||
+	    G->rs.x < 0 || G->rs.y < 0 ||
+	    G->rs.x + G->rs.w > G->su->w || G->rs.y + G->rs.h > G->su->h) {
+		TestMsgS(obj, "Bad glyph color or rectangle");
+		goto out;
+	}
+
+	/* AG_TextBlitGlyph() draws the glyph in its color, within rs only. */
+	S = AG_SurfaceStdRGBA(G->rs.w + 8, G->rs.h + 8);
+	AG_FillRect(S, NULL, &cBg);
+	AG_TextBlitGlyph(S, G, 0, 0);
+	for (y = 0; y < S->h; y++) {
+		for (x = 0; x < S->w; x++) {
+			AG_GetColor32(&c, AG_SurfaceGet32(S, x,y), &S->format);
+			if (c.r == 0 && c.g == 0 && c.b == 0) {
+				continue;
+			}
+			if (x >= G->rs.w || y >= G->rs.h) {
+				TestMsg(obj, "Glyph drawn outside of [%dx%d] at %d,%d",
+				    G->rs.w, G->rs.h, x, y);
+				AG_SurfaceFree(S);
+				goto out;
+			}
+			if (c.g > c.r || c.b > c.r) {
+				TestMsg(obj, "Glyph pixel %d,%d not tinted red", x,y);
+				AG_SurfaceFree(S);
+				goto out;
+			}
+			nLit++;
+		}
+	}
+	AG_SurfaceFree(S);
+	if (nLit == 0) {
+		TestMsgS(obj, "AG_TextBlitGlyph() drew nothing");
+		goto out;
+	}
+
+	/* Budget below one default page: pages shrink to fit, LRU evicts. */
+	AG_TextSetGlyphCacheBudget(drv, 65536);
+	if (RenderGlyphs(drv, font, 0x21, 0x7e) != 0 ||
+	    RenderGlyphs(drv, font, 0xa1, 0x17f) != 0) {
+		TestMsgS(obj, "Glyph outside of its atlas page");
+		goto out;
+	}
+	if (gc->size > 65536 || gc->nEvictions == 0) {
+		TestMsg(obj, "Budget not enforced (%lu bytes, %u evictions)",
+		    (unsigned long)gc->size, gc->nEvictions);
+		goto out;
+	}
+	AG_ColorWhite(&cFg);
+	G = AG_TextRenderGlyph(drv, font, &cBg, &cFg, 'A');
+	if (G->page != TAILQ_FIRST(&gc->pages)) {
+		TestMsgS(obj, "Last rendered glyph not in the MRU page");
+		goto out;
+	}
+
+	/* A budget smaller than any page keeps exactly one page. */
+	AG_TextSetGlyphCacheBudget(drv, 16);
+	if (RenderGlyphs(drv, font, 0x21, 0x7e) != 0 || gc->nPages != 1) {
+		TestMsg(obj, "Expected 1 page with a tiny budget (got %u)",
+		    gc->nPages);
+		goto out;
+	}
+
+	/* No limit. */
+	AG_TextSetGlyphCacheBudget(drv, 0);
+	AG_TextClearGlyphCache(drv);
+	if (RenderGlyphs(drv, font, 0x21, 0x17f) != 0 ||
+	    gc->nGlyphs != 0x17f - 0x21 + 1) {
+		TestMsg(obj, "Glyphs lost without a budget (%u)", gc->nGlyphs);
+		goto out;
+	}
+	TestMsg(obj, "Glyph cache: %u glyphs in %u pages (%lu bytes)",
+	    gc->nGlyphs, gc->nPages, (unsigned long)gc->size);
+	rv = 0;
+out:
+	AG_TextClearGlyphCache(drv);
+	AG_TextSetGlyphCacheBudget(drv, budgetSaved);
+	return (rv);
+}
+
 static int
 TestGUI(void *obj, AG_Window *win)
 {
@@ -322,7 +460,7 @@ const AG_TestCase fontsTest = {
 	sizeof(AG_TestInstance),
 	NULL,			/* init */
 	NULL,			/* destroy */
-	NULL,			/* test */
+	Test,
 	TestGUI,
 	NULL,			/* bench */
 };
@@ -7,12 +7,24 @@
 #include "agartest.h"
 #ifdef AG_TIMERS
 
+#include <stdlib.h>
+
 #include "objsystem_animal.h"
 #include "objsystem_mammal.h"
 
+#define BENCH_PATHS 1024			/* Paths resolved by Bench() */
+
 typedef struct {
 	AG_TestInstance _inherit;
 	AG_Object vfsRoot;			/* Our test VFS */
+	AG_Object *_Nullable benchVFS[2];	/* Bench() VFS (flat, nested) */
+	char (*_Nullable benchPaths)[AG_OBJECT_PATH_MAX];
+	Uint benchPath;
+	Uint32 _pad;
+#ifdef AG_SERIALIZATION
+	AG_Db *_Nullable benchDb;		/* Bench() database */
+	AG_Object *_Nullable benchObj;		/* Object loaded from benchDb */
+#endif
 } MyTestInstance;
 
 static int inited = 0;
@@ -77,6 +89,514 @@ TestGUI(void *obj, AG_Window *win)
 	return (0);
 }
 
+static void
+PooledEvent(AG_Event *event)
+{
+	int *n = AG_PTR(1);
+
+	(*n)++;
+}
+
+/*
+ * Create and destroy instances of a pooled class, mixed with instances
+ * allocated by malloc() before (and while) pooling is enabled, and check
+ * that each is returned to the allocator it came from.
+ */
+static int
+TestPooling(MyTestInstance *ti)
+{
+	AG_ObjectClass *C;
+	AG_Object *obMalloc, *obInit, *obLate, *ob[64];
+	AG_PoolStats st;
+	int i, nCalls = 0, rv = -1;
+
+	C = AG_CreateClass("AG_Object:MyPooledObject", sizeof(AG_Object),
+	    sizeof(AG_ObjectClass), 1, 0);
+	if (C == NULL) {
+		TestMsg(ti, "AG_CreateClass: %s", AG_GetError());
+		return (-1);
+	}
+
+	/* Unpooled instances: AG_ObjectNew(), then Malloc()+AG_ObjectInit(). */
+	obMalloc = AG_ObjectNew(NULL, "malloc", C);
+	if (AG_ClassSetPooling(C, 1) == -1) {
+		TestMsg(ti, "AG_ClassSetPooling: %s", AG_GetError());
+		AG_ObjectDestroy(obMalloc);
+		goto out;
+	}
+	obInit = Malloc(C->size);
+	AG_ObjectInit(obInit, C);
+
+	/* Pooled instances: AG_ObjectNew() and AG_ObjectAlloc()+Init(). */
+	for (i = 0; i < 64; i++) {
+		if (i & 1) {
+			ob[i] = AG_ObjectAlloc(C);
+			AG_ObjectInit(ob[i], C);
+		} else {
+			ob[i] = AG_ObjectNew(NULL, NULL, C);
+		}
+		AG_SetInt(ob[i], "n", i);
+		AG_SetEvent(ob[i], "ping", PooledEvent, "%p", &nCalls);
+	}
+	if ((obMalloc->flags & AG_OBJECT_POOLED) ||
+	    (obInit->flags & AG_OBJECT_POOLED)) {
+		TestMsgS(ti, "Unpooled instance flagged POOLED");
+		goto fail;
+	}
+	for (i = 0; i < 64; i++) {
+		if (!(ob[i]->flags & AG_OBJECT_POOLED) ||
+		    AG_GetInt(ob[i], "n") != i) {
+			TestMsg(ti, "Bad pooled instance #%d", i);
+			goto fail;
+		}
+		AG_PostEvent(ob[i], "ping", NULL);
+	}
+	AG_ClassGetPoolStats(C, &st);
+	if (st.nInUse != 64 || nCalls != 64) {
+		TestMsg(ti, "Expected 64 pooled instances (got %u)", st.nInUse);
+		goto fail;
+	}
+
+	/* Unpooled instances go to free(), not to the pool. */
+	AG_ObjectDestroy(obMalloc);
+	AG_ObjectDestroy(obInit);
+	obMalloc = obInit = NULL;
+	AG_ClassGetPoolStats(C, &st);
+	if (st.nInUse != 64) {
+		TestMsg(ti, "Unpooled free changed nInUse (%u)", st.nInUse);
+		goto fail;
+	}
+
+	/* Disable pooling at runtime: live instances remain valid. */
+	for (i = 0; i < 32; i++) {
+		AG_ObjectDestroy(ob[i]);
+		ob[i] = NULL;
+	}
+	AG_ClassSetPooling(C, 0);
+	obLate = AG_ObjectNew(NULL, "late", C);
+	if (obLate->flags & AG_OBJECT_POOLED) {
+		TestMsgS(ti, "Instance flagged POOLED with pooling disabled");
+		AG_ObjectDestroy(obLate);
+		goto fail;
+	}
+	for (i = 32; i < 64; i++) {
+		if (AG_GetInt(ob[i], "n") != i) {
+			TestMsg(ti, "Pooled instance #%d corrupted", i);
+			AG_ObjectDestroy(obLate);
+			goto fail;
+		}
+		AG_ObjectDestroy(ob[i]);
+		ob[i] = NULL;
+	}
+	AG_ObjectDestroy(obLate);
+
+	/* All slabs are free and can be trimmed. */
+	AG_ClassGetPoolStats(C, &st);
+	if (st.nInUse != 0 || st.nPeak != 64) {
+		TestMsg(ti, "Expected 0 in use, 64 peak (got %u, %u)",
+		    st.nInUse, st.nPeak);
+		goto out;
+	}
+	AG_ClassSetPooling(C, 0);
+	AG_ClassGetPoolStats(C, &st);
+	if (st.nSlabs != 0) {
+		TestMsg(ti, "%u slabs left after trim", st.nSlabs);
+		goto out;
+	}
+
+	/* Re-enabling pooling allocates from fresh slabs. */
+	AG_ClassSetPooling(C, 1);
+	ob[0] = AG_ObjectNew(NULL, NULL, C);
+	AG_ClassGetPoolStats(C, &st);
+	i = (st.nInUse == 1 && st.nSlabs == 1 &&
+	     (ob[0]->flags & AG_OBJECT_POOLED));
+	AG_ObjectDestroy(ob[0]);
+	if (!i) {
+		TestMsgS(ti, "Pool not reusable after trim");
+		goto out;
+	}
+	TestMsg(ti, "Pooling: %lu allocations, %u per slab",
+	    (unsigned long)st.nAllocs, st.nPerSlab);
+	rv = 0;
+	goto out;
+fail:
+	for (i = 0; i < 64; i++) {
+		if (ob[i] != NULL)
+			AG_ObjectDestroy(ob[i]);
+	}
+	if (obMalloc != NULL) { AG_ObjectDestroy(obMalloc); }
+	if (obInit != NULL) { AG_ObjectDestroy(obInit); }
+out:
+	AG_DestroyClass(C);
+	return (rv);
+}
+
+/*
+ * Event handler index test. Random AG_SetEvent(), AG_AddEvent() and
+ * AG_UnsetEvent() calls on an object (crossing the size at which event
+ * handlers are indexed) are mirrored in a list of the expected handlers.
+ * After each call, posting an event (by name or by atom) must invoke the
+ * expected handlers in order of registration.
+ */
+#define EVTEST_NAMES    24		/* Distinct event names */
+#define EVTEST_HANDLERS 64		/* Maximum handlers at once */
+#define EVTEST_OPS      4000		/* Random operations */
+
+typedef struct {
+	int name;			/* Index into names */
+	int tag;			/* Identifies the handler */
+} EvTestHandler;
+
+typedef struct {
+	int tags[EVTEST_HANDLERS];	/* Tags of handlers invoked */
+	int nTags;
+	int nBadArgs;
+} EvTestLog;
+
+static void
+EvTestRecord(AG_Event *event)
+{
+	EvTestLog *log = AG_PTR(1);
+	const int tag = AG_INT(2);
+
+	if (AG_INT(3) != tag*3 + 1) {
+		log->nBadArgs++;
+	}
+	if (log->nTags < EVTEST_HANDLERS)
+		log->tags[log->nTags++] = tag;
+}
+
+static int
+TestEventIndex(MyTestInstance *ti)
+{
+	char names[EVTEST_NAMES][16];
+	AG_EventAtom atoms[EVTEST_NAMES];
+	EvTestHandler model[EVTEST_HANDLERS];
+	EvTestLog log;
+	AG_Object *ob;
+	AG_Event *ev;
+	Uint32 seed = 7;
+	int nModel = 0, nMin = EVTEST_HANDLERS, nMax = 0, nextTag = 1;
+	int op, i, j, k, rv = -1;
+
+	/* Atoms are stable, distinct and only created on demand. */
+	if (AG_LookupEventAtom("objsystem-never-set") != 0) {
+		TestMsgS(ti, "Lookup of an unknown event name returned an atom");
+		return (-1);
+	}
+	for (i = 0; i < EVTEST_NAMES; i++) {
+		Snprintf(names[i], sizeof(names[i]), "ev-test-%d", i);
+		atoms[i] = AG_GetEventAtom(names[i]);
+		for (j = 0; j < i; j++) {
+			if (atoms[j] == atoms[i]) {
+				TestMsg(ti, "Atoms of %s and %s are equal",
+				    names[i], names[j]);
+				return (-1);
+			}
+		}
+	}
+	for (i = 0; i < EVTEST_NAMES; i++) {
+		if (atoms[i] == 0 ||
+		    AG_GetEventAtom(names[i]) != atoms[i] ||
+		    AG_LookupEventAtom(names[i]) != atoms[i]) {
+			TestMsg(ti, "Atom of %s is not stable", names[i]);
+			return (-1);
+		}
+	}
+
+	ob = AG_ObjectNew(NULL, "evTest", &agObjectClass);
+
+	for (op = 0; op < EVTEST_OPS; op++) {
+		seed = seed*1103515245 + 12345;
+		i = (seed >> 16) % EVTEST_NAMES;
+		seed = seed*1103515245 + 12345;
+		k = (seed >> 16) % 10;
+		if ((op / 500) & 1) {			/* Mostly unset */
+			k = (k < 2) ? 0 : (k < 3) ? 4 : 9;
+		}
+
+		if (k < 4 && nModel < EVTEST_HANDLERS) {	/* Set */
+			for (j = 0; j < nModel; j++) {
+				if (model[j].name == i)
+					break;
+			}
+			if (j == nModel) {
+				model[nModel].name = i;
+				nModel++;
+			}
+			model[j].tag = nextTag;
+			AG_SetEvent(ob, names[i], EvTestRecord, "%p,%i", &log,
+			    nextTag);
+			nextTag++;
+		} else if (k < 7 && nModel < EVTEST_HANDLERS) {	/* Add */
+			model[nModel].name = i;
+			model[nModel].tag = nextTag;
+			nModel++;
+			AG_AddEvent(ob, names[i], EvTestRecord, "%p,%i", &log,
+			    nextTag);
+			nextTag++;
+		} else {					/* Unset */
+			for (j = 0; j < nModel; j++) {
+				if (model[j].name == i)
+					break;
+			}
+			if (j < nModel) {
+				memmove(&model[j], &model[j+1],
+				    (nModel - j - 1) * sizeof(EvTestHandler));
+				nModel--;
+			}
+			AG_UnsetEvent(ob, names[i]);
+		}
+
+		if (nModel > nMax) { nMax = nModel; }
+		if (nMax > EVTEST_HANDLERS/2 && nModel < nMin) { nMin = nModel; }
+
+		/* Post one event, alternately by name and by atom. */
+		seed = seed*1103515245 + 12345;
+		i = (seed >> 16) % EVTEST_NAMES;
+		log.nTags = 0;
+		log.nBadArgs = 0;
+		for (j = 0, k = 0; j < nModel; j++) {
+			if (model[j].name == i)
+				k++;
+		}
+		if (k == 1) {
+			for (j = 0; model[j].name != i; j++)
+				;
+			k = model[j].tag*3 + 1;
+		} else {
+			k = -1;			/* Arguments checked below */
+		}
+		if (op & 1) {
+			AG_PostEvent(ob, names[i], "%i", k);
+		} else {
+			AG_PostEventByAtom(ob, atoms[i], "%i", k);
+		}
+		for (j = 0, k = 0; j < nModel; j++) {
+			if (model[j].name != i) {
+				continue;
+			}
+			if (k >= log.nTags || log.tags[k] != model[j].tag) {
+				break;
+			}
+			k++;
+		}
+		if (j < nModel || k != log.nTags ||
+		    (log.nTags == 1 && log.nBadArgs > 0)) {
+			TestMsg(ti, "Op %d: post of %s invoked %d handlers "
+			            "(mismatch at #%d, %d handlers on object)",
+			    op, names[i], log.nTags, k, nModel);
+			goto out;
+		}
+
+		/* AG_FindEventHandler() returns the first matching handler. */
+		ev = AG_FindEventHandler(ob, names[i]);
+		for (j = 0; j < nModel; j++) {
+			if (model[j].name == i)
+				break;
+		}
+		if ((j == nModel) ? (ev != NULL) :
+		    (ev == NULL || ev->argv[2].data.i != model[j].tag)) {
+			TestMsg(ti, "Op %d: AG_FindEventHandler(%s) failed",
+			    op, names[i]);
+			goto out;
+		}
+	}
+#if AG_MODEL != AG_SMALL
+	if (ob->evIndex.nEvents != (Uint)nModel) {
+		TestMsg(ti, "Event index has %u handlers (expected %d)",
+		    ob->evIndex.nEvents, nModel);
+		goto out;
+	}
+#endif
+	TestMsg(ti, "Event index: %d random set/add/unset operations OK "
+	            "(%d to %d handlers)", EVTEST_OPS, nMin, nMax);
+	rv = 0;
+out:
+	AG_ObjectDestroy(ob);
+	return (rv);
+}
+
+static int
+Test(void *obj)
+{
+	MyTestInstance *ti = obj;
+
+	if (TestPooling(ti) == -1 ||
+	    TestEventIndex(ti) == -1)
+		return (-1);
+
+	return (0);
+}
+
+/*
+ * Path lookups in a VFS of 100000 objects, either as 100000 children of
+ * the root ("flat"), or as 10 x 100 x 100 objects ("nested").
+ */
+static void
+Bench_FindS(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	const char *path;
+
+	path = ti->benchPaths[arg*BENCH_PATHS + (ti->benchPath++ % BENCH_PATHS)];
+	if (AG_ObjectFindS(ti->benchVFS[arg], path) == NULL)
+		AG_FatalError("No such object");
+}
+static void
+Bench_FindMissing(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+
+	if (AG_ObjectFindS(ti->benchVFS[arg], "/object0/object0/missing") != NULL)
+		AG_FatalError("Found missing object");
+}
+static struct ag_benchmark_fn findOpsFns[] = {
+	{ "AG_ObjectFindS(flat, 1 level)",       Bench_FindS,       0 },
+	{ "AG_ObjectFindS(nested, 3 levels)",    Bench_FindS,       1 },
+	{ "AG_ObjectFindS(nested, missing)",     Bench_FindMissing, 1 },
+};
+struct ag_benchmark findOps = {
+	"AG_ObjectFindS(3)",
+	&findOpsFns[0],
+	sizeof(findOpsFns) / sizeof(findOpsFns[0]),
+	10, 10000, 0
+};
+
+#ifdef AG_SERIALIZATION
+/*
+ * Archive objects to (and load them from) a database using the built-in
+ * "file" backend.
+ */
+static void
+Bench_SaveToDB(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	const char *name = &ti->benchPaths[ti->benchPath++ % BENCH_PATHS][1];
+	AG_Object *ob;
+	AG_Dbt key;
+
+	if ((ob = AG_ObjectFindChild(ti->benchVFS[0], name)) == NULL)
+		AG_FatalError("No such object");
+
+	key.data = (void *)name;
+	key.size = strlen(name);
+	if (AG_ObjectSaveToDB(ob, ti->benchDb, &key) == -1)
+		AG_FatalError(NULL);
+}
+static void
+Bench_LoadFromDB(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	const char *name = &ti->benchPaths[ti->benchPath++ % BENCH_PATHS][1];
+	AG_Dbt key;
+
+	key.data = (void *)name;
+	key.size = strlen(name);
+	if (AG_ObjectLoadFromDB(ti->benchObj, ti->benchDb, &key) == -1)
+		AG_FatalError(NULL);
+}
+static struct ag_benchmark_fn dbOpsFns[] = {
+	{ "AG_ObjectSaveToDB(file)",   Bench_SaveToDB,   0 },
+	{ "AG_ObjectLoadFromDB(file)", Bench_LoadFromDB, 0 },
+};
+struct ag_benchmark dbOps = {
+	"AG_ObjectSaveToDB(3)",
+	&dbOpsFns[0],
+	sizeof(dbOpsFns) / sizeof(dbOpsFns[0]),
+	10, 1000, 0
+};
+
+static void
+BenchDB(MyTestInstance *ti)
+{
+	char path[AG_PATHNAME_MAX];
+	Uint i;
+
+	AG_ConfigGetPath(AG_CONFIG_PATH_TEMP, 0, path, sizeof(path));
+	Strlcat(path, AG_PATHSEP "agartest-objsystem.db", sizeof(path));
+
+	if ((ti->benchDb = AG_DbNew("file")) == NULL) {
+		TestMsg(ti, "AG_DbNew: %s", AG_GetError());
+		return;
+	}
+	AG_SetInt(ti->benchDb, "db-truncate", 1);
+	AG_SetInt(ti->benchDb, "db-fsync", 0);
+	if (AG_DbOpen(ti->benchDb, path, 0) == -1) {
+		TestMsg(ti, "%s", AG_GetError());
+		goto out;
+	}
+	ti->benchObj = AG_ObjectNew(NULL, "loaded", &agObjectClass);
+	for (i = 0; i < BENCH_PATHS; i++) {
+		Bench_SaveToDB(ti, 0);
+	}
+	AG_DbSync(ti->benchDb);
+
+	TestExecBenchmark(ti, &dbOps);
+
+	AG_ObjectDestroy(ti->benchObj);
+	ti->benchObj = NULL;
+	AG_DbClose(ti->benchDb);
+	AG_FileDelete(path);
+out:
+	AG_ObjectDestroy(ti->benchDb);
+	ti->benchDb = NULL;
+}
+#endif /* AG_SERIALIZATION */
+
+static int
+Bench(void *obj)
+{
+	MyTestInstance *ti = obj;
+	AG_Object *a, *b;
+	char name[AG_OBJECT_NAME_MAX];
+	Uint32 t1;
+	int i, j, k;
+
+	TestMsg(ti, "Creating 2 x 100000 objects...");
+	t1 = AG_GetTicks();
+	ti->benchPaths = Malloc(2*BENCH_PATHS*AG_OBJECT_PATH_MAX);
+	ti->benchVFS[0] = AG_ObjectNew(NULL, "flat", &agObjectClass);
+	ti->benchVFS[1] = AG_ObjectNew(NULL, "nested", &agObjectClass);
+	for (i = 0; i < 100000; i++) {
+		Snprintf(name, sizeof(name), "object%d", i);
+		AG_ObjectNew(ti->benchVFS[0], name, &agObjectClass);
+	}
+	for (i = 0; i < 10; i++) {
+		Snprintf(name, sizeof(name), "object%d", i);
+		a = AG_ObjectNew(ti->benchVFS[1], name, &agObjectClass);
+		for (j = 0; j < 100; j++) {
+			Snprintf(name, sizeof(name), "object%d", j);
+			b = AG_ObjectNew(a, name, &agObjectClass);
+			for (k = 0; k < 100; k++) {
+				Snprintf(name, sizeof(name), "object%d", k);
+				AG_ObjectNew(b, name, &agObjectClass);
+			}
+		}
+	}
+	for (i = 0; i < BENCH_PATHS; i++) {
+		Snprintf(ti->benchPaths[i], AG_OBJECT_PATH_MAX,
+		    "/object%d", rand() % 100000);
+		Snprintf(ti->benchPaths[BENCH_PATHS+i], AG_OBJECT_PATH_MAX,
+		    "/object%d/object%d/object%d",
+		    rand() % 10, rand() % 100, rand() % 100);
+	}
+	TestMsg(ti, "Created in %u ms", (Uint)(AG_GetTicks() - t1));
+
+	TestExecBenchmark(obj, &findOps);
+#ifdef AG_SERIALIZATION
+	BenchDB(ti);
+#endif
+
+	AG_ObjectDestroy(ti->benchVFS[0]);
+	AG_ObjectDestroy(ti->benchVFS[1]);
+	ti->benchVFS[0] = NULL;
+	ti->benchVFS[1] = NULL;
+	free(ti->benchPaths);
+	ti->benchPaths = NULL;
+	return (0);
+}
+
 const AG_TestCase objsystemTest = {
 	AGSI_IDEOGRAM AGSI_SMALL_SPHERE AGSI_RST,
 	"objsystem",
@@ -86,8 +606,8 @@ const AG_TestCase objsystemTest = {
 	sizeof(MyTestInstance),
 	Init,
 	Destroy,
-	NULL,		/* test */
+	Test,
 	TestGUI,
-	NULL		/* bench */
+	Bench
 };
 #endif /* AG_TIMERS */
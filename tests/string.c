@@ -10,6 +10,13 @@
 #include <agar/math/m_gui.h>
 
 #include <string.h>
+#include <stdlib.h>
+
+static AG_FmtProgram *_Nullable benchProg = NULL;	/* For Bench() */
+static AG_FmtString *_Nullable benchFs = NULL;
+static int benchInt = -123;
+static Uint benchUint = 123;
+static char benchBuf[128];
 
 static int
 Init(void *obj)
@@ -18,6 +25,324 @@ Init(void *obj)
 	return (0);
 }
 
+#ifdef AG_UNICODE
+
+#define NRANDOM_STRINGS 300		/* Strings for TestUnicodeRandom() */
+#define RANDOM_STRING_MAX 100		/* Maximum length (characters) */
+
+/* UTF-8 input and expected UCS-4 output. */
+static const struct {
+	const char *s;
+	int len;
+	AG_Char ucs[8];
+} utf8Tests[] = {
+	{ "A\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80Z", 5,
+	  { 0x41, 0xe9, 0x20ac, 0x1f600, 0x5a } },
+	{ "\xc2\x80\xdf\xbf\xe0\xa0\x80\xef\xbf\xbf\xf0\x90\x80\x80"
+	  "\xf4\x8f\xbf\xbf", 6,
+	  { 0x80, 0x7ff, 0x800, 0xffff, 0x10000, 0x10ffff } },
+	{ "\xf8\x88\x80\x80\x80\xfc\x84\x80\x80\x80\x80", 2,	/* Legacy */
+	  { 0x200000, 0x4000000 } },
+	{ "a\x80" "b", 3, { 'a', 0xfffd, 'b' } },		/* Continuation */
+	{ "\xc3" "A", 2, { 0xfffd, 'A' } },			/* Truncated */
+	{ "a\xe2\x82", 3, { 'a', 0xfffd, 0xfffd } },		/* Truncated */
+	{ "\xfe\xff", 2, { 0xfffd, 0xfffd } },			/* Bad lead */
+	{ "\xc0\x80", 2, { 0xfffd, 0xfffd } },			/* Overlong NUL */
+	{ "\xc1\xbf" "/", 3, { 0xfffd, 0xfffd, '/' } },	/* Overlong */
+	{ "\xe0\x80\xaf", 3, { 0xfffd, 0xfffd, 0xfffd } },	/* Overlong */
+	{ "\xf0\x82\x82\xac", 4,				/* Overlong */
+	  { 0xfffd, 0xfffd, 0xfffd, 0xfffd } },
+	{ "\xf8\x80\x80\x80\x80", 5,				/* Overlong */
+	  { 0xfffd, 0xfffd, 0xfffd, 0xfffd, 0xfffd } },
+};
+
+/* UTF-16 input (terminated by a 16-bit NUL) and expected UCS-4 output. */
+static const struct {
+	const char *encoding;
+	char s[12];
+	int len;
+	AG_Char ucs[4];
+} utf16Tests[] = {
+	{ "UTF-16LE", "A\0\x3d\xd8\x00\xde\0", 2, { 'A', 0x1f600 } },
+	{ "UTF-16BE", "\0A\xd8\x3d\xde\x00\0", 2, { 'A', 0x1f600 } },
+	{ "UTF-16LE", "\x3d\xd8\0", 1, { 0xfffd } },		/* Lone high */
+	{ "UTF-16LE", "\x00\xde" "B\0\0", 2, { 0xfffd, 'B' } }, /* Lone low */
+	{ "UTF-16LE", "\x3d\xd8" "B\0\0", 2, { 0xfffd, 'B' } }, /* High, no low */
+	{ "UTF-16BE", "\xdb\xff\xdf\xff\0", 1, { 0x10ffff } },
+};
+
+/* Import s and compare the result against len characters of expected. */
+static int
+CheckImport(AG_TestInstance *ti, const char *encoding, const char *s,
+    const AG_Char *expected, AG_Size len)
+{
+	AG_Char *ucs;
+	AG_Size outLen, outSize, i;
+
+	if ((ucs = AG_ImportUnicode(encoding, s, &outLen, &outSize)) == NULL) {
+		TestMsg(ti, "AG_ImportUnicode(%s): %s", encoding, AG_GetError());
+		return (-1);
+	}
+	if (outLen != len || ucs[len] != '\0' ||
+	    outSize < (len+1)*sizeof(AG_Char)) {
+		TestMsg(ti, "AG_ImportUnicode(%s): %lu characters (expected %lu)",
+		    encoding, (Ulong)outLen, (Ulong)len);
+		free(ucs);
+		return (-1);
+	}
+	for (i = 0; i < len; i++) {
+		if (ucs[i] != expected[i]) {
+			TestMsg(ti, "AG_ImportUnicode(%s): character %lu is "
+			            "U+%04X (expected U+%04X)", encoding, (Ulong)i,
+				    (Uint)ucs[i], (Uint)expected[i]);
+			free(ucs);
+			return (-1);
+		}
+	}
+	free(ucs);
+	return (0);
+}
+
+/* Decode the UTF-8 and UTF-16 test vectors. */
+static int
+TestUnicodeVectors(AG_TestInstance *ti)
+{
+	static const AG_Char latin1[] = { 'a', 0xe9, 0xff };
+	int i;
+
+	for (i = 0; i < (int)(sizeof(utf8Tests) / sizeof(utf8Tests[0])); i++) {
+		if (CheckImport(ti, "UTF-8", utf8Tests[i].s, utf8Tests[i].ucs,
+		    utf8Tests[i].len) == -1) {
+			TestMsg(ti, "UTF-8 test #%d failed", i);
+			return (-1);
+		}
+	}
+	for (i = 0; i < (int)(sizeof(utf16Tests) / sizeof(utf16Tests[0])); i++) {
+		if (CheckImport(ti, utf16Tests[i].encoding, utf16Tests[i].s,
+		    utf16Tests[i].ucs, utf16Tests[i].len) == -1) {
+			TestMsg(ti, "UTF-16 test #%d failed", i);
+			return (-1);
+		}
+	}
+	if (CheckImport(ti, "ISO-8859-1", "a\xe9\xff", latin1, 3) == -1)
+		return (-1);
+
+	return (0);
+}
+
+/*
+ * Export strings which are too long or not representable in the target
+ * encoding. AG_ExportUnicode() must fail, without splitting a character,
+ * and leave a NUL-terminated prefix.
+ */
+static int
+TestUnicodeExportErrors(AG_TestInstance *ti)
+{
+	static const AG_Char sEuro[] = { 'a', 0x20ac, 0 };
+	static const AG_Char sABC[] = { 'A', 'B', 'C', 0 };
+	static const AG_Char sLatin1[] = { 0xe9, 0x100, 0 };
+	static const AG_Char sASCII[] = { 'a', 0x80, 0 };
+	static const AG_Char sSurrogate[] = { 'A', 0xd800, 0 };
+	static const AG_Char sNonBMP[] = { 'A', 0x110000, 0 };
+	static const AG_Char sBad[] = { 'x', 0x80000000U, 0 };
+	char dst[16];
+
+	memset(dst, 0xaa, sizeof(dst));
+	if (AG_ExportUnicode("UTF-8", dst, sEuro, 4) == 0 ||
+	    strcmp(dst, "a") != 0) {
+		TestMsgS(ti, "UTF-8: bad truncation");
+		return (-1);
+	}
+	if (AG_ExportUnicode("UTF-8", dst, sEuro, 5) == -1 ||
+	    strcmp(dst, "a\xe2\x82\xac") != 0) {
+		TestMsgS(ti, "UTF-8: bad output");
+		return (-1);
+	}
+	memset(dst, 0xaa, sizeof(dst));
+	if (AG_ExportUnicode("UTF-8", dst, sBad, sizeof(dst)) == 0 ||
+	    strcmp(dst, "x") != 0) {
+		TestMsgS(ti, "UTF-8: exported a bad character");
+		return (-1);
+	}
+	memset(dst, 0xaa, sizeof(dst));
+	if (AG_ExportUnicode("ISO-8859-1", dst, sLatin1, sizeof(dst)) == 0 ||
+	    strcmp(dst, "\xe9") != 0 ||
+	    AG_ExportUnicode("US-ASCII", dst, sASCII, sizeof(dst)) == 0 ||
+	    strcmp(dst, "a") != 0) {
+		TestMsgS(ti, "ISO-8859-1/US-ASCII: exported a bad character");
+		return (-1);
+	}
+	memset(dst, 0xaa, sizeof(dst));
+	if (AG_ExportUnicode("US-ASCII", dst, sABC, 3) == 0 ||
+	    strcmp(dst, "AB") != 0) {
+		TestMsgS(ti, "US-ASCII: bad truncation");
+		return (-1);
+	}
+	memset(dst, 0xaa, sizeof(dst));
+	if (AG_ExportUnicode("UTF-16LE", dst, sABC, 6) == 0 ||
+	    memcmp(dst, "A\0B\0\0\0", 6) != 0) {
+		TestMsgS(ti, "UTF-16LE: bad truncation");
+		return (-1);
+	}
+	memset(dst, 0xaa, sizeof(dst));
+	if (AG_ExportUnicode("UTF-16BE", dst, sSurrogate, sizeof(dst)) == 0 ||
+	    memcmp(dst, "\0A\0\0", 4) != 0) {
+		TestMsgS(ti, "UTF-16BE: exported a surrogate");
+		return (-1);
+	}
+	memset(dst, 0xaa, sizeof(dst));
+	if (AG_ExportUnicode("UTF-16LE", dst, sNonBMP, sizeof(dst)) == 0 ||
+	    memcmp(dst, "A\0\0\0", 4) != 0) {
+		TestMsgS(ti, "UTF-16LE: exported a character above U+10FFFF");
+		return (-1);
+	}
+	return (0);
+}
+
+/* Generate a random string of mostly US-ASCII and some longer characters. */
+static AG_Size
+RandomUnicodeString(AG_Char *ucs, Uint32 *seed)
+{
+	AG_Size i, len;
+	Uint32 r;
+
+	*seed = *seed*1103515245 + 12345;
+	len = (*seed >> 16) % RANDOM_STRING_MAX;
+	for (i = 0; i < len; i++) {
+		*seed = *seed*1103515245 + 12345;
+		r = *seed >> 8;
+		switch ((r >> 20) % 10) {
+		case 0:
+			ucs[i] = 0x80 + r % (0x800 - 0x80);
+			break;
+		case 1:
+			ucs[i] = 0x800 + r % (0xd800 - 0x800);
+			break;
+		case 2:
+			ucs[i] = 0x10000 + r % (0x110000 - 0x10000);
+			break;
+		default:
+			ucs[i] = 1 + r % 0x7f;
+			break;
+		}
+	}
+	ucs[len] = '\0';
+	return (len);
+}
+
+/*
+ * Round-trip random strings through UTF-8 and UTF-16, and decode UTF-8
+ * with an invalid byte inserted at a random position (which must decode
+ * to a single U+FFFD). Long runs of US-ASCII exercise the block decoder.
+ */
+static int
+TestUnicodeRandom(AG_TestInstance *ti)
+{
+	static const char *encodings[] = { "UTF-8", "UTF-16LE", "UTF-16BE" };
+	AG_Char ucs[RANDOM_STRING_MAX+2], ucsBad[RANDOM_STRING_MAX+2];
+	char buf[RANDOM_STRING_MAX*6 + 2], *p;
+	AG_Size len, pos;
+	Uint32 seed = 1;
+	int i, j;
+
+	for (i = 0; i < NRANDOM_STRINGS; i++) {
+		len = RandomUnicodeString(ucs, &seed);
+		for (j = 0; j < 3; j++) {
+			if (AG_ExportUnicode(encodings[j], buf, ucs,
+			    sizeof(buf)) == -1) {
+				TestMsg(ti, "AG_ExportUnicode(%s): %s",
+				    encodings[j], AG_GetError());
+				return (-1);
+			}
+			if (CheckImport(ti, encodings[j], buf, ucs, len) == -1)
+				return (-1);
+		}
+
+		/* Insert 0xff between two characters. */
+		pos = (len > 0) ? (seed >> 16) % len : 0;
+		memcpy(ucsBad, ucs, pos*sizeof(AG_Char));
+		ucsBad[pos] = 0;
+		if (AG_ExportUnicode("UTF-8", buf, ucsBad, sizeof(buf)) == -1) {
+			return (-1);
+		}
+		p = &buf[strlen(buf)];
+		*p++ = (char)0xff;
+		if (AG_ExportUnicode("UTF-8", p, &ucs[pos],
+		    sizeof(buf) - (AG_Size)(p - buf)) == -1) {
+			return (-1);
+		}
+		ucsBad[pos] = 0xfffd;
+		memcpy(&ucsBad[pos+1], &ucs[pos], (len-pos)*sizeof(AG_Char));
+		if (CheckImport(ti, "UTF-8", buf, ucsBad, len+1) == -1) {
+			TestMsg(ti, "Invalid byte at character %lu", (Ulong)pos);
+			return (-1);
+		}
+	}
+	TestMsg(ti, "Unicode: %d random strings round-tripped",
+	    NRANDOM_STRINGS);
+	return (0);
+}
+#endif /* AG_UNICODE */
+
+/*
+ * Compile formats made only of conversions (which need the most space for
+ * their printf(3) specs) and compare the output against AG_Printf().
+ */
+static int
+TestFmtSpecs(AG_TestInstance *ti)
+{
+	char buf[256];
+	AG_FmtProgram *prog;
+	AG_FmtString *fs;
+	Uint u[8] = { 1, 0x22, 0x333, 0x4444, 0x55555, 0xa, 0xbb, 0xccc };
+	int i[4] = { 1, -22, 333, -4444 };
+	long l[4] = { 1L, -22L, 333L, -4444L };
+
+	if ((prog = AG_FmtCompile("%x%x%x%x%x%x%x%x")) == NULL) {
+		return (-1);
+	}
+	AG_FmtPrint(prog, buf, sizeof(buf), u[0], u[1], u[2], u[3], u[4],
+	    u[5], u[6], u[7]);
+	AG_FmtFree(prog);
+	if (strcmp(buf, AG_Printf("%x%x%x%x%x%x%x%x", u[0], u[1], u[2], u[3],
+	    u[4], u[5], u[6], u[7])) != 0) {
+		TestMsg(ti, "AG_FmtPrint(\"%%x...\") gave \"%s\"", buf);
+		return (-1);
+	}
+	if ((prog = AG_FmtCompile("%5d%5d%5d%5d")) == NULL) {
+		return (-1);
+	}
+	AG_FmtPrint(prog, buf, sizeof(buf), i[0], i[1], i[2], i[3]);
+	AG_FmtFree(prog);
+	if (strcmp(buf, AG_Printf("%5d%5d%5d%5d", i[0], i[1], i[2], i[3]))
+	    != 0) {
+		TestMsg(ti, "AG_FmtPrint(\"%%5d...\") gave \"%s\"", buf);
+		return (-1);
+	}
+	if ((prog = AG_FmtCompile("%ld%ld%ld%ld")) == NULL) {
+		return (-1);
+	}
+	AG_FmtPrint(prog, buf, sizeof(buf), l[0], l[1], l[2], l[3]);
+	AG_FmtFree(prog);
+	if (strcmp(buf, AG_Printf("%ld%ld%ld%ld", l[0], l[1], l[2], l[3]))
+	    != 0) {
+		TestMsg(ti, "AG_FmtPrint(\"%%ld...\") gave \"%s\"", buf);
+		return (-1);
+	}
+
+	/* Polled format strings are compiled the same way. */
+	fs = AG_PrintfP("%x%x%x%x%x%x%x%x", &u[0], &u[1], &u[2], &u[3],
+	    &u[4], &u[5], &u[6], &u[7]);
+	AG_ProcessFmtString(fs, buf, sizeof(buf));
+	AG_FreeFmtString(fs);
+	if (strcmp(buf, AG_Printf("%x%x%x%x%x%x%x%x", u[0], u[1], u[2], u[3],
+	    u[4], u[5], u[6], u[7])) != 0) {
+		TestMsg(ti, "AG_PrintfP(\"%%x...\") gave \"%s\"", buf);
+		return (-1);
+	}
+	return (0);
+}
+
 static int
 Test(void *obj)
 {
@@ -36,6 +361,7 @@ Test(void *obj)
 	Uint32 u32 = 323232;
 	Sint32 s32 = -323232;
 	AG_FmtString *fs;
+	AG_FmtProgram *prog;
 	M_Vector2 v2 = M_VECTOR2(2.1, M_PI);
 	M_Vector3 v3 = M_VECTOR3(3.1, 3.2, M_E);
 
@@ -74,6 +400,86 @@ Test(void *obj)
 	AG_ProcessFmtString(fs, buf, sizeof(buf));
 	TestMsgS(ti, buf);
 
+	TestMsgS(ti, "AG_FmtCompile() test:");
+	if ((prog = AG_FmtCompile("\tInt=%d Uint=%u Str=\"%-12s\" u8=%[u8] "
+	                          "s32=%[s32]")) == NULL) {
+		TestMsg(ti, "AG_FmtCompile: %s", AG_GetError());
+		return (-1);
+	}
+	AG_FmtPrint(prog, buf, sizeof(buf), i, u, someString, &u8, &s32);
+	TestMsgS(ti, buf);
+	if (strcmp(buf, AG_Printf("\tInt=%d Uint=%u Str=\"%-12s\" u8=%[u8] "
+	                          "s32=%[s32]", i, u, someString, &u8, &s32))
+	    != 0) {
+		TestMsgS(ti, "AG_FmtPrint() differs from AG_Printf()");
+		AG_FmtFree(prog);
+		return (-1);
+	}
+	if (AG_FmtPrint(prog, buf, 8, i, u, someString, &u8, &s32) !=
+	    strlen(AG_Printf("\tInt=%d Uint=%u Str=\"%-12s\" u8=%[u8] "
+	                     "s32=%[s32]", i, u, someString, &u8, &s32)) ||
+	    strlen(buf) != 7) {
+		TestMsgS(ti, "AG_FmtPrint() truncation failed");
+		AG_FmtFree(prog);
+		return (-1);
+	}
+	AG_FmtFree(prog);
+
+	if (TestFmtSpecs(ti) == -1)
+		return (-1);
+
+#ifdef AG_UNICODE
+	if (TestUnicodeVectors(ti) == -1 ||
+	    TestUnicodeExportErrors(ti) == -1 ||
+	    TestUnicodeRandom(ti) == -1)
+		return (-1);
+#endif
+	return (0);
+}
+
+static void
+Bench_Printf(void *obj, int arg)
+{
+	(void)AG_Printf("Int=%d Uint=%u Str=%s", benchInt, benchUint, "string");
+}
+static void
+Bench_FmtPrint(void *obj, int arg)
+{
+	(void)AG_FmtPrint(benchProg, benchBuf, sizeof(benchBuf),
+	    benchInt, benchUint, "string");
+}
+static void
+Bench_ProcessFmtString(void *obj, int arg)
+{
+	(void)AG_ProcessFmtString(benchFs, benchBuf, sizeof(benchBuf));
+}
+static struct ag_benchmark_fn printOpsFns[] = {
+	{ "AG_Printf()",           Bench_Printf,           0 },
+	{ "AG_FmtPrint()",         Bench_FmtPrint,         0 },
+	{ "AG_ProcessFmtString()", Bench_ProcessFmtString, 0 },
+};
+struct ag_benchmark printOps = {
+	"Formatted output",
+	&printOpsFns[0],
+	sizeof(printOpsFns) / sizeof(printOpsFns[0]),
+	10, 100000, 0
+};
+
+static int
+Bench(void *obj)
+{
+	if ((benchProg = AG_FmtCompile("Int=%d Uint=%u Str=%s")) == NULL) {
+		return (-1);
+	}
+	benchFs = AG_PrintfP("Int=%d Uint=%u Str=%s", &benchInt, &benchUint,
+	    "string");
+
+	TestExecBenchmark(obj, &printOps);
+
+	AG_FreeFmtString(benchFs);
+	benchFs = NULL;
+	AG_FmtFree(benchProg);
+	benchProg = NULL;
 	return (0);
 }
 
@@ -88,5 +494,5 @@ const AG_TestCase stringTest = {
 	NULL,		/* destroy */
 	Test,
 	NULL,		/* testGUI */
-	NULL		/* bench */
+	Bench
 };
@@ -20,6 +20,8 @@ typedef struct {
 	AG_Surface *_Nullable Sparrot;
 	AG_Surface *_Nullable S[24];
 	int nSurfaces;
+	AG_Surface *_Nullable Sblit[5];		/* Sources for blitter benchmarks */
+	AG_Surface *_Nullable Dblit[2];		/* Targets for blitter benchmarks */
 	AG_Color randColorA;
 	AG_Color randColorNoA;
 } MyTestInstance;
@@ -58,6 +60,71 @@ ClearSurfaces(MyTestInstance *ti)
 	}
 }
 
+static AG_Component
+RandomComponent(int x, int y)
+{
+#ifdef HAVE_RAND48
+	return (AG_Component)lrand48();
+#else
+	return (AG_Component)(x * y);
+#endif
+}
+
+/*
+ * Create the surfaces for the 32-bit blitter benchmarks. Like rendered text,
+ * the RGBA source has a mix of transparent, opaque and translucent pixels.
+ */
+static void
+InitBlitSurfaces(MyTestInstance *ti, int w, int h)
+{
+	AG_Surface *Srgba, *Srgb, *Skey, *Sidx;
+	AG_Palette *pal;
+	AG_Color c;
+	int x, y;
+	Uint i;
+
+	Srgba = ti->Sblit[0] = AG_SurfaceStdRGBA(w,h);
+	Srgb  = ti->Sblit[1] = AG_SurfaceStdRGB(w,h);
+	for (y = 0; y < h; y++) {
+		for (x = 0; x < w; x++) {
+			c.r = RandomComponent(x,y);
+			c.g = RandomComponent(x,y);
+			c.b = RandomComponent(x,y);
+			switch ((x + y) % 4) {
+			case 0:  c.a = AG_TRANSPARENT;	break;
+			case 1:  c.a = RandomComponent(x,y); break;
+			default: c.a = AG_OPAQUE;	break;
+			}
+			AG_SurfacePut(Srgba, x,y, AG_MapPixel(&Srgba->format, &c));
+			c.a = AG_OPAQUE;
+			AG_SurfacePut(Srgb, x,y, AG_MapPixel(&Srgb->format, &c));
+		}
+	}
+
+	ti->Sblit[2] = AG_SurfaceDup(Srgba);		/* Per-surface alpha */
+	AG_SurfaceSetAlpha(ti->Sblit[2], 0, AG_OPAQUE/2);
+
+	Skey = ti->Sblit[3] = AG_SurfaceDup(Srgb);	/* Colorkey */
+	AG_SurfaceSetColorKey(Skey, AG_SURFACE_COLORKEY,
+	    AG_SurfaceGet(Skey, 0,0));
+
+	Sidx = ti->Sblit[4] = AG_SurfaceIndexed(w,h, 8, 0);
+	pal = Sidx->format.palette;
+	for (i = 0; i < pal->nColors; i++) {
+		pal->colors[i].r = RandomComponent(i,i);
+		pal->colors[i].g = RandomComponent(i,i);
+		pal->colors[i].b = RandomComponent(i,i);
+		pal->colors[i].a = (i == 0) ? AG_TRANSPARENT : AG_OPAQUE;
+	}
+	for (y = 0; y < h; y++)
+		for (x = 0; x < w; x++)
+			AG_SurfacePut8(Sidx, x,y, (Uint8)RandomComponent(x,y));
+
+	ti->Dblit[0] = AG_SurfaceStdRGBA(w,h);
+	ti->Dblit[1] = AG_SurfaceRGBA(w,h, 32, 0,               /* 32-bit ARGB */
+	    0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000);
+}
+
 static int
 Init(void *obj)
 {
@@ -146,6 +213,7 @@ Init(void *obj)
 
 	RandomizeColors(ti);
 	ClearSurfaces(ti);
+	InitBlitSurfaces(ti, w,h);
 	return (0);
 }
 
@@ -162,6 +230,15 @@ Destroy(void *obj)
 
 	for (i = 0; i < ti->nSurfaces; i++)
 		AG_SurfaceFree(ti->S[i]);
+
+	for (i = 0; i < 5; i++) {
+		if (ti->Sblit[i] != NULL)
+			AG_SurfaceFree(ti->Sblit[i]);
+	}
+	for (i = 0; i < 2; i++) {
+		if (ti->Dblit[i] != NULL)
+			AG_SurfaceFree(ti->Dblit[i]);
+	}
 }
 
 static void
@@ -218,6 +295,686 @@ RandomizeSurfaces(MyTestInstance *ti)
 	}
 }
 
+/*
+ * Formats for the blitter correctness test: the 32-bit formats handled by
+ * the fast blitters, and two which fall back to the general blitters.
+ */
+static const struct blit_test_format {
+	const char *name;
+	int depth;
+	Uint32 R, G, B, A;
+} blitTestFormats[] = {
+	{ "RGBA32", 32, 0xff000000, 0x00ff0000, 0x0000ff00, 0x000000ff },
+	{ "ARGB32", 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 },
+	{ "ABGR32", 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 },
+	{ "BGRA32", 32, 0x0000ff00, 0x00ff0000, 0xff000000, 0x000000ff },
+	{ "XRGB32", 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0 },
+	{ "XBGR32", 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0 },
+	{ "RGB24",  24, 0xff0000,   0x00ff00,   0x0000ff,   0 },
+	{ "RGBA16", 16, 0xf000,     0x0f00,     0x00f0,     0x000f },
+};
+#define BLIT_TEST_W 67			/* Odd sizes, to exercise SIMD tails */
+#define BLIT_TEST_H 41
+
+static AG_Surface *
+BlitTestSurface(const struct blit_test_format *bf, int w, int h)
+{
+	if (bf->A != 0) {
+		return AG_SurfaceRGBA(w,h, bf->depth, 0,
+		    bf->R, bf->G, bf->B, bf->A);
+	} else {
+		return AG_SurfaceRGB(w,h, bf->depth, 0, bf->R, bf->G, bf->B);
+	}
+}
+
+/* Fill a surface with random colors (and alphas if mixedAlpha). */
+static void
+RandomFill(AG_Surface *S, int mixedAlpha)
+{
+	AG_Color c;
+	int x, y;
+
+	for (y = 0; y < S->h; y++) {
+		for (x = 0; x < S->w; x++) {
+			c.r = RandomComponent(x,y);
+			c.g = RandomComponent(x,y);
+			c.b = RandomComponent(x,y);
+			if (!mixedAlpha) {
+				c.a = AG_OPAQUE;
+			} else {
+				switch ((x + y) % 4) {
+				case 0:  c.a = AG_TRANSPARENT;	break;
+				case 1:  c.a = RandomComponent(x,y); break;
+				default: c.a = AG_OPAQUE;	break;
+				}
+			}
+			AG_SurfacePut(S, x,y, AG_MapPixel(&S->format, &c));
+		}
+	}
+}
+
+/* Compare two surfaces of the same format and size, pixel by pixel. */
+static int
+CompareSurfaces(MyTestInstance *ti, const AG_Surface *A, const AG_Surface *B,
+    const char *what)
+{
+	AG_Pixel pxA, pxB;
+	int x, y;
+
+	for (y = 0; y < A->h; y++) {
+		for (x = 0; x < A->w; x++) {
+			pxA = AG_SurfaceGet(A, x,y);
+			pxB = AG_SurfaceGet(B, x,y);
+			if (pxA != pxB) {
+				TestMsg(ti, "%s: pixel %d,%d is 0x%lx "
+				            "(expected 0x%lx)", what, x,y,
+				    (unsigned long)pxB, (unsigned long)pxA);
+				return (-1);
+			}
+		}
+	}
+	return (0);
+}
+
+/*
+ * Return the function of the standard blitter table (for sources of the
+ * given mode) matching the given depths, capabilities and CPU extensions.
+ */
+static AG_LowerBlitFn
+FindStdBlit(AG_SurfaceMode mode, int depthSrc, int depthDst, Uint32 caps,
+    Uint32 cpuExts)
+{
+	const AG_LowerBlit *b = agLowerBlits_Std[mode];
+	int i;
+
+	for (i = 0; i < agLowerBlits_Std_Count[mode]; i++, b++) {
+		if ((b->modeDst == AG_SURFACE_PACKED ||
+		     b->modeDst == AG_SURFACE_ANY) &&
+		    b->depthSrc == depthSrc && b->depthDst == depthDst &&
+		    b->caps == caps && b->cpuExts == cpuExts)
+			return (b->fn);
+	}
+	return (NULL);
+}
+
+/*
+ * Blit S to a copy of D with the given lower blitter (or AG_SurfaceBlit()
+ * if fn is NULL) and compare the result against Dref.
+ */
+static int
+CheckBlit(MyTestInstance *ti, AG_LowerBlitFn fn, const AG_Surface *S,
+    const AG_Rect *rs, const AG_Surface *D, const AG_Rect *rd,
+    const AG_Surface *Dref, const char *what)
+{
+	AG_Surface *Dt;
+	int rv;
+
+	Dt = AG_SurfaceDup(D);
+	if (fn != NULL) {
+		fn(Dt, rd, S, rs);
+	} else {
+		AG_SurfaceBlit(S, rs, Dt, rd->x, rd->y);
+	}
+	rv = CompareSurfaces(ti, Dref, Dt, what);
+	AG_SurfaceFree(Dt);
+	return (rv);
+}
+
+/*
+ * Check that the fast 32-bit blitters (C and SIMD versions) and the blitter
+ * selected by AG_SurfaceBlit() produce the same pixels as the general
+ * blitters, for every pair of test formats, with per-pixel alpha, per-surface
+ * alpha, colorkey and both. Also check the 8-bit indexed to 32-bit blitter.
+ */
+static int
+TestBlit(MyTestInstance *ti)
+{
+	static const Uint32 modes[] = {
+		0,
+		AG_LOWERBLIT_PSALPHA_SRC,
+		AG_LOWERBLIT_COLORKEY_SRC,
+		AG_LOWERBLIT_PSALPHA_SRC | AG_LOWERBLIT_COLORKEY_SRC
+	};
+	static const char *modeNames[] = { "", "Al", "Co", "AlCo" };
+	static const Uint32 exts[] = { 0, AG_EXT_SSE2 };
+	const int nFormats = sizeof(blitTestFormats) / sizeof(blitTestFormats[0]);
+	const struct blit_test_format *bfS, *bfD;
+	AG_Surface *S, *D, *Dref;
+	AG_LowerBlitFn fnRef, fn;
+	AG_Palette *pal;
+	AG_Rect rs, rd;
+	AG_Pixel key;
+	char what[64];
+	int i, j, k, e, x, y, nBlits = 0, rv = -1;
+
+	rs.x = 3;
+	rs.y = 2;
+	rs.w = BLIT_TEST_W - 5;
+	rs.h = BLIT_TEST_H - 3;
+	rd.x = 5;
+	rd.y = 4;
+	rd.w = rs.w;
+	rd.h = rs.h;
+
+	for (i = 0; i < nFormats; i++) {
+		bfS = &blitTestFormats[i];
+		for (j = 0; j < nFormats; j++) {
+			bfD = &blitTestFormats[j];
+			for (k = 0; k < 4; k++) {
+				S = BlitTestSurface(bfS, BLIT_TEST_W, BLIT_TEST_H);
+				RandomFill(S, 1);
+				if (modes[k] & AG_LOWERBLIT_PSALPHA_SRC) {
+					AG_SurfaceSetAlpha(S, 0, AG_OPAQUE/3);
+				}
+				if (modes[k] & AG_LOWERBLIT_COLORKEY_SRC) {
+					key = AG_SurfaceGet(S, rs.x, rs.y);
+					for (x = 0; x < S->w; x++) {
+						AG_SurfacePut(S, x, x % S->h, key);
+					}
+					AG_SurfaceSetColorKey(S, AG_SURFACE_COLORKEY,
+					    key);
+				}
+				D = BlitTestSurface(bfD, BLIT_TEST_W + 8,
+				                         BLIT_TEST_H + 8);
+				RandomFill(D, 1);
+
+				fnRef = FindStdBlit(AG_SURFACE_PACKED, 0,0,
+				    modes[k], 0);
+				Dref = AG_SurfaceDup(D);
+				fnRef(Dref, &rd, S, &rs);
+
+				Snprintf(what, sizeof(what), "%s->%s %s",
+				    bfS->name, bfD->name, modeNames[k]);
+				if (CheckBlit(ti, NULL, S,&rs, D,&rd, Dref,
+				    what) == -1) {
+					goto fail;
+				}
+				nBlits++;
+				for (e = 0; e < 2; e++) {
+					if (bfS->depth != 32 || bfD->depth != 32 ||
+					    (agCPU.ext & exts[e]) != exts[e] ||
+					    (fn = FindStdBlit(AG_SURFACE_PACKED,
+					     32,32, modes[k], exts[e])) == NULL)
+						continue;
+
+					Snprintf(what, sizeof(what),
+					    "%s->%s %s (%s)", bfS->name,
+					    bfD->name, modeNames[k],
+					    exts[e] ? "SSE2" : "C");
+					if (CheckBlit(ti, fn, S,&rs, D,&rd,
+					    Dref, what) == -1) {
+						goto fail;
+					}
+					nBlits++;
+				}
+				AG_SurfaceFree(Dref);
+				AG_SurfaceFree(D);
+				AG_SurfaceFree(S);
+			}
+		}
+	}
+
+	/* 8-bit indexed to 32-bit packed. */
+	S = AG_SurfaceIndexed(BLIT_TEST_W, BLIT_TEST_H, 8, 0);
+	pal = S->format.palette;
+	for (i = 0; i < (int)pal->nColors; i++) {
+		pal->colors[i].r = RandomComponent(i,i);
+		pal->colors[i].g = RandomComponent(i,i);
+		pal->colors[i].b = RandomComponent(i,i);
+		pal->colors[i].a = (i % 16 == 0) ? AG_TRANSPARENT : AG_OPAQUE;
+	}
+	for (y = 0; y < S->h; y++) {
+		for (x = 0; x < S->w; x++)
+			AG_SurfacePut8(S, x,y, (Uint8)RandomComponent(x,y));
+	}
+	for (j = 0; j < nFormats; j++) {
+		bfD = &blitTestFormats[j];
+		if (bfD->depth != 32) {
+			continue;
+		}
+		D = BlitTestSurface(bfD, BLIT_TEST_W + 8, BLIT_TEST_H + 8);
+		RandomFill(D, 1);
+		Dref = AG_SurfaceDup(D);
+		fnRef = FindStdBlit(AG_SURFACE_INDEXED, 8,0, 0, 0);
+		fnRef(Dref, &rd, S, &rs);
+
+		Snprintf(what, sizeof(what), "Indexed8->%s", bfD->name);
+		if (CheckBlit(ti, NULL, S,&rs, D,&rd, Dref, what) == -1 ||
+		    CheckBlit(ti, FindStdBlit(AG_SURFACE_INDEXED, 8,32, 0,0),
+		    S,&rs, D,&rd, Dref, what) == -1) {
+			goto fail;
+		}
+		nBlits += 2;
+		AG_SurfaceFree(Dref);
+		AG_SurfaceFree(D);
+	}
+	AG_SurfaceFree(S);
+
+	TestMsg(ti, "Blitters: %d blits identical to the general blitters",
+	    nBlits);
+	return (0);
+fail:
+	AG_SurfaceFree(Dref);
+	AG_SurfaceFree(D);
+	AG_SurfaceFree(S);
+	return (rv);
+}
+
+/*
+ * Fill (or if blend is 1, blend) the color c into the pixels of S which
+ * are inside both rd and the clipping rectangle, one pixel at a time.
+ * This is the reference for AG_FillRect() and AG_SurfaceBlendRect().
+ */
+static void
+FillRectRef(AG_Surface *S, const AG_Rect *rd, const AG_Color *c, int blend)
+{
+	const AG_Rect *cr = &S->clipRect;
+	const AG_Pixel px = AG_MapPixel(&S->format, c);
+	AG_Color pc;
+	int x, y;
+
+	if (blend && c->a == AG_TRANSPARENT)
+		return;
+
+	for (y = 0; y < S->h; y++) {
+		for (x = 0; x < S->w; x++) {
+			if (x < cr->x || x >= cr->x + cr->w ||
+			    y < cr->y || y >= cr->y + cr->h) {
+				continue;
+			}
+			if (rd != NULL &&
+			    (x < rd->x || x >= rd->x + rd->w ||
+			     y < rd->y || y >= rd->y + rd->h)) {
+				continue;
+			}
+			if (!blend || c->a == AG_OPAQUE) {
+				AG_SurfacePut(S, x,y, px);
+			} else if (S->format.BitsPerPixel < 8) {
+				AG_GetColor(&pc, AG_SurfaceGet(S, x,y),
+				    &S->format);
+				pc.r += ((c->r - pc.r) * c->a) >> AG_COMPONENT_BITS;
+				pc.g += ((c->g - pc.g) * c->a) >> AG_COMPONENT_BITS;
+				pc.b += ((c->b - pc.b) * c->a) >> AG_COMPONENT_BITS;
+				AG_SurfacePut(S, x,y,
+				    AG_MapPixel(&S->format, &pc));
+			} else {
+				AG_SurfaceBlend(S, x,y, c);
+			}
+		}
+	}
+}
+
+/*
+ * Fill or blend a rectangle into copies of S with AG_FillRect() or
+ * AG_SurfaceBlendRect(), and compare them against FillRectRef(). Blends
+ * are done with and without the SIMD kernels.
+ */
+static int
+CheckFillRect(MyTestInstance *ti, const AG_Surface *S, const AG_Rect *clip,
+    const AG_Rect *rd, const AG_Color *c, int blend, const char *name)
+{
+	AG_Surface *Sref, *St;
+	const Uint32 ext = agCPU.ext;
+	char what[96];
+	int pass, rv = 0;
+
+	Sref = AG_SurfaceDup(S);
+	Sref->clipRect = *clip;
+	FillRectRef(Sref, rd, c, blend);
+
+	for (pass = 0; pass < 2 && rv == 0; pass++) {
+		if (pass == 1) {
+			if (!blend || !(ext & AG_EXT_SSE2)) {
+				break;
+			}
+			agCPU.ext &= ~(AG_EXT_SSE2);
+		}
+		St = AG_SurfaceDup(S);
+		St->clipRect = *clip;
+		if (blend) {
+			AG_SurfaceBlendRect(St, rd, c);
+		} else {
+			AG_FillRect(St, rd, c);
+		}
+		agCPU.ext = ext;
+
+		if (rd != NULL) {
+			Snprintf(what, sizeof(what), "%s %s [%d,%d %dx%d] a=%d%s",
+			    name, blend ? "BlendRect" : "FillRect",
+			    rd->x, rd->y, rd->w, rd->h, (int)c->a,
+			    (pass == 1) ? " (no SIMD)" : "");
+		} else {
+			Snprintf(what, sizeof(what), "%s %s [clip] a=%d%s",
+			    name, blend ? "BlendRect" : "FillRect", (int)c->a,
+			    (pass == 1) ? " (no SIMD)" : "");
+		}
+		rv = CompareSurfaces(ti, Sref, St, what);
+		AG_SurfaceFree(St);
+	}
+	AG_SurfaceFree(Sref);
+	return (rv);
+}
+
+/*
+ * Check AG_FillRect() and AG_SurfaceBlendRect() pixel by pixel on every
+ * test surface format, with rectangles at odd offsets and sizes, partially
+ * outside of the surface, empty, and within a clipping rectangle. Pixels
+ * outside of the rectangle must be left untouched.
+ */
+static int
+TestFillRect(MyTestInstance *ti)
+{
+	const int nFormats = sizeof(blitTestFormats) / sizeof(blitTestFormats[0]);
+	const AG_Component alphas[] = {
+		AG_OPAQUE, AG_OPAQUE/3, AG_OPAQUE/2 + 1, 1, AG_TRANSPARENT
+	};
+	AG_Surface *S;
+	AG_Rect rects[7], clip;
+	AG_Color c;
+	char name[32];
+	int i, j, k, nSurfaces, nChecks = 0, rv = -1;
+
+	nSurfaces = ti->nSurfaces + nFormats;
+	for (i = 0; i < nSurfaces; i++) {
+		if (i < ti->nSurfaces) {
+			S = AG_SurfaceDup(ti->S[i]);
+			Snprintf(name, sizeof(name), "S[%d]", i);
+		} else {
+			S = BlitTestSurface(&blitTestFormats[i - ti->nSurfaces],
+			    BLIT_TEST_W, BLIT_TEST_H);
+			Strlcpy(name, blitTestFormats[i - ti->nSurfaces].name,
+			    sizeof(name));
+		}
+		RandomFill(S, 1);
+
+		AG_RectInit(&rects[0], 0, 0, S->w, S->h);
+		AG_RectInit(&rects[1], 3, 5, S->w/2 - 3, S->h/3 + 1);
+		AG_RectInit(&rects[2], -7, -3, 20, 11);
+		AG_RectInit(&rects[3], S->w - 9, S->h - 4, 30, 30);
+		AG_RectInit(&rects[4], 1, 2, 1, 1);
+		AG_RectInit(&rects[5], 7, 1, 5, S->h);
+		AG_RectInit(&rects[6], 10, 10, 0, 10);
+
+		for (k = 0; k < (int)(sizeof(alphas) / sizeof(alphas[0])); k++) {
+			c.r = RandomComponent(i,k);
+			c.g = RandomComponent(i,k);
+			c.b = RandomComponent(i,k);
+			c.a = alphas[k];
+
+			AG_RectInit(&clip, 0, 0, S->w, S->h);
+			for (j = 0; j < 7; j++) {
+				if (CheckFillRect(ti, S, &clip, &rects[j], &c, 0,
+				    name) == -1 ||
+				    CheckFillRect(ti, S, &clip, &rects[j], &c, 1,
+				    name) == -1) {
+					goto out;
+				}
+				nChecks += 2;
+			}
+			AG_RectInit(&clip, 5, 3, S->w/2 + 1, S->h/2 - 1);
+			if (CheckFillRect(ti, S, &clip, NULL, &c, 0, name) == -1 ||
+			    CheckFillRect(ti, S, &clip, NULL, &c, 1, name) == -1 ||
+			    CheckFillRect(ti, S, &clip, &rects[0], &c, 1,
+			    name) == -1 ||
+			    CheckFillRect(ti, S, &clip, &rects[3], &c, 0,
+			    name) == -1) {
+				goto out;
+			}
+			nChecks += 4;
+		}
+		AG_SurfaceFree(S);
+	}
+	TestMsg(ti, "FillRect/BlendRect: %d fills identical to per-pixel fills",
+	    nChecks);
+	return (0);
+out:
+	AG_SurfaceFree(S);
+	return (rv);
+}
+
+/*
+ * Scale S with AG_SurfaceScale() serially, in parallel and without SIMD,
+ * and check that all three results are identical. Return the serial result.
+ */
+static AG_Surface *
+ScaleCompare(MyTestInstance *ti, const AG_Surface *S, Uint w, Uint h,
+    Uint filter, const char *name)
+{
+	static const char *filterNames[] = {
+		"nearest", "bilinear", "box", "lanczos"
+	};
+	const Uint32 ext = agCPU.ext;
+	AG_Surface *D, *Dt;
+	char what[96];
+
+	D = AG_SurfaceScale(S, w,h, filter);
+
+	Dt = AG_SurfaceScale(S, w,h, filter | AG_SCALE_PARALLEL);
+	Snprintf(what, sizeof(what), "%s %dx%d->%ux%u %s (parallel)", name,
+	    S->w, S->h, w, h, filterNames[filter]);
+	if (CompareSurfaces(ti, D, Dt, what) == -1) {
+		goto fail;
+	}
+	AG_SurfaceFree(Dt);
+
+	if (ext & AG_EXT_SSE2) {
+		agCPU.ext &= ~(AG_EXT_SSE2);
+		Dt = AG_SurfaceScale(S, w,h, filter);
+		agCPU.ext = ext;
+		Snprintf(what, sizeof(what), "%s %dx%d->%ux%u %s (no SIMD)",
+		    name, S->w, S->h, w, h, filterNames[filter]);
+		if (CompareSurfaces(ti, Dt, D, what) == -1) {
+			goto fail;
+		}
+		AG_SurfaceFree(Dt);
+	}
+	return (D);
+fail:
+	AG_SurfaceFree(Dt);
+	AG_SurfaceFree(D);
+	return (NULL);
+}
+
+/*
+ * Check that nearest neighbor scaling of S to D picks the source pixel
+ * at x*(S->w - 1)/(w - 1), y*(S->h - 1)/(h - 1).
+ */
+static int
+CheckScaleNearest(MyTestInstance *ti, const AG_Surface *S,
+    const AG_Surface *D, const char *name)
+{
+	AG_Pixel pxS, pxD;
+	int x, y, xs, ys;
+
+	for (y = 0; y < D->h; y++) {
+		ys = (D->h > 1) ? y*(S->h - 1) / (D->h - 1) : 0;
+		for (x = 0; x < D->w; x++) {
+			xs = (D->w > 1) ? x*(S->w - 1) / (D->w - 1) : 0;
+			pxS = AG_SurfaceGet(S, xs,ys);
+			pxD = AG_SurfaceGet(D, x,y);
+			if (pxS != pxD) {
+				TestMsg(ti, "%s %dx%d->%dx%d nearest: pixel %d,%d "
+				            "is 0x%lx (expected 0x%lx from %d,%d)",
+				    name, S->w, S->h, D->w, D->h, x,y,
+				    (unsigned long)pxD, (unsigned long)pxS, xs,ys);
+				return (-1);
+			}
+		}
+	}
+	return (0);
+}
+
+/*
+ * Check that a filtered scaling of a horizontal (red) and vertical (green)
+ * opaque gradient remains monotonic, and that a constant surface remains
+ * constant.
+ */
+static int
+CheckScaleFiltered(MyTestInstance *ti, const AG_Surface *Sgrad,
+    const AG_Surface *Sconst, Uint w, Uint h, Uint filter, const char *name)
+{
+	AG_Surface *D;
+	AG_Color c, cPrev;
+	AG_Component aOpaque;
+	AG_Pixel px;
+	int x, y, rv = -1;
+
+	if ((D = ScaleCompare(ti, Sconst, w,h, filter, name)) == NULL) {
+		return (-1);
+	}
+	px = AG_SurfaceGet(Sconst, 0,0);
+	for (y = 0; y < D->h; y++) {
+		for (x = 0; x < D->w; x++) {
+			if (AG_SurfaceGet(D, x,y) != px) {
+				TestMsg(ti, "%s %ux%u filter %u: constant surface "
+				            "has 0x%lx at %d,%d", name, w,h, filter,
+				    (unsigned long)AG_SurfaceGet(D, x,y), x,y);
+				goto out;
+			}
+		}
+	}
+	AG_SurfaceFree(D);
+
+	if ((D = ScaleCompare(ti, Sgrad, w,h, filter, name)) == NULL) {
+		return (-1);
+	}
+	if (filter == AG_SCALE_LANCZOS) {		/* Lanczos rings */
+		rv = 0;
+		goto out;
+	}
+	AG_GetColor(&c, AG_SurfaceGet(Sgrad, 0,0), &Sgrad->format);
+	aOpaque = c.a;				/* Opaque in this format */
+	for (y = 0; y < D->h; y++) {
+		for (x = 0; x < D->w; x++) {
+			AG_GetColor(&c, AG_SurfaceGet(D, x,y), &D->format);
+			if (x > 0) {
+				AG_GetColor(&cPrev, AG_SurfaceGet(D, x-1,y),
+				    &D->format);
+				if (c.r < cPrev.r)
+					break;
+			}
+			if (y > 0) {
+				AG_GetColor(&cPrev, AG_SurfaceGet(D, x,y-1),
+				    &D->format);
+				if (c.g < cPrev.g)
+					break;
+			}
+			if (c.a != aOpaque)
+				break;
+		}
+		if (x < D->w) {
+			TestMsg(ti, "%s %ux%u filter %u: gradient is not "
+			            "monotonic (or opaque) at %d,%d",
+			    name, w,h, filter, x,y);
+			goto out;
+		}
+	}
+	rv = 0;
+out:
+	AG_SurfaceFree(D);
+	return (rv);
+}
+
+/*
+ * Check AG_SurfaceScale() with each filter, up and down by non-integer
+ * ratios: results must not depend on AG_SCALE_PARALLEL or SIMD, nearest
+ * neighbor must pick the expected source pixels, and filters must keep
+ * constant surfaces constant and gradients monotonic.
+ */
+static int
+TestScale(MyTestInstance *ti)
+{
+	static const Uint sizes[][2] = {
+		{ 150, 97 }, { 23, 17 }, { 67, 13 }, { 1, 1 }
+	};
+	const int nFormats = sizeof(blitTestFormats) / sizeof(blitTestFormats[0]);
+	AG_Surface *S, *Sgrad, *Sconst, *D;
+	AG_Color c;
+	char name[32];
+	int i, j, x, y, nScales = 0;
+	Uint filter;
+
+	/* Nearest neighbor on every test surface format. */
+	for (i = 0; i < ti->nSurfaces; i++) {
+		S = AG_SurfaceDup(ti->S[i]);
+		RandomFill(S, 1);
+		Snprintf(name, sizeof(name), "S[%d]", i);
+		for (j = 0; j < 4; j++) {
+			D = ScaleCompare(ti, S, sizes[j][0], sizes[j][1],
+			    AG_SCALE_NEAREST, name);
+			if (D == NULL) {
+				AG_SurfaceFree(S);
+				return (-1);
+			}
+			if (CheckScaleNearest(ti, S, D, name) == -1) {
+				AG_SurfaceFree(D);
+				AG_SurfaceFree(S);
+				return (-1);
+			}
+			AG_SurfaceFree(D);
+			nScales++;
+		}
+		AG_SurfaceFree(S);
+	}
+
+	/* Filters, on surfaces of the fast formats and a converted one. */
+	for (i = 0; i < nFormats; i++) {
+		const struct blit_test_format *bf = &blitTestFormats[i];
+
+		if (bf->depth == 24)
+			continue;
+
+		Sgrad = BlitTestSurface(bf, BLIT_TEST_W, BLIT_TEST_H);
+		for (y = 0; y < Sgrad->h; y++) {
+			for (x = 0; x < Sgrad->w; x++) {
+				c.r = x * AG_COLOR_LAST / (Sgrad->w - 1);
+				c.g = y * AG_COLOR_LAST / (Sgrad->h - 1);
+				c.b = AG_COLOR_LAST/3;
+				c.a = AG_OPAQUE;
+				AG_SurfacePut(Sgrad, x,y,
+				    AG_MapPixel(&Sgrad->format, &c));
+			}
+		}
+		Sconst = BlitTestSurface(bf, BLIT_TEST_W, BLIT_TEST_H);
+		c.r = AG_COLOR_LAST/5;
+		c.g = AG_COLOR_LAST/2;
+		c.b = AG_COLOR_LAST;
+		c.a = AG_OPAQUE;
+		AG_FillRect(Sconst, NULL, &c);
+		S = BlitTestSurface(bf, BLIT_TEST_W, BLIT_TEST_H);
+		RandomFill(S, 1);
+
+		for (filter = AG_SCALE_BILINEAR;
+		     filter <= AG_SCALE_LANCZOS;
+		     filter++) {
+			for (j = 0; j < 4; j++) {
+				if (CheckScaleFiltered(ti, Sgrad, Sconst,
+				    sizes[j][0], sizes[j][1], filter,
+				    bf->name) == -1) {
+					goto fail;
+				}
+				D = ScaleCompare(ti, S, sizes[j][0], sizes[j][1],
+				    filter, bf->name);
+				if (D == NULL) {
+					goto fail;
+				}
+				AG_SurfaceFree(D);
+				nScales++;
+			}
+		}
+		AG_SurfaceFree(S);
+		AG_SurfaceFree(Sconst);
+		AG_SurfaceFree(Sgrad);
+	}
+	TestMsg(ti, "AG_SurfaceScale: %d scalings OK", nScales);
+	return (0);
+fail:
+	AG_SurfaceFree(S);
+	AG_SurfaceFree(Sconst);
+	AG_SurfaceFree(Sgrad);
+	return (-1);
+}
+
 static int
 Test(void *obj)
 {
@@ -276,6 +1033,11 @@ Test(void *obj)
 		}
 	}
 
+	if (TestBlit(ti) == -1 ||
+	    TestFillRect(ti) == -1 ||
+	    TestScale(ti) == -1)
+		return (-1);
+
 	RandomizeSurfaces(ti);
 	return (0);
 }
@@ -468,16 +1230,20 @@ static struct ag_benchmark_fn fillRectOpsFns[] = {
 #if AG_MODEL == AG_LARGE
 	{ "AG_FillRect(64-bit Grayscale  <- a)",   Bench_FillRect_A,   16 },
 	{ "AG_FillRect(64-bit Grayscale <- !a)",   Bench_FillRect_NoA, 16 },
-	{ "AG_FillRect(48-bit RGB  <- a)",         Bench_FillRect_A,   17 },
-	{ "AG_FillRect(48-bit RGB <- !a)",         Bench_FillRect_NoA, 17 },
-	{ "AG_FillRect(48-bit BGR  <- a)",         Bench_FillRect_A,   18 },
-	{ "AG_FillRect(48-bit BGR <- !a)",         Bench_FillRect_NoA, 18 },
-	{ "AG_FillRect(64-bit RGBA  <- a)",        Bench_FillRect_A,   19 },
-	{ "AG_FillRect(64-bit RGBA <- !a)",        Bench_FillRect_NoA, 19 },
-	{ "AG_FillRect(64-bit ABGR  <- a)",        Bench_FillRect_A,   20 },
-	{ "AG_FillRect(64-bit ABGR <- !a)",        Bench_FillRect_NoA, 20 },
-	{ "AG_FillRect(64-bit BGRA  <- a)",        Bench_FillRect_A,   21 },
-	{ "AG_FillRect(64-bit BGRA <- !a)",        Bench_FillRect_NoA, 21 },
+	{ "AG_FillRect(40-bit RGB  <- a)",         Bench_FillRect_A,   17 },
+	{ "AG_FillRect(40-bit RGB <- !a)",         Bench_FillRect_NoA, 17 },
+	{ "AG_FillRect(40-bit BGR  <- a)",         Bench_FillRect_A,   18 },
+	{ "AG_FillRect(40-bit BGR <- !a)",         Bench_FillRect_NoA, 18 },
+	{ "AG_FillRect(48-bit RGB  <- a)",         Bench_FillRect_A,   19 },
+	{ "AG_FillRect(48-bit RGB <- !a)",         Bench_FillRect_NoA, 19 },
+	{ "AG_FillRect(48-bit BGR  <- a)",         Bench_FillRect_A,   20 },
+	{ "AG_FillRect(48-bit BGR <- !a)",         Bench_FillRect_NoA, 20 },
+	{ "AG_FillRect(64-bit RGBA  <- a)",        Bench_FillRect_A,   21 },
+	{ "AG_FillRect(64-bit RGBA <- !a)",        Bench_FillRect_NoA, 21 },
+	{ "AG_FillRect(64-bit ABGR  <- a)",        Bench_FillRect_A,   22 },
+	{ "AG_FillRect(64-bit ABGR <- !a)",        Bench_FillRect_NoA, 22 },
+	{ "AG_FillRect(64-bit BGRA  <- a)",        Bench_FillRect_A,   23 },
+	{ "AG_FillRect(64-bit BGRA <- !a)",        Bench_FillRect_NoA, 23 },
 #endif
 };
 struct ag_benchmark fillRectOps = {
@@ -487,6 +1253,110 @@ struct ag_benchmark fillRectOps = {
 	10, 1000, 1000000
 };
 
+/*
+ * Fills of a sub-rectangle crossing the left edge of the surface.
+ */
+static void
+Bench_FillRect_Clipped(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_Surface *S = ti->S[arg];
+	AG_Rect r;
+
+	r.x = -(S->w >> 3);
+	r.y = (S->h >> 3);
+	r.w = (S->w >> 1);
+	r.h = (S->h >> 1) + 1;
+	AG_FillRect(S, &r, &ti->randColorNoA);
+}
+static struct ag_benchmark_fn fillRectClippedOpsFns[] = {
+	{ "AG_FillRect(1-bit Indexed, clipped)",   Bench_FillRect_Clipped,  0 },
+	{ "AG_FillRect(2-bit Indexed, clipped)",   Bench_FillRect_Clipped,  1 },
+	{ "AG_FillRect(4-bit Indexed, clipped)",   Bench_FillRect_Clipped,  2 },
+	{ "AG_FillRect(8-bit Indexed, clipped)",   Bench_FillRect_Clipped,  3 },
+	{ "AG_FillRect(16-bit RGB, clipped)",      Bench_FillRect_Clipped,  6 },
+	{ "AG_FillRect(24-bit RGB, clipped)",      Bench_FillRect_Clipped, 11 },
+	{ "AG_FillRect(32-bit RGBA, clipped)",     Bench_FillRect_Clipped, 13 },
+#if AG_MODEL == AG_LARGE
+	{ "AG_FillRect(48-bit RGB, clipped)",      Bench_FillRect_Clipped, 19 },
+	{ "AG_FillRect(64-bit RGBA, clipped)",     Bench_FillRect_Clipped, 21 },
+#endif
+};
+struct ag_benchmark fillRectClippedOps = {
+	"AG_FillRect(3) clipped",
+	&fillRectClippedOpsFns[0],
+	sizeof(fillRectClippedOpsFns) / sizeof(fillRectClippedOpsFns[0]),
+	10, 1000, 1000000
+};
+
+/*
+ * Blended rectangle fills.
+ */
+static void
+Bench_BlendRect(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_Color c = ti->randColorA;
+
+	c.a = AG_OPAQUE/2;
+	AG_SurfaceBlendRect(ti->S[arg], NULL, &c);
+}
+static struct ag_benchmark_fn blendRectOpsFns[] = {
+	{ "AG_SurfaceBlendRect(16-bit RGB)",       Bench_BlendRect,  6 },
+	{ "AG_SurfaceBlendRect(16-bit RGBA)",      Bench_BlendRect,  8 },
+	{ "AG_SurfaceBlendRect(24-bit RGB)",       Bench_BlendRect, 11 },
+	{ "AG_SurfaceBlendRect(32-bit RGBA)",      Bench_BlendRect, 13 },
+	{ "AG_SurfaceBlendRect(32-bit ARGB)",      Bench_BlendRect, 14 },
+	{ "AG_SurfaceBlendRect(32-bit ABGR)",      Bench_BlendRect, 15 },
+#if AG_MODEL == AG_LARGE
+	{ "AG_SurfaceBlendRect(48-bit RGB)",       Bench_BlendRect, 19 },
+	{ "AG_SurfaceBlendRect(64-bit RGBA)",      Bench_BlendRect, 21 },
+#endif
+};
+struct ag_benchmark blendRectOps = {
+	"AG_SurfaceBlendRect(3)",
+	&blendRectOpsFns[0],
+	sizeof(blendRectOpsFns) / sizeof(blendRectOpsFns[0]),
+	10, 100, 10000000
+};
+
+/*
+ * Scaling.
+ */
+static void
+Bench_ScaleUp(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_Surface *S = ti->Sparrot;
+
+	AG_SurfaceFree(AG_SurfaceScale(S, S->w*3, S->h*3, (Uint)arg));
+}
+static void
+Bench_ScaleDown(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_Surface *S = ti->Sblit[0];
+
+	AG_SurfaceFree(AG_SurfaceScale(S, S->w/3, S->h/3, (Uint)arg));
+}
+static struct ag_benchmark_fn scaleOpsFns[] = {
+	{ "AG_SurfaceScale(x3, Nearest)",            Bench_ScaleUp,   AG_SCALE_NEAREST },
+	{ "AG_SurfaceScale(x3, Bilinear)",           Bench_ScaleUp,   AG_SCALE_BILINEAR },
+	{ "AG_SurfaceScale(x3, Box)",                Bench_ScaleUp,   AG_SCALE_BOX },
+	{ "AG_SurfaceScale(x3, Lanczos)",            Bench_ScaleUp,   AG_SCALE_LANCZOS },
+	{ "AG_SurfaceScale(x3, Lanczos, Parallel)",  Bench_ScaleUp,   AG_SCALE_LANCZOS|AG_SCALE_PARALLEL },
+	{ "AG_SurfaceScale(/3, Nearest)",            Bench_ScaleDown, AG_SCALE_NEAREST },
+	{ "AG_SurfaceScale(/3, Bilinear)",           Bench_ScaleDown, AG_SCALE_BILINEAR },
+	{ "AG_SurfaceScale(/3, Box)",                Bench_ScaleDown, AG_SCALE_BOX },
+	{ "AG_SurfaceScale(/3, Lanczos)",            Bench_ScaleDown, AG_SCALE_LANCZOS },
+};
+struct ag_benchmark scaleOps = {
+	"AG_SurfaceScale(3)",
+	&scaleOpsFns[0],
+	sizeof(scaleOpsFns) / sizeof(scaleOpsFns[0]),
+	10, 100, 100000000
+};
+
 /*
  * Blitters.
  */
@@ -586,6 +1456,56 @@ struct ag_benchmark blitOps = {
 	10, 100, 10000000
 };
 
+/*
+ * 32-bit Blitters.
+ */
+static void
+Bench_Blit32_Alpha(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_SurfaceBlit(ti->Sblit[0], NULL, ti->Dblit[arg], 0,0);
+}
+static void
+Bench_Blit32_Opaque(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_SurfaceBlit(ti->Sblit[1], NULL, ti->Dblit[arg], 0,0);
+}
+static void
+Bench_Blit32_SurfaceAlpha(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_SurfaceBlit(ti->Sblit[2], NULL, ti->Dblit[arg], 0,0);
+}
+static void
+Bench_Blit32_Colorkey(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_SurfaceBlit(ti->Sblit[3], NULL, ti->Dblit[arg], 0,0);
+}
+static void
+Bench_Blit32_Indexed(void *obj, int arg)
+{
+	MyTestInstance *ti = obj;
+	AG_SurfaceBlit(ti->Sblit[4], NULL, ti->Dblit[arg], 0,0);
+}
+static struct ag_benchmark_fn blit32OpsFns[] = {
+	{ "AG_SurfaceBlit(32-bit RGB -> RGBA)",             Bench_Blit32_Opaque,       0 },
+	{ "AG_SurfaceBlit(32-bit RGB -> ARGB)",             Bench_Blit32_Opaque,       1 },
+	{ "AG_SurfaceBlit(32-bit RGBA -> RGBA)",            Bench_Blit32_Alpha,        0 },
+	{ "AG_SurfaceBlit(32-bit RGBA -> ARGB)",            Bench_Blit32_Alpha,        1 },
+	{ "AG_SurfaceBlit(32-bit RGBA -> RGBA, Alpha)",     Bench_Blit32_SurfaceAlpha, 0 },
+	{ "AG_SurfaceBlit(32-bit RGB -> RGBA, Colorkey)",   Bench_Blit32_Colorkey,     0 },
+	{ "AG_SurfaceBlit(8-bit Indexed -> RGBA)",          Bench_Blit32_Indexed,      0 },
+	{ "AG_SurfaceBlit(8-bit Indexed -> ARGB)",          Bench_Blit32_Indexed,      1 },
+};
+struct ag_benchmark blit32Ops = {
+	"AG_SurfaceBlit(3) 32-bit",
+	&blit32OpsFns[0],
+	sizeof(blit32OpsFns) / sizeof(blit32OpsFns[0]),
+	10, 100, 10000000
+};
+
 static int
 Bench(void *obj)
 {
@@ -597,8 +1517,18 @@ Bench(void *obj)
 	TestMsg(ti, "AG_SurfaceBlit():");
 	TestExecBenchmark(obj, &blitOps);
 
-//	TestMsg(ti, "AG_FillRect():");
-//	TestExecBenchmark(obj, &fillRectOps);
+	TestMsg(ti, "AG_SurfaceBlit() (32-bit):");
+	TestExecBenchmark(obj, &blit32Ops);
+
+	TestMsg(ti, "AG_FillRect():");
+	TestExecBenchmark(obj, &fillRectOps);
+	TestExecBenchmark(obj, &fillRectClippedOps);
+
+	TestMsg(ti, "AG_SurfaceBlendRect():");
+	TestExecBenchmark(obj, &blendRectOps);
+
+	TestMsg(ti, "AG_SurfaceScale():");
+	TestExecBenchmark(obj, &scaleOps);
 
 	return (0);
 }
@@ -0,0 +1,248 @@
+/*	Public domain	*/
+/*
+ * Test the AG_Tbl(3) hash tables (chained and growable modes) and the
+ * resizing of the AG_Table(3) cell backing store.
+ */
+
+#include "agartest.h"
+
+#define NKEYS 5000			/* Keys inserted in each AG_Tbl */
+#define NROWS 4000			/* Rows in the AG_Table */
+
+static int values[NKEYS];
+
+/* Check that every key present[k] != 0 is found, and no other. */
+static int
+CheckKeys(AG_TestInstance *ti, AG_Tbl *tbl, const char *present,
+    const char *what)
+{
+	char key[32];
+	void *p;
+	int k;
+
+	for (k = 0; k < NKEYS; k++) {
+		Snprintf(key, sizeof(key), "key-%d", k);
+		if (present[k]) {
+			if (AG_TblLookupPointer(tbl, key, &p) == -1 ||
+			    p != &values[k] || !AG_TblExists(tbl, key)) {
+				TestMsg(ti, "%s: lost \"%s\"", what, key);
+				return (-1);
+			}
+		} else {
+			if (AG_TblLookup(tbl, key) != NULL ||
+			    AG_TblExists(tbl, key)) {
+				TestMsg(ti, "%s: found deleted \"%s\"", what, key);
+				return (-1);
+			}
+		}
+	}
+	return (0);
+}
+
+/*
+ * Insert NKEYS keys, then delete every third key and reinsert some of
+ * them. Lookups must agree with a reference array throughout. In growable
+ * mode, the index must grow with the load and AG_TBL_FOREACH must visit
+ * the entries in insertion order, also after deletions.
+ */
+static int
+TestTbl(AG_TestInstance *ti, Uint nBuckets, Uint flags, const char *what)
+{
+	char present[NKEYS];
+	char key[32];
+	AG_Tbl tbl;
+	AG_Variable *V;
+	Uint i, j, nSlotsInit, nEnts;
+	int k, rv = -1;
+
+	AG_TblInit(&tbl, nBuckets, flags);
+	nSlotsInit = tbl.nSlots;
+	memset(present, 0, sizeof(present));
+
+	for (k = 0; k < NKEYS; k++) {
+		Snprintf(key, sizeof(key), "key-%d", k);
+		if (AG_TblInsertPointer(&tbl, key, &values[k]) == -1) {
+			TestMsg(ti, "%s: insert \"%s\": %s", what, key,
+			    AG_GetError());
+			goto out;
+		}
+		present[k] = 1;
+	}
+	if (AG_TblInsertPointer(&tbl, "key-42", NULL) == 0) {
+		TestMsgS(ti, "Inserted a duplicate key");
+		goto out;
+	}
+	if (CheckKeys(ti, &tbl, present, what) == -1)
+		goto out;
+
+	if (flags & AG_TBL_GROWABLE) {
+		if ((nBuckets < NKEYS && tbl.nSlots <= nSlotsInit) ||
+		    NKEYS*100 > tbl.nSlots*AG_TBL_LOAD_MAX) {
+			TestMsg(ti, "%s: %u slots (from %u) for %d entries",
+			    what, tbl.nSlots, nSlotsInit, NKEYS);
+			goto out;
+		}
+		k = 0;
+		AG_TBL_FOREACH(V, i,j, &tbl) {
+			Snprintf(key, sizeof(key), "key-%d", k);
+			if (strcmp(tbl.buckets[i].keys[j], key) != 0 ||
+			    V->data.p != &values[k]) {
+				TestMsg(ti, "%s: entry #%d is \"%s\"", what, k,
+				    tbl.buckets[i].keys[j]);
+				goto out;
+			}
+			k++;
+		}
+		if (k != NKEYS) {
+			TestMsg(ti, "%s: iterated over %d entries", what, k);
+			goto out;
+		}
+	}
+
+	for (k = 0; k < NKEYS; k += 3) {
+		Snprintf(key, sizeof(key), "key-%d", k);
+		if (AG_TblDelete(&tbl, key) == -1) {
+			TestMsg(ti, "%s: delete \"%s\": %s", what, key,
+			    AG_GetError());
+			goto out;
+		}
+		present[k] = 0;
+	}
+	if (AG_TblDelete(&tbl, "key-0") == 0) {
+		TestMsgS(ti, "Deleted a nonexistent key");
+		goto out;
+	}
+	if (CheckKeys(ti, &tbl, present, what) == -1)
+		goto out;
+
+	if (flags & AG_TBL_GROWABLE) {
+		k = 0;
+		AG_TBL_FOREACH(V, i,j, &tbl) {
+			while (!present[k]) {
+				k++;
+			}
+			Snprintf(key, sizeof(key), "key-%d", k);
+			if (strcmp(tbl.buckets[i].keys[j], key) != 0 ||
+			    V->data.p != &values[k]) {
+				TestMsg(ti, "%s: after deletes, \"%s\" is out of "
+				            "order (expected \"%s\")", what,
+					    tbl.buckets[i].keys[j], key);
+				goto out;
+			}
+			k++;
+		}
+	}
+
+	for (k = 0; k < NKEYS; k += 6) {
+		Snprintf(key, sizeof(key), "key-%d", k);
+		if (AG_TblInsertPointer(&tbl, key, &values[k]) == -1) {
+			goto out;
+		}
+		present[k] = 1;
+	}
+	if (CheckKeys(ti, &tbl, present, what) == -1)
+		goto out;
+
+	nEnts = 0;
+	AG_TBL_FOREACH(V, i,j, &tbl) {
+		nEnts++;
+	}
+	for (k = 0, j = 0; k < NKEYS; k++) {
+		if (present[k])
+			j++;
+	}
+	if (nEnts != j) {
+		TestMsg(ti, "%s: iterated over %u entries (expected %u)",
+		    what, nEnts, j);
+		goto out;
+	}
+	rv = 0;
+out:
+	AG_TblDestroy(&tbl);
+	return (rv);
+}
+
+/*
+ * Rebuild a large AG_Table in reverse order. The backing store must have
+ * grown to about 4 cells per bucket, and the row selections must follow
+ * the contents of the rows.
+ */
+static int
+TestTableRebuild(AG_TestInstance *ti, AG_Window *win)
+{
+	AG_Table *t;
+	int m, k, nSel = 0;
+
+	t = AG_TableNew(win, 0);
+	AG_TableAddCol(t, "Id", "<8888>", NULL);
+	AG_TableAddCol(t, "Name", NULL, NULL);
+
+	AG_TableBegin(t);
+	for (k = 0; k < NROWS; k++) {
+		AG_TableAddRow(t, "%d:Item %d", k, k);
+	}
+	AG_TableEnd(t);
+	for (m = 0; m < NROWS; m += 7)
+		AG_TableSelectRow(t, m);
+
+	AG_TableBegin(t);
+	for (k = NROWS-1; k >= 0; k--) {
+		AG_TableAddRow(t, "%d:Item %d", k, k);
+	}
+	AG_TableEnd(t);
+
+	if (t->nPrevBuckets < NROWS*2/4) {
+		TestMsg(ti, "Table: %u buckets for %d cells", t->nPrevBuckets,
+		    NROWS*2);
+		return (-1);
+	}
+	for (m = 0; m < t->m; m++) {
+		k = NROWS-1 - m;
+		if (AG_TableRowSelected(t, m) != ((k % 7) == 0)) {
+			TestMsg(ti, "Table: row %d (item %d) selection lost",
+			    m, k);
+			return (-1);
+		}
+		if (AG_TableRowSelected(t, m))
+			nSel++;
+	}
+	if (t->m != NROWS || nSel != (NROWS+6)/7) {
+		TestMsg(ti, "Table: %d rows, %d selected", t->m, nSel);
+		return (-1);
+	}
+	return (0);
+}
+
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+	AG_Window *win;
+	int rv;
+
+	if (TestTbl(ti, 64, 0, "Chained") == -1 ||
+	    TestTbl(ti, 0, AG_TBL_GROWABLE, "Growable") == -1 ||
+	    TestTbl(ti, NKEYS, AG_TBL_GROWABLE, "Growable (presized)") == -1)
+		return (-1);
+
+	if ((win = AG_WindowNew(0)) == NULL) {
+		return (-1);
+	}
+	rv = TestTableRebuild(ti, win);
+	AG_ObjectDetach(win);
+	return (rv);
+}
+
+const AG_TestCase tblTest = {
+	AGSI_IDEOGRAM AGSI_TABLE AGSI_RST,
+	"tbl",
+	N_("Test AG_Tbl(3) growable tables and AG_Table(3) rebuilds"),
+	"1.7.1",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
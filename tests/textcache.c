@@ -0,0 +1,272 @@
+/*	Public domain	*/
+/*
+ * Test the AG_TextCache(3) lookups, expiration and window-shared caches.
+ */
+
+#include "agartest.h"
+
+#include <agar/gui/text_cache.h>
+
+#include <stdlib.h>
+
+#define NSTRINGS 200			/* Strings inserted by TestGrow() */
+
+/*
+ * Two polled labels with the same text share the cache of their window:
+ * the first one renders the text (one miss) and the second one reuses it
+ * (one hit). A change of text state must not hit the same entry.
+ */
+static int
+TestShared(AG_TestInstance *ti, AG_Window *win)
+{
+	AG_Label *lbl1, *lbl2;
+	AG_TextCache *tc;
+	AG_SizeReq r1, r2;
+	int value = 1234, s1, s2;
+
+	lbl1 = AG_LabelNewPolled(win, 0, "Value: %i", &value);
+	lbl2 = AG_LabelNewPolled(win, 0, "Value: %i", &value);
+	if (lbl1->tCache != NULL || lbl2->tCache != NULL) {
+		TestMsgS(ti, "Polled label has a private text cache");
+		return (-1);
+	}
+	AG_WidgetSizeReq(lbl1, &r1);
+	if ((tc = win->tCache) == NULL) {
+		TestMsgS(ti, "Polled label did not use the window's text cache");
+		return (-1);
+	}
+	if (AG_TextCacheGetShared(lbl1) != tc ||
+	    AG_TextCacheGetShared(lbl2) != tc ||
+	    AG_TextCacheGetShared(win) != tc ||
+	    !(tc->flags & AG_TEXT_CACHE_SHARED)) {
+		TestMsgS(ti, "Widgets of a window do not share one cache");
+		return (-1);
+	}
+	if (tc->nMisses != 1 || tc->nHits != 0 || tc->curEnts != 1) {
+		TestMsg(ti, "First label: %lu misses, %lu hits, %u entries",
+		    (Ulong)tc->nMisses, (Ulong)tc->nHits, tc->curEnts);
+		return (-1);
+	}
+	AG_WidgetSizeReq(lbl2, &r2);
+	if (tc->nMisses != 1 || tc->nHits != 1 || tc->curEnts != 1 ||
+	    r1.w != r2.w || r1.h != r2.h) {
+		TestMsg(ti, "Second label: %lu misses, %lu hits, %u entries",
+		    (Ulong)tc->nMisses, (Ulong)tc->nHits, tc->curEnts);
+		return (-1);
+	}
+
+	/* Same text in another color. */
+	s1 = AG_TextCacheGet(tc, "Value: 1234");
+	AG_PushTextState();
+	AG_TextColorRGB(255, 0, 0);
+	s2 = AG_TextCacheGet(tc, "Value: 1234");
+	AG_PopTextState();
+	if (s1 == -1 || s2 == -1 || s1 == s2 || tc->nMisses != 2) {
+		TestMsg(ti, "Text state change: surfaces %d,%d, %lu misses",
+		    s1, s2, (Ulong)tc->nMisses);
+		return (-1);
+	}
+	if (AG_TextCacheGet(tc, "Value: 1234") != s1 || tc->nMisses != 2) {
+		TestMsgS(ti, "Text state change evicted the first entry");
+		return (-1);
+	}
+	return (0);
+}
+
+/*
+ * With an entry limit, the least recently used entry must be expired
+ * first and the number of entries must never exceed the limit.
+ */
+static int
+TestEntryLimit(AG_TestInstance *ti, void *wid)
+{
+	AG_TextCache *tc;
+	int sA, rv = -1;
+
+	tc = AG_TextCacheNew(wid, 2, 2);		/* Up to 4 entries */
+	sA = AG_TextCacheGet(tc, "A");
+	if (sA == -1 ||
+	    AG_TextCacheGet(tc, "B") == -1 ||
+	    AG_TextCacheGet(tc, "C") == -1 ||
+	    AG_TextCacheGet(tc, "D") == -1)
+		goto out;
+
+	if (AG_TextCacheGet(tc, "A") != sA ||		/* A is now MRU */
+	    AG_TextCacheGet(tc, "E") == -1) {		/* Expires B */
+		goto out;
+	}
+	if (tc->curEnts != 4 || tc->nEvictions != 1) {
+		TestMsg(ti, "Entry limit: %u entries, %lu evictions",
+		    tc->curEnts, (Ulong)tc->nEvictions);
+		goto out;
+	}
+	if (AG_TextCacheGet(tc, "A") != sA || tc->nMisses != 5) {
+		TestMsgS(ti, "Entry limit: expired a recently used entry");
+		goto out;
+	}
+	if (AG_TextCacheGet(tc, "B") == -1 || tc->nMisses != 6 ||
+	    tc->curEnts != 4) {
+		TestMsgS(ti, "Entry limit: did not expire the LRU entry");
+		goto out;
+	}
+	rv = 0;
+out:
+	AG_TextCacheDestroy(tc);
+	return (rv);
+}
+
+/*
+ * With a memory budget, the total size of the entries must remain within
+ * the budget (the most recent entry is always kept).
+ */
+static int
+TestBudget(AG_TestInstance *ti, void *wid)
+{
+	char text[32];
+	AG_TextCache *tc;
+	AG_Size budget;
+	int i, rv = -1;
+
+	tc = AG_TextCacheNewBudget(wid, 0);
+	if (AG_TextCacheGet(tc, "Text 0") == -1) {
+		goto out;
+	}
+	budget = tc->size * 3;
+	AG_TextCacheSetBudget(tc, budget);
+
+	for (i = 1; i < 20; i++) {
+		Snprintf(text, sizeof(text), "Text %d", i);
+		if (AG_TextCacheGet(tc, text) == -1) {
+			goto out;
+		}
+		if (tc->size > budget && tc->curEnts > 1) {
+			TestMsg(ti, "Budget: %lu bytes in cache (budget %lu)",
+			    (Ulong)tc->size, (Ulong)budget);
+			goto out;
+		}
+	}
+	if (tc->nEvictions == 0 || tc->curEnts > 3) {
+		TestMsg(ti, "Budget: %u entries, %lu evictions", tc->curEnts,
+		    (Ulong)tc->nEvictions);
+		goto out;
+	}
+
+	/* Lowering the budget expires entries immediately. */
+	AG_TextCacheSetBudget(tc, 1);
+	if (tc->curEnts != 1) {
+		TestMsg(ti, "Budget: %u entries after lowering", tc->curEnts);
+		goto out;
+	}
+	rv = 0;
+out:
+	AG_TextCacheDestroy(tc);
+	return (rv);
+}
+
+/*
+ * An unlimited cache must grow its hash table as entries are added, and
+ * find every entry again afterwards.
+ */
+static int
+TestGrow(AG_TestInstance *ti, void *wid)
+{
+	char text[32];
+	int surfaces[NSTRINGS];
+	AG_TextCache *tc;
+	Uint nBucketsInit;
+	int i, rv = -1;
+
+	tc = AG_TextCacheNewBudget(wid, 0);
+	nBucketsInit = tc->nBuckets;
+	for (i = 0; i < NSTRINGS; i++) {
+		Snprintf(text, sizeof(text), "String %d", i);
+		if ((surfaces[i] = AG_TextCacheGet(tc, text)) == -1)
+			goto out;
+	}
+	if (tc->nBuckets <= nBucketsInit || tc->nBuckets < NSTRINGS ||
+	    tc->curEnts != NSTRINGS || tc->nEvictions != 0) {
+		TestMsg(ti, "Grow: %u buckets (from %u) for %u entries",
+		    tc->nBuckets, nBucketsInit, tc->curEnts);
+		goto out;
+	}
+	for (i = 0; i < NSTRINGS; i++) {
+		Snprintf(text, sizeof(text), "String %d", i);
+		if (AG_TextCacheGet(tc, text) != surfaces[i]) {
+			TestMsg(ti, "Grow: lost \"%s\"", text);
+			goto out;
+		}
+	}
+	if (tc->nHits != NSTRINGS || tc->nMisses != NSTRINGS) {
+		TestMsg(ti, "Grow: %lu hits, %lu misses", (Ulong)tc->nHits,
+		    (Ulong)tc->nMisses);
+		goto out;
+	}
+	rv = 0;
+out:
+	AG_TextCacheDestroy(tc);
+	return (rv);
+}
+
+/*
+ * Destroying a window must destroy its shared cache. The window is made
+ * static so that its structure can still be inspected once destroyed.
+ */
+static int
+TestWindowDestroy(AG_TestInstance *ti, AG_Window *win)
+{
+	AG_Object *ob = AGOBJECT(win);
+	int rv = 0;
+
+	ob->flags |= AG_OBJECT_STATIC;
+	AG_ObjectDetach(win);
+	AG_LockVFS(&agDrivers);
+	AG_WindowProcessDetachQueue();
+	AG_UnlockVFS(&agDrivers);
+
+	if (win->tCache != NULL) {
+		TestMsgS(ti, "Window destroyed without its text cache");
+		rv = -1;
+	}
+	if (ob->flags & AG_OBJECT_POOLED) {
+		AG_PoolFree(ob->cls->pool, ob);
+	} else {
+		free(ob);
+	}
+	return (rv);
+}
+
+static int
+Test(void *obj)
+{
+	AG_TestInstance *ti = obj;
+	AG_Window *win;
+	AG_Label *lbl;
+
+	if ((win = AG_WindowNew(0)) == NULL) {
+		return (-1);
+	}
+	lbl = AG_LabelNewS(win, 0, "Cache owner");
+
+	if (TestShared(ti, win) == -1 ||
+	    TestEntryLimit(ti, lbl) == -1 ||
+	    TestBudget(ti, lbl) == -1 ||
+	    TestGrow(ti, lbl) == -1) {
+		AG_ObjectDetach(win);
+		return (-1);
+	}
+	return TestWindowDestroy(ti, win);
+}
+
+const AG_TestCase textcacheTest = {
+	AGSI_IDEOGRAM AGSI_TEXTBOX AGSI_RST,
+	"textcache",
+	N_("Test the AG_TextCache(3) and window-shared text caches"),
+	"1.7.1",
+	0,
+	sizeof(AG_TestInstance),
+	NULL,		/* init */
+	NULL,		/* destroy */
+	Test,
+	NULL,		/* testGUI */
+	NULL		/* bench */
+};
@@ -243,6 +243,410 @@ Destroy(void *obj)
 	AG_ObjectDestroy(&ti->workerMgr);
 }
 
+#define TASK_DATA_SIZE 0x100000
+
+static int taskData[TASK_DATA_SIZE];	/* For Test() and Bench() */
+static int taskCount;
+static AG_Mutex taskLock = AG_MUTEX_INITIALIZER;
+
+static void
+SumRange(void *arg, int start, int end)
+{
+	Sint64 sum = 0;
+	int i;
+
+	for (i = start; i < end; i++) {
+		sum += taskData[i];
+	}
+	AG_MutexLock(&taskLock);
+	*(Sint64 *)arg += sum;
+	AG_MutexUnlock(&taskLock);
+}
+
+static void
+CountTask(void *arg)
+{
+	AG_MutexLock(&taskLock);
+	taskCount++;
+	AG_MutexUnlock(&taskLock);
+}
+
+static void
+SubmitTasks(void *arg)
+{
+	AG_TaskPool *pool = arg;
+	AG_TaskGroup grp = AG_TASK_GROUP_INITIALIZER;
+	int i;
+
+	for (i = 0; i < 100; i++) {
+		if (AG_TaskSubmit(pool, &grp, CountTask, NULL) == -1)
+			AG_FatalError(NULL);
+	}
+	AG_TaskWait(pool, &grp);
+}
+
+#if AG_MODEL != AG_SMALL
+
+#define QUEUE_PRODUCERS 8		/* Threads calling AG_QueueEvent() */
+#define QUEUE_OBJECTS   4		/* Objects receiving the events */
+#define QUEUE_EVENTS    100000		/* Events queued by each producer */
+
+typedef struct {
+	AG_Object *obj;
+	int lastSeq[QUEUE_PRODUCERS];	/* Last sequence number received */
+	int nRecv;			/* Events received */
+	int nOutOfOrder;		/* Events received out of order */
+} QueueTarget;
+
+typedef struct {
+	QueueTarget *targets;
+	AG_Mutex *lock;			/* Start gate (and lock on nDone) */
+	int *nDone;			/* Producers done */
+	AG_EventAtom atom;
+	int producer;
+	int nSent[QUEUE_OBJECTS];	/* Events sent to each object */
+	int nFailed;
+} QueueProducer;
+
+/* Called by AG_ProcessQueuedEvents() with the object locked. */
+static void
+QueuedEventReceived(AG_Event *event)
+{
+	QueueTarget *qt = AG_PTR(1);
+	const int producer = AG_INT(2);
+	const int seq = AG_INT(3);
+
+	if (seq <= qt->lastSeq[producer]) {
+		qt->nOutOfOrder++;
+	}
+	qt->lastSeq[producer] = seq;
+	qt->nRecv++;
+}
+
+/*
+ * Destroy another object which has events queued, and cancel the rest of
+ * our own queued events.
+ */
+static void
+QueuedEventKill(AG_Event *event)
+{
+	AG_Object **victim = AG_PTR(1);
+	int *nKills = AG_PTR(2);
+
+	if (*victim != NULL) {
+		AG_ObjectDestroy(*victim);
+		*victim = NULL;
+	}
+	AG_CancelQueuedEvents(AG_SELF());
+	(*nKills)++;
+}
+
+static void *
+QueueProducerThread(void *arg)
+{
+	QueueProducer *qp = arg;
+	Uint32 seed = 1 + qp->producer;
+	int seq, i, rv;
+
+	AG_MutexLock(qp->lock);
+	AG_MutexUnlock(qp->lock);
+
+	for (seq = 0; seq < QUEUE_EVENTS; seq++) {
+		seed = seed*1103515245 + 12345;
+		i = (seed >> 16) % QUEUE_OBJECTS;
+		if (seq & 1) {
+			rv = AG_QueueEventByAtom(qp->targets[i].obj, qp->atom,
+			    "%i,%i", qp->producer, seq);
+		} else {
+			rv = AG_QueueEvent(qp->targets[i].obj, "queued",
+			    "%i,%i", qp->producer, seq);
+		}
+		if (rv == 0) {
+			qp->nSent[i]++;
+		} else {
+			qp->nFailed++;
+		}
+	}
+	AG_MutexLock(qp->lock);
+	(*qp->nDone)++;
+	AG_MutexUnlock(qp->lock);
+	return (NULL);
+}
+
+/* Return the number of events received by all targets. */
+static int
+QueueReceived(QueueTarget *targets)
+{
+	int i, n = 0;
+
+	for (i = 0; i < QUEUE_OBJECTS; i++) {
+		AG_ObjectLock(targets[i].obj);
+		n += targets[i].nRecv;
+		AG_ObjectUnlock(targets[i].obj);
+	}
+	return (n);
+}
+
+/*
+ * Queue events from several threads at once while this thread drains the
+ * queue. Every event must be delivered exactly once, and the events from
+ * a given producer to a given object must arrive in the order sent.
+ * Cancelled events and events for a destroyed object must not be delivered,
+ * even when a handler is the one destroying the object.
+ */
+static int
+TestQueueEvent(MyTestInstance *ti)
+{
+	QueueTarget targets[QUEUE_OBJECTS];
+	QueueProducer producers[QUEUE_PRODUCERS];
+	AG_Thread th[QUEUE_PRODUCERS];
+	AG_Mutex lock;
+	AG_Object *objDead, *objKiller;
+	int i, j, nDone = 0, nSent, nRecv, nRecv0, nKills = 0, rv = -1;
+
+	memset(targets, 0, sizeof(targets));
+	memset(producers, 0, sizeof(producers));
+	for (i = 0; i < QUEUE_OBJECTS; i++) {
+		QueueTarget *qt = &targets[i];
+
+		qt->obj = AG_ObjectNew(NULL, NULL, &agObjectClass);
+		for (j = 0; j < QUEUE_PRODUCERS; j++) {
+			qt->lastSeq[j] = -1;
+		}
+		AG_SetEvent(qt->obj, "queued", QueuedEventReceived, "%p", qt);
+	}
+	AG_MutexInit(&lock);
+	AG_MutexLock(&lock);
+	for (i = 0; i < QUEUE_PRODUCERS; i++) {
+		producers[i].targets = targets;
+		producers[i].lock = &lock;
+		producers[i].nDone = &nDone;
+		producers[i].atom = AG_GetEventAtom("queued");
+		producers[i].producer = i;
+		AG_ThreadCreate(&th[i], QueueProducerThread, &producers[i]);
+	}
+	AG_MutexUnlock(&lock);
+	for (;;) {
+		AG_MutexLock(&lock);
+		j = nDone;
+		AG_MutexUnlock(&lock);
+		if (j == QUEUE_PRODUCERS) {
+			break;
+		}
+		if (AG_ProcessQueuedEvents() == 0)
+			AG_Delay(1);
+	}
+	for (i = 0; i < QUEUE_PRODUCERS; i++) {
+		AG_ThreadJoin(th[i], NULL);
+		if (producers[i].nFailed > 0) {
+			TestMsg(ti, "AG_QueueEvent: %d failures",
+			    producers[i].nFailed);
+			goto out;
+		}
+	}
+	AG_MutexDestroy(&lock);
+	AG_ProcessQueuedEvents();
+
+	for (i = 0; i < QUEUE_OBJECTS; i++) {
+		QueueTarget *qt = &targets[i];
+
+		for (j = 0, nSent = 0; j < QUEUE_PRODUCERS; j++) {
+			nSent += producers[j].nSent[i];
+		}
+		if (qt->nRecv != nSent || qt->nOutOfOrder > 0) {
+			TestMsg(ti, "AG_QueueEvent: object %d received %d events "
+			            "(sent %d), %d out of order", i, qt->nRecv,
+				    nSent, qt->nOutOfOrder);
+			goto out;
+		}
+	}
+	TestMsg(ti, "AG_QueueEvent: %d events from %d threads delivered in order",
+	    QUEUE_PRODUCERS*QUEUE_EVENTS, QUEUE_PRODUCERS);
+
+	/* Cancelled events are never delivered. */
+	nRecv = QueueReceived(targets);
+	nRecv0 = targets[0].nRecv;
+	for (i = 0; i < 100; i++) {
+		AG_QueueEvent(targets[0].obj, "queued", "%i,%i", 0,
+		    QUEUE_EVENTS + i);
+		AG_QueueEvent(targets[1].obj, "queued", "%i,%i", 0,
+		    QUEUE_EVENTS + i);
+	}
+	AG_CancelQueuedEvents(targets[0].obj);
+	AG_ProcessQueuedEvents();
+	if (targets[0].nRecv != nRecv0 ||
+	    QueueReceived(targets) != nRecv + 100 ||
+	    targets[1].lastSeq[0] != QUEUE_EVENTS + 99) {
+		TestMsg(ti, "AG_CancelQueuedEvents: %d events delivered "
+		            "(expected 100)", QueueReceived(targets) - nRecv);
+		goto out;
+	}
+
+	/* Destroying an object discards its pending events. */
+	objDead = AG_ObjectNew(NULL, NULL, &agObjectClass);
+	AG_SetEvent(objDead, "queued", QueuedEventReceived, "%p", &targets[2]);
+	AG_QueueEvent(objDead, "queued", "%i,%i", 0, 0);
+	AG_QueueEvent(targets[3].obj, "queued", "%i,%i", 1, QUEUE_EVENTS);
+	nRecv = QueueReceived(targets);
+	AG_ObjectDestroy(objDead);
+	AG_ProcessQueuedEvents();
+	if (QueueReceived(targets) != nRecv + 1) {
+		TestMsgS(ti, "AG_ObjectDestroy: pending events were delivered");
+		goto out;
+	}
+
+	/*
+	 * A handler destroys an object whose events are waiting behind its
+	 * own, and cancels its own remaining events.
+	 */
+	objKiller = AG_ObjectNew(NULL, NULL, &agObjectClass);
+	objDead = AG_ObjectNew(NULL, NULL, &agObjectClass);
+	AG_SetEvent(objKiller, "queued", QueuedEventKill, "%p,%p", &objDead,
+	    &nKills);
+	AG_SetEvent(objDead, "queued", QueuedEventReceived, "%p", &targets[2]);
+	AG_QueueEvent(objKiller, "queued", NULL);
+	AG_QueueEvent(objKiller, "queued", NULL);
+	AG_QueueEvent(objDead, "queued", "%i,%i", 0, 1);
+	AG_QueueEvent(targets[3].obj, "queued", "%i,%i", 1, QUEUE_EVENTS+1);
+	nRecv = QueueReceived(targets);
+	AG_ProcessQueuedEvents();
+	AG_ObjectDestroy(objKiller);
+	if (objDead != NULL || nKills != 1 ||
+	    QueueReceived(targets) != nRecv + 1 ||
+	    targets[3].lastSeq[1] != QUEUE_EVENTS+1) {
+		TestMsg(ti, "AG_ProcessQueuedEvents: %d kills, %d events "
+		            "delivered (expected 1, 1)", nKills,
+			    QueueReceived(targets) - nRecv);
+		goto out;
+	}
+	rv = 0;
+out:
+	for (i = 0; i < QUEUE_OBJECTS; i++) {
+		AG_ObjectDestroy(targets[i].obj);
+	}
+	return (rv);
+}
+#endif /* !AG_SMALL */
+
+static int
+Test(void *obj)
+{
+	MyTestInstance *ti = obj;
+	AG_TaskPool *pool;
+	AG_TaskGroup grp;
+	AG_TaskPoolStats st;
+	Sint64 sum, sumRef = 0;
+	int i;
+
+#if AG_MODEL != AG_SMALL
+	if (TestQueueEvent(ti) == -1)
+		return (-1);
+#endif
+	for (i = 0; i < TASK_DATA_SIZE; i++) {
+		taskData[i] = i % 7;
+		sumRef += taskData[i];
+	}
+	if ((pool = AG_TaskPoolNew(4)) == NULL) {
+		TestMsg(ti, "AG_TaskPoolNew: %s", AG_GetError());
+		return (-1);
+	}
+	for (i = 0; i < 10; i++) {
+		sum = 0;
+		AG_TaskParallelFor(pool, 0, TASK_DATA_SIZE, 0, SumRange, &sum);
+		if (sum != sumRef) {
+			TestMsg(ti, "AG_TaskParallelFor: Bad sum %lld (!= %lld)",
+			    (long long)sum, (long long)sumRef);
+			goto fail;
+		}
+	}
+	/* Uneven ranges and grain sizes. */
+	for (i = 0; i < 3; i++) {
+		static const int ranges[3][3] = {
+			{ 3, 1000, 1 },
+			{ 0, 100000, 999 },
+			{ 5, TASK_DATA_SIZE-3, 4097 }
+		};
+		Sint64 sumRange = 0;
+		int j;
+
+		for (j = ranges[i][0]; j < ranges[i][1]; j++) {
+			sumRange += taskData[j];
+		}
+		sum = 0;
+		AG_TaskParallelFor(pool, ranges[i][0], ranges[i][1],
+		    ranges[i][2], SumRange, &sum);
+		if (sum != sumRange) {
+			TestMsg(ti, "AG_TaskParallelFor: [%d,%d) grain %d: "
+			            "Bad sum %lld (!= %lld)", ranges[i][0],
+				    ranges[i][1], ranges[i][2], (long long)sum,
+				    (long long)sumRange);
+			goto fail;
+		}
+	}
+
+	/* Tasks submitting and waiting on tasks of their own. */
+	taskCount = 0;
+	AG_TaskGroupInit(&grp);
+	for (i = 0; i < 50; i++) {
+		if (AG_TaskSubmit(pool, &grp, SubmitTasks, pool) == -1)
+			goto fail;
+	}
+	AG_TaskWait(pool, &grp);
+	if (taskCount != 5000) {
+		TestMsg(ti, "AG_TaskWait: Got %d completions (!= 5000)",
+		    taskCount);
+		goto fail;
+	}
+	AG_TaskPoolGetStats(pool, &st);
+	TestMsg(ti, "Task pool: %u threads, %lu tasks executed (%lu stolen, "
+	            "%lu inline)", st.nThreads, (Ulong)st.nExecuted,
+		    (Ulong)st.nStolen, (Ulong)st.nInline);
+	AG_TaskPoolDestroy(pool);
+	return (0);
+fail:
+	AG_TaskPoolDestroy(pool);
+	return (-1);
+}
+
+static void
+Bench_SumSerial(void *obj, int arg)
+{
+	Sint64 sum = 0;
+
+	SumRange(&sum, 0, TASK_DATA_SIZE);
+}
+static void
+Bench_SumParallel(void *obj, int arg)
+{
+	Sint64 sum = 0;
+
+	AG_TaskParallelFor(AG_TaskPoolDefault(), 0, TASK_DATA_SIZE, arg,
+	    SumRange, &sum);
+}
+static struct ag_benchmark_fn taskOpsFns[] = {
+	{ "Sum (serial)",                        Bench_SumSerial,   0 },
+	{ "Sum (AG_TaskParallelFor, auto grain)", Bench_SumParallel, 0 },
+	{ "Sum (AG_TaskParallelFor, grain=4096)", Bench_SumParallel, 4096 },
+};
+struct ag_benchmark taskOps = {
+	"AG_TaskParallelFor(3)",
+	&taskOpsFns[0],
+	sizeof(taskOpsFns) / sizeof(taskOpsFns[0]),
+	10, 100, 0
+};
+
+static int
+Bench(void *obj)
+{
+	int i;
+
+	for (i = 0; i < TASK_DATA_SIZE; i++) {
+		taskData[i] = i % 7;
+	}
+	TestExecBenchmark(obj, &taskOps);
+	return (0);
+}
+
 static void
 CloseTest(AG_Event *event)
 {
@@ -281,21 +685,22 @@ TestGUI(void *obj, AG_Window *win)
 const AG_TestCase threadsTest = {
 	AGSI_IDEOGRAM AGSI_THREADS AGSI_RST,
 	"threads",
-	N_("Test multithreaded widget creation"),
+	N_("Test multithreaded widget creation, task pools and queued events"),
 	"1.6.0",
 	0,
 #ifdef AG_THREADS
 	sizeof(MyTestInstance),
 	Init,
 	Destroy,
-	NULL,		/* test */
+	Test,
 	TestGUI,
+	Bench
 #else
 	sizeof(AG_TestInstance),
 	NULL,		/* init */
 	NULL,		/* destroy */
 	NULL,		/* test */
 	NULL,		/* testGUI */
-#endif
 	NULL		/* bench */
+#endif
 };
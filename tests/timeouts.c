@@ -80,6 +80,200 @@ StopPeriodic(AG_Event *event)
 	AG_DelTimer(ti->win, &ti->toReg);
 }
 
+/*
+ * Soft timer heap test. The timers are run by calling AG_ProcessTimeouts()
+ * for every tick, so each timer must fire exactly at its expiration time,
+ * in expiration order, and AG_GetNextTimeout() must return the time until
+ * the soonest pending timer.
+ */
+#define NHEAPTIMERS 250
+
+typedef struct {
+	AG_Timer to;
+	Uint32 tExpected;		/* Expiration time (or 0 if cancelled) */
+	int nFired;
+} HeapTimer;
+
+typedef struct {
+	MyTestInstance *ti;
+	HeapTimer *timers;
+	Uint32 t;			/* Current tick */
+	Uint32 tLast;			/* Expiration of the last timer fired */
+	int nErrors;
+} HeapTest;
+
+static Uint32
+HeapTimeout(AG_Timer *to, AG_Event *event)
+{
+	AG_Object *ob = AG_SELF();
+	HeapTest *ht = AG_PTR(1);
+	const int i = AG_INT(2);
+	HeapTimer *htm = &ht->timers[i];
+
+	if (htm->tExpected == 0 || htm->nFired > 0 ||
+	    ht->t != htm->tExpected ||
+	    (int)(to->tSched - ht->tLast) < 0) {
+		if (ht->nErrors++ == 0)
+			TestMsg(ht->ti, "Timer %d fired at %u (expected %u, "
+			                "%d times before)", i, (Uint)ht->t,
+			    (Uint)htm->tExpected, htm->nFired);
+	}
+	htm->nFired++;
+	ht->tLast = to->tSched;
+
+	/* Cancel a later timer from within a callback. */
+	if ((i % 13) == 0 && i+1 < NHEAPTIMERS &&
+	    ht->timers[i+1].tExpected != 0 &&
+	    ht->timers[i+1].nFired == 0 &&
+	    (int)(ht->timers[i+1].tExpected - ht->t) > 0) {
+		AG_DelTimer(ob, &ht->timers[i+1].to);
+		ht->timers[i+1].tExpected = 0;
+	}
+	return (0);
+}
+
+/* Return the ticks until the soonest pending timer (as AG_GetNextTimeout). */
+static Uint32
+HeapNextTimeout(const HeapTest *ht)
+{
+	Uint32 dtMin = 0xfffffffe;
+	int i, dt;
+
+	for (i = 0; i < NHEAPTIMERS; i++) {
+		const HeapTimer *htm = &ht->timers[i];
+
+		if (htm->tExpected == 0 || htm->nFired > 0) {
+			continue;
+		}
+		dt = (int)(htm->tExpected - ht->t);
+		if (dt <= 0) {
+			return (0);
+		}
+		if ((Uint32)dt < dtMin)
+			dtMin = (Uint32)dt;
+	}
+	return (dtMin);
+}
+
+static int
+Test(void *obj)
+{
+	MyTestInstance *ti = obj;
+	AG_EventSource *src = AG_GetEventSource();
+	int (*addTimerFnSave)(AG_Timer *, Uint32, int) = src->addTimerFn;
+	void (*delTimerFnSave)(AG_Timer *) = src->delTimerFn;
+	const Uint8 capSave = src->caps[AG_SINK_TIMER];
+	AG_Object *ob;
+	HeapTest ht;
+	Uint32 t0, tEnd, next, seed = 1;
+	int i, heapEmpty, rv = -1;
+
+	/* Use soft timers, as with AG_SOFT_TIMERS. */
+	src->addTimerFn = NULL;
+	src->delTimerFn = NULL;
+	src->caps[AG_SINK_TIMER] = 0;
+
+	ht.ti = ti;
+	ht.timers = Malloc(NHEAPTIMERS * sizeof(HeapTimer));
+	ht.nErrors = 0;
+	ob = AG_ObjectNew(NULL, "heapTimers", &agObjectClass);
+
+	AG_LockTiming();
+	heapEmpty = (AG_GetNextTimeout(AG_GetTicks()) == 0xfffffffe);
+	AG_UnlockTiming();
+
+	t0 = AG_GetTicks();
+	for (i = 0; i < NHEAPTIMERS; i++) {
+		HeapTimer *htm = &ht.timers[i];
+
+		seed = seed*1103515245 + 12345;
+		AG_InitTimer(&htm->to, "heapTimer", 0);
+		if (AG_AddTimer(ob, &htm->to, 1 + (seed >> 16) % 1000,
+		    HeapTimeout, "%p,%i", &ht, i) == -1) {
+			TestMsg(ti, "AddTimer: %s", AG_GetError());
+			goto out;
+		}
+		htm->tExpected = htm->to.tSched;
+		htm->nFired = 0;
+	}
+
+	/* Reschedule, change the interval of and cancel some timers. */
+	for (i = 0; i < NHEAPTIMERS; i++) {
+		HeapTimer *htm = &ht.timers[i];
+
+		seed = seed*1103515245 + 12345;
+		switch (i % 7) {
+		case 1:
+			if (AG_AddTimer(ob, &htm->to, 1 + (seed >> 16) % 1200,
+			    HeapTimeout, "%p,%i", &ht, i) == -1) {
+				goto out;
+			}
+			htm->tExpected = htm->to.tSched;
+			break;
+		case 3:
+			if (AG_ResetTimer(ob, &htm->to, 1 + (seed >> 16) % 50)
+			    == -1) {
+				goto out;
+			}
+			htm->tExpected = htm->to.tSched;
+			break;
+		case 5:
+			AG_DelTimer(ob, &htm->to);
+			htm->tExpected = 0;
+			break;
+		}
+	}
+
+	/* Run every tick until all timers have fired. */
+	tEnd = AG_GetTicks() + 1200;
+	ht.tLast = t0;
+	for (ht.t = t0; (int)(ht.t - tEnd) <= 0; ht.t++) {
+		AG_LockTiming();
+		next = AG_GetNextTimeout(ht.t);
+		AG_UnlockTiming();
+		if (heapEmpty ? (next != HeapNextTimeout(&ht)) :
+		                (next > HeapNextTimeout(&ht))) {
+			TestMsg(ti, "AG_GetNextTimeout(%u) = %u (expected %u)",
+			    (Uint)ht.t, (Uint)next, (Uint)HeapNextTimeout(&ht));
+			goto out;
+		}
+		AG_ProcessTimeouts(ht.t);
+		if (ht.nErrors > 0)
+			goto out;
+	}
+	for (i = 0; i < NHEAPTIMERS; i++) {
+		const HeapTimer *htm = &ht.timers[i];
+
+		if (htm->nFired != (htm->tExpected != 0 ? 1 : 0)) {
+			TestMsg(ti, "Timer %d fired %d times", i, htm->nFired);
+			goto out;
+		}
+	}
+	if (!TAILQ_EMPTY(&ob->timers)) {
+		TestMsgS(ti, "Object still has timers");
+		goto out;
+	}
+	if (heapEmpty) {
+		AG_LockTiming();
+		next = AG_GetNextTimeout(ht.t);
+		AG_UnlockTiming();
+		if (next != 0xfffffffe) {
+			TestMsg(ti, "Timer heap not empty (next in %u)", (Uint)next);
+			goto out;
+		}
+	}
+	TestMsg(ti, "Soft timers: %d timers fired in order", NHEAPTIMERS);
+	rv = 0;
+out:
+	AG_DelTimers(ob);
+	AG_ObjectDestroy(ob);
+	Free(ht.timers);
+	src->addTimerFn = addTimerFnSave;
+	src->delTimerFn = delTimerFnSave;
+	src->caps[AG_SINK_TIMER] = capSave;
+	return (rv);
+}
+
 static int
 Init(void *obj)
 {
@@ -143,7 +337,7 @@ const AG_TestCase timeoutsTest = {
 	sizeof(MyTestInstance),
 	Init,
 	NULL,
-	NULL,		/* test */
+	Test,
 	TestGUI,
 	NULL		/* bench */
 };